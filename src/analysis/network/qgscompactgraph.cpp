@@ -0,0 +1,95 @@
+/***************************************************************************
+  qgscompactgraph.cpp
+  --------------------------------------
+  Date                 : October 2015
+  Copyright            : (C) 2015 by QGIS Development Team
+  Email                : qgis-developer at lists dot osgeo dot org
+****************************************************************************
+*                                                                          *
+*   This program is free software; you can redistribute it and/or modify   *
+*   it under the terms of the GNU General Public License as published by   *
+*   the Free Software Foundation; either version 2 of the License, or      *
+*   (at your option) any later version.                                    *
+*                                                                          *
+***************************************************************************/
+
+#include "qgscompactgraph.h"
+#include "qgsgraph.h"
+
+QgsCompactGraph::QgsCompactGraph()
+    : mOutArcStart( 1, 0 )
+{
+}
+
+QgsCompactGraph::QgsCompactGraph( const QgsGraph* graph )
+{
+  int vertexCount = graph->vertexCount();
+  int arcCount = graph->arcCount();
+
+  mVertexX.resize( vertexCount );
+  mVertexY.resize( vertexCount );
+  mOutArcStart.resize( vertexCount + 1 );
+
+  int criterionCount = 0;
+  for ( int i = 0; i < vertexCount; ++i )
+  {
+    const QgsGraphVertex& vertex = graph->vertex( i );
+    QgsPoint pt = vertex.point();
+    mVertexX[i] = pt.x();
+    mVertexY[i] = pt.y();
+  }
+
+  // count outgoing arcs and the number of properties
+  QVector<int> outDegree( vertexCount, 0 );
+  for ( int i = 0; i < arcCount; ++i )
+  {
+    const QgsGraphArc& arc = graph->arc( i );
+    outDegree[ arc.outVertex()]++;
+    criterionCount = qMax( criterionCount, arc.properties().size() );
+  }
+
+  int pos = 0;
+  for ( int i = 0; i < vertexCount; ++i )
+  {
+    mOutArcStart[i] = pos;
+    pos += outDegree[i];
+  }
+  mOutArcStart[ vertexCount ] = pos;
+
+  mArcInVertex.resize( arcCount );
+  mArcOutVertex.resize( arcCount );
+  mArcId.resize( arcCount );
+  mCosts.resize( criterionCount );
+  for ( int c = 0; c < criterionCount; ++c )
+    mCosts[c].resize( arcCount );
+
+  // fill arcs - keep the order of outgoing arcs of the source graph
+  QVector<int> next = mOutArcStart;
+  for ( int i = 0; i < arcCount; ++i )
+  {
+    const QgsGraphArc& arc = graph->arc( i );
+    int arcPos = next[ arc.outVertex()]++;
+
+    mArcInVertex[ arcPos ] = arc.inVertex();
+    mArcOutVertex[ arcPos ] = arc.outVertex();
+    mArcId[ arcPos ] = i;
+
+    const QVector< QVariant > properties = arc.properties();
+    for ( int c = 0; c < criterionCount; ++c )
+    {
+      mCosts[c][ arcPos ] = c < properties.size() ? properties[c].toDouble() : 0.0;
+    }
+  }
+}
+
+int QgsCompactGraph::findVertex( const QgsPoint& pt ) const
+{
+  for ( int i = 0; i < mVertexX.size(); ++i )
+  {
+    if ( mVertexX[i] == pt.x() && mVertexY[i] == pt.y() )
+    {
+      return i;
+    }
+  }
+  return -1;
+}
@@ -0,0 +1,152 @@
+/***************************************************************************
+  qgscompactgraph.h
+  --------------------------------------
+  Date                 : October 2015
+  Copyright            : (C) 2015 by QGIS Development Team
+  Email                : qgis-developer at lists dot osgeo dot org
+****************************************************************************
+*                                                                          *
+*   This program is free software; you can redistribute it and/or modify   *
+*   it under the terms of the GNU General Public License as published by   *
+*   the Free Software Foundation; either version 2 of the License, or      *
+*   (at your option) any later version.                                    *
+*                                                                          *
+***************************************************************************/
+
+#ifndef QGSCOMPACTGRAPHH
+#define QGSCOMPACTGRAPHH
+
+// QT4 includes
+#include <QVector>
+
+// QGIS includes
+#include "qgspoint.h"
+
+class QgsGraph;
+
+/**
+ * \ingroup networkanalysis
+ * \class QgsCompactGraph
+ * \brief Read-only graph stored in compressed sparse row form.
+ *
+ * Outgoing arcs of a vertex are stored next to each other and arc costs are kept
+ * in plain arrays of doubles (one array per arc property). Shortest path searches
+ * on this representation neither copy arc lists nor convert QVariant properties
+ * for every relaxed arc, which makes them considerably faster on large networks.
+ *
+ * Arcs are addressed by their position in the compact graph. The index of the
+ * arc in the source QgsGraph is available through arcId().
+ *
+ * \note added in QGIS 2.14
+ */
+class ANALYSIS_EXPORT QgsCompactGraph
+{
+  public:
+    /**
+     * Create an empty graph
+     */
+    QgsCompactGraph();
+
+    /**
+     * Create compact copy of a graph. All arc properties are converted to double,
+     * properties that can not be converted get zero cost.
+     * @param graph source graph
+     */
+    explicit QgsCompactGraph( const QgsGraph* graph );
+
+    /**
+     * return vertex count
+     */
+    int vertexCount() const { return mVertexX.size(); }
+
+    /**
+     * return arc count
+     */
+    int arcCount() const { return mArcInVertex.size(); }
+
+    /**
+     * return number of cost columns (arc properties)
+     */
+    int criterionCount() const { return mCosts.size(); }
+
+    /**
+     * return point of the vertex
+     */
+    QgsPoint vertexPoint( int vertexIdx ) const { return QgsPoint( mVertexX[ vertexIdx ], mVertexY[ vertexIdx ] ); }
+
+    /**
+     * return x coordinate of the vertex
+     */
+    double vertexX( int vertexIdx ) const { return mVertexX[ vertexIdx ]; }
+
+    /**
+     * return y coordinate of the vertex
+     */
+    double vertexY( int vertexIdx ) const { return mVertexY[ vertexIdx ]; }
+
+    /**
+     * return position of the first outgoing arc of the vertex
+     */
+    int outArcBegin( int vertexIdx ) const { return mOutArcStart[ vertexIdx ]; }
+
+    /**
+     * return position after the last outgoing arc of the vertex
+     */
+    int outArcEnd( int vertexIdx ) const { return mOutArcStart[ vertexIdx + 1 ]; }
+
+    /**
+     * return index of incoming vertex of the arc at given position
+     */
+    int arcInVertex( int arcPos ) const { return mArcInVertex[ arcPos ]; }
+
+    /**
+     * return index of outgoing vertex of the arc at given position
+     */
+    int arcOutVertex( int arcPos ) const { return mArcOutVertex[ arcPos ]; }
+
+    /**
+     * return index of the arc in the source graph
+     */
+    int arcId( int arcPos ) const { return mArcId[ arcPos ]; }
+
+    /**
+     * return cost of the arc at given position, 0 if the arc has no such property
+     * @param arcPos position of the arc
+     * @param criterionNum index of arc property
+     */
+    double arcCost( int arcPos, int criterionNum ) const { return hasCriterion( criterionNum ) ? mCosts[ criterionNum ][ arcPos ] : 0.0; }
+
+    /**
+     * return costs of all arcs (ordered by arc position) for the criterion,
+     * NULL if no arc of the graph has such property
+     * @note not available in python bindings
+     */
+    const double* costs( int criterionNum ) const { return hasCriterion( criterionNum ) ? mCosts[ criterionNum ].constData() : NULL; }
+
+    /**
+     * return whether criterionNum is a valid index of arc property
+     */
+    bool hasCriterion( int criterionNum ) const { return criterionNum >= 0 && criterionNum < mCosts.size(); }
+
+    /**
+     * find vertex by point
+     * \return vertex index
+     */
+    int findVertex( const QgsPoint& pt ) const;
+
+  private:
+    QVector<double> mVertexX;
+    QVector<double> mVertexY;
+
+    //! start of outgoing arcs for each vertex (vertexCount() + 1 items)
+    QVector<int> mOutArcStart;
+
+    QVector<int> mArcInVertex;
+    QVector<int> mArcOutVertex;
+    QVector<int> mArcId;
+
+    //! cost columns - one for each arc property
+    QVector< QVector<double> > mCosts;
+};
+
+#endif //QGSCOMPACTGRAPHH
@@ -15,17 +15,236 @@
  *                                                                         *
  ***************************************************************************/
 // C++ standard includes
+#include <algorithm>
+#include <cmath>
+#include <functional>
 #include <limits>
+#include <queue>
+#include <vector>
 
 // QT includes
-#include <QMap>
 #include <QVector>
 #include <QPair>
+#include <QThread>
+#include <QtConcurrentMap>
 
 //QGIS-uncludes
 #include "qgsgraph.h"
+#include "qgscompactgraph.h"
 #include "qgsgraphanalyzer.h"
 
+// pair of cost and vertex index
+typedef std::pair<double, int> QueueItem;
+
+// binary min-heap of vertices to visit. Vertices are not removed when their cost
+// decreases - outdated items are skipped when they are taken from the queue
+typedef std::priority_queue< QueueItem, std::vector< QueueItem >, std::greater< QueueItem > > VertexQueue;
+
+namespace
+{
+  /**
+   * Returns costs of arcs for the criterion. Arcs without the property cost nothing (as in
+   * QgsCompactGraph::arcCost()), if no arc has the property the costs are kept in zeroCosts.
+   */
+  const double* criterionCosts( const QgsCompactGraph* source, int criterionNum, QVector<double>& zeroCosts )
+  {
+    if ( source->hasCriterion( criterionNum ) )
+      return source->costs( criterionNum );
+
+    zeroCosts.fill( 0.0, source->arcCount() );
+    return zeroCosts.constData();
+  }
+
+  /**
+   * State of a dijkstra search on a compact graph that is reused between searches.
+   * Only vertices touched by the previous search are reset, so a workspace
+   * can run many searches without allocating or clearing full size arrays.
+   */
+  class DijkstraWorkspace
+  {
+    public:
+      explicit DijkstraWorkspace( int vertexCount )
+          : mCost( vertexCount, std::numeric_limits<double>::infinity() )
+      {
+      }
+
+      /**
+       * Run search from the origin. Arcs leading over maxCost are not followed.
+       * If targets are given, the search stops once all targetCount of them are settled.
+       * Settled vertices are appended to settled list in order of increasing cost.
+       */
+      void run( const QgsCompactGraph* source, const double* arcCosts, int origin, double maxCost,
+                const QVector<bool>* targets, int targetCount, QVector<int>* settled = NULL )
+      {
+        reset();
+
+        double* cost = mCost.data();
+        cost[ origin ] = 0.0;
+        mTouched.push_back( origin );
+        mHeap.push_back( QueueItem( 0.0, origin ) );
+
+        while ( !mHeap.empty() )
+        {
+          std::pop_heap( mHeap.begin(), mHeap.end(), std::greater< QueueItem >() );
+          double curCost = mHeap.back().first;
+          int curVertex = mHeap.back().second;
+          mHeap.pop_back();
+
+          // skip outdated queue items
+          if ( curCost > cost[ curVertex ] )
+            continue;
+
+          if ( settled )
+            settled->append( curVertex );
+
+          if ( targets && ( *targets )[ curVertex ] && --targetCount == 0 )
+            break;
+
+          int end = source->outArcEnd( curVertex );
+          for ( int arcPos = source->outArcBegin( curVertex ); arcPos < end; ++arcPos )
+          {
+            int inVertex = source->arcInVertex( arcPos );
+            double newCost = curCost + arcCosts[ arcPos ];
+            if ( newCost < cost[ inVertex ] && newCost <= maxCost )
+            {
+              if ( cost[ inVertex ] == std::numeric_limits<double>::infinity() )
+                mTouched.push_back( inVertex );
+              cost[ inVertex ] = newCost;
+              mHeap.push_back( QueueItem( newCost, inVertex ) );
+              std::push_heap( mHeap.begin(), mHeap.end(), std::greater< QueueItem >() );
+            }
+          }
+        }
+      }
+
+      //! cost of the vertex found by the last search (not final for vertices that were not settled)
+      double cost( int vertexIdx ) const { return mCost[ vertexIdx ]; }
+
+    private:
+      void reset()
+      {
+        for ( std::vector<int>::const_iterator it = mTouched.begin(); it != mTouched.end(); ++it )
+          mCost[ *it ] = std::numeric_limits<double>::infinity();
+        mTouched.clear();
+        mHeap.clear();
+      }
+
+      QVector<double> mCost;
+      //! vertices with finite cost (std::vector keeps its capacity when cleared)
+      std::vector<int> mTouched;
+      std::vector< QueueItem > mHeap;
+  };
+
+  //! continuous range of origins processed by one job
+  struct OriginBatch
+  {
+    int begin;
+    int end;
+  };
+
+  /**
+   * Split origins into batches. There are several batches per thread to balance the load,
+   * but each batch is large enough to amortize allocation of its workspace.
+   */
+  QList< OriginBatch > originBatches( int originCount )
+  {
+    int batchCount = qMax( 1, QThread::idealThreadCount() * 4 );
+    int batchSize = qMax( 1, ( originCount + batchCount - 1 ) / batchCount );
+
+    QList< OriginBatch > batches;
+    for ( int begin = 0; begin < originCount; begin += batchSize )
+    {
+      OriginBatch batch;
+      batch.begin = begin;
+      batch.end = qMin( originCount, begin + batchSize );
+      batches << batch;
+    }
+    return batches;
+  }
+
+  //! fills rows of the cost matrix for a batch of origins
+  class CostMatrixWrapper
+  {
+    public:
+      CostMatrixWrapper( const QgsCompactGraph* source, const double* arcCosts, const QVector<int>& origins, const QVector<int>& destinations,
+                         const QVector<bool>& targets, int targetCount, double maxCost, double* result )
+          : mSource( source )
+          , mArcCosts( arcCosts )
+          , mOrigins( origins )
+          , mDestinations( destinations )
+          , mTargets( targets )
+          , mTargetCount( targetCount )
+          , mMaxCost( maxCost )
+          , mResult( result )
+      {}
+
+      void operator()( const OriginBatch& batch )
+      {
+        DijkstraWorkspace workspace( mSource->vertexCount() );
+        int destinationCount = mDestinations.size();
+        for ( int i = batch.begin; i < batch.end; ++i )
+        {
+          workspace.run( mSource, mArcCosts, mOrigins[i], mMaxCost, &mTargets, mTargetCount );
+
+          double* row = mResult + static_cast< qint64 >( i ) * destinationCount;
+          for ( int j = 0; j < destinationCount; ++j )
+            row[j] = workspace.cost( mDestinations[j] );
+        }
+      }
+
+    private:
+      const QgsCompactGraph* mSource;
+      const double* mArcCosts;
+      const QVector<int>& mOrigins;
+      const QVector<int>& mDestinations;
+      const QVector<bool>& mTargets;
+      int mTargetCount;
+      double mMaxCost;
+      double* mResult;
+  };
+
+  //! collects reachable vertices for a batch of origins
+  class ServiceAreaWrapper
+  {
+    public:
+      ServiceAreaWrapper( const QgsCompactGraph* source, const double* arcCosts, const QVector<int>& origins, double maxCost,
+                          QVector<int>* resultVertices, QVector<double>* resultCosts )
+          : mSource( source )
+          , mArcCosts( arcCosts )
+          , mOrigins( origins )
+          , mMaxCost( maxCost )
+          , mResultVertices( resultVertices )
+          , mResultCosts( resultCosts )
+      {}
+
+      void operator()( const OriginBatch& batch )
+      {
+        DijkstraWorkspace workspace( mSource->vertexCount() );
+        for ( int i = batch.begin; i < batch.end; ++i )
+        {
+          QVector<int>& vertices = mResultVertices[i];
+          workspace.run( mSource, mArcCosts, mOrigins[i], mMaxCost, NULL, 0, &vertices );
+
+          if ( mResultCosts )
+          {
+            QVector<double>& costs = mResultCosts[i];
+            costs.resize( vertices.size() );
+            for ( int j = 0; j < vertices.size(); ++j )
+              costs[j] = workspace.cost( vertices[j] );
+          }
+        }
+      }
+
+    private:
+      const QgsCompactGraph* mSource;
+      const double* mArcCosts;
+      const QVector<int>& mOrigins;
+      double mMaxCost;
+      QVector<int>* mResultVertices;
+      QVector<double>* mResultCosts;
+  };
+}
+
 void QgsGraphAnalyzer::dijkstra( const QgsGraph* source, int startPointIdx, int criterionNum, QVector<int>* resultTree, QVector<double>* resultCost )
 {
   QVector< double > * result = NULL;
@@ -48,26 +267,25 @@ void QgsGraphAnalyzer::dijkstra( const QgsGraph* source, int startPointIdx, int
     resultTree->insert( resultTree->begin(), source->vertexCount(), -1 );
   }
 
-  // QMultiMap< cost, vertexIdx > not_begin
-  // I use it and not create any struct or class.
-  QMultiMap< double, int > not_begin;
-  QMultiMap< double, int >::iterator it;
-
-  not_begin.insert( 0.0, startPointIdx );
+  VertexQueue not_begin;
+  not_begin.push( QueueItem( 0.0, startPointIdx ) );
 
   while ( !not_begin.empty() )
   {
-    it = not_begin.begin();
-    double curCost = it.key();
-    int curVertex = it.value();
-    not_begin.erase( it );
+    double curCost = not_begin.top().first;
+    int curVertex = not_begin.top().second;
+    not_begin.pop();
+
+    // skip outdated queue items
+    if ( curCost > ( *result )[ curVertex ] )
+      continue;
 
     // edge index list
-    QgsGraphArcIdList l = source->vertex( curVertex ).outArc();
-    QgsGraphArcIdList::iterator arcIt;
-    for ( arcIt = l.begin(); arcIt != l.end(); ++arcIt )
+    const QgsGraphArcIdList l = source->vertex( curVertex ).outArc();
+    QgsGraphArcIdList::const_iterator arcIt;
+    for ( arcIt = l.constBegin(); arcIt != l.constEnd(); ++arcIt )
     {
-      const QgsGraphArc arc = source->arc( *arcIt );
+      const QgsGraphArc& arc = source->arc( *arcIt );
       double cost = arc.property( criterionNum ).toDouble() + curCost;
 
       if ( cost < ( *result )[ arc.inVertex()] )
@@ -77,7 +295,7 @@ void QgsGraphAnalyzer::dijkstra( const QgsGraph* source, int startPointIdx, int
         {
           ( *resultTree )[ arc.inVertex()] = *arcIt;
         }
-        not_begin.insert( cost, arc.inVertex() );
+        not_begin.push( QueueItem( cost, arc.inVertex() ) );
       }
     }
   }
@@ -87,6 +305,170 @@ void QgsGraphAnalyzer::dijkstra( const QgsGraph* source, int startPointIdx, int
   }
 }
 
+void QgsGraphAnalyzer::dijkstra( const QgsCompactGraph* source, int startVertexIdx, int criterionNum, QVector<int>* resultTree, QVector<double>* resultCost )
+{
+  QVector< double > localCost;
+  QVector< double >& cost = resultCost ? *resultCost : localCost;
+
+  cost.fill( std::numeric_limits<double>::infinity(), source->vertexCount() );
+  cost[ startVertexIdx ] = 0.0;
+
+  if ( resultTree )
+    resultTree->fill( -1, source->vertexCount() );
+
+  QVector<double> zeroCosts;
+  const double* arcCosts = criterionCosts( source, criterionNum, zeroCosts );
+  double* vertexCosts = cost.data();
+
+  VertexQueue queue;
+  queue.push( QueueItem( 0.0, startVertexIdx ) );
+
+  while ( !queue.empty() )
+  {
+    double curCost = queue.top().first;
+    int curVertex = queue.top().second;
+    queue.pop();
+
+    // skip outdated queue items
+    if ( curCost > vertexCosts[ curVertex ] )
+      continue;
+
+    int end = source->outArcEnd( curVertex );
+    for ( int arcPos = source->outArcBegin( curVertex ); arcPos < end; ++arcPos )
+    {
+      int inVertex = source->arcInVertex( arcPos );
+      double newCost = curCost + arcCosts[ arcPos ];
+      if ( newCost < vertexCosts[ inVertex ] )
+      {
+        vertexCosts[ inVertex ] = newCost;
+        if ( resultTree )
+          ( *resultTree )[ inVertex ] = source->arcId( arcPos );
+        queue.push( QueueItem( newCost, inVertex ) );
+      }
+    }
+  }
+}
+
+double QgsGraphAnalyzer::aStar( const QgsCompactGraph* source, int startVertexIdx, int endVertexIdx, int criterionNum, QVector<int>* resultPath, double heuristicFactor )
+{
+  if ( resultPath )
+    resultPath->clear();
+
+  int vertexCount = source->vertexCount();
+  QVector<double> cost( vertexCount, std::numeric_limits<double>::infinity() );
+  QVector<int> previous( vertexCount, -1 );
+  QVector<bool> closed( vertexCount, false );
+
+  QVector<double> zeroCosts;
+  const double* arcCosts = criterionCosts( source, criterionNum, zeroCosts );
+  double endX = source->vertexX( endVertexIdx );
+  double endY = source->vertexY( endVertexIdx );
+
+  cost[ startVertexIdx ] = 0.0;
+
+  // queue is ordered by estimated total cost (cost so far + heuristic)
+  VertexQueue queue;
+  queue.push( QueueItem( 0.0, startVertexIdx ) );
+
+  while ( !queue.empty() )
+  {
+    int curVertex = queue.top().second;
+    queue.pop();
+
+    if ( closed[ curVertex ] )
+      continue;
+    closed[ curVertex ] = true;
+
+    if ( curVertex == endVertexIdx )
+      break;
+
+    double curCost = cost[ curVertex ];
+    int end = source->outArcEnd( curVertex );
+    for ( int arcPos = source->outArcBegin( curVertex ); arcPos < end; ++arcPos )
+    {
+      int inVertex = source->arcInVertex( arcPos );
+      if ( closed[ inVertex ] )
+        continue;
+
+      double newCost = curCost + arcCosts[ arcPos ];
+      if ( newCost < cost[ inVertex ] )
+      {
+        cost[ inVertex ] = newCost;
+        previous[ inVertex ] = curVertex;
+
+        double dx = source->vertexX( inVertex ) - endX;
+        double dy = source->vertexY( inVertex ) - endY;
+        queue.push( QueueItem( newCost + heuristicFactor * sqrt( dx * dx + dy * dy ), inVertex ) );
+      }
+    }
+  }
+
+  if ( resultPath && closed[ endVertexIdx ] )
+  {
+    for ( int v = endVertexIdx; v != -1; v = previous[ v ] )
+      resultPath->append( v );
+    std::reverse( resultPath->begin(), resultPath->end() );
+  }
+
+  return cost[ endVertexIdx ];
+}
+
+QVector<double> QgsGraphAnalyzer::costMatrix( const QgsCompactGraph* source, const QVector<int>& origins, const QVector<int>& destinations, int criterionNum, double maxCost )
+{
+  // the size of a QVector is an int, its allocation in bytes too
+  qint64 entryCount = static_cast< qint64 >( origins.size() ) * destinations.size();
+  if ( entryCount > static_cast< qint64 >( std::numeric_limits<int>::max() / sizeof( double ) ) )
+    return QVector<double>();
+
+  QVector<double> result( static_cast< int >( entryCount ), std::numeric_limits<double>::infinity() );
+  if ( result.isEmpty() )
+    return result;
+
+  if ( maxCost < 0 )
+    maxCost = std::numeric_limits<double>::infinity();
+
+  // searches may stop once all (distinct) destinations are settled
+  QVector<bool> targets( source->vertexCount(), false );
+  int targetCount = 0;
+  Q_FOREACH ( int v, destinations )
+  {
+    if ( !targets[v] )
+    {
+      targets[v] = true;
+      ++targetCount;
+    }
+  }
+
+  // rows are filled through a raw pointer, the vector is detached before it is shared by the threads
+  QVector<double> zeroCosts;
+  const double* arcCosts = criterionCosts( source, criterionNum, zeroCosts );
+
+  QList< OriginBatch > batches = originBatches( origins.size() );
+  QtConcurrent::blockingMap( batches, CostMatrixWrapper( source, arcCosts, origins, destinations, targets, targetCount, maxCost, result.data() ) );
+  return result;
+}
+
+void QgsGraphAnalyzer::serviceAreas( const QgsCompactGraph* source, const QVector<int>& origins, int criterionNum, double maxCost,
+                                     QVector< QVector<int> >* resultVertices, QVector< QVector<double> >* resultCosts )
+{
+  if ( !resultVertices )
+    return;
+
+  resultVertices->clear();
+  resultVertices->resize( origins.size() );
+  if ( resultCosts )
+  {
+    resultCosts->clear();
+    resultCosts->resize( origins.size() );
+  }
+
+  QVector<double> zeroCosts;
+  const double* arcCosts = criterionCosts( source, criterionNum, zeroCosts );
+
+  QList< OriginBatch > batches = originBatches( origins.size() );
+  QtConcurrent::blockingMap( batches, ServiceAreaWrapper( source, arcCosts, origins, maxCost, resultVertices->data(), resultCosts ? resultCosts->data() : NULL ) );
+}
+
 QgsGraph* QgsGraphAnalyzer::shortestTree( const QgsGraph* source, int startVertexIdx, int criterionNum )
 {
   QgsGraph *treeResult = new QgsGraph();
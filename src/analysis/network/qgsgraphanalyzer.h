@@ -23,6 +23,7 @@
 
 // forward-declaration
 class QgsGraph;
+class QgsCompactGraph;
 
 /** \ingroup networkanalysis
  * The QGis class provides graph analysis functions
@@ -48,5 +49,63 @@ class ANALYSIS_EXPORT QgsGraphAnalyzer
      * @param criterionNum index of edge property as optimization criterion
      */
     static QgsGraph* shortestTree( const QgsGraph* source, int startVertexIdx, int criterionNum );
+
+    /**
+     * solve shortest path problem using dijkstra algorithm on a compact graph
+     * @param source The source graph
+     * @param startVertexIdx index of start vertex
+     * @param criterionNum index of arc property as optimization criterion
+     * @param resultTree array represents the shortest path tree. resultTree[ vertexIndex ] == inboundingArcIndex (index of the arc in the graph the compact graph has been created from) if vertex reacheble and resultTree[ vertexIndex ] == -1 others.
+     * @param resultCost array of cost paths
+     * @note added in QGIS 2.14
+     */
+    static void dijkstra( const QgsCompactGraph* source, int startVertexIdx, int criterionNum, QVector<int>* resultTree = NULL, QVector<double>* resultCost = NULL );
+
+    /**
+     * find the shortest path between two vertices using A* search with euclidean distance heuristic.
+     * The heuristic is admissible only if cost of every arc is at least heuristicFactor times its
+     * euclidean length (e.g. heuristicFactor = 1 for length of arcs in map units). Zero factor makes
+     * the search equal to dijkstra algorithm stopped at the end vertex.
+     * @param source The source graph
+     * @param startVertexIdx index of start vertex
+     * @param endVertexIdx index of end vertex
+     * @param criterionNum index of arc property as optimization criterion
+     * @param resultPath indices of vertices on the path (starting with startVertexIdx), empty if end vertex is not reachable
+     * @param heuristicFactor lower bound of arc cost per map unit
+     * @return cost of the path or infinity if end vertex is not reachable
+     * @note added in QGIS 2.14
+     */
+    static double aStar( const QgsCompactGraph* source, int startVertexIdx, int endVertexIdx, int criterionNum, QVector<int>* resultPath = NULL, double heuristicFactor = 1.0 );
+
+    /**
+     * compute matrix of shortest path costs between origins and destinations. Origins are processed
+     * in parallel, each search stops as soon as all destinations are reached or cost of the
+     * remaining vertices exceeds maxCost.
+     * @param source The source graph
+     * @param origins indices of origin vertices
+     * @param destinations indices of destination vertices
+     * @param criterionNum index of arc property as optimization criterion
+     * @param maxCost maximal cost of the path, negative value means no limit
+     * @return row-major matrix with origins.size() rows and destinations.size() columns. Destinations
+     * that are not reachable (or not reachable within maxCost) have infinite cost. The matrix is empty
+     * if it has too many entries to be held in a QVector.
+     * @note added in QGIS 2.14
+     */
+    static QVector<double> costMatrix( const QgsCompactGraph* source, const QVector<int>& origins, const QVector<int>& destinations, int criterionNum, double maxCost = -1 );
+
+    /**
+     * find all vertices reachable from each of the origins within the cost limit (service areas / isochrones).
+     * Origins are processed in parallel.
+     * @param source The source graph
+     * @param origins indices of origin vertices
+     * @param criterionNum index of arc property as optimization criterion
+     * @param maxCost maximal cost of the path
+     * @param resultVertices for each origin indices of reachable vertices in order of increasing cost
+     * @param resultCosts for each origin cost of the reachable vertices (matching resultVertices)
+     * @note added in QGIS 2.14
+     * @note not available in python bindings
+     */
+    static void serviceAreas( const QgsCompactGraph* source, const QVector<int>& origins, int criterionNum, double maxCost,
+                              QVector< QVector<int> >* resultVertices, QVector< QVector<double> >* resultCosts = NULL );
 };
 #endif //QGSGRAPHANALYZERH
@@ -24,63 +24,57 @@
 #include <qgsgeometry.h>
 #include <qgsdistancearea.h>
 
+#include <qgsspatialindex.h>
+
 // QT includes
 #include <QString>
+#include <QHash>
 #include <QtAlgorithms>
 
 //standard includes
 #include <limits>
 #include <algorithm>
+#include <cstring>
 
-class QgsPointCompare
+namespace
 {
-  public:
-    explicit QgsPointCompare( double tolerance )
-        : mTolerance( tolerance )
-    {  }
-
-    bool operator()( const QgsPoint& p1, const QgsPoint& p2 ) const
+  /**
+   * Key of a graph vertex. Points are merged on a grid with cell size equal to the topology
+   * tolerance (or must be equal if there is no tolerance), so vertices can be looked up in a hash.
+   */
+  struct VertexKey
+  {
+    VertexKey( const QgsPoint& pt, double tolerance )
     {
-      if ( mTolerance <= 0 )
-        return p1.x() == p2.x() ? p1.y() < p2.y() : p1.x() < p2.x();
-
-      double tx1 = ceil( p1.x() / mTolerance );
-      double tx2 = ceil( p2.x() / mTolerance );
-      if ( tx1 == tx2 )
-        return ceil( p1.y() / mTolerance ) < ceil( p2.y() / mTolerance );
-      return tx1 < tx2;
+      if ( tolerance <= 0 )
+      {
+        // adding zero turns negative zero to positive zero - they have to give the same hash
+        x = pt.x() + 0.0;
+        y = pt.y() + 0.0;
+      }
+      else
+      {
+        x = ceil( pt.x() / tolerance ) + 0.0;
+        y = ceil( pt.y() / tolerance ) + 0.0;
+      }
     }
 
-  private:
-    double mTolerance;
-};
+    bool operator==( const VertexKey& other ) const
+    {
+      return x == other.x && y == other.y;
+    }
 
-template <typename RandIter, typename Type, typename CompareOp > RandIter my_binary_search( RandIter begin, RandIter end, Type val, CompareOp comp )
-{
-  // result if not found
-  RandIter not_found = end;
+    double x;
+    double y;
+  };
 
-  while ( true )
+  uint qHash( const VertexKey& key )
   {
-    RandIter avg = begin + ( end - begin ) / 2;
-    if ( begin == avg || end == avg )
-    {
-      if ( !comp( *begin, val ) && !comp( val, *begin ) )
-        return begin;
-      if ( !comp( *end, val ) && !comp( val, *end ) )
-        return end;
-
-      return not_found;
-    }
-    if ( comp( val, *avg ) )
-      end = avg;
-    else if ( comp( *avg, val ) )
-      begin = avg;
-    else
-      return avg;
+    quint64 bits[2];
+    memcpy( &bits[0], &key.x, sizeof( double ) );
+    memcpy( &bits[1], &key.y, sizeof( double ) );
+    return ::qHash( bits[0] ) ^( ::qHash( bits[1] ) * 31 );
   }
-
-  return not_found;
 }
 
 struct TiePointInfo
@@ -158,9 +152,13 @@ void QgsLineVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, c
   //Graph's points;
   QVector< QgsPoint > points;
 
+  // segments of the lines - index of the first point of the segment in 'points'
+  QVector< int > segments;
+  QgsSpatialIndex segmentIndex;
+
   QgsFeatureIterator fit = vl->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() ) );
 
-  // begin: tie points to the graph
+  // begin: collect points and segments of the graph
   QgsAttributeList la;
   QgsFeature feature;
   while ( fit.nextFeature( feature ) )
@@ -174,52 +172,76 @@ void QgsLineVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, c
     QgsMultiPolyline::iterator mplIt;
     for ( mplIt = mpl.begin(); mplIt != mpl.end(); ++mplIt )
     {
-      QgsPoint pt1, pt2;
       bool isFirstPoint = true;
       QgsPolyline::iterator pointIt;
       for ( pointIt = mplIt->begin(); pointIt != mplIt->end(); ++pointIt )
       {
-        pt2 = ct.transform( *pointIt );
+        QgsPoint pt2 = ct.transform( *pointIt );
         points.push_back( pt2 );
 
-        if ( !isFirstPoint )
+        if ( !isFirstPoint && !additionalPoints.isEmpty() )
         {
-          int i = 0;
-          for ( i = 0; i != additionalPoints.size(); ++i )
-          {
-            TiePointInfo info;
-            if ( pt1 == pt2 )
-            {
-              info.mLength = additionalPoints[ i ].sqrDist( pt1 );
-              info.mTiedPoint = pt1;
-            }
-            else
-            {
-              info.mLength = additionalPoints[ i ].sqrDistToSegment( pt1.x(), pt1.y(),
-                             pt2.x(), pt2.y(), info.mTiedPoint );
-            }
-
-            if ( pointLengthMap[ i ].mLength > info.mLength )
-            {
-              Q_UNUSED( info.mTiedPoint );
-              info.mFirstPoint = pt1;
-              info.mLastPoint = pt2;
-
-              pointLengthMap[ i ] = info;
-              tiedPoint[ i ] = info.mTiedPoint;
-            }
-          }
+          const QgsPoint& pt1 = points[ points.size() - 2 ];
+          segmentIndex.insertFeature( segments.size(), QgsRectangle( pt1, pt2 ) );
+          segments.push_back( points.size() - 2 );
         }
-        pt1 = pt2;
         isFirstPoint = false;
       }
     }
     emit buildProgress( ++step, featureCount );
   }
+  // end: collect points and segments
+
+  // begin: tie points to the graph
+  int i = 0;
+  for ( i = 0; i < additionalPoints.size() && !segments.isEmpty(); ++i )
+  {
+    const QgsPoint& pt = additionalPoints[ i ];
+
+    // the nearest segment by bounding box gives an upper bound of the distance,
+    // the nearest segment has to intersect the square around the point
+    QList<QgsFeatureId> candidates = segmentIndex.nearestNeighbor( pt, 1 );
+    if ( candidates.isEmpty() )
+      continue;
+
+    QgsPoint tmpPoint;
+    const QgsPoint& nearestPt1 = points[ segments[ candidates.first()]];
+    const QgsPoint& nearestPt2 = points[ segments[ candidates.first()] + 1 ];
+    double dist = sqrt( pt.sqrDistToSegment( nearestPt1.x(), nearestPt1.y(), nearestPt2.x(), nearestPt2.y(), tmpPoint ) );
+
+    candidates = segmentIndex.intersects( QgsRectangle( pt.x() - dist, pt.y() - dist, pt.x() + dist, pt.y() + dist ) );
+    // keep the first segment of the layer in case of equal distances
+    qSort( candidates );
+
+    Q_FOREACH ( QgsFeatureId segmentId, candidates )
+    {
+      const QgsPoint& pt1 = points[ segments[ segmentId ] ];
+      const QgsPoint& pt2 = points[ segments[ segmentId ] + 1 ];
+
+      TiePointInfo info;
+      if ( pt1 == pt2 )
+      {
+        info.mLength = pt.sqrDist( pt1 );
+        info.mTiedPoint = pt1;
+      }
+      else
+      {
+        info.mLength = pt.sqrDistToSegment( pt1.x(), pt1.y(), pt2.x(), pt2.y(), info.mTiedPoint );
+      }
+
+      if ( pointLengthMap[ i ].mLength > info.mLength )
+      {
+        info.mFirstPoint = pt1;
+        info.mLastPoint = pt2;
+
+        pointLengthMap[ i ] = info;
+        tiedPoint[ i ] = info.mTiedPoint;
+      }
+    }
+  }
   // end: tie points to graph
 
   // add tied point to graph
-  int i = 0;
   for ( i = 0; i < tiedPoint.size(); ++i )
   {
     if ( tiedPoint[ i ] != QgsPoint( 0.0, 0.0 ) )
@@ -228,17 +250,31 @@ void QgsLineVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, c
     }
   }
 
-  QgsPointCompare pointCompare( builder->topologyTolerance() );
-
-  qSort( points.begin(), points.end(), pointCompare );
-  QVector< QgsPoint >::iterator tmp = std::unique( points.begin(), points.end() );
-  points.resize( tmp - points.begin() );
+  // merge points within topology tolerance - the first point in a grid cell represents the vertex
+  double tolerance = builder->topologyTolerance();
+  QHash< VertexKey, int > vertexIds;
+  QVector< QgsPoint > vertices;
+  vertexIds.reserve( points.size() );
+  Q_FOREACH ( const QgsPoint& pt, points )
+  {
+    VertexKey key( pt, tolerance );
+    if ( !vertexIds.contains( key ) )
+    {
+      vertexIds.insert( key, vertices.size() );
+      vertices.push_back( pt );
+    }
+  }
+  points.clear();
 
-  for ( i = 0;i < points.size();++i )
-    builder->addVertex( i, points[ i ] );
+  for ( i = 0; i < vertices.size(); ++i )
+    builder->addVertex( i, vertices[ i ] );
 
   for ( i = 0; i < tiedPoint.size() ; ++i )
-    tiedPoint[ i ] = *( my_binary_search( points.begin(), points.end(), tiedPoint[ i ], pointCompare ) );
+  {
+    int idx = vertexIds.value( VertexKey( tiedPoint[ i ], tolerance ), -1 );
+    if ( idx != -1 )
+      tiedPoint[ i ] = vertices[ idx ];
+  }
 
   qSort( pointLengthMap.begin(), pointLengthMap.end(), TiePointInfoCompare );
 
@@ -326,25 +362,13 @@ void QgsLineVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, c
           t.mFirstPoint = pt1;
           t.mLastPoint  = pt2;
           t.mLength = 0.0;
-          pointLengthIt = my_binary_search( pointLengthMap.begin(), pointLengthMap.end(), t, TiePointInfoCompare );
 
-          if ( pointLengthIt != pointLengthMap.end() )
+          // tie points of the segment are next to each other in the sorted list
+          std::pair< QVector< TiePointInfo >::iterator, QVector< TiePointInfo >::iterator > range;
+          range = std::equal_range( pointLengthMap.begin(), pointLengthMap.end(), t, TiePointInfoCompare );
+          for ( pointLengthIt = range.first; pointLengthIt != range.second; ++pointLengthIt )
           {
-            QVector< TiePointInfo >::iterator it;
-            for ( it = pointLengthIt; it - pointLengthMap.begin() >= 0; --it )
-            {
-              if ( it->mFirstPoint == pt1 && it->mLastPoint == pt2 )
-              {
-                pointsOnArc[ pt1.sqrDist( it->mTiedPoint )] = it->mTiedPoint;
-              }
-            }
-            for ( it = pointLengthIt + 1; it != pointLengthMap.end(); ++it )
-            {
-              if ( it->mFirstPoint == pt1 && it->mLastPoint == pt2 )
-              {
-                pointsOnArc[ pt1.sqrDist( it->mTiedPoint )] = it->mTiedPoint;
-              }
-            }
+            pointsOnArc[ pt1.sqrDist( pointLengthIt->mTiedPoint )] = pointLengthIt->mTiedPoint;
           }
 
           std::map< double, QgsPoint >::iterator pointsIt;
@@ -354,10 +378,8 @@ void QgsLineVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, c
           bool isFirstPoint = true;
           for ( pointsIt = pointsOnArc.begin(); pointsIt != pointsOnArc.end(); ++pointsIt )
           {
-            pt2 = pointsIt->second;
-            tmp = my_binary_search( points.begin(), points.end(), pt2, pointCompare );
-            pt2 = *tmp;
-            pt2idx = tmp - points.begin();
+            pt2idx = vertexIds.value( VertexKey( pointsIt->second, tolerance ) );
+            pt2 = vertices[ pt2idx ];
 
             if ( !isFirstPoint && pt1 != pt2 )
             {
@@ -18,6 +18,107 @@
 #include "qgsgeometry.h"
 #include "qgslogger.h"
 
+#include <QtAlgorithms>
+#include <limits>
+
+
+namespace
+{
+  /**
+   * Locations of all nodes of the database, sorted by node id. Used to build
+   * the geometries of ways without querying the nodes table for every way.
+   */
+  class NodeLocations
+  {
+    public:
+      //! Reads all nodes, returns false if they do not fit into memory or cannot be read
+      bool load( sqlite3* database, int count )
+      {
+        if ( count < 0 || count > std::numeric_limits<int>::max() / ( int ) sizeof( QgsPoint ) )
+          return false;
+
+        sqlite3_stmt* stmt;
+        if ( sqlite3_prepare_v2( database, "SELECT id,lon,lat FROM nodes ORDER BY id", -1, &stmt, 0 ) != SQLITE_OK )
+          return false;
+
+        mIds.reserve( count );
+        mPoints.reserve( count );
+        int res;
+        while (( res = sqlite3_step( stmt ) ) == SQLITE_ROW )
+        {
+          mIds.append( sqlite3_column_int64( stmt, 0 ) );
+          mPoints.append( QgsPoint( sqlite3_column_double( stmt, 1 ), sqlite3_column_double( stmt, 2 ) ) );
+        }
+
+        sqlite3_finalize( stmt );
+        if ( res != SQLITE_DONE )
+        {
+          // incomplete locations would make ways miss nodes
+          mIds.clear();
+          mPoints.clear();
+          return false;
+        }
+        return true;
+      }
+
+      bool point( QgsOSMId id, QgsPoint& point ) const
+      {
+        QVector<QgsOSMId>::const_iterator it = qLowerBound( mIds.constBegin(), mIds.constEnd(), id );
+        if ( it == mIds.constEnd() || *it != id )
+          return false;
+        point = mPoints[ it - mIds.constBegin()];
+        return true;
+      }
+
+    private:
+      QVector<QgsOSMId> mIds;
+      QVector<QgsPoint> mPoints;
+  };
+
+  /**
+   * Reads the rows of a statement ordered by the id in the first column, so that rows
+   * of ways visited in the order of their ids are read in a single pass.
+   */
+  class OrderedRows
+  {
+    public:
+      OrderedRows()
+          : mStmt( 0 )
+          , mHasRow( false )
+      {
+      }
+
+      ~OrderedRows()
+      {
+        sqlite3_finalize( mStmt );
+      }
+
+      bool prepare( sqlite3* database, const char* sql )
+      {
+        if ( sqlite3_prepare_v2( database, sql, -1, &mStmt, 0 ) != SQLITE_OK )
+          return false;
+        next();
+        return true;
+      }
+
+      //! Skips rows with lower id, returns whether the current row has the id
+      bool seek( QgsOSMId id )
+      {
+        while ( mHasRow && sqlite3_column_int64( mStmt, 0 ) < id )
+          next();
+        return mHasRow && sqlite3_column_int64( mStmt, 0 ) == id;
+      }
+
+      void next() { mHasRow = sqlite3_step( mStmt ) == SQLITE_ROW; }
+
+      sqlite3_stmt* stmt() const { return mStmt; }
+
+    private:
+      sqlite3_stmt* mStmt;
+      bool mHasRow;
+  };
+}
+
 
 QgsOSMDatabase::QgsOSMDatabase( const QString& dbFileName )
     : mDbFileName( dbFileName )
@@ -28,6 +129,7 @@ QgsOSMDatabase::QgsOSMDatabase( const QString& dbFileName )
     , mStmtWayNode( 0 )
     , mStmtWayNodePoints( 0 )
     , mStmtWayTags( 0 )
+    , mNodeLocationsInMemory( true )
 {
 }
 
@@ -459,13 +561,54 @@ void QgsOSMDatabase::exportSpatiaLiteWays( bool closed, const QString& tableName
     return;
   }
 
+  NodeLocations nodeLocations;
+  bool inMemory = mNodeLocationsInMemory && nodeLocations.load( mDatabase, countNodes() );
+  if ( mNodeLocationsInMemory && !inMemory )
+    QgsDebugMsg( "Node locations cannot be loaded into memory, querying nodes of each way." );
+
+  // nodes and tags of all ways in the order of way ids, read along with the ways
+  OrderedRows wayNodes;
+  OrderedRows wayTags;
+  if ( inMemory && ( !wayNodes.prepare( mDatabase, "SELECT way_id,node_id FROM ways_nodes ORDER BY way_id,way_pos" )
+                     || !wayTags.prepare( mDatabase, "SELECT id,k,v FROM ways_tags ORDER BY id" ) ) )
+  {
+    mError = "Prepare SELECT FROM ways_nodes failed.";
+    sqlite3_finalize( stmtInsert );
+    return;
+  }
+
   QgsOSMWayIterator ways = listWays();
   QgsOSMWay w;
   while (( w = ways.next() ).isValid() )
   {
-    QgsOSMTags t = tags( true, w.id() );
+    QgsOSMTags t;
+    QgsPolyline polyline;
 
-    QgsPolyline polyline = wayPoints( w.id() );
+    if ( inMemory )
+    {
+      for ( ; wayTags.seek( w.id() ); wayTags.next() )
+      {
+        t.insert( QString::fromUtf8(( const char* ) sqlite3_column_text( wayTags.stmt(), 1 ) ),
+                  QString::fromUtf8(( const char* ) sqlite3_column_text( wayTags.stmt(), 2 ) ) );
+      }
+
+      bool missingNode = false;
+      for ( ; wayNodes.seek( w.id() ); wayNodes.next() )
+      {
+        QgsPoint point;
+        if ( nodeLocations.point( sqlite3_column_int64( wayNodes.stmt(), 1 ), point ) )
+          polyline.append( point );
+        else
+          missingNode = true;
+      }
+      if ( missingNode )
+        polyline.clear();
+    }
+    else
+    {
+      t = tags( true, w.id() );
+      polyline = wayPoints( w.id() );
+    }
 
     if ( polyline.count() < 2 )
       continue; // invalid way
@@ -595,7 +738,7 @@ void QgsOSMNodeIterator::close()
 QgsOSMWayIterator::QgsOSMWayIterator( sqlite3* handle )
     : mStmt( 0 )
 {
-  const char* sql = "SELECT id FROM ways";
+  const char* sql = "SELECT id FROM ways ORDER BY id";
   if ( sqlite3_prepare_v2( handle, sql, -1, &mStmt, 0 ) != SQLITE_OK )
   {
     qDebug( "OSMWayIterator: error prepare" );
@@ -83,6 +83,17 @@ class ANALYSIS_EXPORT QgsOSMDatabase
                            const QStringList& tagKeys = QStringList(),
                            const QStringList& noNullTagKeys = QStringList() );
 
+    /**
+     * Sets whether the export of ways loads the locations of all nodes into memory first
+     * (about 24 bytes per node) and reads the nodes and tags of ways in one pass, instead of
+     * querying the database for every way. Much faster for large databases. Enabled by default,
+     * the export falls back to the queries if there are too many nodes to hold in memory.
+     * @note added in QGIS 2.14
+     */
+    void setNodeLocationsInMemory( bool enabled ) { mNodeLocationsInMemory = enabled; }
+    //! @note added in QGIS 2.14
+    bool nodeLocationsInMemory() const { return mNodeLocationsInMemory; }
+
   protected:
     bool prepareStatements();
     int runCountStatement( const char* sql ) const;
@@ -111,6 +122,8 @@ class ANALYSIS_EXPORT QgsOSMDatabase
     sqlite3_stmt* mStmtWayNode;
     sqlite3_stmt* mStmtWayNodePoints;
     sqlite3_stmt* mStmtWayTags;
+
+    bool mNodeLocationsInMemory;
 };
 
 
@@ -14,10 +14,13 @@
  ***************************************************************************/
 
 #include "qgsosmimport.h"
+#include "qgsosmpbfreader.h"
 #include "qgsslconnect.h"
 
 #include <QStringList>
+#include <QThread>
 #include <QXmlStreamReader>
+#include <QtConcurrentMap>
 
 
 QgsOSMXmlImport::QgsOSMXmlImport( const QString& xmlFilename, const QString& dbFilename )
@@ -70,6 +73,27 @@ bool QgsOSMXmlImport::import()
 
   // start parsing
 
+  bool res = QgsOSMPbfReader::isPbf( &mInputFile ) ? readPbf() : readXml();
+
+  int retY = sqlite3_exec( mDatabase, "COMMIT", NULL, NULL, 0 );
+  Q_ASSERT( retY == SQLITE_OK );
+  Q_UNUSED( retY );
+
+  createIndexes();
+
+  if ( !res )
+  {
+    // mError is set in readXml() / readPbf()
+    return false;
+  }
+
+  closeDatabase();
+
+  return true;
+}
+
+bool QgsOSMXmlImport::readXml()
+{
   QXmlStreamReader xml( &mInputFile );
 
   while ( !xml.atEnd() )
@@ -88,19 +112,148 @@ bool QgsOSMXmlImport::import()
     }
   }
 
-  int retY = sqlite3_exec( mDatabase, "COMMIT", NULL, NULL, 0 );
-  Q_ASSERT( retY == SQLITE_OK );
-  Q_UNUSED( retY );
-
-  createIndexes();
-
   if ( xml.hasError() )
   {
     mError = QString( "XML error: %1" ).arg( xml.errorString() );
     return false;
   }
 
-  closeDatabase();
+  return true;
+}
+
+bool QgsOSMXmlImport::readPbf()
+{
+  QgsOSMPbfReader reader( &mInputFile );
+
+  // the blobs are read and decoded in batches, a batch is decoded
+  // by the thread pool while the previous one is stored
+  int batchSize = 4 * qMax( 1, QThread::idealThreadCount() );
+  int percent = -1;
+
+  QFuture<QgsOSMPbfBlock> decoding;
+  bool decodingStarted = false;
+
+  while ( true )
+  {
+    QList<QByteArray> blobs;
+    QByteArray blob;
+    while ( blobs.size() < batchSize && reader.readBlob( blob ) )
+      blobs << blob;
+
+    QFuture<QgsOSMPbfBlock> next;
+    if ( !blobs.isEmpty() )
+      next = QtConcurrent::mapped( blobs, QgsOSMPbfReader::decodeBlob );
+
+    if ( decodingStarted )
+    {
+      QList<QgsOSMPbfBlock> blocks = decoding.results();
+      for ( int i = 0; i < blocks.size(); ++i )
+      {
+        if ( !storePbfBlock( blocks[i] ) )
+        {
+          next.waitForFinished();
+          return false;
+        }
+      }
+
+      int new_percent = 100 * mInputFile.pos() / mInputFile.size();
+      if ( new_percent > percent )
+      {
+        emit progress( new_percent );
+        percent = new_percent;
+      }
+    }
+
+    if ( reader.hasError() )
+    {
+      next.waitForFinished();
+      mError = reader.errorString();
+      return false;
+    }
+
+    if ( blobs.isEmpty() )
+      break;
+
+    decoding = next;
+    decodingStarted = true;
+  }
+
+  return true;
+}
+
+bool QgsOSMXmlImport::storePbfBlock( const QgsOSMPbfBlock& block )
+{
+  if ( !block.error.isEmpty() )
+  {
+    mError = block.error;
+    return false;
+  }
+
+  for ( int i = 0; i < block.nodeIds.size(); ++i )
+  {
+    sqlite3_bind_int64( mStmtInsertNode, 1, block.nodeIds[i] );
+    sqlite3_bind_double( mStmtInsertNode, 2, block.nodeLats[i] );
+    sqlite3_bind_double( mStmtInsertNode, 3, block.nodeLons[i] );
+
+    int res = sqlite3_step( mStmtInsertNode );
+    sqlite3_reset( mStmtInsertNode );
+    if ( res != SQLITE_DONE )
+    {
+      mError = QString( "Storing node %1 failed." ).arg( block.nodeIds[i] );
+      return false;
+    }
+  }
+
+  int wayNode = 0;
+  for ( int i = 0; i < block.wayIds.size(); ++i )
+  {
+    QgsOSMId id = block.wayIds[i];
+    sqlite3_bind_int64( mStmtInsertWay, 1, id );
+
+    int res = sqlite3_step( mStmtInsertWay );
+    sqlite3_reset( mStmtInsertWay );
+    if ( res != SQLITE_DONE )
+    {
+      mError = QString( "Storing way %1 failed." ).arg( id );
+      return false;
+    }
+
+    for ( int way_pos = 0; way_pos < block.wayNodeCounts[i]; ++way_pos, ++wayNode )
+    {
+      sqlite3_bind_int64( mStmtInsertWayNode, 1, id );
+      sqlite3_bind_int64( mStmtInsertWayNode, 2, block.wayNodeIds[wayNode] );
+      sqlite3_bind_int( mStmtInsertWayNode, 3, way_pos );
+
+      res = sqlite3_step( mStmtInsertWayNode );
+      sqlite3_reset( mStmtInsertWayNode );
+      if ( res != SQLITE_DONE )
+      {
+        mError = QString( "Storing ways_nodes %1 - %2 failed." ).arg( id ).arg( block.wayNodeIds[wayNode] );
+        return false;
+      }
+    }
+  }
+
+  for ( int way = 0; way < 2; ++way )
+  {
+    const QVector<QgsOSMPbfTag>& tags = way ? block.wayTags : block.nodeTags;
+    sqlite3_stmt* stmtInsertTag = way ? mStmtInsertWayTag : mStmtInsertNodeTag;
+
+    for ( int i = 0; i < tags.size(); ++i )
+    {
+      sqlite3_bind_int64( stmtInsertTag, 1, tags[i].id );
+      sqlite3_bind_text( stmtInsertTag, 2, tags[i].key.constData(), tags[i].key.size(), SQLITE_STATIC );
+      sqlite3_bind_text( stmtInsertTag, 3, tags[i].value.constData(), tags[i].value.size(), SQLITE_STATIC );
+
+      int res = sqlite3_step( stmtInsertTag );
+      sqlite3_reset( stmtInsertTag );
+      if ( res != SQLITE_DONE )
+      {
+        mError = QString( "Storing tag failed [%1]" ).arg( res );
+        return false;
+      }
+    }
+  }
 
   return true;
 }
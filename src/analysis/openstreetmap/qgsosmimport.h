@@ -22,11 +22,15 @@
 #include "qgsosmbase.h"
 
 class QXmlStreamReader;
+struct QgsOSMPbfBlock;
 
 /**
  * @brief The QgsOSMXmlImport class imports OpenStreetMap XML format to our topological representation
  * in a SQLite database (see QgsOSMDatabase for details).
  *
+ * Files in the PBF format are recognized by their content and imported too. Their blocks
+ * are decoded in several threads (see QgsOSMPbfReader).
+ *
  * How to use the classs:
  * 1. set input XML file name and output DB file name (in constructor or with respective functions)
  * 2. run import()
@@ -64,6 +68,10 @@ class ANALYSIS_EXPORT QgsOSMXmlImport : public QObject
 
     bool createIndexes();
 
+    bool readXml();
+    bool readPbf();
+    bool storePbfBlock( const QgsOSMPbfBlock& block );
+
     void readRoot( QXmlStreamReader& xml );
     void readNode( QXmlStreamReader& xml );
     void readWay( QXmlStreamReader& xml );
@@ -0,0 +1,597 @@
+/***************************************************************************
+  qgsosmpbfreader.cpp
+  --------------------------------------
+  Date                 : October 2015
+  Copyright            : (C) 2015 by QGIS Development Team
+  Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsosmpbfreader.h"
+
+#include <QIODevice>
+#include <QList>
+
+// limits given by the format specification
+static const qint64 MAX_BLOB_HEADER_SIZE = 64 * 1024;
+static const qint64 MAX_BLOB_SIZE = 32 * 1024 * 1024;
+
+namespace
+{
+  /**
+   * Reads the fields of a protocol buffer message one after the other.
+   * See https://developers.google.com/protocol-buffers/docs/encoding
+   */
+  class PbfMessage
+  {
+    public:
+      PbfMessage( const char* data, int size )
+          : mPos( data ), mEnd( data + size ), mError( false ), mField( 0 ), mWireType( 0 ), mValue( 0 ), mData( 0 ), mSize( 0 ) {}
+      explicit PbfMessage( const QByteArray& data )
+          : mPos( data.constData() ), mEnd( data.constData() + data.size() ), mError( false ), mField( 0 ), mWireType( 0 ), mValue( 0 ), mData( 0 ), mSize( 0 ) {}
+
+      //! Reads the next field, returns false at the end of the message or on error
+      bool next()
+      {
+        if ( mError || mPos >= mEnd )
+          return false;
+
+        quint64 key;
+        if ( !readVarint( key ) )
+          return false;
+        mField = key >> 3;
+        mWireType = key & 0x7;
+
+        switch ( mWireType )
+        {
+          case 0: // varint
+            return readVarint( mValue );
+
+          case 1: // 64 bit
+            return readFixed( 8 );
+
+          case 2: // length delimited
+          {
+            quint64 size;
+            if ( !readVarint( size ) || size > quint64( mEnd - mPos ) )
+              return fail();
+            mData = mPos;
+            mSize = ( int ) size;
+            mPos += size;
+            return true;
+          }
+
+          case 5: // 32 bit
+            return readFixed( 4 );
+
+          default:
+            return fail();
+        }
+      }
+
+      //! Reads a varint of a packed field, returns false at the end or on error
+      bool readVarint( quint64& value )
+      {
+        value = 0;
+        for ( int shift = 0; shift < 64; shift += 7 )
+        {
+          if ( mPos >= mEnd )
+            return fail();
+          quint8 byte = *mPos++;
+          value |= quint64( byte & 0x7f ) << shift;
+          if ( !( byte & 0x80 ) )
+            return true;
+        }
+        return fail();
+      }
+
+      bool atEnd() const { return mPos >= mEnd; }
+      bool hasError() const { return mError; }
+
+      int field() const { return mField; }
+      int wireType() const { return mWireType; }
+      quint64 value() const { return mValue; }
+      //! Value of a sint64 field (zigzag encoded)
+      qint64 signedValue() const { return zigzag( mValue ); }
+      const char* data() const { return mData; }
+      int size() const { return mSize; }
+      QByteArray bytes() const { return QByteArray( mData, mSize ); }
+      PbfMessage message() const { return PbfMessage( mData, mSize ); }
+
+      static qint64 zigzag( quint64 value ) { return ( qint64 )( value >> 1 ) ^ -( qint64 )( value & 1 ); }
+
+    private:
+      bool readFixed( int bytes )
+      {
+        if ( mEnd - mPos < bytes )
+          return fail();
+        mValue = 0;
+        for ( int i = bytes - 1; i >= 0; --i )
+          mValue = ( mValue << 8 ) | ( quint8 ) mPos[i];
+        mPos += bytes;
+        return true;
+      }
+
+      bool fail()
+      {
+        mError = true;
+        return false;
+      }
+
+      const char* mPos;
+      const char* mEnd;
+      bool mError;
+
+      int mField;
+      int mWireType;
+      quint64 mValue;
+      const char* mData;
+      int mSize;
+  };
+
+  //! Reads the values of a repeated varint field, packed or not
+  bool readVarints( const PbfMessage& field, QVector<quint64>& values )
+  {
+    if ( field.wireType() == 0 )
+    {
+      values << field.value();
+      return true;
+    }
+    if ( field.wireType() != 2 )
+      return false;
+
+    PbfMessage packed = field.message();
+    quint64 value;
+    while ( !packed.atEnd() )
+    {
+      if ( !packed.readVarint( value ) )
+        return false;
+      values << value;
+    }
+    return true;
+  }
+
+  //! Returns the uncompressed content of a blob
+  bool blobData( const QByteArray& blob, QByteArray& data, QString& error )
+  {
+    PbfMessage msg( blob );
+    qint64 rawSize = -1;
+    bool compressed = false;
+    bool raw = false;
+    QByteArray zlibData;
+
+    while ( msg.next() )
+    {
+      switch ( msg.field() )
+      {
+        case 1: // raw
+          data = msg.bytes();
+          raw = true;
+          break;
+        case 2: // raw_size
+          rawSize = msg.value();
+          break;
+        case 3: // zlib_data
+        {
+          // qUncompress() expects the uncompressed size in front of the zlib stream, it is filled in below
+          zlibData.reserve( msg.size() + 4 );
+          zlibData.append( QByteArray( 4, 0 ) );
+          zlibData.append( msg.data(), msg.size() );
+          compressed = true;
+          break;
+        }
+        case 4: // lzma_data
+        case 5: // bzip2_data
+          error = QString( "Unsupported compression of PBF blob." );
+          return false;
+      }
+    }
+
+    if ( msg.hasError() )
+    {
+      error = QString( "Invalid PBF blob." );
+      return false;
+    }
+
+    if ( raw )
+      return true;
+
+    if ( !compressed || rawSize < 0 || rawSize > MAX_BLOB_SIZE )
+    {
+      error = QString( "Invalid PBF blob." );
+      return false;
+    }
+
+    zlibData[0] = ( char )(( rawSize >> 24 ) & 0xff );
+    zlibData[1] = ( char )(( rawSize >> 16 ) & 0xff );
+    zlibData[2] = ( char )(( rawSize >> 8 ) & 0xff );
+    zlibData[3] = ( char )( rawSize & 0xff );
+    data = qUncompress( zlibData );
+    if ( data.size() != rawSize )
+    {
+      error = QString( "Decompressing PBF blob failed." );
+      return false;
+    }
+    return true;
+  }
+
+  //! Parameters of a primitive block needed to decode its groups
+  struct BlockContext
+  {
+    QList<QByteArray> strings;
+    qint64 granularity;
+    qint64 latOffset;
+    qint64 lonOffset;
+
+    double lat( qint64 value ) const { return 1E-9 * ( latOffset + granularity * value ); }
+    double lon( qint64 value ) const { return 1E-9 * ( lonOffset + granularity * value ); }
+  };
+
+  bool addTags( QgsOSMId id, const QVector<quint64>& keys, const QVector<quint64>& vals, const BlockContext& context, QVector<QgsOSMPbfTag>& tags )
+  {
+    if ( keys.size() != vals.size() )
+      return false;
+
+    for ( int i = 0; i < keys.size(); ++i )
+    {
+      if ( keys[i] >= ( quint64 ) context.strings.size() || vals[i] >= ( quint64 ) context.strings.size() )
+        return false;
+
+      QgsOSMPbfTag tag;
+      tag.id = id;
+      tag.key = context.strings[keys[i]];
+      tag.value = context.strings[vals[i]];
+      tags << tag;
+    }
+    return true;
+  }
+
+  bool decodeNode( PbfMessage msg, const BlockContext& context, QgsOSMPbfBlock& block )
+  {
+    QgsOSMId id = 0;
+    qint64 lat = 0, lon = 0;
+    QVector<quint64> keys, vals;
+
+    while ( msg.next() )
+    {
+      switch ( msg.field() )
+      {
+        case 1:
+          id = msg.signedValue();
+          break;
+        case 2:
+          if ( !readVarints( msg, keys ) )
+            return false;
+          break;
+        case 3:
+          if ( !readVarints( msg, vals ) )
+            return false;
+          break;
+        case 8:
+          lat = msg.signedValue();
+          break;
+        case 9:
+          lon = msg.signedValue();
+          break;
+      }
+    }
+    if ( msg.hasError() )
+      return false;
+
+    block.nodeIds << id;
+    block.nodeLats << context.lat( lat );
+    block.nodeLons << context.lon( lon );
+    return addTags( id, keys, vals, context, block.nodeTags );
+  }
+
+  bool decodeDenseNodes( PbfMessage msg, const BlockContext& context, QgsOSMPbfBlock& block )
+  {
+    QVector<quint64> ids, lats, lons, keysVals;
+
+    while ( msg.next() )
+    {
+      bool ok = true;
+      switch ( msg.field() )
+      {
+        case 1:
+          ok = readVarints( msg, ids );
+          break;
+        case 8:
+          ok = readVarints( msg, lats );
+          break;
+        case 9:
+          ok = readVarints( msg, lons );
+          break;
+        case 10:
+          ok = readVarints( msg, keysVals );
+          break;
+      }
+      if ( !ok )
+        return false;
+    }
+    if ( msg.hasError() || lats.size() != ids.size() || lons.size() != ids.size() )
+      return false;
+
+    // ids and coordinates are delta coded, the tags of all nodes are in one array,
+    // key and value string indexes of a node are terminated by 0
+    QgsOSMId id = 0;
+    qint64 lat = 0, lon = 0;
+    int kv = 0;
+    for ( int i = 0; i < ids.size(); ++i )
+    {
+      id += PbfMessage::zigzag( ids[i] );
+      lat += PbfMessage::zigzag( lats[i] );
+      lon += PbfMessage::zigzag( lons[i] );
+
+      block.nodeIds << id;
+      block.nodeLats << context.lat( lat );
+      block.nodeLons << context.lon( lon );
+
+      if ( keysVals.isEmpty() )
+        continue;
+
+      while ( kv < keysVals.size() && keysVals[kv] != 0 )
+      {
+        if ( kv + 1 >= keysVals.size() )
+          return false;
+
+        quint64 k = keysVals[kv], v = keysVals[kv + 1];
+        if ( k >= ( quint64 ) context.strings.size() || v >= ( quint64 ) context.strings.size() )
+          return false;
+
+        QgsOSMPbfTag tag;
+        tag.id = id;
+        tag.key = context.strings[k];
+        tag.value = context.strings[v];
+        block.nodeTags << tag;
+        kv += 2;
+      }
+      ++kv; // the terminating 0
+    }
+    return true;
+  }
+
+  bool decodeWay( PbfMessage msg, const BlockContext& context, QgsOSMPbfBlock& block )
+  {
+    QgsOSMId id = 0;
+    QVector<quint64> keys, vals, refs;
+
+    while ( msg.next() )
+    {
+      bool ok = true;
+      switch ( msg.field() )
+      {
+        case 1:
+          id = msg.value();
+          break;
+        case 2:
+          ok = readVarints( msg, keys );
+          break;
+        case 3:
+          ok = readVarints( msg, vals );
+          break;
+        case 8:
+          ok = readVarints( msg, refs );
+          break;
+      }
+      if ( !ok )
+        return false;
+    }
+    if ( msg.hasError() )
+      return false;
+
+    block.wayIds << id;
+    block.wayNodeCounts << refs.size();
+
+    // node ids are delta coded
+    QgsOSMId nodeId = 0;
+    for ( int i = 0; i < refs.size(); ++i )
+    {
+      nodeId += PbfMessage::zigzag( refs[i] );
+      block.wayNodeIds << nodeId;
+    }
+    return addTags( id, keys, vals, context, block.wayTags );
+  }
+
+  bool decodeGroup( PbfMessage msg, const BlockContext& context, QgsOSMPbfBlock& block )
+  {
+    while ( msg.next() )
+    {
+      bool ok = true;
+      switch ( msg.field() )
+      {
+        case 1:
+          ok = decodeNode( msg.message(), context, block );
+          break;
+        case 2:
+          ok = decodeDenseNodes( msg.message(), context, block );
+          break;
+        case 3:
+          ok = decodeWay( msg.message(), context, block );
+          break;
+        // relations and changesets are not imported
+      }
+      if ( !ok )
+        return false;
+    }
+    return !msg.hasError();
+  }
+}
+
+
+QgsOSMPbfReader::QgsOSMPbfReader( QIODevice* device )
+    : mDevice( device )
+{
+}
+
+bool QgsOSMPbfReader::isPbf( QIODevice* device )
+{
+  // the file starts with the size of the first blob header and its type field
+  QByteArray start = device->peek( 15 );
+  return start.size() == 15 && start.mid( 4, 2 ) == QByteArray( "\x0a\x09", 2 ) && start.mid( 6 ) == "OSMHeader";
+}
+
+bool QgsOSMPbfReader::readBlob( QByteArray& blob )
+{
+  while ( !mDevice->atEnd() )
+  {
+    QByteArray sizeBytes = mDevice->read( 4 );
+    if ( sizeBytes.size() != 4 )
+    {
+      mError = QString( "Unexpected end of PBF file." );
+      return false;
+    }
+
+    qint64 headerSize = 0;
+    for ( int i = 0; i < 4; ++i )
+      headerSize = ( headerSize << 8 ) | ( quint8 ) sizeBytes[i];
+    if ( headerSize > MAX_BLOB_HEADER_SIZE )
+    {
+      mError = QString( "Invalid PBF blob header." );
+      return false;
+    }
+
+    QByteArray header = mDevice->read( headerSize );
+    if ( header.size() != headerSize )
+    {
+      mError = QString( "Unexpected end of PBF file." );
+      return false;
+    }
+
+    QByteArray type;
+    qint64 dataSize = -1;
+    PbfMessage msg( header );
+    while ( msg.next() )
+    {
+      if ( msg.field() == 1 )
+        type = msg.bytes();
+      else if ( msg.field() == 3 )
+        dataSize = msg.value();
+    }
+    if ( msg.hasError() || dataSize < 0 || dataSize > MAX_BLOB_SIZE )
+    {
+      mError = QString( "Invalid PBF blob header." );
+      return false;
+    }
+
+    blob = mDevice->read( dataSize );
+    if ( blob.size() != dataSize )
+    {
+      mError = QString( "Unexpected end of PBF file." );
+      return false;
+    }
+
+    if ( type == "OSMData" )
+      return true;
+
+    if ( type == "OSMHeader" && !checkHeader( blob ) )
+      return false;
+
+    // blobs of other types are skipped
+  }
+
+  return false;
+}
+
+bool QgsOSMPbfReader::checkHeader( const QByteArray& blob )
+{
+  QByteArray data;
+  if ( !blobData( blob, data, mError ) )
+    return false;
+
+  PbfMessage msg( data );
+  while ( msg.next() )
+  {
+    if ( msg.field() != 4 ) // required_features
+      continue;
+
+    QByteArray feature = msg.bytes();
+    if ( feature != "OsmSchema-V0.6" && feature != "DenseNodes" )
+    {
+      mError = QString( "PBF file requires unsupported feature %1." ).arg( QString::fromUtf8( feature ) );
+      return false;
+    }
+  }
+
+  if ( msg.hasError() )
+  {
+    mError = QString( "Invalid PBF file header." );
+    return false;
+  }
+  return true;
+}
+
+QgsOSMPbfBlock QgsOSMPbfReader::decodeBlob( const QByteArray& blob )
+{
+  QgsOSMPbfBlock block;
+
+  QByteArray data;
+  if ( !blobData( blob, data, block.error ) )
+    return block;
+
+  BlockContext context;
+  context.granularity = 100;
+  context.latOffset = 0;
+  context.lonOffset = 0;
+
+  // the string table may follow the groups, they are decoded at the end
+  QList<PbfMessage> groups;
+
+  PbfMessage msg( data );
+  while ( msg.next() )
+  {
+    switch ( msg.field() )
+    {
+      case 1: // stringtable
+      {
+        PbfMessage strings = msg.message();
+        while ( strings.next() )
+        {
+          if ( strings.field() == 1 )
+            context.strings << strings.bytes();
+        }
+        if ( strings.hasError() )
+        {
+          block.error = QString( "Invalid PBF string table." );
+          return block;
+        }
+        break;
+      }
+      case 2: // primitivegroup
+        groups << msg.message();
+        break;
+      case 17:
+        context.granularity = msg.value();
+        break;
+      case 19:
+        context.latOffset = msg.value();
+        break;
+      case 20:
+        context.lonOffset = msg.value();
+        break;
+    }
+  }
+
+  if ( msg.hasError() )
+  {
+    block.error = QString( "Invalid PBF primitive block." );
+    return block;
+  }
+
+  Q_FOREACH ( const PbfMessage& group, groups )
+  {
+    if ( !decodeGroup( group, context, block ) )
+    {
+      block.error = QString( "Invalid PBF primitive group." );
+      return block;
+    }
+  }
+
+  return block;
+}
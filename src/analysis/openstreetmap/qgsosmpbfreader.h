@@ -0,0 +1,96 @@
+/***************************************************************************
+  qgsosmpbfreader.h
+  --------------------------------------
+  Date                 : October 2015
+  Copyright            : (C) 2015 by QGIS Development Team
+  Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef OSMPBFREADER_H
+#define OSMPBFREADER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include "qgsosmbase.h"
+
+class QIODevice;
+
+/**
+ * @brief Tag of a node or way decoded from a PBF block
+ */
+struct QgsOSMPbfTag
+{
+  QgsOSMId id;
+  QByteArray key;
+  QByteArray value;
+};
+
+/**
+ * @brief Nodes, ways and their tags decoded from one primitive block of a PBF file.
+ * Relations are not decoded, the XML import skips them too.
+ */
+struct QgsOSMPbfBlock
+{
+  QVector<QgsOSMId> nodeIds;
+  QVector<double> nodeLats;
+  QVector<double> nodeLons;
+  QVector<QgsOSMPbfTag> nodeTags;
+
+  QVector<QgsOSMId> wayIds;
+  //! number of nodes of each way in wayNodeIds
+  QVector<int> wayNodeCounts;
+  QVector<QgsOSMId> wayNodeIds;
+  QVector<QgsOSMPbfTag> wayTags;
+
+  //! set if the block could not be decoded
+  QString error;
+};
+
+/**
+ * @brief The QgsOSMPbfReader class reads OpenStreetMap data in the PBF format.
+ *
+ * The file is a sequence of blobs, each holding a zlib compressed primitive block with
+ * its own string table. The reader splits the file into blobs sequentially, the blobs
+ * can then be decoded independently with decodeBlob(), e.g. in several threads.
+ * See http://wiki.openstreetmap.org/wiki/PBF_Format for the format description.
+ */
+class ANALYSIS_EXPORT QgsOSMPbfReader
+{
+  public:
+    explicit QgsOSMPbfReader( QIODevice* device );
+
+    //! Whether the data of the device start with a PBF file header (does not consume the data)
+    static bool isPbf( QIODevice* device );
+
+    /**
+     * Reads the next blob with a primitive block. The file header blobs are checked
+     * on the way, blobs of unknown types are skipped.
+     * @return false at the end of the file or on error (see hasError())
+     */
+    bool readBlob( QByteArray& blob );
+
+    /**
+     * Decompresses and decodes a blob returned by readBlob(). Thread safe.
+     */
+    static QgsOSMPbfBlock decodeBlob( const QByteArray& blob );
+
+    bool hasError() const { return !mError.isEmpty(); }
+    QString errorString() const { return mError; }
+
+  private:
+    bool checkHeader( const QByteArray& blob );
+
+    QIODevice* mDevice;
+    QString mError;
+};
+
+#endif // OSMPBFREADER_H
@@ -39,6 +39,7 @@
 #include "qgscomposerlegendwidget.h"
 #include "qgscomposermap.h"
 #include "qgsatlascomposition.h"
+#include "qgsatlasparallelexport.h"
 #include "qgscomposermapwidget.h"
 #include "qgscomposerpicture.h"
 #include "qgscomposerpicturewidget.h"
@@ -1679,7 +1680,13 @@ void QgsComposer::exportCompositionAsPDF( QgsComposer::OutputMode mode )
 
   mView->setPaintingEnabled( false );
 
-  if ( mode == QgsComposer::Atlas )
+  if ( mode == QgsComposer::Atlas &&
+       exportAtlasInParallel( atlasOnASingleFile ? QgsAtlasParallelExport::SinglePdf : QgsAtlasParallelExport::PdfFiles,
+                              atlasOnASingleFile ? outputFileName : outputDir ) )
+  {
+    // exported with several threads
+  }
+  else if ( mode == QgsComposer::Atlas )
   {
     QPrinter printer;
 
@@ -2214,6 +2221,16 @@ void QgsComposer::exportCompositionAsImage( QgsComposer::OutputMode mode )
 
     myQSettings.setValue( "/UI/lastSaveAtlasAsImagesDir", dir );
 
+    // world files and cropping need the composition of the GUI
+    if ( !cropToContents && !( mComposition->generateWorldFile() && mComposition->worldFileMap() ) )
+    {
+      mView->setPaintingEnabled( false );
+      bool exported = exportAtlasInParallel( QgsAtlasParallelExport::ImageFiles, dir, format, imageDlg.resolution() );
+      mView->setPaintingEnabled( true );
+      if ( exported )
+        return;
+    }
+
     // So, now we can render the atlas
     mView->setPaintingEnabled( false );
     QApplication::setOverrideCursor( Qt::BusyCursor );
@@ -4143,6 +4160,47 @@ void QgsComposer::updateAtlasMapLayerAction( bool atlasEnabled )
   }
 }
 
+bool QgsComposer::exportAtlasInParallel( QgsAtlasParallelExport::Output output, const QString& path, const QString& imageFormat, int dpi )
+{
+  QSettings settings;
+  if ( !settings.value( "/qgis/parallel_atlas_export", false ).toBool() ||
+       !QgsAtlasParallelExport::canExport( mComposition, output ) )
+  {
+    return false;
+  }
+
+  loadAtlasPredefinedScalesFromProject();
+  QgsAtlasParallelExport exporter( mComposition );
+
+  QProgressDialog progress( tr( "Rendering maps..." ), tr( "Abort" ), 0, mComposition->atlasComposition().numFeatures(), this );
+  progress.setWindowTitle( tr( "Exporting atlas" ) );
+  progress.setWindowModality( Qt::WindowModal );
+  connect( &mComposition->atlasComposition(), SIGNAL( numberFeaturesChanged( int ) ), &progress, SLOT( setMaximum( int ) ) );
+  connect( &exporter, SIGNAL( progressChanged( int ) ), &progress, SLOT( setValue( int ) ) );
+  connect( &progress, SIGNAL( canceled() ), &exporter, SLOT( cancel() ) );
+
+  QApplication::setOverrideCursor( Qt::BusyCursor );
+  bool ok;
+  if ( output == QgsAtlasParallelExport::PdfFiles )
+    ok = exporter.exportPdfFiles( path );
+  else if ( output == QgsAtlasParallelExport::SinglePdf )
+    ok = exporter.exportSinglePdf( path );
+  else
+    ok = exporter.exportImageFiles( path, imageFormat, dpi );
+  QApplication::restoreOverrideCursor();
+
+  disconnect( &mComposition->atlasComposition(), SIGNAL( numberFeaturesChanged( int ) ), &progress, SLOT( setMaximum( int ) ) );
+
+  if ( !ok && !progress.wasCanceled() )
+  {
+    QMessageBox::warning( this, tr( "Atlas processing error" ),
+                          exporter.errorString(),
+                          QMessageBox::Ok,
+                          QMessageBox::Ok );
+  }
+  return true;
+}
+
 void QgsComposer::loadAtlasPredefinedScalesFromProject()
 {
   if ( !mComposition )
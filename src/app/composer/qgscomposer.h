@@ -18,6 +18,7 @@
 #define QGSCOMPOSER_H
 #include "ui_qgscomposerbase.h"
 #include "qgscomposermap.h"
+#include "qgsatlasparallelexport.h"
 #include "qgscontexthelp.h"
 #include <QDockWidget>
 
@@ -511,6 +512,11 @@ class QgsComposer: public QMainWindow, private Ui::QgsComposerBase
     //! Load predefined scales from the project's properties
     void loadAtlasPredefinedScalesFromProject();
 
+    /** Exports the atlas with several threads if enabled in settings and possible for the composition.
+     * @returns false if the atlas has to be exported sequentially
+     */
+    bool exportAtlasInParallel( QgsAtlasParallelExport::Output output, const QString& path, const QString& imageFormat = QString(), int dpi = 0 );
+
     QPrinter* printer();
 
     /** Composer title*/
@@ -201,6 +201,20 @@ int QgsAtlasComposition::updateFeatures()
 
   updateFilenameExpression();
 
+  if ( mPageFeatures )
+  {
+    // pages already determined by another composition
+    mFeatureIds.clear();
+    mFeatureIds.reserve( mPageFeatures->size() );
+    PageFeatures::const_iterator pageIt = mPageFeatures->constBegin();
+    for ( ; pageIt != mPageFeatures->constEnd(); ++pageIt )
+    {
+      mFeatureIds.push_back( qMakePair( pageIt->first.id(), pageIt->second ) );
+    }
+    emit numberFeaturesChanged( mFeatureIds.size() );
+    return mFeatureIds.size();
+  }
+
   // select all features with all attributes
   QgsFeatureRequest req;
 
@@ -373,6 +387,36 @@ void QgsAtlasComposition::lastFeature()
   prepareForFeature( mFeatureIds.size() - 1 );
 }
 
+QSharedPointer<const QgsAtlasComposition::PageFeatures> QgsAtlasComposition::fetchPageFeatures() const
+{
+  QSharedPointer<PageFeatures> pages( new PageFeatures() );
+  if ( !mCoverageLayer )
+    return pages;
+
+  // fetch the features in one pass, they are ordered afterwards
+  QgsFeatureIds ids;
+  QVector< QPair<QgsFeatureId, QString> >::const_iterator it = mFeatureIds.constBegin();
+  for ( ; it != mFeatureIds.constEnd(); ++it )
+  {
+    ids.insert( it->first );
+  }
+
+  QHash<QgsFeatureId, QgsFeature> features;
+  QgsFeature feat;
+  QgsFeatureIterator fit = mCoverageLayer->getFeatures( QgsFeatureRequest().setFilterFids( ids ) );
+  while ( fit.nextFeature( feat ) )
+  {
+    features.insert( feat.id(), feat );
+  }
+
+  pages->reserve( mFeatureIds.size() );
+  for ( it = mFeatureIds.constBegin(); it != mFeatureIds.constEnd(); ++it )
+  {
+    pages->append( qMakePair( features.value( it->first ), it->second ) );
+  }
+  return pages;
+}
+
 bool QgsAtlasComposition::prepareForFeature( const QgsFeature * feat )
 {
   int featureI = -1;
@@ -422,7 +466,10 @@ bool QgsAtlasComposition::prepareForFeature( const int featureI, const bool upda
   mCurrentFeatureNo = featureI;
 
   // retrieve the next feature, based on its id
-  mCoverageLayer->getFeatures( QgsFeatureRequest().setFilterFid( mFeatureIds[ featureI ].first ) ).nextFeature( mCurrentFeature );
+  if ( mPageFeatures && featureI < mPageFeatures->size() )
+    mCurrentFeature = mPageFeatures->at( featureI ).first;
+  else
+    mCoverageLayer->getFeatures( QgsFeatureRequest().setFilterFid( mFeatureIds[ featureI ].first ) ).nextFeature( mCurrentFeature );
 
   QgsExpressionContext expressionContext = createExpressionContext();
 
@@ -24,6 +24,7 @@
 #include <QString>
 #include <QDomElement>
 #include <QDomDocument>
+#include <QSharedPointer>
 #include <QStringList>
 
 class QgsComposerMap;
@@ -253,6 +254,27 @@ class CORE_EXPORT QgsAtlasComposition : public QObject
     /** Recalculates the bounds of an atlas driven map */
     void prepareMap( QgsComposerMap* map );
 
+    /** Features of the atlas pages paired with the page names, in page order */
+    typedef QVector< QPair<QgsFeature, QString> > PageFeatures;
+
+    /** Fetches the features of all atlas pages from the coverage layer. Must be called
+     * after beginRender().
+     * @see setPageFeatures()
+     * @note added in QGIS 2.14
+     * @note not available in python bindings
+     */
+    QSharedPointer<const PageFeatures> fetchPageFeatures() const;
+
+    /** Sets the features of the atlas pages, as fetched by another composition with the same
+     * atlas settings. The atlas then takes the features from the list instead of querying
+     * the coverage layer, which lets copies of a composition render pages concurrently.
+     * Set a null pointer to query the coverage layer again.
+     * @see fetchPageFeatures()
+     * @note added in QGIS 2.14
+     * @note not available in python bindings
+     */
+    void setPageFeatures( const QSharedPointer<const PageFeatures>& features ) { mPageFeatures = features; }
+
 
     //deprecated methods
 
@@ -411,6 +433,9 @@ class CORE_EXPORT QgsAtlasComposition : public QObject
 
     // projected geometry cache
     mutable QMap<long, QgsGeometry> mGeometryCache;
+
+    // features of the pages shared with other compositions, if set
+    QSharedPointer<const PageFeatures> mPageFeatures;
 };
 
 #endif
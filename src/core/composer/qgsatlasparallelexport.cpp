@@ -0,0 +1,385 @@
+/***************************************************************************
+                         qgsatlasparallelexport.cpp
+                         --------------------------
+    begin                : October 2015
+    copyright            : (C) 2015 by QGIS Development Team
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsatlasparallelexport.h"
+#include "qgscomposermap.h"
+#include "qgscomposition.h"
+#include "qgslogger.h"
+#include "qgsmaplayer.h"
+#include "qgsmaplayerregistry.h"
+#include "qgsmaprenderercustompainterjob.h"
+
+#include <QDir>
+#include <QDomDocument>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QPainter>
+#include <QPrinter>
+#include <QThread>
+
+QgsAtlasParallelExport::QgsAtlasParallelExport( QgsComposition* composition )
+    : mComposition( composition )
+    , mMapSettings( composition->mapSettings() )
+    , mThreadCount( QThread::idealThreadCount() )
+    , mOutput( PdfFiles )
+    , mDpi( 0 )
+    , mEventLoop( 0 )
+    , mCancelled( false )
+    , mPrinter( 0 )
+    , mPainter( 0 )
+    , mFirstPageWritten( false )
+{
+}
+
+QgsAtlasParallelExport::~QgsAtlasParallelExport()
+{
+}
+
+bool QgsAtlasParallelExport::canExport( QgsComposition* composition, Output output )
+{
+  if ( !composition || !composition->atlasComposition().enabled() )
+    return false;
+
+  // the maps are rendered to images, which would replace the vector output of a PDF
+  if ( output != ImageFiles && !composition->printAsRaster() )
+    return false;
+
+  // layers blended with the content below them must be drawn onto the page, not into a separate image
+  Q_FOREACH ( QgsMapLayer* layer, QgsMapLayerRegistry::instance()->mapLayers() )
+  {
+    if ( layer->blendMode() != QPainter::CompositionMode_SourceOver )
+      return false;
+  }
+  return true;
+}
+
+bool QgsAtlasParallelExport::exportPdfFiles( const QString& directory )
+{
+  mDirectory = directory;
+  return run( PdfFiles );
+}
+
+bool QgsAtlasParallelExport::exportSinglePdf( const QString& fileName )
+{
+  mFileName = fileName;
+  return run( SinglePdf );
+}
+
+bool QgsAtlasParallelExport::exportImageFiles( const QString& directory, const QString& format, int dpi )
+{
+  mDirectory = directory;
+  mImageFormat = format;
+  mDpi = dpi;
+  return run( ImageFiles );
+}
+
+void QgsAtlasParallelExport::cancel()
+{
+  mCancelled = true;
+  if ( mEventLoop )
+    mEventLoop->quit();
+}
+
+bool QgsAtlasParallelExport::run( Output output )
+{
+  mOutput = output;
+  mCancelled = false;
+  mError.clear();
+  mFirstPageWritten = false;
+  if ( output != ImageFiles || mDpi <= 0 )
+    mDpi = mComposition->printResolution();
+
+  QgsAtlasComposition& atlas = mComposition->atlasComposition();
+  if ( !atlas.beginRender() )
+  {
+    mError = atlas.featureFilterErrorString().isEmpty() ? tr( "No matching atlas features" )
+             : tr( "Feature filter parser error: %1" ).arg( atlas.featureFilterErrorString() );
+    return false;
+  }
+  int featureCount = atlas.numFeatures();
+
+  // the features are shared by the copies of the composition
+  mPageFeatures = atlas.fetchPageFeatures();
+  mPredefinedScales = atlas.predefinedScales();
+
+  QDomDocument doc;
+  QDomElement composerElem = doc.createElement( "Composer" );
+  doc.appendChild( composerElem );
+  mComposition->writeXML( composerElem, doc );
+  atlas.writeXML( composerElem, doc );
+  mTemplateXml = doc.toString();
+
+  QPrinter printer;
+  QPainter painter;
+  if ( output == SinglePdf )
+  {
+    // paper size is taken from the first feature
+    atlas.prepareForFeature( 0 );
+    mComposition->beginPrintAsPDF( printer, mFileName );
+    mComposition->beginPrint( printer );
+    if ( !painter.begin( &printer ) )
+    {
+      mError = tr( "Error creating %1." ).arg( mFileName );
+      atlas.endRender();
+      return false;
+    }
+    mPrinter = &printer;
+    mPainter = &painter;
+    mPaperSize = QSizeF( mComposition->paperWidth(), mComposition->paperHeight() );
+  }
+
+  // the maps of the next features are rendered while the pages of the current one are written
+  int pageCount = qBound( 1, mThreadCount, featureCount );
+  QgsDebugMsg( QString( "exporting %1 atlas features, rendering maps of %2 features at once" ).arg( featureCount ).arg( pageCount ) );
+
+  QVector<Page> pages( pageCount );
+  bool ok = true;
+  for ( int i = 0; ok && i < pageCount; ++i )
+  {
+    pages[i].composition = createComposition();
+    if ( !pages[i].composition )
+    {
+      mError = tr( "Could not copy the composition" );
+      ok = false;
+    }
+  }
+  for ( int i = 0; ok && i < pageCount; ++i )
+  {
+    ok = startFeature( pages[i], i );
+  }
+
+  for ( int featureIndex = 0; ok && featureIndex < featureCount; ++featureIndex )
+  {
+    Page& page = pages[featureIndex % pageCount];
+    ok = waitForMaps( page ) && exportFeature( page );
+    if ( !ok )
+      break;
+
+    emit progressChanged( featureIndex + 1 );
+
+    if ( featureIndex + pageCount < featureCount )
+      ok = startFeature( page, featureIndex + pageCount );
+  }
+
+  for ( int i = 0; i < pageCount; ++i )
+  {
+    releaseMaps( pages[i] );
+    delete pages[i].composition;
+  }
+
+  if ( output == SinglePdf )
+  {
+    painter.end();
+    mPrinter = 0;
+    mPainter = 0;
+  }
+  mPageFeatures.clear();
+
+  atlas.endRender();
+  return ok && !mCancelled && mError.isEmpty();
+}
+
+QgsComposition* QgsAtlasParallelExport::createComposition()
+{
+  QDomDocument doc;
+  if ( !doc.setContent( mTemplateXml ) )
+    return 0;
+
+  QgsComposition* composition = new QgsComposition( mMapSettings );
+  if ( !composition->loadFromTemplate( doc, 0, false ) )
+  {
+    delete composition;
+    return 0;
+  }
+  composition->setUseAdvancedEffects( mComposition->useAdvancedEffects() );
+
+  // the copy is never shown, its maps must not render previews when the atlas feature changes
+  QList<QgsComposerMap*> maps;
+  composition->composerItems( maps );
+  Q_FOREACH ( QgsComposerMap* map, maps )
+  {
+    map->setPreviewMode( QgsComposerMap::Rectangle );
+  }
+
+  QgsAtlasComposition& atlas = composition->atlasComposition();
+  atlas.setPredefinedScales( mPredefinedScales );
+  atlas.setPageFeatures( mPageFeatures );
+  if ( !composition->setAtlasMode( QgsComposition::ExportAtlas ) )
+  {
+    delete composition;
+    return 0;
+  }
+  return composition;
+}
+
+bool QgsAtlasParallelExport::startFeature( Page& page, int featureIndex )
+{
+  if ( !page.composition->atlasComposition().prepareForFeature( featureIndex ) )
+  {
+    mError = tr( "Atlas processing error" );
+    return false;
+  }
+
+  // map renderer jobs are started from this thread, they prepare the layers here and render them in the background
+  QList<QgsComposerMap*> maps;
+  page.composition->composerItems( maps );
+  Q_FOREACH ( QgsComposerMap* map, maps )
+  {
+    QgsMapSettings settings = map->printMapSettings( mDpi );
+    if ( settings.outputSize().isEmpty() )
+      continue;
+
+    MapJob mapJob;
+    mapJob.map = map;
+    mapJob.image = new QImage( settings.outputSize(), settings.outputImageFormat() );
+    // the map background is transparent, the job does not overwrite the image
+    mapJob.image->fill( 0 );
+    mapJob.painter = new QPainter( mapJob.image );
+    mapJob.job = new QgsMapRendererCustomPainterJob( settings, mapJob.painter );
+    page.maps << mapJob;
+    mapJob.job->start();
+  }
+  return true;
+}
+
+bool QgsAtlasParallelExport::waitForMaps( Page& page )
+{
+  QEventLoop loop;
+  Q_FOREACH ( const MapJob& mapJob, page.maps )
+  {
+    connect( mapJob.job, SIGNAL( finished() ), &loop, SLOT( quit() ) );
+  }
+
+  mEventLoop = &loop;
+  while ( !mCancelled )
+  {
+    bool active = false;
+    Q_FOREACH ( const MapJob& mapJob, page.maps )
+    {
+      active = active || mapJob.job->isActive();
+    }
+    if ( !active )
+      break;
+
+    loop.exec();
+  }
+  mEventLoop = 0;
+  return !mCancelled;
+}
+
+void QgsAtlasParallelExport::releaseMaps( Page& page )
+{
+  Q_FOREACH ( const MapJob& mapJob, page.maps )
+  {
+    mapJob.job->cancel();
+    delete mapJob.job;
+    delete mapJob.painter;
+    mapJob.map->setPrerenderedMap( QImage(), 0 );
+    delete mapJob.image;
+  }
+  page.maps.clear();
+}
+
+bool QgsAtlasParallelExport::exportFeature( Page& page )
+{
+  for ( int i = 0; i < page.maps.size(); ++i )
+  {
+    MapJob& mapJob = page.maps[i];
+    delete mapJob.painter;
+    mapJob.painter = 0;
+    mapJob.map->setPrerenderedMap( *mapJob.image, mDpi );
+  }
+  QgsComposition* composition = page.composition;
+  QgsAtlasComposition& atlas = composition->atlasComposition();
+  bool ok = true;
+
+  if ( mOutput == PdfFiles )
+  {
+    QString fileName = QDir( mDirectory ).filePath( atlas.currentFilename() ) + ".pdf";
+    QPrinter printer;
+    composition->beginPrintAsPDF( printer, fileName );
+    composition->beginPrint( printer );
+    QPainter painter;
+    if ( painter.begin( &printer ) )
+    {
+      composition->doPrint( printer, painter );
+      painter.end();
+    }
+    else
+    {
+      mError = tr( "Error creating %1." ).arg( fileName );
+      ok = false;
+    }
+  }
+  else if ( mOutput == ImageFiles )
+  {
+    QString fileName = QDir( mDirectory ).filePath( atlas.currentFilename() ) + '.' + mImageFormat;
+    for ( int i = 0; ok && i < composition->numPages(); ++i )
+    {
+      if ( !composition->shouldExportPage( i + 1 ) )
+        continue;
+
+      QImage image = composition->printPageAsRaster( i, QSize(), mDpi );
+      QString imageFileName = fileName;
+      if ( i != 0 )
+      {
+        //append page number
+        QFileInfo fi( fileName );
+        imageFileName = fi.absolutePath() + '/' + fi.baseName() + '_' + QString::number( i + 1 ) + '.' + fi.suffix();
+      }
+      if ( !image.save( imageFileName, mImageFormat.toLocal8Bit().constData() ) )
+      {
+        mError = tr( "Error creating %1." ).arg( imageFileName );
+        ok = false;
+      }
+    }
+  }
+  else
+  {
+    // page size may be data defined, it has been updated for the feature
+    QSizeF paperSize( composition->paperWidth(), composition->paperHeight() );
+    if ( paperSize != mPaperSize )
+    {
+      mPaperSize = paperSize;
+      //must set orientation to portrait before setting paper size, otherwise size will be flipped
+      //for landscape sized outputs (#11352)
+      mPrinter->setOrientation( QPrinter::Portrait );
+      mPrinter->setPaperSize( paperSize, QPrinter::Millimeter );
+    }
+
+    for ( int i = 0; i < composition->numPages(); ++i )
+    {
+      if ( !composition->shouldExportPage( i + 1 ) )
+        continue;
+
+      if ( mFirstPageWritten )
+        mPrinter->newPage();
+      mFirstPageWritten = true;
+
+      QImage image = composition->printPageAsRaster( i );
+      if ( !image.isNull() )
+      {
+        QRectF targetArea( 0, 0, image.width(), image.height() );
+        mPainter->drawImage( targetArea, image, targetArea );
+      }
+    }
+  }
+
+  // the images belong to the exported feature only
+  releaseMaps( page );
+  return ok;
+}
@@ -0,0 +1,163 @@
+/***************************************************************************
+                         qgsatlasparallelexport.h
+                         ------------------------
+    begin                : October 2015
+    copyright            : (C) 2015 by QGIS Development Team
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSATLASPARALLELEXPORT_H
+#define QGSATLASPARALLELEXPORT_H
+
+#include "qgsatlascomposition.h"
+#include "qgsmapsettings.h"
+
+#include <QList>
+#include <QObject>
+#include <QVector>
+
+class QgsComposerMap;
+class QgsComposition;
+class QgsMapRendererCustomPainterJob;
+class QEventLoop;
+class QImage;
+class QPainter;
+class QPrinter;
+
+/** \ingroup MapComposer
+ * Exports the atlas of a composition, rendering the maps of several atlas features concurrently.
+ *
+ * The export works with copies of the composition, created from the composition's template.
+ * Each copy is prepared for another atlas feature, and the layers of its maps are rendered in
+ * advance by map renderer jobs running in the background. The pages themselves are painted
+ * one after the other in the thread calling the export, in the atlas order, so that the scenes
+ * of the compositions are never used by other threads. The features of the coverage layer are
+ * fetched once and shared by all copies.
+ *
+ * The maps are rendered to images, so the atlas can be exported to image files, or to PDF
+ * files if the composition is printed as raster, see canExport().
+ *
+ * @note added in QGIS 2.14
+ * @note not available in python bindings
+ */
+class CORE_EXPORT QgsAtlasParallelExport : public QObject
+{
+    Q_OBJECT
+
+  public:
+    enum Output
+    {
+      PdfFiles,    //!< a PDF file for each atlas feature
+      SinglePdf,   //!< all atlas features in one PDF file
+      ImageFiles   //!< an image file for each page of each atlas feature
+    };
+
+    /** Constructor
+     * @param composition composition with atlas enabled. Only read during the export.
+     */
+    QgsAtlasParallelExport( QgsComposition* composition );
+    ~QgsAtlasParallelExport();
+
+    /** Returns whether the atlas of the composition can be exported in parallel */
+    static bool canExport( QgsComposition* composition, Output output );
+
+    /** Sets the number of atlas features whose maps are rendered at the same time, by default
+     * the number of processor cores */
+    void setThreadCount( int count ) { mThreadCount = count; }
+
+    /** Exports a PDF file for each atlas feature, named by the atlas filename pattern.
+     * Blocks until finished, progressChanged() is emitted meanwhile.
+     * @returns false on error or when cancelled
+     */
+    bool exportPdfFiles( const QString& directory );
+
+    /** Exports all atlas features to a single PDF file.
+     * Blocks until finished, progressChanged() is emitted meanwhile.
+     * @returns false on error or when cancelled
+     */
+    bool exportSinglePdf( const QString& fileName );
+
+    /** Exports an image file for each page of each atlas feature, named by the atlas filename pattern.
+     * Blocks until finished, progressChanged() is emitted meanwhile.
+     * @param directory output directory
+     * @param format image format, e.g. "png"
+     * @param dpi resolution, or 0 to use the composition's resolution
+     * @returns false on error or when cancelled
+     */
+    bool exportImageFiles( const QString& directory, const QString& format, int dpi = 0 );
+
+    /** Returns description of the last error */
+    QString errorString() const { return mError; }
+
+  public slots:
+    /** Stops the export, can be called while the export is running */
+    void cancel();
+
+  signals:
+    /** Emitted with the number of features exported so far */
+    void progressChanged( int features );
+
+  private:
+    //! Map of a copy of the composition with the job rendering its layers
+    struct MapJob
+    {
+      QgsComposerMap* map;
+      QImage* image;
+      QPainter* painter;
+      QgsMapRendererCustomPainterJob* job;
+    };
+
+    //! Copy of the composition with the jobs rendering its maps
+    struct Page
+    {
+      Page() : composition( 0 ) {}
+
+      QgsComposition* composition;
+      QList<MapJob> maps;
+    };
+
+    bool run( Output output );
+    QgsComposition* createComposition();
+    //! prepares the copy for a feature and starts rendering its maps
+    bool startFeature( Page& page, int featureIndex );
+    //! waits until the maps of the page are rendered, returns false when cancelled
+    bool waitForMaps( Page& page );
+    //! writes the output of the prepared page
+    bool exportFeature( Page& page );
+    //! stops the jobs of the page and deletes the rendered images
+    void releaseMaps( Page& page );
+
+    QgsComposition* mComposition;
+    QgsMapSettings mMapSettings;
+    QString mTemplateXml;
+    QSharedPointer<const QgsAtlasComposition::PageFeatures> mPageFeatures;
+    QVector<qreal> mPredefinedScales;
+    int mThreadCount;
+
+    Output mOutput;
+    QString mFileName;
+    QString mDirectory;
+    QString mImageFormat;
+    int mDpi;
+
+    QEventLoop* mEventLoop;
+    bool mCancelled;
+    QString mError;
+
+    // single PDF output
+    QPrinter* mPrinter;
+    QPainter* mPainter;
+    QSizeF mPaperSize;
+    bool mFirstPageWritten;
+};
+
+#endif // QGSATLASPARALLELEXPORT_H
@@ -59,6 +59,7 @@ QgsComposerMap::QgsComposerMap( QgsComposition *composition, int x, int y, int w
     , mAtlasDriven( false )
     , mAtlasScalingMode( Auto )
     , mAtlasMargin( 0.10 )
+    , mPrerenderedMapDpi( 0 )
 {
   mComposition = composition;
 
@@ -104,6 +105,7 @@ QgsComposerMap::QgsComposerMap( QgsComposition *composition )
     , mAtlasDriven( false )
     , mAtlasScalingMode( Auto )
     , mAtlasMargin( 0.10 )
+    , mPrerenderedMapDpi( 0 )
 {
   //Offset
   mXOffset = 0.0;
@@ -248,6 +250,24 @@ QgsMapSettings QgsComposerMap::mapSettings( const QgsRectangle& extent, const QS
   return jobMapSettings;
 }
 
+QgsMapSettings QgsComposerMap::printMapSettings( int dpi ) const
+{
+  const QgsRectangle& cExtent = *currentMapExtent();
+  QSizeF theSize( cExtent.width() * mapUnitsToMM(), cExtent.height() * mapUnitsToMM() );
+  theSize *= dpi / 25.4; // output size in dots, as in paint()
+
+  QgsMapSettings jobMapSettings = mapSettings( cExtent, theSize, dpi );
+  //the map is printed, no optimisations like layer simplification
+  jobMapSettings.setFlag( QgsMapSettings::UseRenderingOptimization, false );
+  return jobMapSettings;
+}
+
+void QgsComposerMap::setPrerenderedMap( const QImage& image, int dpi )
+{
+  mPrerenderedMap = image;
+  mPrerenderedMapDpi = dpi;
+}
+
 void QgsComposerMap::cache( void )
 {
   if ( mPreviewMode == Rectangle )
@@ -399,7 +419,15 @@ void QgsComposerMap::paint( QPainter* painter, const QStyleOptionGraphicsItem* i
     double dotsPerMM = thePaintDevice->logicalDpiX() / 25.4;
     theSize *= dotsPerMM; // output size will be in dots (pixels)
     painter->scale( 1 / dotsPerMM, 1 / dotsPerMM ); // scale painter from mm to dots
-    draw( painter, cExtent, theSize, thePaintDevice->logicalDpiX() );
+    if ( !mPrerenderedMap.isNull() && mPrerenderedMapDpi == thePaintDevice->logicalDpiX() &&
+         mPrerenderedMap.size() == theSize.toSize() )
+    {
+      painter->drawImage( 0, 0, mPrerenderedMap );
+    }
+    else
+    {
+      draw( painter, cExtent, theSize, thePaintDevice->logicalDpiX() );
+    }
 
     //restore rotation
     painter->restore();
@@ -156,6 +156,21 @@ class CORE_EXPORT QgsComposerMap : public QgsComposerItem
      *  @note added in 2.6 */
     QgsMapSettings mapSettings( const QgsRectangle& extent, const QSizeF& size, int dpi ) const;
 
+    /** Returns the map settings used for drawing the map layers when the map is printed to a
+     * device with the given resolution, e.g. to render the layers in advance with a map renderer job.
+     * @see setPrerenderedMap()
+     * @note added in QGIS 2.14
+     */
+    QgsMapSettings printMapSettings( int dpi ) const;
+
+    /** Sets an image of the map layers rendered in advance with printMapSettings(). When the map
+     * is printed to a device with the same resolution, the image is drawn instead of rendering
+     * the layers again. Set a null image to render the layers when printing.
+     * @see printMapSettings()
+     * @note added in QGIS 2.14
+     */
+    void setPrerenderedMap( const QImage& image, int dpi );
+
     /** \brief Get identification number*/
     int id() const {return mId;}
 
@@ -851,6 +866,10 @@ class CORE_EXPORT QgsComposerMap : public QgsComposerItem
     // Cache used in composer preview
     QImage mCacheImage;
 
+    // Map layers rendered in advance for printing, and their resolution
+    QImage mPrerenderedMap;
+    int mPrerenderedMapDpi;
+
     // Is cache up to date
     bool mCacheUpdated;
 
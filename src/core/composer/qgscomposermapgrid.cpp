@@ -496,6 +496,14 @@ void QgsComposerMapGrid::drawGridCRSTransform( QgsRenderContext &context, double
     mPrevMapPolygon = mapPolygon;
   }
 
+  //lines are reprojected from the map crs
+  QgsCoordinateReferenceSystem mapCrs = mComposerMap->composition()->mapSettings().destinationCrs();
+  if ( mapCrs != mPrevMapCrs )
+  {
+    mTransformDirty = true;
+    mPrevMapCrs = mapCrs;
+  }
+
   if ( mTransformDirty )
   {
     calculateCRSTransformLines();
@@ -563,6 +571,17 @@ void QgsComposerMapGrid::drawGridCRSTransform( QgsRenderContext &context, double
   }
 }
 
+static bool sortByBoundsTop( const QPair< QRectF, const QPolygonF* >& a, const QPair< QRectF, const QPolygonF* >& b )
+{
+  return a.first.top() < b.first.top();
+}
+
+static bool boundsOverlap( const QRectF& a, const QRectF& b )
+{
+  //unlike QRectF::intersects, also true for the zero width bounds of straight lines
+  return a.left() <= b.right() && b.left() <= a.right() && a.top() <= b.bottom() && b.top() <= a.bottom();
+}
+
 void QgsComposerMapGrid::calculateCRSTransformLines()
 {
   QgsRectangle crsBoundingRect;
@@ -584,60 +603,56 @@ void QgsComposerMapGrid::calculateCRSTransformLines()
   {
     //cross or markers style - we also need to calculate intersections of lines
 
-    //first convert lines to QgsGeometry
-    QList< QgsGeometry* > yLines;
-    QList< QPair< double, QPolygonF > >::const_iterator yGridIt = mTransformedYLines.constBegin();
-    for ( ; yGridIt != mTransformedYLines.constEnd(); ++yGridIt )
-    {
-      QgsPolyline yLine;
-      for ( int i = 0; i < ( *yGridIt ).second.size(); ++i )
-      {
-        yLine.append( QgsPoint(( *yGridIt ).second.at( i ).x(), ( *yGridIt ).second.at( i ).y() ) );
-      }
-      yLines << QgsGeometry::fromPolyline( yLine );
-    }
-    QList< QgsGeometry* > xLines;
+    //sweep through the lines ordered by their bounding boxes, so that only lines with
+    //overlapping bounds have their segments tested for intersections
+    QList< QPair< QRectF, const QPolygonF* > > xLines;
     QList< QPair< double, QPolygonF > >::const_iterator xGridIt = mTransformedXLines.constBegin();
     for ( ; xGridIt != mTransformedXLines.constEnd(); ++xGridIt )
     {
-      QgsPolyline xLine;
-      for ( int i = 0; i < ( *xGridIt ).second.size(); ++i )
-      {
-        xLine.append( QgsPoint(( *xGridIt ).second.at( i ).x(), ( *xGridIt ).second.at( i ).y() ) );
-      }
-      xLines << QgsGeometry::fromPolyline( xLine );
+      xLines << qMakePair( xGridIt->second.boundingRect(), &xGridIt->second );
     }
+    qSort( xLines.begin(), xLines.end(), sortByBoundsTop );
 
-    //now, loop through geometries and calculate intersection points
     mTransformedIntersections.clear();
-    QList< QgsGeometry* >::const_iterator yLineIt = yLines.constBegin();
-    for ( ; yLineIt != yLines.constEnd(); ++yLineIt )
+    QList< QPair< double, QPolygonF > >::const_iterator yGridIt = mTransformedYLines.constBegin();
+    for ( ; yGridIt != mTransformedYLines.constEnd(); ++yGridIt )
     {
-      QList< QgsGeometry* >::const_iterator xLineIt = xLines.constBegin();
-      for ( ; xLineIt != xLines.constEnd(); ++xLineIt )
+      const QPolygonF& yLine = yGridIt->second;
+      QRectF yBounds = yLine.boundingRect();
+
+      QList< QPair< QRectF, const QPolygonF* > >::const_iterator xLineIt = xLines.constBegin();
+      for ( ; xLineIt != xLines.constEnd() && xLineIt->first.top() <= yBounds.bottom(); ++xLineIt )
       {
-        //look for intersections between lines
-        QgsGeometry* intersects = ( *yLineIt )->intersection(( *xLineIt ) );
-        if ( !intersects )
+        const QRectF& xBounds = xLineIt->first;
+        if ( !boundsOverlap( xBounds, yBounds ) )
           continue;
 
-        //go through all intersections and draw grid markers/crosses
-        int i = 0;
-        QgsPoint vertex = intersects->vertexAt( i );
-        while ( vertex != QgsPoint( 0, 0 ) )
+        const QPolygonF& xLine = *xLineIt->second;
+        int lineIntersections = 0;
+        QPointF lastIntersection;
+        for ( int i = 1; i < yLine.size(); ++i )
         {
-          mTransformedIntersections << vertex;
-          i = i + 1;
-          vertex = intersects->vertexAt( i );
+          QLineF ySegment( yLine.at( i - 1 ), yLine.at( i ) );
+          if ( !boundsOverlap( QRectF( ySegment.p1(), ySegment.p2() ).normalized(), xBounds ) )
+            continue;
+
+          for ( int j = 1; j < xLine.size(); ++j )
+          {
+            QPointF intersectionPoint;
+            if ( ySegment.intersect( QLineF( xLine.at( j - 1 ), xLine.at( j ) ), &intersectionPoint ) != QLineF::BoundedIntersection )
+              continue;
+
+            //lines crossing at a vertex intersect in two adjacent segments
+            if ( lineIntersections > 0 && qgsDoubleNear( intersectionPoint.x(), lastIntersection.x() ) && qgsDoubleNear( intersectionPoint.y(), lastIntersection.y() ) )
+              continue;
+
+            mTransformedIntersections << QgsPoint( intersectionPoint.x(), intersectionPoint.y() );
+            lastIntersection = intersectionPoint;
+            ++lineIntersections;
+          }
         }
-        delete intersects;
       }
     }
-    //clean up
-    qDeleteAll( yLines );
-    yLines.clear();
-    qDeleteAll( xLines );
-    xLines.clear();
   }
 
   mTransformDirty = false;
@@ -2113,11 +2128,11 @@ void QgsComposerMapGrid::calculateMaxExtension( double& top, double& right, doub
   QList< QPair< double, QLineF > > horizontalLines;
   if ( mGridUnit == MapUnit && mCRS.isValid() && mCRS != ms.destinationCrs() )
   {
-    drawGridCRSTransform( context, 0, horizontalLines, verticalLines, false );
+    drawGridCRSTransform( context, 0, horizontalLines, verticalLines, true );
   }
   else
   {
-    drawGridNoTransform( context, 0, horizontalLines, verticalLines, false );
+    drawGridNoTransform( context, 0, horizontalLines, verticalLines, true );
   }
 
   if ( mGridFrameStyle != QgsComposerMapGrid::NoFrame )
@@ -929,6 +929,7 @@ class CORE_EXPORT QgsComposerMapGrid : public QgsComposerMapItem
     QList< QgsPoint > mTransformedIntersections;
     QRectF mPrevPaintRect;
     QPolygonF mPrevMapPolygon;
+    QgsCoordinateReferenceSystem mPrevMapCrs;
 
     class QgsMapAnnotation
     {
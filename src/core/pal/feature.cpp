@@ -1278,6 +1278,12 @@ namespace pal
     {
       lPos << new LabelPosition( 0, mLF->fixedPosition().x(), mLF->fixedPosition().y(), getLabelWidth(), getLabelHeight(), angle, 0.0, this );
     }
+    else if ( mLF->hasRetainedPosition() )
+    {
+      // keep the label where the previous labeling run placed it
+      lPos << new LabelPosition( 0, mLF->retainedPosition().x(), mLF->retainedPosition().y(), getLabelWidth(), getLabelHeight(),
+                                 mLF->retainedAngle(), 0.0, this, mLF->retainedReversed(), ( LabelPosition::Quadrant ) mLF->retainedQuadrant() );
+    }
     else
     {
       switch ( type )
@@ -1333,7 +1339,7 @@ namespace pal
         i.remove();
         delete pos;
       }
-      else   // this one is OK
+      else if ( candidates )  // this one is OK
       {
         pos->insertIntoIndex( candidates );
       }
@@ -158,10 +158,11 @@ namespace pal
        * \param bbox_min min values of the map extent
        * \param bbox_max max values of the map extent
        * \param mapShape generate candidates for this spatial entity
-       * \param candidates index for candidates
+       * \param candidates index for candidates. If null, the caller is responsible for indexing the
+       * generated candidates, which allows candidates of several features to be generated concurrently.
        * \return the number of candidates in *lPos
        */
-      int setPosition( QList<LabelPosition *> &lPos, double bbox_min[2], double bbox_max[2], PointSet *mapShape, RTree<LabelPosition*, double, 2, double>*candidates );
+      int setPosition( QList<LabelPosition *> &lPos, double bbox_min[2], double bbox_max[2], PointSet *mapShape, RTree<LabelPosition*, double, 2, double>*candidates = 0 );
 
       /** Returns the unique ID of the feature.
        */
@@ -46,6 +46,7 @@
 #include "internalexception.h"
 #include "util.h"
 #include <QTime>
+#include <QtConcurrentMap>
 #include <cstdarg>
 #include <iostream>
 #include <fstream>
@@ -134,9 +135,8 @@ namespace pal
   typedef struct _featCbackCtx
   {
     Layer *layer;
-    QLinkedList<Feats*>* fFeats;
+    QList<Feats*>* fFeats;
     RTree<FeaturePart*, double, 2, double> *obstacles;
-    RTree<LabelPosition*, double, 2, double> *candidates;
     double bbox_min[2];
     double bbox_max[2];
   } FeatCallBackCtx;
@@ -165,24 +165,89 @@ namespace pal
       }
     }
 
-    // generate candidates for the feature part
-    QList< LabelPosition* > lPos;
-    if ( ft_ptr->setPosition( lPos, context->bbox_min, context->bbox_max, ft_ptr, context->candidates ) )
-    {
-      // valid features are added to fFeats
-      Feats *ft = new Feats();
-      ft->feature = ft_ptr;
-      ft->shape = NULL;
-      ft->lPos = lPos;
-      ft->priority = ft_ptr->calculatePriority();
-      context->fFeats->append( ft );
-    }
-    else
-    {
-      // Others are deleted
-      qDeleteAll( lPos );
-    }
+    // candidates for the feature part are generated later in parallel, see Pal::extract()
+    Feats *ft = new Feats();
+    ft->feature = ft_ptr;
+    ft->shape = NULL;
+    context->fFeats->append( ft );
+
+    return true;
+  }
+
+  /*
+   * Functor for QtConcurrent
+   *
+   * Generates candidates for a single feature part. Only the feature part itself
+   * is touched, so several feature parts may be processed concurrently.
+   */
+  class GenerateCandidatesWrapper
+  {
+    public:
+      GenerateCandidatesWrapper( double bbox_min[2], double bbox_max[2] )
+      {
+        mBboxMin[0] = bbox_min[0];
+        mBboxMin[1] = bbox_min[1];
+        mBboxMax[0] = bbox_max[0];
+        mBboxMax[1] = bbox_max[1];
+      }
+
+      void operator()( Feats* ft )
+      {
+        ft->feature->setPosition( ft->lPos, mBboxMin, mBboxMax, ft->feature, 0 );
+      }
+
+    private:
+      double mBboxMin[2];
+      double mBboxMax[2];
+  };
+
+  /** Candidates of a feature with the number of candidates to keep */
+  struct CandidateCostJob
+  {
+    Feats *feat;
+    int maxCandidates;
+  };
+
+  /*
+   * Functor for QtConcurrent
+   *
+   * Sorts candidates and computes their final costs. The obstacle index is only
+   * read, its GEOS geometries have to be created beforehand (see prepareObstacleCallback).
+   */
+  class FinalizeCostsWrapper
+  {
+    public:
+      FinalizeCostsWrapper( RTree<FeaturePart*, double, 2, double> *obstacles, double bbx[4], double bby[4] )
+          : mObstacles( obstacles )
+      {
+        for ( int i = 0; i < 4; ++i )
+        {
+          mBbx[i] = bbx[i];
+          mBby[i] = bby[i];
+        }
+      }
+
+      void operator()( CandidateCostJob& job )
+      {
+        job.maxCandidates = CostCalculator::finalizeCandidatesCosts( job.feat, job.maxCandidates, mObstacles, mBbx, mBby );
+      }
+
+    private:
+      RTree<FeaturePart*, double, 2, double> *mObstacles;
+      double mBbx[4];
+      double mBby[4];
+  };
 
+  /*
+   * Callback function
+   *
+   * Creates the lazily built GEOS geometry and prepared geometry of an obstacle, so that
+   * the obstacle index can be safely searched from several threads afterwards
+   */
+  bool prepareObstacleCallback( FeaturePart *ft_ptr, void *ctx )
+  {
+    Q_UNUSED( ctx );
+    ft_ptr->preparedGeom();
     return true;
   }
 
@@ -262,11 +327,11 @@ namespace pal
     prob->pal = this;
 
     QLinkedList<Feats*> *fFeats = new QLinkedList<Feats*>;
+    QList<Feats*> layerFeats;
 
     FeatCallBackCtx context;
-    context.fFeats = fFeats;
+    context.fFeats = &layerFeats;
     context.obstacles = obstacles;
-    context.candidates = prob->candidates;
     context.bbox_min[0] = amin[0];
     context.bbox_min[1] = amin[1];
     context.bbox_max[0] = amax[0];
@@ -304,19 +369,44 @@ namespace pal
 
       layer->mMutex.lock();
 
-      // find features within bounding box and generate candidates list
+      // find features within bounding box
       context.layer = layer;
+      layerFeats.clear();
       layer->mFeatureIndex->Search( amin, amax, extractFeatCallback, ( void* ) &context );
       // find obstacles within bounding box
       layer->mObstacleIndex->Search( amin, amax, extractObstaclesCallback, ( void* ) &obstacleContext );
 
+      // generate candidates list, spread across the global thread pool
+      QtConcurrent::blockingMap( layerFeats, GenerateCandidatesWrapper( context.bbox_min, context.bbox_max ) );
+
       layer->mMutex.unlock();
 
-      if ( context.fFeats->size() - previousFeatureCount > 0 || obstacleContext.obstacleCount > previousObstacleCount )
+      // merge in the original order, so the result does not depend on thread scheduling
+      Q_FOREACH ( Feats* ft, layerFeats )
+      {
+        if ( !ft->lPos.isEmpty() )
+        {
+          // valid features are added to fFeats
+          ft->priority = ft->feature->calculatePriority();
+          Q_FOREACH ( LabelPosition* pos, ft->lPos )
+          {
+            pos->insertIntoIndex( prob->candidates );
+          }
+          fFeats->append( ft );
+        }
+        else
+        {
+          // Others are deleted
+          delete ft;
+        }
+      }
+      layerFeats.clear();
+
+      if ( fFeats->size() - previousFeatureCount > 0 || obstacleContext.obstacleCount > previousObstacleCount )
       {
         layersWithFeaturesInBBox << layer->name();
       }
-      previousFeatureCount = context.fFeats->size();
+      previousFeatureCount = fFeats->size();
       previousObstacleCount = obstacleContext.obstacleCount;
     }
     mMutex.unlock();
@@ -370,29 +460,44 @@ namespace pal
       return 0;
     }
 
-    int idlp = 0;
-    for ( i = 0; i < prob->nbft; i++ ) /* foreach feature into prob */
-    {
-      feat = fFeats->takeFirst();
-
-      prob->featStartId[i] = idlp;
-      prob->inactiveCost[i] = pow( 2, 10 - 10 * feat->priority );
+    // make sure that the obstacle index is read-only while computing the candidate costs
+    obstacles->Search( amin, amax, prepareObstacleCallback, 0 );
 
+    QVector< CandidateCostJob > costJobs;
+    costJobs.reserve( prob->nbft );
+    Q_FOREACH ( Feats* feat, *fFeats )
+    {
+      CandidateCostJob job;
+      job.feat = feat;
       switch ( feat->feature->getGeosType() )
       {
         case GEOS_POINT:
-          max_p = point_p;
+          job.maxCandidates = point_p;
           break;
         case GEOS_LINESTRING:
-          max_p = line_p;
+          job.maxCandidates = line_p;
           break;
         case GEOS_POLYGON:
-          max_p = poly_p;
+          job.maxCandidates = poly_p;
+          break;
+        default:
+          job.maxCandidates = max_p;
           break;
       }
+      costJobs << job;
+    }
 
-      // sort candidates by cost, skip less interesting ones, calculate polygon costs (if using polygons)
-      max_p = CostCalculator::finalizeCandidatesCosts( feat, max_p, obstacles, bbx, bby );
+    // sort candidates by cost, skip less interesting ones, calculate polygon costs (if using polygons)
+    QtConcurrent::blockingMap( costJobs, FinalizeCostsWrapper( obstacles, bbx, bby ) );
+
+    int idlp = 0;
+    for ( i = 0; i < prob->nbft; i++ ) /* foreach feature into prob */
+    {
+      feat = fFeats->takeFirst();
+      max_p = costJobs.at( i ).maxCandidates;
+
+      prob->featStartId[i] = idlp;
+      prob->inactiveCost[i] = pow( 2, 10 - 10 * feat->priority );
 
       // only keep the 'max_p' best candidates
       while ( feat->lPos.count() > max_p )
@@ -132,6 +132,13 @@ class CORE_EXPORT QgsCachedFeatureWriterIterator : public QgsAbstractFeatureIter
      */
     virtual bool fetchFeature( QgsFeature& f ) override;
 
+    /**
+     * The features are ordered by the layer iterator answering the request.
+     *
+     * @note added in QGIS 2.14
+     */
+    virtual bool prepareOrderBy( const QList<QgsFeatureRequest::OrderByClause>& orderBys ) override { Q_UNUSED( orderBys ); return true; }
+
   private:
     QgsFeatureIterator mFeatIt;
     QgsVectorLayerCache* mVectorLayerCache;
@@ -47,6 +47,42 @@
 
 CUSTOM_CRS_VALIDATION QgsCoordinateReferenceSystem::mCustomSrsValidation = NULL;
 
+// a proj4 match must be unique in srs.db, otherwise the user qgis.db is tried,
+// ambiguous matches are rejected
+static bool uniqueRecord( const QList<QgsCRSCatalog::Record>& records, QgsCRSCatalog::Record& record )
+{
+  QList<QgsCRSCatalog::Record> system;
+  QList<QgsCRSCatalog::Record> user;
+  Q_FOREACH ( const QgsCRSCatalog::Record& r, records )
+  {
+    if ( r.srsId < USER_CRS_START_ID )
+      system << r;
+    else
+      user << r;
+  }
+
+  if ( system.size() == 1 )
+  {
+    record = system.first();
+    return true;
+  }
+  if ( system.size() > 1 )
+  {
+    QgsDebugMsg( "Multiple records found in srs.db" );
+  }
+
+  if ( user.size() == 1 )
+  {
+    record = user.first();
+    return true;
+  }
+  if ( user.size() > 1 )
+  {
+    QgsDebugMsg( "Multiple records found in user qgis.db" );
+  }
+  return false;
+}
+
 //--------------------------
 
 QgsCoordinateReferenceSystem::QgsCoordinateReferenceSystem()
@@ -224,7 +260,9 @@ bool QgsCoordinateReferenceSystem::createFromOgcWmsCrs( QString theCrs )
     }
   }
 
-  if ( loadFromDb( QgsApplication::srsDbFilePath(), "lower(auth_name||':'||auth_id)", theCrs.toLower() ) )
+  QgsCRSCatalog::Record record;
+  bool found = QgsCRSCatalog::instance()->recordByAuthId( theCrs, record );
+  if ( loadFromRecord( found ? &record : 0 ) )
     return true;
 
   // NAD27
@@ -308,97 +346,55 @@ void QgsCoordinateReferenceSystem::validate()
 
 bool QgsCoordinateReferenceSystem::createFromSrid( long id )
 {
-  return loadFromDb( QgsApplication::srsDbFilePath(), "srid", QString::number( id ) );
+  QgsCRSCatalog::Record record;
+  bool found = QgsCRSCatalog::instance()->recordBySrid( id, record );
+  return loadFromRecord( found ? &record : 0 );
 }
 
 bool QgsCoordinateReferenceSystem::createFromSrsId( long id )
 {
-  return loadFromDb( id < USER_CRS_START_ID ? QgsApplication::srsDbFilePath() :
-                     QgsApplication::qgisUserDbFilePath(),
-                     "srs_id", QString::number( id ) );
+  QgsCRSCatalog::Record record;
+  bool found = QgsCRSCatalog::instance()->recordBySrsId( id, record );
+  return loadFromRecord( found ? &record : 0 );
 }
 
-bool QgsCoordinateReferenceSystem::loadFromDb( const QString& db, const QString& expression, const QString& value )
+bool QgsCoordinateReferenceSystem::loadFromRecord( const QgsCRSCatalog::Record* record )
 {
-  QgsDebugMsgLevel( "load CRS from " + db + " where " + expression + " is " + value, 3 );
   mIsValidFlag = false;
   mWkt.clear();
 
-  QFileInfo myInfo( db );
-  if ( !myInfo.exists() )
+  if ( !record )
   {
-    QgsDebugMsg( "failed : " + db + " does not exist!" );
     return mIsValidFlag;
   }
 
-  sqlite3      *myDatabase;
-  const char   *myTail;
-  sqlite3_stmt *myPreparedStatement;
-  int           myResult;
-  //check the db is available
-  myResult = openDb( db, &myDatabase );
-  if ( myResult != SQLITE_OK )
+  mSrsId = record->srsId;
+  mDescription = record->description;
+  mProjectionAcronym = record->projectionAcronym;
+  mEllipsoidAcronym = record->ellipsoidAcronym;
+  mProj4 = record->parameters;
+  mSRID = record->srid;
+  mAuthId = record->authId;
+  mGeoFlag = record->isGeo;
+  mAxisInverted = -1;
+
+  if ( mSrsId >= USER_CRS_START_ID && mAuthId.isEmpty() )
   {
-    QgsDebugMsg( "failed : " + db + " could not be opened!" );
-    return mIsValidFlag;
+    mAuthId = QString( "USER:%1" ).arg( mSrsId );
   }
-
-  /*
-    srs_id INTEGER PRIMARY KEY,
-    description text NOT NULL,
-    projection_acronym text NOT NULL,
-    ellipsoid_acronym NOT NULL,
-    parameters text NOT NULL,
-    srid integer NOT NULL,
-    auth_name varchar NOT NULL,
-    auth_id integer NOT NULL,
-    is_geo integer NOT NULL);
-  */
-
-  QString mySql = "select srs_id,description,projection_acronym,"
-                  "ellipsoid_acronym,parameters,srid,auth_name||':'||auth_id,is_geo "
-                  "from tbl_srs where " + expression + '=' + quotedValue( value ) + " order by deprecated";
-  myResult = sqlite3_prepare( myDatabase, mySql.toUtf8(),
-                              mySql.toUtf8().length(),
-                              &myPreparedStatement, &myTail );
-  // XXX Need to free memory from the error msg if one is set
-  if ( myResult == SQLITE_OK && sqlite3_step( myPreparedStatement ) == SQLITE_ROW )
-  {
-    mSrsId = QString::fromUtf8(( char * )sqlite3_column_text(
-                                 myPreparedStatement, 0 ) ).toLong();
-    mDescription = QString::fromUtf8(( char * )sqlite3_column_text(
-                                       myPreparedStatement, 1 ) );
-    mProjectionAcronym = QString::fromUtf8(( char * )sqlite3_column_text( myPreparedStatement, 2 ) );
-    mEllipsoidAcronym = QString::fromUtf8(( char * )sqlite3_column_text( myPreparedStatement, 3 ) );
-    mProj4 = QString::fromUtf8(( char * )sqlite3_column_text( myPreparedStatement, 4 ) );
-    mSRID = QString::fromUtf8(( char * )sqlite3_column_text( myPreparedStatement, 5 ) ).toLong();
-    mAuthId = QString::fromUtf8(( char * )sqlite3_column_text( myPreparedStatement, 6 ) );
-    mGeoFlag = QString::fromUtf8(( char * )sqlite3_column_text( myPreparedStatement, 7 ) ).toInt() != 0;
-    mAxisInverted = -1;
-
-    if ( mSrsId >= USER_CRS_START_ID && mAuthId.isEmpty() )
-    {
-      mAuthId = QString( "USER:%1" ).arg( mSrsId );
-    }
-    else if ( mAuthId.startsWith( "EPSG:", Qt::CaseInsensitive ) )
-    {
-      OSRDestroySpatialReference( mCRS );
-      mCRS = OSRNewSpatialReference( NULL );
-      mIsValidFlag = OSRSetFromUserInput( mCRS, mAuthId.toLower().toAscii() ) == OGRERR_NONE;
-      setMapUnits();
-    }
-
-    if ( !mIsValidFlag )
-    {
-      setProj4String( mProj4 );
-    }
+  else if ( mAuthId.startsWith( "EPSG:", Qt::CaseInsensitive ) )
+  {
+    OSRDestroySpatialReference( mCRS );
+    mCRS = OSRNewSpatialReference( NULL );
+    mIsValidFlag = OSRSetFromUserInput( mCRS, mAuthId.toLower().toAscii() ) == OGRERR_NONE;
+    setMapUnits();
   }
-  else
+
+  if ( !mIsValidFlag )
   {
-    QgsDebugMsg( "failed : " + mySql );
+    setProj4String( mProj4 );
   }
-  sqlite3_finalize( myPreparedStatement );
-  sqlite3_close( myDatabase );
+
   return mIsValidFlag;
 }
 
@@ -562,14 +558,14 @@ bool QgsCoordinateReferenceSystem::createFromProj4( const QString &theProj4Strin
    * as its quicker than methods below..
    */
   long mySrsId = 0;
-  QgsCoordinateReferenceSystem::RecordMap myRecord;
+  QgsCRSCatalog::Record myRecord;
 
   /*
    * - if the above does not match perform a whole text search on proj4 string (if not null)
    */
   // QgsDebugMsg( "wholetext match on name failed, trying proj4string match" );
-  myRecord = getRecord( "select * from tbl_srs where parameters=" + quotedValue( myProj4String ) + " order by deprecated" );
-  if ( myRecord.empty() )
+  bool found = uniqueRecord( QgsCRSCatalog::instance()->recordsByProj4( myProj4String ), myRecord );
+  if ( !found )
   {
     // Ticket #722 - aaronr
     // Check if we can swap the lat_1 and lat_2 params (if they exist) to see if we match...
@@ -603,78 +599,48 @@ bool QgsCoordinateReferenceSystem::createFromProj4( const QString &theProj4Strin
       myStart2 = myLat2RegExp.indexIn( theProj4String, myStart2 );
       theProj4StringModified.replace( myStart2 + LAT_PREFIX_LEN, myLength2 - LAT_PREFIX_LEN, lat1Str );
       QgsDebugMsg( "trying proj4string match with swapped lat_1,lat_2" );
-      myRecord = getRecord( "select * from tbl_srs where parameters=" + quotedValue( theProj4StringModified.trimmed() ) + " order by deprecated" );
+      found = uniqueRecord( QgsCRSCatalog::instance()->recordsByProj4( theProj4StringModified.trimmed() ), myRecord );
     }
   }
 
-  if ( myRecord.empty() )
+  if ( !found )
   {
     // match all parameters individually:
     // - order of parameters doesn't matter
-    // - found definition may have more parameters (like +towgs84 in GDAL)
     // - retry without datum, if no match is found (looks like +datum<>WGS84 was dropped in GDAL)
-
-    QString sql = "SELECT * FROM tbl_srs WHERE ";
-    QString delim = "";
     QString datum;
+    QgsCRSCatalog::normalizedProj4( myProj4String, &datum );
+    QList<QgsCRSCatalog::Record> candidates = QgsCRSCatalog::instance()->recordsByProj4Parameters( myProj4String );
 
-    // split on spaces followed by a plus sign (+) to deal
-    // also with parameters containing spaces (e.g. +nadgrids)
-    // make sure result is trimmed (#5598)
-    QStringList myParams;
-    Q_FOREACH ( const QString& param, myProj4String.split( QRegExp( "\\s+(?=\\+)" ), QString::SkipEmptyParts ) )
+    if ( !datum.isEmpty() )
     {
-      QString arg = QString( "' '||parameters||' ' LIKE %1" ).arg( quotedValue( QString( "% %1 %" ).arg( param.trimmed() ) ) );
-      if ( param.startsWith( "+datum=" ) )
+      QList<QgsCRSCatalog::Record> sameDatum;
+      Q_FOREACH ( const QgsCRSCatalog::Record& candidate, candidates )
       {
-        datum = arg;
-      }
-      else
-      {
-        sql += delim + arg;
-        delim = " AND ";
-        myParams << param.trimmed();
+        QString candidateDatum;
+        QgsCRSCatalog::normalizedProj4( candidate.parameters, &candidateDatum );
+        if ( candidateDatum == datum )
+        {
+          sameDatum << candidate;
+        }
       }
+      found = uniqueRecord( sameDatum, myRecord );
     }
 
-    if ( !datum.isEmpty() )
-    {
-      myRecord = getRecord( sql + delim + datum + " order by deprecated" );
-    }
-
-    if ( myRecord.empty() )
+    if ( !found )
     {
       // datum might have disappeared in definition - retry without it
-      myRecord = getRecord( sql + " order by deprecated" );
-    }
-
-    if ( !myRecord.empty() )
-    {
-      // Bugfix 8487 : test param lists are equal, except for +datum
-      QStringList foundParams;
-      Q_FOREACH ( const QString& param, myRecord["parameters"].split( QRegExp( "\\s+(?=\\+)" ), QString::SkipEmptyParts ) )
-      {
-        if ( !param.startsWith( "+datum=" ) )
-          foundParams << param.trimmed();
-      }
-
-      myParams.sort();
-      foundParams.sort();
-
-      if ( myParams != foundParams )
-      {
-        myRecord.clear();
-      }
+      found = uniqueRecord( candidates, myRecord );
     }
   }
 
-  if ( !myRecord.empty() )
+  if ( found )
   {
-    mySrsId = myRecord["srs_id"].toLong();
+    mySrsId = myRecord.srsId;
     QgsDebugMsg( "proj4string param match search for srsid returned srsid: " + QString::number( mySrsId ) );
     if ( mySrsId > 0 )
     {
-      createFromSrsId( mySrsId );
+      loadFromRecord( &myRecord );
     }
   }
   else
@@ -705,120 +671,6 @@ bool QgsCoordinateReferenceSystem::createFromProj4( const QString &theProj4Strin
   return mIsValidFlag;
 }
 
-//private method meant for internal use by this class only
-QgsCoordinateReferenceSystem::RecordMap QgsCoordinateReferenceSystem::getRecord( const QString& theSql )
-{
-  QString myDatabaseFileName;
-  QgsCoordinateReferenceSystem::RecordMap myMap;
-  QString myFieldName;
-  QString myFieldValue;
-  sqlite3      *myDatabase;
-  const char   *myTail;
-  sqlite3_stmt *myPreparedStatement;
-  int           myResult;
-
-  QgsDebugMsg( "running query: " + theSql );
-  // Get the full path name to the sqlite3 spatial reference database.
-  myDatabaseFileName = QgsApplication::srsDbFilePath();
-  QFileInfo myInfo( myDatabaseFileName );
-  if ( !myInfo.exists() )
-  {
-    QgsDebugMsg( "failed : " + myDatabaseFileName + " does not exist!" );
-    return myMap;
-  }
-
-  //check the db is available
-  myResult = openDb( myDatabaseFileName, &myDatabase );
-  if ( myResult != SQLITE_OK )
-  {
-    return myMap;
-  }
-
-  myResult = sqlite3_prepare( myDatabase, theSql.toUtf8(), theSql.toUtf8().length(), &myPreparedStatement, &myTail );
-  // XXX Need to free memory from the error msg if one is set
-  if ( myResult == SQLITE_OK && sqlite3_step( myPreparedStatement ) == SQLITE_ROW )
-  {
-    QgsDebugMsg( "trying system srs.db" );
-    int myColumnCount = sqlite3_column_count( myPreparedStatement );
-    //loop through each column in the record adding its expression name and value to the map
-    for ( int myColNo = 0; myColNo < myColumnCount; myColNo++ )
-    {
-      myFieldName = QString::fromUtf8(( char * )sqlite3_column_name( myPreparedStatement, myColNo ) );
-      myFieldValue = QString::fromUtf8(( char * )sqlite3_column_text( myPreparedStatement, myColNo ) );
-      myMap[myFieldName] = myFieldValue;
-    }
-    if ( sqlite3_step( myPreparedStatement ) != SQLITE_DONE )
-    {
-      QgsDebugMsg( "Multiple records found in srs.db" );
-      myMap.clear();
-    }
-  }
-  else
-  {
-    QgsDebugMsg( "failed :  " + theSql );
-  }
-
-  if ( myMap.empty() )
-  {
-    QgsDebugMsg( "trying user qgis.db" );
-    sqlite3_finalize( myPreparedStatement );
-    sqlite3_close( myDatabase );
-
-    myDatabaseFileName = QgsApplication::qgisUserDbFilePath();
-    QFileInfo myFileInfo;
-    myFileInfo.setFile( myDatabaseFileName );
-    if ( !myFileInfo.exists() )
-    {
-      QgsDebugMsg( "user qgis.db not found" );
-      return myMap;
-    }
-
-    //check the db is available
-    myResult = openDb( myDatabaseFileName, &myDatabase );
-    if ( myResult != SQLITE_OK )
-    {
-      return myMap;
-    }
-
-    myResult = sqlite3_prepare( myDatabase, theSql.toUtf8(), theSql.toUtf8().length(), &myPreparedStatement, &myTail );
-    // XXX Need to free memory from the error msg if one is set
-    if ( myResult == SQLITE_OK && sqlite3_step( myPreparedStatement ) == SQLITE_ROW )
-    {
-      int myColumnCount = sqlite3_column_count( myPreparedStatement );
-      //loop through each column in the record adding its field name and value to the map
-      for ( int myColNo = 0; myColNo < myColumnCount; myColNo++ )
-      {
-        myFieldName = QString::fromUtf8(( char * )sqlite3_column_name( myPreparedStatement, myColNo ) );
-        myFieldValue = QString::fromUtf8(( char * )sqlite3_column_text( myPreparedStatement, myColNo ) );
-        myMap[myFieldName] = myFieldValue;
-      }
-
-      if ( sqlite3_step( myPreparedStatement ) != SQLITE_DONE )
-      {
-        QgsDebugMsg( "Multiple records found in srs.db" );
-        myMap.clear();
-      }
-    }
-    else
-    {
-      QgsDebugMsg( "failed :  " + theSql );
-    }
-  }
-  sqlite3_finalize( myPreparedStatement );
-  sqlite3_close( myDatabase );
-
-#ifdef QGISDEBUG
-  QgsDebugMsg( "retrieved:  " + theSql );
-  RecordMap::Iterator it;
-  for ( it = myMap.begin(); it != myMap.end(); ++it )
-  {
-    QgsDebugMsgLevel( it.key() + " => " + it.value(), 2 );
-  }
-#endif
-
-  return myMap;
-}
-
 // Accessors -----------------------------------
 
 long QgsCoordinateReferenceSystem::srsid() const
@@ -1029,94 +881,18 @@ long QgsCoordinateReferenceSystem::findMatchingProj()
     return 0;
   }
 
-  sqlite3      *myDatabase;
-  const char   *myTail;
-  sqlite3_stmt *myPreparedStatement;
-  int           myResult;
-
-  // Set up the query to retrieve the projection information
-  // needed to populate the list
-  QString mySql = QString( "select srs_id,parameters from tbl_srs where "
-                           "projection_acronym=%1 and ellipsoid_acronym=%2 order by deprecated" )
-                  .arg( quotedValue( mProjectionAcronym ),
-                        quotedValue( mEllipsoidAcronym ) );
-  // Get the full path name to the sqlite3 spatial reference database.
-  QString myDatabaseFileName = QgsApplication::srsDbFilePath();
-
-  //check the db is available
-  myResult = openDb( myDatabaseFileName, &myDatabase );
-  if ( myResult != SQLITE_OK )
-  {
-    return 0;
-  }
-
-  myResult = sqlite3_prepare( myDatabase, mySql.toUtf8(), mySql.toUtf8().length(), &myPreparedStatement, &myTail );
-// XXX Need to free memory from the error msg if one is set
-  if ( myResult == SQLITE_OK )
-  {
-
-    while ( sqlite3_step( myPreparedStatement ) == SQLITE_ROW )
-    {
-      QString mySrsId = QString::fromUtf8(( char * )sqlite3_column_text( myPreparedStatement, 0 ) );
-      QString myProj4String = QString::fromUtf8(( char * )sqlite3_column_text( myPreparedStatement, 1 ) );
-      if ( toProj4() == myProj4String.trimmed() )
-      {
-        QgsDebugMsg( "-------> MATCH FOUND in srs.db srsid: " + mySrsId );
-        // close the sqlite3 statement
-        sqlite3_finalize( myPreparedStatement );
-        sqlite3_close( myDatabase );
-        return mySrsId.toLong();
-      }
-      else
-      {
-// QgsDebugMsg(QString(" Not matched : %1").arg(myProj4String));
-      }
-    }
-  }
-  QgsDebugMsg( "no match found in srs.db, trying user db now!" );
-  // close the sqlite3 statement
-  sqlite3_finalize( myPreparedStatement );
-  sqlite3_close( myDatabase );
-  //
-  // Try the users db now
-  //
-
-  myDatabaseFileName = QgsApplication::qgisUserDbFilePath();
-  //check the db is available
-  myResult = openDb( myDatabaseFileName, &myDatabase );
-  if ( myResult != SQLITE_OK )
-  {
-    return 0;
-  }
-
-  myResult = sqlite3_prepare( myDatabase, mySql.toUtf8(), mySql.toUtf8().length(), &myPreparedStatement, &myTail );
-// XXX Need to free memory from the error msg if one is set
-  if ( myResult == SQLITE_OK )
+  // candidates with the same proj4 string are looked up in the CRS catalog,
+  // the system definitions come before the user ones
+  QString myProj4String = toProj4();
+  Q_FOREACH ( const QgsCRSCatalog::Record& record, QgsCRSCatalog::instance()->recordsByProj4( myProj4String ) )
   {
-
-    while ( sqlite3_step( myPreparedStatement ) == SQLITE_ROW )
+    if ( record.projectionAcronym == mProjectionAcronym && record.ellipsoidAcronym == mEllipsoidAcronym )
     {
-      QString mySrsId = QString::fromUtf8(( char * )sqlite3_column_text( myPreparedStatement, 0 ) );
-      QString myProj4String = QString::fromUtf8(( char * )sqlite3_column_text( myPreparedStatement, 1 ) );
-      if ( toProj4() == myProj4String.trimmed() )
-      {
-        QgsDebugMsg( "-------> MATCH FOUND in user qgis.db srsid: " + mySrsId );
-        // close the sqlite3 statement
-        sqlite3_finalize( myPreparedStatement );
-        sqlite3_close( myDatabase );
-        return mySrsId.toLong();
-      }
-      else
-      {
-// QgsDebugMsg(QString(" Not matched : %1").arg(myProj4String));
-      }
+      QgsDebugMsg( "-------> MATCH FOUND srsid: " + QString::number( record.srsId ) );
+      return record.srsId;
     }
   }
-  QgsDebugMsg( "no match found in user db" );
-
-  // close the sqlite3 statement
-  sqlite3_finalize( myPreparedStatement );
-  sqlite3_close( myDatabase );
+  QgsDebugMsg( "no match found in srs.db and user db" );
   return 0;
 }
 
@@ -1324,64 +1100,14 @@ bool QgsCoordinateReferenceSystem::writeXML( QDomNode & theNode, QDomDocument &
 //this is a static method! NOTE I've made it private for now to reduce API clutter TS
 QString QgsCoordinateReferenceSystem::proj4FromSrsId( const int theSrsId )
 {
-
-  QString myDatabaseFileName;
-  QString myProjString;
-  QString mySql = QString( "select parameters from tbl_srs where srs_id = %1 order by deprecated" ).arg( theSrsId );
-
   QgsDebugMsg( "mySrsId = " + QString::number( theSrsId ) );
-  QgsDebugMsg( "USER_CRS_START_ID = " + QString::number( USER_CRS_START_ID ) );
-  QgsDebugMsg( "Selection sql : " + mySql );
 
-  //
-  // Determine if this is a user projection or a system on
-  // user projection defs all have srs_id >= 100000
-  //
-  if ( theSrsId >= USER_CRS_START_ID )
-  {
-    myDatabaseFileName = QgsApplication::qgisUserDbFilePath();
-    QFileInfo myFileInfo;
-    myFileInfo.setFile( myDatabaseFileName );
-    if ( !myFileInfo.exists() ) //its unlikely that this condition will ever be reached
-    {
-      QgsDebugMsg( "users qgis.db not found" );
-      return NULL;
-    }
-  }
-  else //must be  a system projection then
-  {
-    myDatabaseFileName = QgsApplication::srsDbFilePath();
-  }
-  QgsDebugMsg( "db = " + myDatabaseFileName );
-
-  sqlite3 *db;
-  int rc;
-  rc = openDb( myDatabaseFileName, &db );
-  if ( rc )
+  QgsCRSCatalog::Record record;
+  if ( !QgsCRSCatalog::instance()->recordBySrsId( theSrsId, record ) )
   {
     return QString();
   }
-  // prepare the sql statement
-  const char *pzTail;
-  sqlite3_stmt *ppStmt;
-
-  rc = sqlite3_prepare( db, mySql.toUtf8(), mySql.toUtf8().length(), &ppStmt, &pzTail );
-  // XXX Need to free memory from the error msg if one is set
-
-  if ( rc == SQLITE_OK )
-  {
-    if ( sqlite3_step( ppStmt ) == SQLITE_ROW )
-    {
-      myProjString = QString::fromUtf8(( char* )sqlite3_column_text( ppStmt, 0 ) );
-    }
-  }
-  // close the statement
-  sqlite3_finalize( ppStmt );
-  // close the database
-  sqlite3_close( db );
-
-  //Q_ASSERT(myProjString.length() > 0);
-  return myProjString;
+  return record.parameters;
 }
 
 int QgsCoordinateReferenceSystem::openDb( const QString& path, sqlite3 **db, bool readonly )
@@ -1512,6 +1238,7 @@ bool QgsCoordinateReferenceSystem::saveAsUserCRS( const QString& name )
 
     return_id = sqlite3_last_insert_rowid( myDatabase );
     setInternalId( return_id );
+    QgsCRSCatalog::instance()->invalidateUserCrs();
 
     //We add the just created user CRS to the list of recently used CRS
     QSettings settings;
@@ -1941,6 +1668,7 @@ int QgsCoordinateReferenceSystem::syncDb()
   }
 
   sqlite3_close( database );
+  QgsCRSCatalog::instance()->invalidate();
 
   qWarning( "CRS update (inserted:%d updated:%d deleted:%d errors:%d)", inserted, updated, deleted, errors );
 
@@ -34,6 +34,7 @@ typedef struct sqlite3 sqlite3;
 
 //qgis includes
 #include "qgis.h"
+#include "qgscrscatalog.h"
 
 #ifdef DEBUG
 typedef struct OGRSpatialReferenceHS *OGRSpatialReferenceH;
@@ -418,16 +419,6 @@ class CORE_EXPORT QgsCoordinateReferenceSystem
      */
     void debugPrint();
 
-    /** A string based associative array used for passing records around */
-    typedef QMap<QString, QString> RecordMap;
-    /** Get a record from the srs.db or qgis.db backends, given an sql statment.
-     * @note only handles queries that return a single record.
-     * @note it will first try the system srs.db then the users qgis.db!
-     * @param theSql The sql query to execute
-     * @return An associative array of field name <-> value pairs
-     */
-    RecordMap getRecord( const QString& theSql );
-
     // Open SQLite db and show message if cannot be opened
     // returns the same code as sqlite3_open
     static int openDb( const QString& path, sqlite3 **db, bool readonly = true );
@@ -462,7 +453,8 @@ class CORE_EXPORT QgsCoordinateReferenceSystem
 
     OGRSpatialReferenceH mCRS;
 
-    bool loadFromDb( const QString& db, const QString& expression, const QString& value );
+    //! Initialize from a CRS catalog record, null record makes the CRS invalid
+    bool loadFromRecord( const QgsCRSCatalog::Record* record );
 
     QString mValidationHint;
     mutable QString mWkt;
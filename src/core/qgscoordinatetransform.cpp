@@ -414,6 +414,27 @@ void QgsCoordinateTransform::transformPolygon( QPolygonF& poly, TransformDirecti
 
   //create x, y arrays
   int nVertices = poly.size();
+  if ( nVertices == 0 )
+  {
+    return;
+  }
+
+  if ( sizeof( qreal ) == sizeof( double ) )
+  {
+    // transform the points in place, without copying them to temporary arrays
+    double* data = reinterpret_cast<double*>( poly.data() );
+    try
+    {
+      transformCoords( nVertices, data, data + 1, 0, 2, direction );
+    }
+    catch ( const QgsCsException & )
+    {
+      // rethrow the exception
+      QgsDebugMsg( "rethrowing exception" );
+      throw;
+    }
+    return;
+  }
 
   QVector<double> x( nVertices );
   QVector<double> y( nVertices );
@@ -633,6 +654,11 @@ QgsRectangle QgsCoordinateTransform::transformBoundingBox( const QgsRectangle &r
 }
 
 void QgsCoordinateTransform::transformCoords( const int& numPoints, double *x, double *y, double *z, TransformDirection direction ) const
+{
+  transformCoords( numPoints, x, y, z, 1, direction );
+}
+
+void QgsCoordinateTransform::transformCoords( int numPoints, double *x, double *y, double *z, int pointOffset, TransformDirection direction ) const
 {
   if ( mShortCircuit || !mInitialisedFlag )
     return;
@@ -664,24 +690,25 @@ void QgsCoordinateTransform::transformCoords( const int& numPoints, double *x, d
   if (( pj_is_latlong( mDestinationProjection ) && ( direction == ReverseTransform ) )
       || ( pj_is_latlong( mSourceProjection ) && ( direction == ForwardTransform ) ) )
   {
-    for ( int i = 0; i < numPoints; ++i )
+    for ( int i = 0; i < numPoints * pointOffset; i += pointOffset )
     {
       x[i] *= DEG_TO_RAD;
       y[i] *= DEG_TO_RAD;
-      z[i] *= DEG_TO_RAD;
+      if ( z )
+        z[i] *= DEG_TO_RAD;
     }
 
   }
   int projResult;
   if ( direction == ReverseTransform )
   {
-    projResult = pj_transform( mDestinationProjection, mSourceProjection, numPoints, 0, x, y, z );
+    projResult = pj_transform( mDestinationProjection, mSourceProjection, numPoints, pointOffset, x, y, z );
   }
   else
   {
     Q_ASSERT( mSourceProjection != 0 );
     Q_ASSERT( mDestinationProjection != 0 );
-    projResult = pj_transform( mSourceProjection, mDestinationProjection, numPoints, 0, x, y, z );
+    projResult = pj_transform( mSourceProjection, mDestinationProjection, numPoints, pointOffset, x, y, z );
   }
 
   if ( projResult != 0 )
@@ -689,7 +716,7 @@ void QgsCoordinateTransform::transformCoords( const int& numPoints, double *x, d
     //something bad happened....
     QString points;
 
-    for ( int i = 0; i < numPoints; ++i )
+    for ( int i = 0; i < numPoints * pointOffset; i += pointOffset )
     {
       if ( direction == ForwardTransform )
       {
@@ -732,11 +759,12 @@ void QgsCoordinateTransform::transformCoords( const int& numPoints, double *x, d
   if (( pj_is_latlong( mDestinationProjection ) && ( direction == ForwardTransform ) )
       || ( pj_is_latlong( mSourceProjection ) && ( direction == ReverseTransform ) ) )
   {
-    for ( int i = 0; i < numPoints; ++i )
+    for ( int i = 0; i < numPoints * pointOffset; i += pointOffset )
     {
       x[i] *= RAD_TO_DEG;
       y[i] *= RAD_TO_DEG;
-      z[i] *= RAD_TO_DEG;
+      if ( z )
+        z[i] *= RAD_TO_DEG;
     }
   }
 #ifdef COORDINATE_TRANSFORM_VERBOSE
@@ -290,6 +290,10 @@ class CORE_EXPORT QgsCoordinateTransform : public QObject
      */
     void setFinder();
 
+    /** Transforms coordinates stored with a stride of pointOffset doubles (e.g. 2 for the
+     * x and y members of a QPointF array). z may be null. */
+    void transformCoords( int numPoints, double *x, double *y, double *z, int pointOffset, TransformDirection direction ) const;
+
     /** Removes +nadgrids and +towgs84 from proj4 string*/
     static QString stripDatumTransform( const QString& proj4 );
     static void searchDatumTransform( const QString& sql, QList< int >& transforms );
@@ -16,8 +16,11 @@
  ***************************************************************************/
 
 #include "qgscrscache.h"
+#include "qgscrscatalog.h"
 #include "qgscoordinatetransform.h"
 
+#include <QMutexLocker>
+
 
 QgsCoordinateTransformCache* QgsCoordinateTransformCache::instance()
 {
@@ -96,18 +99,25 @@ QgsCRSCache::QgsCRSCache()
 
 QgsCRSCache::~QgsCRSCache()
 {
+  qDeleteAll( mCRS );
+  qDeleteAll( mReplacedCRS );
 }
 
 void QgsCRSCache::updateCRSCache( const QString& authid )
 {
+  // user CRS definitions might have changed in qgis.db
+  QgsCRSCatalog::instance()->invalidateUserCrs();
+
   QgsCoordinateReferenceSystem s;
-  if ( s.createFromOgcWmsCrs( authid ) )
-  {
-    mCRS.insert( authid, s );
-  }
-  else
+  bool valid = s.createFromOgcWmsCrs( authid );
+
   {
-    mCRS.remove( authid );
+    QMutexLocker locker( &mMutex );
+    QgsCoordinateReferenceSystem* old = mCRS.take( authid );
+    if ( old )
+      mReplacedCRS.append( old );
+    if ( valid )
+      mCRS.insert( authid, new QgsCoordinateReferenceSystem( s ) );
   }
 
   QgsCoordinateTransformCache::instance()->invalidateCrs( authid );
@@ -115,20 +125,29 @@ void QgsCRSCache::updateCRSCache( const QString& authid )
 
 const QgsCoordinateReferenceSystem& QgsCRSCache::crsByAuthId( const QString& authid )
 {
-  QHash< QString, QgsCoordinateReferenceSystem >::const_iterator crsIt = mCRS.find( authid );
-  if ( crsIt == mCRS.constEnd() )
   {
-    QgsCoordinateReferenceSystem s;
-    if ( ! s.createFromOgcWmsCrs( authid ) )
-    {
-      return mInvalidCRS;
-    }
-    return mCRS.insert( authid, s ).value();
+    QMutexLocker locker( &mMutex );
+    QgsCoordinateReferenceSystem* crs = mCRS.value( authid );
+    if ( crs )
+      return *crs;
+  }
+
+  // created without the lock, as creating a CRS may use the cache too
+  QgsCoordinateReferenceSystem s;
+  if ( ! s.createFromOgcWmsCrs( authid ) )
+  {
+    return mInvalidCRS;
   }
-  else
+
+  QMutexLocker locker( &mMutex );
+  // another thread may have created it meanwhile
+  QgsCoordinateReferenceSystem* crs = mCRS.value( authid );
+  if ( !crs )
   {
-    return crsIt.value();
+    crs = new QgsCoordinateReferenceSystem( s );
+    mCRS.insert( authid, crs );
   }
+  return *crs;
 }
 
 const QgsCoordinateReferenceSystem& QgsCRSCache::crsByEpsgId( long epsg )
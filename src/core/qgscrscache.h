@@ -20,6 +20,7 @@
 
 #include "qgscoordinatereferencesystem.h"
 #include <QHash>
+#include <QMutex>
 
 class QgsCoordinateTransform;
 
@@ -45,6 +46,8 @@ class CORE_EXPORT QgsCoordinateTransformCache
     QMultiHash< QPair< QString, QString >, QgsCoordinateTransform* > mTransforms; //same auth_id pairs might have different datum transformations
 };
 
+/** Cache of CRS by authid. It can be used from several threads, the returned
+references stay valid as long as the cache exists*/
 class CORE_EXPORT QgsCRSCache
 {
   public:
@@ -60,7 +63,11 @@ class CORE_EXPORT QgsCRSCache
     QgsCRSCache();
 
   private:
-    QHash< QString, QgsCoordinateReferenceSystem > mCRS;
+    //! CRS are allocated separately, so that references to them are not invalidated when the hash grows
+    QHash< QString, QgsCoordinateReferenceSystem* > mCRS;
+    //! CRS replaced by updateCRSCache(), kept as references to them may still be used
+    QList< QgsCoordinateReferenceSystem* > mReplacedCRS;
+    QMutex mMutex;
     /** CRS that is not initialised (returned in case of error)*/
     QgsCoordinateReferenceSystem mInvalidCRS;
 };
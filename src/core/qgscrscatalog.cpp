@@ -0,0 +1,224 @@
+/***************************************************************************
+                              qgscrscatalog.cpp
+                              -----------------
+  begin                : October 2015
+  copyright            : (C) 2015 by QGIS Development Team
+  email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgscrscatalog.h"
+#include "qgis.h"
+#include "qgsapplication.h"
+#include "qgslogger.h"
+
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QRegExp>
+#include <QStringList>
+
+#include <sqlite3.h>
+
+QgsCRSCatalog* QgsCRSCatalog::instance()
+{
+  static QgsCRSCatalog mInstance;
+  return &mInstance;
+}
+
+QgsCRSCatalog::QgsCRSCatalog()
+{
+}
+
+QString QgsCRSCatalog::normalizedProj4( const QString& proj4, QString* datum )
+{
+  // split on spaces followed by a plus sign (+) to deal
+  // also with parameters containing spaces (e.g. +nadgrids)
+  QStringList params;
+  Q_FOREACH ( const QString& param, proj4.split( QRegExp( "\\s+(?=\\+)" ), QString::SkipEmptyParts ) )
+  {
+    QString p = param.trimmed();
+    if ( p.startsWith( "+datum=" ) )
+    {
+      if ( datum )
+        *datum = p;
+    }
+    else
+    {
+      params << p;
+    }
+  }
+  params.sort();
+  return params.join( " " );
+}
+
+void QgsCRSCatalog::Table::clear()
+{
+  loaded = false;
+  records.clear();
+  bySrsId.clear();
+  bySrid.clear();
+  byAuthId.clear();
+  byProj4.clear();
+  byProj4Parameters.clear();
+}
+
+bool QgsCRSCatalog::Table::load( const QString& dbPath )
+{
+  clear();
+  loaded = true;
+
+  if ( !QFileInfo( dbPath ).exists() )
+  {
+    QgsDebugMsg( "failed : " + dbPath + " does not exist!" );
+    return false;
+  }
+
+  sqlite3* db;
+  if ( sqlite3_open_v2( dbPath.toUtf8().constData(), &db, SQLITE_OPEN_READONLY, NULL ) != SQLITE_OK )
+  {
+    QgsDebugMsg( QString( "Can't open database %1: %2" ).arg( dbPath, sqlite3_errmsg( db ) ) );
+    sqlite3_close( db );
+    return false;
+  }
+
+  // preferred records (not deprecated) come first, the first one wins in unique indexes
+  const char* sql = "select srs_id,description,projection_acronym,ellipsoid_acronym,parameters,srid,auth_name||':'||auth_id,is_geo "
+                    "from tbl_srs order by deprecated,srs_id";
+  sqlite3_stmt* stmt;
+  if ( sqlite3_prepare_v2( db, sql, -1, &stmt, NULL ) != SQLITE_OK )
+  {
+    QgsDebugMsg( QString( "failed : %1 [%2]" ).arg( sql, sqlite3_errmsg( db ) ) );
+    sqlite3_close( db );
+    return false;
+  }
+
+  while ( sqlite3_step( stmt ) == SQLITE_ROW )
+  {
+    Record record;
+    record.srsId = sqlite3_column_int64( stmt, 0 );
+    record.description = QString::fromUtf8(( const char * ) sqlite3_column_text( stmt, 1 ) );
+    record.projectionAcronym = QString::fromUtf8(( const char * ) sqlite3_column_text( stmt, 2 ) );
+    record.ellipsoidAcronym = QString::fromUtf8(( const char * ) sqlite3_column_text( stmt, 3 ) );
+    record.parameters = QString::fromUtf8(( const char * ) sqlite3_column_text( stmt, 4 ) );
+    record.srid = sqlite3_column_int64( stmt, 5 );
+    record.authId = QString::fromUtf8(( const char * ) sqlite3_column_text( stmt, 6 ) );
+    record.isGeo = sqlite3_column_int( stmt, 7 ) != 0;
+
+    int idx = records.size();
+    records.append( record );
+
+    if ( !bySrsId.contains( record.srsId ) )
+      bySrsId.insert( record.srsId, idx );
+    if ( !bySrid.contains( record.srid ) )
+      bySrid.insert( record.srid, idx );
+    QString authId = record.authId.toLower();
+    if ( !authId.isEmpty() && !byAuthId.contains( authId ) )
+      byAuthId.insert( authId, idx );
+    byProj4[ record.parameters.trimmed()].append( idx );
+    byProj4Parameters[ normalizedProj4( record.parameters )].append( idx );
+  }
+
+  sqlite3_finalize( stmt );
+  sqlite3_close( db );
+
+  QgsDebugMsg( QString( "%1 CRS read from %2" ).arg( records.size() ).arg( dbPath ) );
+  return true;
+}
+
+void QgsCRSCatalog::ensureLoaded()
+{
+  if ( !mSystem.loaded )
+    mSystem.load( QgsApplication::srsDbFilePath() );
+  if ( !mUser.loaded )
+    mUser.load( QgsApplication::qgisUserDbFilePath() );
+}
+
+bool QgsCRSCatalog::recordBySrsId( long srsId, Record& record )
+{
+  QMutexLocker locker( &mMutex );
+  ensureLoaded();
+
+  const Table& table = srsId < USER_CRS_START_ID ? mSystem : mUser;
+  QHash<long, int>::const_iterator it = table.bySrsId.constFind( srsId );
+  if ( it == table.bySrsId.constEnd() )
+    return false;
+
+  record = table.records.at( it.value() );
+  return true;
+}
+
+bool QgsCRSCatalog::recordBySrid( long srid, Record& record )
+{
+  QMutexLocker locker( &mMutex );
+  ensureLoaded();
+
+  QHash<long, int>::const_iterator it = mSystem.bySrid.constFind( srid );
+  if ( it == mSystem.bySrid.constEnd() )
+    return false;
+
+  record = mSystem.records.at( it.value() );
+  return true;
+}
+
+bool QgsCRSCatalog::recordByAuthId( const QString& authId, Record& record )
+{
+  QMutexLocker locker( &mMutex );
+  ensureLoaded();
+
+  QHash<QString, int>::const_iterator it = mSystem.byAuthId.constFind( authId.toLower() );
+  if ( it == mSystem.byAuthId.constEnd() )
+    return false;
+
+  record = mSystem.records.at( it.value() );
+  return true;
+}
+
+QList<QgsCRSCatalog::Record> QgsCRSCatalog::recordsByProj4( const QString& proj4 )
+{
+  QMutexLocker locker( &mMutex );
+  ensureLoaded();
+
+  QList<Record> result;
+  QString key = proj4.trimmed();
+  Q_FOREACH ( int idx, mSystem.byProj4.value( key ) )
+    result << mSystem.records.at( idx );
+  Q_FOREACH ( int idx, mUser.byProj4.value( key ) )
+    result << mUser.records.at( idx );
+  return result;
+}
+
+QList<QgsCRSCatalog::Record> QgsCRSCatalog::recordsByProj4Parameters( const QString& proj4 )
+{
+  QString key = normalizedProj4( proj4 );
+
+  QMutexLocker locker( &mMutex );
+  ensureLoaded();
+
+  QList<Record> result;
+  Q_FOREACH ( int idx, mSystem.byProj4Parameters.value( key ) )
+    result << mSystem.records.at( idx );
+  Q_FOREACH ( int idx, mUser.byProj4Parameters.value( key ) )
+    result << mUser.records.at( idx );
+  return result;
+}
+
+void QgsCRSCatalog::invalidateUserCrs()
+{
+  QMutexLocker locker( &mMutex );
+  mUser.clear();
+}
+
+void QgsCRSCatalog::invalidate()
+{
+  QMutexLocker locker( &mMutex );
+  mSystem.clear();
+  mUser.clear();
+}
@@ -0,0 +1,106 @@
+/***************************************************************************
+                              qgscrscatalog.h
+                              ---------------
+  begin                : October 2015
+  copyright            : (C) 2015 by QGIS Development Team
+  email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSCRSCATALOG_H
+#define QGSCRSCATALOG_H
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+/** \ingroup core
+ * In-memory copy of the CRS definitions from the system srs.db and the user qgis.db.
+ *
+ * The tbl_srs tables are read on first use and indexed by srs id, postgis srid,
+ * auth id and proj4 string, so CRS lookups do not need to open the databases and
+ * scan the tables every time. All methods are thread safe.
+ *
+ * User defined CRS are read again after invalidateUserCrs() has been called,
+ * which is done when a CRS is saved to the user database.
+ *
+ * @note added in QGIS 2.14
+ * @note not available in python bindings
+ */
+class CORE_EXPORT QgsCRSCatalog
+{
+  public:
+    /** A row of tbl_srs */
+    struct Record
+    {
+      long srsId;
+      QString description;
+      QString projectionAcronym;
+      QString ellipsoidAcronym;
+      QString parameters;
+      long srid;
+      QString authId;
+      bool isGeo;
+    };
+
+    static QgsCRSCatalog* instance();
+
+    /** Finds CRS by its internal id (system or user CRS) */
+    bool recordBySrsId( long srsId, Record& record );
+    /** Finds system CRS by its postgis srid */
+    bool recordBySrid( long srid, Record& record );
+    /** Finds system CRS by authority identifier like 'EPSG:4326' (case insensitive) */
+    bool recordByAuthId( const QString& authId, Record& record );
+
+    /** Returns CRS with exactly the same proj4 string - system CRS first, not deprecated first */
+    QList<Record> recordsByProj4( const QString& proj4 );
+    /** Returns CRS with the same proj4 parameters in any order, +datum parameter is
+     * not compared. Ordered like recordsByProj4() */
+    QList<Record> recordsByProj4Parameters( const QString& proj4 );
+
+    /** Returns proj4 parameters sorted, without +datum (which is returned in datum if set) */
+    static QString normalizedProj4( const QString& proj4, QString* datum = 0 );
+
+    /** User CRS will be read again from qgis.db on next lookup */
+    void invalidateUserCrs();
+    /** All CRS will be read again on next lookup */
+    void invalidate();
+
+  protected:
+    QgsCRSCatalog();
+
+  private:
+    /** Records of one database with the indexes */
+    struct Table
+    {
+      Table() : loaded( false ) {}
+      void clear();
+      bool load( const QString& dbPath );
+
+      bool loaded;
+      QVector<Record> records;
+      QHash<long, int> bySrsId;
+      QHash<long, int> bySrid;
+      QHash<QString, int> byAuthId;
+      QHash<QString, QList<int> > byProj4;
+      QHash<QString, QList<int> > byProj4Parameters;
+    };
+
+    void ensureLoaded();
+
+    QMutex mMutex;
+    Table mSystem;
+    Table mUser;
+};
+
+#endif // QGSCRSCATALOG_H
@@ -15,14 +15,59 @@
 #include "qgsfeatureiterator.h"
 #include "qgslogger.h"
 
+#include "qgis.h"
 #include "qgsgeometrysimplifier.h"
 #include "qgssimplifymethod.h"
 
+#include <algorithm>
+
+/// @cond PRIVATE
+class QgsExpressionSorter
+{
+  public:
+    explicit QgsExpressionSorter( const QList<QgsFeatureRequest::OrderByClause>& orderBys )
+        : mOrderBys( orderBys )
+    {}
+
+    bool operator()( const QgsIndexedFeature& f1, const QgsIndexedFeature& f2 ) const
+    {
+      int i = 0;
+      Q_FOREACH ( const QgsFeatureRequest::OrderByClause& orderBy, mOrderBys )
+      {
+        const QVariant& v1 = f1.mIndexes.at( i );
+        const QVariant& v2 = f2.mIndexes.at( i );
+        ++i;
+
+        // both NULL: decided by the next clause
+        if ( v1.isNull() && v2.isNull() )
+          continue;
+
+        // one NULL: only the position of NULLs matters
+        if ( v1.isNull() != v2.isNull() )
+          return orderBy.nullsFirst() ? v1.isNull() : v2.isNull();
+
+        if ( v1 == v2 )
+          continue;
+
+        return orderBy.ascending() ? qgsVariantLessThan( v1, v2 ) : qgsVariantGreaterThan( v1, v2 );
+      }
+
+      // equal by all clauses
+      return false;
+    }
+
+  private:
+    QList<QgsFeatureRequest::OrderByClause> mOrderBys;
+};
+/// @endcond
+
 QgsAbstractFeatureIterator::QgsAbstractFeatureIterator( const QgsFeatureRequest& request )
     : mRequest( request )
     , mClosed( false )
     , refs( 0 )
     , mFetchedCount( 0 )
+    , mUseCachedFeatures( false )
+    , mOrderBySource( 0 )
     , mGeometrySimplifier( NULL )
     , mLocalSimplification( false )
 {
@@ -42,6 +87,25 @@ bool QgsAbstractFeatureIterator::nextFeature( QgsFeature& f )
     return false;
   }
 
+  if ( mUseCachedFeatures )
+  {
+    dataOk = nextOrderedFeature( f );
+  }
+  else
+  {
+    dataOk = fetchNextFeature( f );
+  }
+
+  if ( dataOk )
+    mFetchedCount++;
+
+  return dataOk;
+}
+
+bool QgsAbstractFeatureIterator::fetchNextFeature( QgsFeature& f )
+{
+  bool dataOk = false;
+
   switch ( mRequest.filterType() )
   {
     case QgsFeatureRequest::FilterExpression:
@@ -64,8 +128,6 @@ bool QgsAbstractFeatureIterator::nextFeature( QgsFeature& f )
     if ( geometry )
       simplify( f );
   }
-  if ( dataOk )
-    mFetchedCount++;
 
   return dataOk;
 }
@@ -101,6 +163,9 @@ void QgsAbstractFeatureIterator::ref()
   if ( refs == 0 )
   {
     prepareSimplification( mRequest.simplifyMethod() );
+
+    // Setup the order by, for the same reason
+    setupOrderBy( mRequest.orderBy() );
   }
   refs++;
 }
@@ -129,6 +194,150 @@ bool QgsAbstractFeatureIterator::prepareSimplification( const QgsSimplifyMethod&
   return false;
 }
 
+bool QgsAbstractFeatureIterator::prepareOrderBy( const QList<QgsFeatureRequest::OrderByClause>& orderBys )
+{
+  Q_UNUSED( orderBys )
+  return false;
+}
+
+void QgsAbstractFeatureIterator::setupOrderBy( const QList<QgsFeatureRequest::OrderByClause>& orderBys )
+{
+  // let the provider order the features if it can
+  if ( orderBys.isEmpty() || prepareOrderBy( orderBys ) )
+    return;
+
+  QgsExpressionContext* context = mRequest.expressionContext();
+  QList<QgsExpression*> expressions;
+  bool needsGeometry = false;
+  QSet<QString> usedAttributes;
+  Q_FOREACH ( const QgsFeatureRequest::OrderByClause& orderBy, orderBys )
+  {
+    QgsExpression* expression = new QgsExpression( orderBy.expression() );
+    expression->prepare( context );
+    expressions << expression;
+    needsGeometry = needsGeometry || expression->needsGeometry();
+    usedAttributes += expression->referencedColumns().toSet();
+  }
+
+  // only the ids and the order by values are fetched and sorted if the features can be fetched
+  // again by id, the attributes and geometries of all features are not kept in memory
+  mOrderBySource = orderBySource();
+  QgsFeatureIterator keyIterator;
+  if ( mOrderBySource )
+  {
+    QgsFeatureRequest keyRequest( mRequest );
+    keyRequest.setOrderBy( QgsFeatureRequest::OrderBy() );
+    keyRequest.setLimit( -1 );
+
+    if ( mRequest.filterType() == QgsFeatureRequest::FilterExpression )
+    {
+      needsGeometry = needsGeometry || mRequest.filterExpression()->needsGeometry();
+      usedAttributes += mRequest.filterExpression()->referencedColumns().toSet();
+    }
+    if ( mRequest.filterType() == QgsFeatureRequest::FilterRect && ( mRequest.flags() & QgsFeatureRequest::ExactIntersect ) )
+      needsGeometry = true;
+    if ( !needsGeometry )
+      keyRequest.setFlags( keyRequest.flags() | QgsFeatureRequest::NoGeometry );
+
+    // attribute names can be resolved if the context knows the fields, otherwise the attributes of the request are fetched
+    QgsFields fields = context->fields();
+    if ( fields.count() > 0 && !usedAttributes.contains( QgsFeatureRequest::AllAttributes ) )
+      keyRequest.setSubsetOfAttributes( usedAttributes.toList(), fields );
+
+    keyIterator = mOrderBySource->getFeatures( keyRequest );
+  }
+
+  // fetch all features matching the filter, the limit applies to the ordered features
+  QgsIndexedFeature indexedFeature;
+  indexedFeature.mIndexes.resize( expressions.size() );
+  QgsFeature feature;
+  while ( mOrderBySource ? keyIterator.nextFeature( feature ) : fetchNextFeature( feature ) )
+  {
+    context->setFeature( feature );
+    for ( int i = 0; i < expressions.size(); ++i )
+    {
+      indexedFeature.mIndexes[i] = expressions.at( i )->evaluate( context );
+    }
+    if ( mOrderBySource )
+      indexedFeature.mFeature.setFeatureId( feature.id() );
+    else
+      indexedFeature.mFeature = feature;
+    mCachedFeatures.append( indexedFeature );
+  }
+  keyIterator.close();
+  qDeleteAll( expressions );
+
+  QgsExpressionSorter sorter( orderBys );
+  if ( mRequest.limit() >= 0 && mRequest.limit() < mCachedFeatures.size() )
+  {
+    // only the first features are returned
+    std::partial_sort( mCachedFeatures.begin(), mCachedFeatures.begin() + mRequest.limit(), mCachedFeatures.end(), sorter );
+    mCachedFeatures.resize( mRequest.limit() );
+  }
+  else
+  {
+    qStableSort( mCachedFeatures.begin(), mCachedFeatures.end(), sorter );
+  }
+
+  mFeatureIterator = mCachedFeatures.constBegin();
+  mOrderedChunkEnd = mFeatureIterator;
+  mUseCachedFeatures = true;
+}
+
+bool QgsAbstractFeatureIterator::nextOrderedFeature( QgsFeature& f )
+{
+  // number of sorted features fetched by id with one request
+  const int chunkSize = 1000;
+
+  while ( mFeatureIterator != mCachedFeatures.constEnd() )
+  {
+    const QgsIndexedFeature& indexedFeature = *mFeatureIterator;
+    if ( !mOrderBySource )
+    {
+      f = indexedFeature.mFeature;
+      ++mFeatureIterator;
+      return true;
+    }
+
+    if ( mFeatureIterator == mOrderedChunkEnd )
+    {
+      QgsFeatureIds fids;
+      for ( int i = 0; i < chunkSize && mOrderedChunkEnd != mCachedFeatures.constEnd(); ++i, ++mOrderedChunkEnd )
+        fids << mOrderedChunkEnd->mFeature.id();
+
+      QgsFeatureRequest chunkRequest( mRequest );
+      chunkRequest.setOrderBy( QgsFeatureRequest::OrderBy() );
+      chunkRequest.setLimit( -1 );
+      chunkRequest.setFilterFids( fids );
+
+      mOrderedChunk.clear();
+      QgsFeatureIterator it = mOrderBySource->getFeatures( chunkRequest );
+      QgsFeature chunkFeature;
+      while ( it.nextFeature( chunkFeature ) )
+        mOrderedChunk.insert( chunkFeature.id(), chunkFeature );
+    }
+
+    ++mFeatureIterator;
+    QHash<QgsFeatureId, QgsFeature>::iterator chunkIt = mOrderedChunk.find( indexedFeature.mFeature.id() );
+    // features deleted since the ids were fetched are skipped
+    if ( chunkIt != mOrderedChunk.end() )
+    {
+      f = chunkIt.value();
+      mOrderedChunk.erase( chunkIt );
+      return true;
+    }
+  }
+  return false;
+}
+
+void QgsAbstractFeatureIterator::rewindOrderBy()
+{
+  mFeatureIterator = mCachedFeatures.constBegin();
+  // the features of the current chunk are erased once returned, so they are fetched again
+  mOrderedChunkEnd = mFeatureIterator;
+  mOrderedChunk.clear();
+}
+
 bool QgsAbstractFeatureIterator::providerCanSimplify( QgsSimplifyMethod::MethodType methodType ) const
 {
   Q_UNUSED( methodType )
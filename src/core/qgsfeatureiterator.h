@@ -20,6 +20,20 @@
 
 class QgsAbstractGeometrySimplifier;
 
+/** \ingroup core
+ * A feature with the values of the order by expressions of a request, used by
+ * the feature iterator to sort the features if the provider cannot do it. When the
+ * features can be fetched again from the source of the iterator, only their ids are kept.
+ * @note added in QGIS 2.14
+ * @note not available in python bindings
+ */
+class QgsIndexedFeature
+{
+  public:
+    QVector<QVariant> mIndexes;
+    QgsFeature mFeature;
+};
+
 /** \ingroup core
  * Internal feature iterator to be implemented within data providers
  */
@@ -93,7 +107,49 @@ class CORE_EXPORT QgsAbstractFeatureIterator
     //! Setup the simplification of geometries to fetch using the specified simplify method
     virtual bool prepareSimplification( const QgsSimplifyMethod& simplifyMethod );
 
+    /**
+     * Lets the provider apply the order by clauses of the request, e.g. in SQL. If it returns false,
+     * the iterator fetches all features and sorts them locally before returning the first one.
+     * The default implementation returns false.
+     *
+     * @param orderBys the order by clauses of the request
+     * @return true if the features are returned by fetchFeature() already ordered
+     * @note added in QGIS 2.14
+     */
+    virtual bool prepareOrderBy( const QList<QgsFeatureRequest::OrderByClause>& orderBys );
+
+    /**
+     * Returns the source of the iterator, used when the features are sorted locally: only the
+     * ids and order by values are fetched and sorted, the features are then fetched by id.
+     * Returns 0 by default, the sorted features are then kept in memory.
+     * @note added in QGIS 2.14
+     */
+    virtual QgsAbstractFeatureSource* orderBySource() const { return 0; }
+
   private:
+    //! fetch next feature matching the request filter, without the local ordering
+    bool fetchNextFeature( QgsFeature& f );
+
+    //! sort the features locally if the provider cannot do it
+    void setupOrderBy( const QList<QgsFeatureRequest::OrderByClause>& orderBys );
+
+    //! next locally sorted feature, fetched by id from the order by source if there is one
+    bool nextOrderedFeature( QgsFeature& f );
+
+    //! restart the locally sorted features from the first one
+    void rewindOrderBy();
+
+    //! features are returned in the order of mCachedFeatures, sorted locally
+    bool mUseCachedFeatures;
+    QVector<QgsIndexedFeature> mCachedFeatures;
+    QVector<QgsIndexedFeature>::ConstIterator mFeatureIterator;
+
+    //! source the sorted features are fetched from by id, or 0 if mCachedFeatures holds them
+    QgsAbstractFeatureSource* mOrderBySource;
+    //! features fetched from the order by source up to mOrderedChunkEnd
+    QHash<QgsFeatureId, QgsFeature> mOrderedChunk;
+    QVector<QgsIndexedFeature>::ConstIterator mOrderedChunkEnd;
+
     //! optional object to locally simplify geometries fetched by this feature iterator
     QgsAbstractGeometrySimplifier* mGeometrySimplifier;
     //! this iterator runs local simplification
@@ -129,6 +185,8 @@ class QgsAbstractFeatureIteratorFromSource : public QgsAbstractFeatureIterator
     //! to be called by from subclass in close()
     void iteratorClosed() { mSource->iteratorClosed( this ); }
 
+    virtual QgsAbstractFeatureSource* orderBySource() const override { return mSource; }
+
     T* mSource;
     bool mOwnSource;
 };
@@ -202,7 +260,10 @@ inline bool QgsFeatureIterator::nextFeature( QgsFeature& f )
 inline bool QgsFeatureIterator::rewind()
 {
   if ( mIter )
+  {
     mIter->mFetchedCount = 0;
+    mIter->rewindOrderBy();
+  }
 
   return mIter ? mIter->rewind() : false;
 }
@@ -84,6 +84,7 @@ QgsFeatureRequest& QgsFeatureRequest::operator=( const QgsFeatureRequest & rh )
   mAttrs = rh.mAttrs;
   mSimplifyMethod = rh.mSimplifyMethod;
   mLimit = rh.mLimit;
+  mOrderBy = rh.mOrderBy;
   return *this;
 }
 
@@ -147,6 +148,24 @@ QgsFeatureRequest& QgsFeatureRequest::setLimit( long limit )
   return *this;
 }
 
+QgsFeatureRequest& QgsFeatureRequest::addOrderBy( const QString& expression, bool ascending )
+{
+  mOrderBy.append( OrderByClause( expression, ascending ) );
+  return *this;
+}
+
+QgsFeatureRequest& QgsFeatureRequest::addOrderBy( const QString& expression, bool ascending, bool nullsfirst )
+{
+  mOrderBy.append( OrderByClause( expression, ascending, nullsfirst ) );
+  return *this;
+}
+
+QgsFeatureRequest& QgsFeatureRequest::setOrderBy( const QgsFeatureRequest::OrderBy& orderBy )
+{
+  mOrderBy = orderBy;
+  return *this;
+}
+
 QgsFeatureRequest& QgsFeatureRequest::setFlags( const QgsFeatureRequest::Flags& flags )
 {
   mFlags = flags;
@@ -251,4 +270,58 @@ void QgsAbstractFeatureSource::iteratorClosed( QgsAbstractFeatureIterator* it )
   mActiveIterators.remove( it );
 }
 
+QgsFeatureRequest::OrderByClause::OrderByClause( const QString& expression, bool ascending )
+    : mExpression( expression )
+    , mAscending( ascending )
+{
+  // postgres behavior: default for ASC: NULLS LAST, default for DESC: NULLS FIRST
+  mNullsFirst = !ascending;
+}
+
+QgsFeatureRequest::OrderByClause::OrderByClause( const QString& expression, bool ascending, bool nullsfirst )
+    : mExpression( expression )
+    , mAscending( ascending )
+    , mNullsFirst( nullsfirst )
+{
+}
+
+QString QgsFeatureRequest::OrderByClause::dump() const
+{
+  return QString( "%1 %2 %3" )
+         .arg( mExpression,
+               mAscending ? "ASC" : "DESC",
+               mNullsFirst ? "NULLS FIRST" : "NULLS LAST" );
+}
+
+QgsFeatureRequest::OrderBy::OrderBy( const QList<QgsFeatureRequest::OrderByClause>& other )
+{
+  Q_FOREACH ( const QgsFeatureRequest::OrderByClause& clause, other )
+  {
+    append( clause );
+  }
+}
+
+QSet<QString> QgsFeatureRequest::OrderBy::usedAttributes() const
+{
+  QSet<QString> usedAttributes;
 
+  Q_FOREACH ( const OrderByClause& clause, *this )
+  {
+    QgsExpression expression( clause.expression() );
+    usedAttributes.unite( expression.referencedColumns().toSet() );
+  }
+
+  return usedAttributes;
+}
+
+QString QgsFeatureRequest::OrderBy::dump() const
+{
+  QStringList results;
+
+  Q_FOREACH ( const OrderByClause& clause, *this )
+  {
+    results << clause.dump();
+  }
+
+  return results.join( ", " );
+}
@@ -58,6 +58,8 @@ typedef QList<int> QgsAttributeList;
  *     QgsFeatureRequest().setFilterRect(QgsRectangle(0,0,1,1))
  * - fetch only one feature
  *     QgsFeatureRequest().setFilterFid(45)
+ * - fetch the ten largest features by area
+ *     QgsFeatureRequest().addOrderBy("$area", false).setLimit(10)
  *
  */
 class CORE_EXPORT QgsFeatureRequest
@@ -84,6 +86,74 @@ class CORE_EXPORT QgsFeatureRequest
       FilterFids        //!< Filter using feature IDs
     };
 
+    /** \ingroup core
+     * An ordering clause of a request: the features are sorted by the value of an expression.
+     * Providers translate the clauses to SQL if they can, otherwise the features are sorted
+     * by the feature iterator.
+     * @note added in QGIS 2.14
+     */
+    class CORE_EXPORT OrderByClause
+    {
+      public:
+        /**
+         * Creates a new order by clause. NULL values come last in ascending order and first in descending order.
+         * @param expression expression to sort by, e.g. a field name
+         * @param ascending ascending or descending order
+         */
+        OrderByClause( const QString& expression, bool ascending = true );
+
+        /**
+         * Creates a new order by clause.
+         * @param expression expression to sort by, e.g. a field name
+         * @param ascending ascending or descending order
+         * @param nullsfirst whether NULL values come before all other values
+         */
+        OrderByClause( const QString& expression, bool ascending, bool nullsfirst );
+
+        //! The expression to sort by
+        QString expression() const { return mExpression; }
+
+        //! Whether the order is ascending
+        bool ascending() const { return mAscending; }
+        //! Set whether the order is ascending
+        void setAscending( bool ascending ) { mAscending = ascending; }
+
+        //! Whether NULL values come before all other values
+        bool nullsFirst() const { return mNullsFirst; }
+        //! Set whether NULL values come before all other values
+        void setNullsFirst( bool nullsFirst ) { mNullsFirst = nullsFirst; }
+
+        //! Returns a textual representation, e.g. "name" ASC NULLS LAST
+        QString dump() const;
+
+      private:
+        QString mExpression;
+        bool mAscending;
+        bool mNullsFirst;
+    };
+
+    /** \ingroup core
+     * A list of order by clauses, the first clause has the highest priority.
+     * @note added in QGIS 2.14
+     */
+    class CORE_EXPORT OrderBy : public QList<OrderByClause>
+    {
+      public:
+        OrderBy() {}
+
+        //! Creates an order by from a list of clauses
+        OrderBy( const QList<OrderByClause>& other );
+
+        //! Returns the clauses as a list
+        QList<OrderByClause> list() const { return *this; }
+
+        //! Returns the names of the attributes used in the clauses
+        QSet<QString> usedAttributes() const;
+
+        //! Returns a textual representation of the clauses separated by commas
+        QString dump() const;
+    };
+
     /**
      * A special attribute that if set matches all attributes
      */
@@ -188,6 +258,38 @@ class CORE_EXPORT QgsFeatureRequest
      */
     long limit() const { return mLimit; }
 
+    /** Adds a new order by clause with lower priority than the clauses set before.
+     * NULL values come last in ascending order and first in descending order.
+     * @param expression expression to sort by, e.g. a field name
+     * @param ascending ascending or descending order
+     * @see orderBy()
+     * @note added in QGIS 2.14
+     */
+    QgsFeatureRequest& addOrderBy( const QString& expression, bool ascending = true );
+
+    /** Adds a new order by clause with lower priority than the clauses set before.
+     * @param expression expression to sort by, e.g. a field name
+     * @param ascending ascending or descending order
+     * @param nullsfirst whether NULL values come before all other values
+     * @see orderBy()
+     * @note added in QGIS 2.14
+     */
+    QgsFeatureRequest& addOrderBy( const QString& expression, bool ascending, bool nullsfirst );
+
+    /** Returns the order in which the features are returned. Features are returned in
+     * the order of the provider if it is empty.
+     * @see setOrderBy()
+     * @note added in QGIS 2.14
+     */
+    OrderBy orderBy() const { return mOrderBy; }
+
+    /** Sets the order in which the features are returned. The limit of features applies
+     * to the ordered features.
+     * @see orderBy()
+     * @note added in QGIS 2.14
+     */
+    QgsFeatureRequest& setOrderBy( const OrderBy& orderBy );
+
     //! Set flags that affect how features will be fetched
     QgsFeatureRequest& setFlags( const QgsFeatureRequest::Flags& flags );
     const Flags& flags() const { return mFlags; }
@@ -224,7 +326,6 @@ class CORE_EXPORT QgsFeatureRequest
 
     // TODO: in future
     // void setFilterNativeExpression(con QString& expr);   // using provider's SQL (if supported)
-    // void setLimit(int limit);
 
   protected:
     FilterType mFilter;
@@ -237,6 +338,7 @@ class CORE_EXPORT QgsFeatureRequest
     QgsAttributeList mAttrs;
     QgsSimplifyMethod mSimplifyMethod;
     long mLimit;
+    OrderBy mOrderBy;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS( QgsFeatureRequest::Flags )
@@ -0,0 +1,168 @@
+/***************************************************************************
+                         qgsgeneralizedgeometrycache.cpp
+                         -------------------------------
+    begin                : October 2015
+    copyright            : (C) 2015 by QGIS Development Team
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsgeneralizedgeometrycache.h"
+#include "qgsfeatureiterator.h"
+#include "qgsfeaturerequest.h"
+#include "qgsgeometry.h"
+#include "qgslogger.h"
+#include "qgsmaptopixelgeometrysimplifier.h"
+
+#include <QMutexLocker>
+#include <QSettings>
+#include <QTime>
+#include <QtConcurrentRun>
+
+#include <cmath>
+
+QgsGeneralizedGeometryCache::QgsGeneralizedGeometryCache()
+    : mState( Empty )
+    , mGeneration( 0 )
+{
+}
+
+QgsGeneralizedGeometryCache::~QgsGeneralizedGeometryCache()
+{
+  invalidate();
+  mFuture.waitForFinished();
+}
+
+void QgsGeneralizedGeometryCache::build( QgsAbstractFeatureSource* source, const QgsRectangle& extent )
+{
+  QMutexLocker locker( &mMutex );
+  // an abandoned build has to finish first
+  if ( mState != Empty || mFuture.isRunning() || extent.isEmpty() )
+  {
+    delete source;
+    return;
+  }
+
+  QSettings settings;
+  qint64 maxSize = settings.value( "/qgis/simplifyCacheMaxSize", 256 ).toInt() * 1024 * 1024;
+
+  mState = Building;
+  mFuture = QtConcurrent::run( this, &QgsGeneralizedGeometryCache::run, source, extent, mGeneration, maxSize );
+}
+
+bool QgsGeneralizedGeometryCache::needsBuild() const
+{
+  QMutexLocker locker( &mMutex );
+  return mState == Empty;
+}
+
+QSharedPointer<const QgsGeneralizedGeometryCache::Level> QgsGeneralizedGeometryCache::level( double tolerance ) const
+{
+  QMutexLocker locker( &mMutex );
+  if ( mState != Ready )
+    return QSharedPointer<const Level>();
+
+  // levels are ordered from the most simplified one
+  Q_FOREACH ( const QSharedPointer<const Level>& level, mLevels )
+  {
+    if ( level->tolerance <= tolerance )
+      return level;
+  }
+  return QSharedPointer<const Level>();
+}
+
+void QgsGeneralizedGeometryCache::invalidate()
+{
+  QMutexLocker locker( &mMutex );
+  ++mGeneration;
+  mState = Empty;
+  mLevels.clear();
+}
+
+void QgsGeneralizedGeometryCache::run( QgsAbstractFeatureSource* source, QgsRectangle extent, int generation, qint64 maxSize )
+{
+  QTime time;
+  time.start();
+
+  double maxTolerance = sqrt( extent.width() * extent.width() + extent.height() * extent.height() ) / 256;
+
+  QSet<QgsFeatureId>* nullGeometries = new QSet<QgsFeatureId>();
+  QSharedPointer< const QSet<QgsFeatureId> > sharedNullGeometries( nullGeometries );
+
+  QVector< QSharedPointer<Level> > levels( LevelCount );
+  for ( int i = 0; i < LevelCount; ++i )
+  {
+    levels[i] = QSharedPointer<Level>( new Level );
+    levels[i]->tolerance = maxTolerance / ( 1 << i );
+    levels[i]->nullGeometries = sharedNullGeometries;
+  }
+
+  int simplifyFlags = QgsMapToPixelSimplifier::SimplifyGeometry | QgsMapToPixelSimplifier::SimplifyEnvelope;
+  qint64 size = 0;
+  bool outdated = false;
+  int count = 0;
+
+  QgsFeatureIterator fit = source->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() ) );
+  QgsFeature f;
+  while ( fit.nextFeature( f ) )
+  {
+    if ( ++count % 1000 == 0 )
+    {
+      QMutexLocker locker( &mMutex );
+      outdated = generation != mGeneration;
+    }
+    if ( outdated || size > maxSize )
+      break;
+
+    // recorded so that the renderer does not take them for features added after the build
+    if ( !f.constGeometry() )
+    {
+      nullGeometries->insert( f.id() );
+      continue;
+    }
+
+    // every level is simplified from the previous, more detailed one
+    QgsGeometry geom( *f.constGeometry() );
+    for ( int i = LevelCount - 1; i >= 0; --i )
+    {
+      QgsMapToPixelSimplifier::simplifyGeometry( &geom, simplifyFlags, levels[i]->tolerance );
+      if ( !geom.geometry() )
+        break;
+
+      // a deep copy, not sharing data with geom, with its bounding box computed now
+      // so that render threads only ever read it
+      QgsAbstractGeometryV2* simplified = geom.geometry()->clone();
+      simplified->boundingBox();
+      levels[i]->geometries.insert( f.id(), simplified );
+      size += simplified->wkbSize();
+    }
+  }
+  fit.close();
+  delete source;
+
+  QMutexLocker locker( &mMutex );
+  if ( generation != mGeneration )
+    return;
+
+  if ( size > maxSize )
+  {
+    QgsDebugMsg( QString( "simplified geometries exceed %1 bytes, not cached" ).arg( maxSize ) );
+    mState = Failed;
+    return;
+  }
+
+  mLevels.clear();
+  Q_FOREACH ( const QSharedPointer<Level>& level, levels )
+    mLevels << level;
+  mState = Ready;
+
+  QgsDebugMsg( QString( "%1 features simplified in %2 levels in %3 ms" ).arg( count ).arg( LevelCount ).arg( time.elapsed() ) );
+}
@@ -0,0 +1,115 @@
+/***************************************************************************
+                         qgsgeneralizedgeometrycache.h
+                         -----------------------------
+    begin                : October 2015
+    copyright            : (C) 2015 by QGIS Development Team
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSGENERALIZEDGEOMETRYCACHE_H
+#define QGSGENERALIZEDGEOMETRYCACHE_H
+
+#include "qgsabstractgeometryv2.h"
+#include "qgsfeature.h"
+#include "qgsrectangle.h"
+
+#include <QFuture>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QSharedPointer>
+#include <QVector>
+
+class QgsAbstractFeatureSource;
+
+/** \ingroup core
+ * Geometries of a vector layer simplified in advance for a ladder of tolerances.
+ *
+ * The cache is built in a background thread from a feature source, simplifying
+ * every geometry with the map to pixel simplifier once per level. The levels are
+ * spaced by a factor of two, from tolerance extent / 256 down to extent / 32768
+ * (in layer units). The renderer picks the most simplified level whose tolerance
+ * does not exceed the tolerance of the current map scale and takes the geometries
+ * from it instead of fetching and simplifying them on every redraw.
+ *
+ * All methods are thread safe. The cache must be invalidated whenever the
+ * geometries of the layer change. The geometries of a level are never modified
+ * once the level is built: renderers take clones of them.
+ *
+ * @note added in QGIS 2.14
+ * @note not available in python bindings
+ */
+class CORE_EXPORT QgsGeneralizedGeometryCache
+{
+  public:
+    //! Simplified geometries of one level
+    struct Level
+    {
+      Level() : tolerance( 0 ) {}
+      ~Level() { qDeleteAll( geometries ); }
+
+      //! simplification tolerance in layer units
+      double tolerance;
+      //! simplified geometries, owned by the level
+      QHash<QgsFeatureId, const QgsAbstractGeometryV2*> geometries;
+      //! features without geometry (the same set for all levels)
+      QSharedPointer< const QSet<QgsFeatureId> > nullGeometries;
+
+    private:
+      Q_DISABLE_COPY( Level )
+    };
+
+    //! Number of levels of the ladder
+    static const int LevelCount = 8;
+
+    QgsGeneralizedGeometryCache();
+    //! Waits for the build to finish
+    ~QgsGeneralizedGeometryCache();
+
+    /** Starts building the levels in a background thread, unless the cache is already
+     * built or being built. Takes ownership of the feature source.
+     * @param source source of the layer features
+     * @param extent extent of the layer, determines the tolerances of the levels
+     */
+    void build( QgsAbstractFeatureSource* source, const QgsRectangle& extent );
+
+    //! Whether the build is needed (cache empty or invalidated)
+    bool needsBuild() const;
+
+    /** Returns the most simplified level with tolerance not larger than the
+     * given one (in layer units), or a null pointer if there is none (yet)
+     */
+    QSharedPointer<const Level> level( double tolerance ) const;
+
+    //! Drops all levels, a build in progress is abandoned
+    void invalidate();
+
+  private:
+    enum State
+    {
+      Empty,
+      Building,
+      Ready,
+      Failed   //!< the geometries do not fit in the memory limit
+    };
+
+    void run( QgsAbstractFeatureSource* source, QgsRectangle extent, int generation, qint64 maxSize );
+
+    mutable QMutex mMutex;
+    State mState;
+    //! incremented on invalidation, lets a running build detect it is outdated
+    int mGeneration;
+    QVector< QSharedPointer<const Level> > mLevels;
+    QFuture<void> mFuture;
+};
+
+#endif // QGSGENERALIZEDGEOMETRYCACHE_H
@@ -50,6 +50,7 @@ QgsGml::QgsGml(
     , mDimension( 2 )
     , mCoorMode( QgsGml::coordinate )
     , mEpsg( 0 )
+    , mStreamingParser( 0 )
 {
   mThematicAttributes.clear();
   for ( int i = 0; i < fields.size(); i++ )
@@ -68,6 +69,9 @@ QgsGml::QgsGml(
 
 QgsGml::~QgsGml()
 {
+  if ( mStreamingParser )
+    XML_ParserFree( mStreamingParser );
+  delete mCurrentFeature;
 }
 
 int QgsGml::getFeatures( const QString& uri, QGis::WkbType* wkbType, QgsRectangle* extent, const QString& userName, const QString& password , const QString& authcfg )
@@ -201,6 +205,53 @@ int QgsGml::getFeatures( const QByteArray &data, QGis::WkbType* wkbType, QgsRect
   return 0;
 }
 
+bool QgsGml::processData( const QByteArray& data, bool atEnd, QGis::WkbType* wkbType )
+{
+  if ( !mStreamingParser )
+  {
+    mStreamingParser = XML_ParserCreateNS( NULL, NS_SEPARATOR );
+    XML_SetUserData( mStreamingParser, this );
+    XML_SetElementHandler( mStreamingParser, QgsGml::start, QgsGml::end );
+    XML_SetCharacterDataHandler( mStreamingParser, QgsGml::chars );
+    mExtent.setMinimal();
+  }
+  mWkbType = wkbType;
+
+  bool ok = true;
+  if ( XML_Parse( mStreamingParser, data.constData(), data.size(), atEnd ) == 0 )
+  {
+    XML_Error errorCode = XML_GetErrorCode( mStreamingParser );
+    QString errorString = tr( "Error: %1 on line %2, column %3" )
+                          .arg( XML_ErrorString( errorCode ) )
+                          .arg( XML_GetCurrentLineNumber( mStreamingParser ) )
+                          .arg( XML_GetCurrentColumnNumber( mStreamingParser ) );
+    QgsMessageLog::logMessage( errorString, tr( "WFS" ) );
+    ok = false;
+  }
+
+  if ( atEnd || !ok )
+  {
+    XML_ParserFree( mStreamingParser );
+    mStreamingParser = 0;
+
+    // drop state of an incomplete document
+    delete mCurrentFeature;
+    mCurrentFeature = 0;
+    mParseModeStack.clear();
+  }
+  return ok;
+}
+
+QList<QgsFeature*> QgsGml::takeFeatures( QMap<QgsFeatureId, QString >* idsMap )
+{
+  QList<QgsFeature*> features = mFeatures.values();
+  mFeatures.clear();
+  if ( idsMap )
+    *idsMap = mIdMap;
+  mIdMap.clear();
+  return features;
+}
+
 void QgsGml::setFinished()
 {
   mFinished = true;
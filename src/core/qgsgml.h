@@ -72,6 +72,26 @@ class CORE_EXPORT QgsGml : public QObject
      */
     int getFeatures( const QByteArray &data, QGis::WkbType* wkbType, QgsRectangle* extent = 0 );
 
+    /** Parse a chunk of GML data. The data may be passed as they arrive from the network,
+     *  features completed so far can be taken with takeFeatures(), so they do not have to be
+     *  kept until the whole document is read. After the last chunk of a document (atEnd set)
+     *  the next call starts a new document, feature ids keep increasing.
+     *  @param data chunk of the GML document
+     *  @param atEnd true if this is the last chunk of the document
+     *  @param wkbType wkbType of the parsed geometries, has to stay valid until the end of the document
+     *  @return true if the data were parsed without errors
+     *  @note added in QGIS 2.14
+     */
+    bool processData( const QByteArray& data, bool atEnd, QGis::WkbType* wkbType );
+
+    /** Take the features parsed by processData() so far, ordered by feature id.
+     *  Ownership of the features is transferred to the caller.
+     *  @param idsMap if not null, receives the WFS server ids of the taken features
+     *  @note added in QGIS 2.14
+     *  @note not available in python bindings
+     */
+    QList<QgsFeature*> takeFeatures( QMap<QgsFeatureId, QString >* idsMap = 0 );
+
     /** Get parsed features for given type name */
     QMap<QgsFeatureId, QgsFeature* > featuresMap() const { return mFeatures; }
 
@@ -247,6 +267,8 @@ class CORE_EXPORT QgsGml : public QObject
     ParseMode mCoorMode;
     /** EPSG of parsed features geometries */
     int mEpsg;
+    /** Parser of the document processed with processData() */
+    XML_Parser mStreamingParser;
 };
 
 #endif
@@ -24,6 +24,8 @@
 #include "pal.h"
 #include "problem.h"
 
+#include <cmath>
+
 
 
 // helper function for checking for job cancellation within PAL
@@ -133,10 +135,33 @@ void QgsLabelingEngineV2::processProvider( QgsAbstractLabelProvider* provider, Q
   l->setUpsidedownLabels( upsdnlabels );
 
 
+  // identify the provider within the solution
+  QgsLabelingSolution::ProviderKey key( provider->name(), 0 );
+  Q_FOREACH ( const QgsLabelingSolution::ProviderKey& otherKey, mProviderKeys )
+  {
+    if ( otherKey.first == key.first )
+      key.second++;
+  }
+  mProviderKeys.insert( provider, key );
+
+  // labels from the previous run can be kept only if there is a single label per feature at a simple position
+  bool retainLabels = !mRetainExtent.isEmpty()
+                      && provider->placement() != QgsPalLayerSettings::Curved
+                      && !flags.testFlag( QgsAbstractLabelProvider::LabelPerFeaturePart )
+                      && !flags.testFlag( QgsAbstractLabelProvider::MergeConnectedLines );
+
   QList<QgsLabelFeature*> features = provider->labelFeatures( context );
 
   Q_FOREACH ( QgsLabelFeature* feature, features )
   {
+    QgsLabelingSolution::Label previousLabel;
+    if ( retainLabels && !feature->hasFixedPosition() && qgsDoubleNear( feature->repeatDistance(), 0.0 )
+         && mPreviousSolution.label( key, feature->id(), previousLabel )
+         && mRetainExtent.contains( previousLabel.boundingBox ) )
+    {
+      feature->setRetainedPosition( previousLabel.position, previousLabel.angle, previousLabel.reversed, previousLabel.quadrant );
+    }
+
     try
     {
       l->registerFeature( feature );
@@ -181,6 +206,27 @@ void QgsLabelingEngineV2::run( QgsRenderContext& context )
 
   p.setShowPartial( mFlags.testFlag( UsePartialCandidates ) );
 
+  QgsGeometry* extentGeom( QgsGeometry::fromRect( mMapSettings.visibleExtent() ) );
+  if ( !qgsDoubleNear( mMapSettings.rotation(), 0.0 ) )
+  {
+    //PAL features are prerotated, so extent also needs to be unrotated
+    extentGeom->rotate( -mMapSettings.rotation(), mMapSettings.visibleExtent().center() );
+  }
+
+  QgsRectangle extent = extentGeom->boundingBox();
+  delete extentGeom;
+
+  // labels of the previous solution which are within the part of map that is still visible
+  // keep their positions, so that only the newly exposed area needs to be solved
+  mSolution = QgsLabelingSolution();
+  mProviderKeys.clear();
+  mRetainExtent = QgsRectangle();
+  if ( !mPreviousSolution.isEmpty() && mPreviousSolution.isCompatible( mMapSettings ) )
+  {
+    QgsRectangle previousExtent = mPreviousSolution.extent();
+    if ( extent.intersects( previousExtent ) )
+      mRetainExtent = extent.intersect( &previousExtent );
+  }
 
   // for each provider: get labels and register them in PAL
   Q_FOREACH ( QgsAbstractLabelProvider* provider, mProviders )
@@ -193,16 +239,6 @@ void QgsLabelingEngineV2::run( QgsRenderContext& context )
 
   QPainter* painter = context.painter();
 
-  QgsGeometry* extentGeom( QgsGeometry::fromRect( mMapSettings.visibleExtent() ) );
-  if ( !qgsDoubleNear( mMapSettings.rotation(), 0.0 ) )
-  {
-    //PAL features are prerotated, so extent also needs to be unrotated
-    extentGeom->rotate( -mMapSettings.rotation(), mMapSettings.visibleExtent().center() );
-  }
-
-  QgsRectangle extent = extentGeom->boundingBox();
-  delete extentGeom;
-
   p.registerCancellationCallback( &_palIsCancelled, ( void* ) &context );
 
   QTime t;
@@ -272,6 +308,37 @@ void QgsLabelingEngineV2::run( QgsRenderContext& context )
     delete labels;
     return;
   }
+
+  // keep the layout for the next run
+  mSolution = QgsLabelingSolution( mMapSettings, extent );
+  for ( std::list<pal::LabelPosition*>::const_iterator it = labels->begin(); it != labels->end(); ++it )
+  {
+    pal::LabelPosition* lp = *it;
+    QgsLabelFeature* lf = lp->getFeaturePart()->feature();
+    if ( !lf || lp->getNextPart() || !mProviderKeys.contains( lf->provider() ) )
+      continue;
+
+    double amin[2], amax[2];
+    lp->getBoundingBox( amin, amax );
+
+    QgsLabelingSolution::Label label;
+    if ( lp->getUpsideDown() )
+    {
+      // store the position before it got turned upright, so the label is recreated identically
+      label.position = QgsPoint( lp->getX( 2 ), lp->getY( 2 ) );
+      label.angle = lp->getAlpha() < M_PI ? lp->getAlpha() + M_PI : lp->getAlpha() - M_PI;
+    }
+    else
+    {
+      label.position = QgsPoint( lp->getX(), lp->getY() );
+      label.angle = lp->getAlpha();
+    }
+    label.reversed = lp->getReversed();
+    label.quadrant = lp->getQuadrant();
+    label.boundingBox = QgsRectangle( amin[0], amin[1], amax[0], amax[1] );
+    mSolution.addLabel( mProviderKeys.value( lf->provider() ), lf->id(), label );
+  }
+
   painter->setRenderHint( QPainter::Antialiasing );
 
   // draw the labels
@@ -344,6 +411,68 @@ void QgsLabelingEngineV2::writeSettingsToProject()
 
 
 
+////
+
+
+QgsLabelingSolution::QgsLabelingSolution()
+    : mScale( 0 )
+    , mOutputDpi( 0 )
+{
+}
+
+QgsLabelingSolution::QgsLabelingSolution( const QgsMapSettings& mapSettings, const QgsRectangle& extent )
+    : mScale( mapSettings.scale() )
+    , mOutputDpi( mapSettings.outputDpi() )
+    , mDestCrs( mapSettings.destinationCrs().toProj4() )
+    , mExtent( extent )
+{
+}
+
+bool QgsLabelingSolution::isCompatible( const QgsMapSettings& mapSettings ) const
+{
+  // PAL features are prerotated around the center of the map, so with rotation
+  // the coordinates of labels change with every pan
+  return qgsDoubleNear( mapSettings.rotation(), 0.0 )
+         && qgsDoubleNearSig( mapSettings.scale(), mScale )
+         && qgsDoubleNear( mapSettings.outputDpi(), mOutputDpi )
+         && mapSettings.destinationCrs().toProj4() == mDestCrs;
+}
+
+void QgsLabelingSolution::addLabel( const ProviderKey& provider, QgsFeatureId id, const Label& label )
+{
+  mLabels[provider].insertMulti( id, label );
+}
+
+bool QgsLabelingSolution::label( const ProviderKey& provider, QgsFeatureId id, Label& label ) const
+{
+  QHash< ProviderKey, QMultiHash<QgsFeatureId, Label> >::const_iterator providerIt = mLabels.constFind( provider );
+  if ( providerIt == mLabels.constEnd() )
+    return false;
+
+  // features with several labels are placed from scratch
+  if ( providerIt->count( id ) != 1 )
+    return false;
+
+  label = providerIt->value( id );
+  return true;
+}
+
+void QgsLabelingSolution::removeProviders( const QString& name )
+{
+  QMutableHashIterator< ProviderKey, QMultiHash<QgsFeatureId, Label> > it( mLabels );
+  while ( it.hasNext() )
+  {
+    if ( it.next().key().first == name )
+      it.remove();
+  }
+}
+
+void QgsLabelingSolution::clear()
+{
+  mLabels.clear();
+}
+
+
 ////
 
 
@@ -358,6 +487,10 @@ QgsLabelFeature::QgsLabelFeature( QgsFeatureId id, GEOSGeometry* geometry, const
     , mHasFixedPosition( false )
     , mHasFixedAngle( false )
     , mFixedAngle( 0 )
+    , mHasRetainedPosition( false )
+    , mRetainedAngle( 0 )
+    , mRetainedReversed( false )
+    , mRetainedQuadrant( 0 )
     , mHasFixedQuadrant( false )
     , mDistLabel( 0 )
     , mRepeatDistance( 0 )
@@ -387,6 +520,15 @@ void QgsLabelFeature::setObstacleGeometry( GEOSGeometry* obstacleGeom )
   mObstacleGeometry = obstacleGeom;
 }
 
+void QgsLabelFeature::setRetainedPosition( const QgsPoint& point, double angle, bool reversed, int quadrant )
+{
+  mHasRetainedPosition = true;
+  mRetainedPosition = point;
+  mRetainedAngle = angle;
+  mRetainedReversed = reversed;
+  mRetainedQuadrant = quadrant;
+}
+
 QgsAbstractLabelProvider*QgsLabelFeature::provider() const
 {
   return mLayer ? mLayer->provider() : 0;
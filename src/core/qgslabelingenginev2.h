@@ -23,6 +23,8 @@
 #include "qgspallabeling.h"
 
 #include <QFlags>
+#include <QHash>
+#include <QPair>
 
 class QgsAbstractLabelProvider;
 class QgsRenderContext;
@@ -113,6 +115,28 @@ class CORE_EXPORT QgsLabelFeature
     //! Set angle in degrees of the fixed angle (relevant only if hasFixedAngle() returns true)
     void setFixedAngle( double angle ) { mFixedAngle = angle; }
 
+    /** Returns whether the label keeps the position computed by a previous labeling run.
+     * Such labels get only a single candidate, see QgsLabelingEngineV2::setPreviousSolution()
+     * @note added in QGIS 2.14
+     */
+    bool hasRetainedPosition() const { return mHasRetainedPosition; }
+    /** Sets the position computed by a previous labeling run which the label should keep.
+     * @param point down-left corner of the label (in map units)
+     * @param angle rotation of the label (in radians)
+     * @param reversed whether the label was reversed
+     * @param quadrant relative position of label to feature (pal::LabelPosition::Quadrant)
+     * @note added in QGIS 2.14
+     */
+    void setRetainedPosition( const QgsPoint& point, double angle, bool reversed, int quadrant );
+    //! Coordinates of the retained position (relevant only if hasRetainedPosition() returns true)
+    QgsPoint retainedPosition() const { return mRetainedPosition; }
+    //! Rotation in radians of the retained position (relevant only if hasRetainedPosition() returns true)
+    double retainedAngle() const { return mRetainedAngle; }
+    //! Whether the retained position was reversed (relevant only if hasRetainedPosition() returns true)
+    bool retainedReversed() const { return mRetainedReversed; }
+    //! Quadrant of the retained position (relevant only if hasRetainedPosition() returns true)
+    int retainedQuadrant() const { return mRetainedQuadrant; }
+
     /** Returns whether the quadrant for the label is fixed.
      * Applies to "around point" placement strategy.
      * @see setFixedQuadrant
@@ -226,6 +250,16 @@ class CORE_EXPORT QgsLabelFeature
     bool mHasFixedAngle;
     //! fixed rotation for the label (instead of automatic choice)
     double mFixedAngle;
+    //! whether the position from a previous labeling run should be kept
+    bool mHasRetainedPosition;
+    //! down-left corner of the label from a previous labeling run
+    QgsPoint mRetainedPosition;
+    //! rotation (in radians) of the label from a previous labeling run
+    double mRetainedAngle;
+    //! whether the label from a previous labeling run was reversed
+    bool mRetainedReversed;
+    //! quadrant of the label from a previous labeling run
+    int mRetainedQuadrant;
     //! whether mQuadOffset should be respected (only for "around point" placement)
     bool mHasFixedQuadrant;
     //! whether the side of the label is fixed (only for "around point" placement)
@@ -340,6 +374,79 @@ Q_DECLARE_OPERATORS_FOR_FLAGS( QgsAbstractLabelProvider::Flags )
 
 
 
+/**
+ * @brief The QgsLabelingSolution class keeps the layout of labels computed by QgsLabelingEngineV2.
+ *
+ * The solution may be passed to a following run of the labeling engine: if the map settings
+ * are compatible (same scale, CRS and output DPI, no rotation - i.e. the view was only panned),
+ * labels that are still within the map extent are kept at their positions and only the features
+ * in the newly exposed area are placed from scratch.
+ *
+ * Labels are identified by the name of their provider, the order of the provider among
+ * providers with the same name and the label feature ID.
+ *
+ * @note this class is not a part of public API yet. See notes in QgsLabelingEngineV2
+ * @note added in QGIS 2.14
+ */
+class CORE_EXPORT QgsLabelingSolution
+{
+  public:
+    //! Position of a single label
+    struct Label
+    {
+      //! down-left corner of the label (in map units)
+      QgsPoint position;
+      //! rotation in radians
+      double angle;
+      //! whether the label is reversed
+      bool reversed;
+      //! relative position of label to feature (pal::LabelPosition::Quadrant)
+      int quadrant;
+      //! bounding box of the label
+      QgsRectangle boundingBox;
+    };
+
+    //! Provider name and its order among providers with the same name
+    typedef QPair<QString, int> ProviderKey;
+
+    //! Construct an empty solution
+    QgsLabelingSolution();
+
+    //! Construct an empty solution for given map settings and labeled extent
+    QgsLabelingSolution( const QgsMapSettings& mapSettings, const QgsRectangle& extent );
+
+    //! Whether the solution does not contain any labels
+    bool isEmpty() const { return mLabels.isEmpty(); }
+
+    //! Whether labels of the solution may be reused for given map settings
+    bool isCompatible( const QgsMapSettings& mapSettings ) const;
+
+    //! Extent which was labeled
+    QgsRectangle extent() const { return mExtent; }
+
+    //! Add position of a label
+    void addLabel( const ProviderKey& provider, QgsFeatureId id, const Label& label );
+
+    /** Find position of a label.
+     * @returns false if the label is not in the solution or the feature had more than one label
+     */
+    bool label( const ProviderKey& provider, QgsFeatureId id, Label& label ) const;
+
+    //! Remove labels of all providers with given name (i.e. layer ID for layer providers)
+    void removeProviders( const QString& name );
+
+    //! Remove all labels
+    void clear();
+
+  private:
+    double mScale;
+    double mOutputDpi;
+    QString mDestCrs;
+    QgsRectangle mExtent;
+    QHash< ProviderKey, QMultiHash<QgsFeatureId, Label> > mLabels;
+};
+
+
 /**
  * @brief The QgsLabelingEngineV2 class provides map labeling functionality.
  * The input for the engine is a list of label provider objects and map settings.
@@ -407,6 +514,17 @@ class CORE_EXPORT QgsLabelingEngineV2
     //! Return pointer to recently computed results and pass the ownership of results to the caller
     QgsLabelingResults* takeResults();
 
+    /** Set layout of labels from a previous run. If it is compatible with the map settings,
+     * labels still within the map extent keep their positions.
+     * @note added in QGIS 2.14
+     */
+    void setPreviousSolution( const QgsLabelingSolution& solution ) { mPreviousSolution = solution; }
+
+    /** Layout of labels computed by the recent run(). Empty if the run has been cancelled.
+     * @note added in QGIS 2.14
+     */
+    QgsLabelingSolution solution() const { return mSolution; }
+
     //! For internal use by the providers
     QgsLabelingResults* results() const { return mResults; }
 
@@ -452,6 +570,15 @@ class CORE_EXPORT QgsLabelingEngineV2
 
     //! Resulting labeling layout
     QgsLabelingResults* mResults;
+
+    //! Layout of labels from a previous run
+    QgsLabelingSolution mPreviousSolution;
+    //! Area where labels from the previous run may be kept (empty if the previous solution is not used)
+    QgsRectangle mRetainExtent;
+    //! Layout of labels from the recent run
+    QgsLabelingSolution mSolution;
+    //! Keys of the providers processed in the recent run
+    QHash<QgsAbstractLabelProvider*, QgsLabelingSolution::ProviderKey> mProviderKeys;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS( QgsLabelingEngineV2::Flags )
@@ -15,9 +15,12 @@
 
 #include "qgsmaprenderercache.h"
 
+#include "qgis.h"
 #include "qgsmaplayerregistry.h"
 #include "qgsmaplayer.h"
 
+#include <QSet>
+
 QgsMapRendererCache::QgsMapRendererCache()
 {
   clear();
@@ -27,6 +30,7 @@ void QgsMapRendererCache::clear()
 {
   QMutexLocker lock( &mMutex );
   clearInternal();
+  mLabelingSolution.clear();
 }
 
 void QgsMapRendererCache::clearInternal()
@@ -35,7 +39,8 @@ void QgsMapRendererCache::clearInternal()
   mScale = 0;
 
   // make sure we are disconnected from all layers
-  Q_FOREACH ( const QString& layerId, mCachedImages.keys() )
+  QSet<QString> layerIds = mCachedImages.keys().toSet() + mPreviousImages.keys().toSet();
+  Q_FOREACH ( const QString& layerId, layerIds )
   {
     QgsMapLayer* layer = QgsMapLayerRegistry::instance()->mapLayer( layerId );
     if ( layer )
@@ -44,6 +49,8 @@ void QgsMapRendererCache::clearInternal()
     }
   }
   mCachedImages.clear();
+  mPreviousImages.clear();
+  mPreviousExtent.setMinimal();
 }
 
 bool QgsMapRendererCache::init( const QgsRectangle& extent, double scale )
@@ -55,6 +62,28 @@ bool QgsMapRendererCache::init( const QgsRectangle& extent, double scale )
        scale == mScale )
     return true;
 
+  // panned: keep the images, the unchanged part can be reused
+  if ( scale == mScale && mScale != 0 &&
+       qgsDoubleNear( extent.width(), mExtent.width(), mExtent.width() * 1e-9 ) &&
+       qgsDoubleNear( extent.height(), mExtent.height(), mExtent.height() * 1e-9 ) )
+  {
+    // images of layers that have not been rendered in the last extent are of no use anymore
+    Q_FOREACH ( const QString& layerId, mPreviousImages.keys() )
+    {
+      QgsMapLayer* layer = QgsMapLayerRegistry::instance()->mapLayer( layerId );
+      if ( layer && !mCachedImages.contains( layerId ) )
+      {
+        disconnect( layer, SIGNAL( repaintRequested() ), this, SLOT( layerRequestedRepaint() ) );
+      }
+    }
+    mPreviousImages = mCachedImages;
+    mPreviousExtent = mExtent;
+    mCachedImages.clear();
+
+    mExtent = extent;
+    return false;
+  }
+
   clearInternal();
 
   // set new params
@@ -68,12 +97,13 @@ void QgsMapRendererCache::setCacheImage( const QString& layerId, const QImage& i
 {
   QMutexLocker lock( &mMutex );
   mCachedImages[layerId] = img;
+  mPreviousImages.remove( layerId );
 
   // connect to the layer to listen to layer's repaintRequested() signals
   QgsMapLayer* layer = QgsMapLayerRegistry::instance()->mapLayer( layerId );
   if ( layer )
   {
-    connect( layer, SIGNAL( repaintRequested() ), this, SLOT( layerRequestedRepaint() ) );
+    connect( layer, SIGNAL( repaintRequested() ), this, SLOT( layerRequestedRepaint() ), Qt::UniqueConnection );
   }
 }
 
@@ -83,6 +113,35 @@ QImage QgsMapRendererCache::cacheImage( const QString& layerId )
   return mCachedImages.value( layerId );
 }
 
+QImage QgsMapRendererCache::previousCacheImage( const QString& layerId, QgsRectangle& extent )
+{
+  QMutexLocker lock( &mMutex );
+  extent = mPreviousExtent;
+  return mPreviousImages.value( layerId );
+}
+
+void QgsMapRendererCache::setLabelingSolution( const QgsLabelingSolution& solution, const QStringList& layerIds )
+{
+  QMutexLocker lock( &mMutex );
+  mLabelingSolution = solution;
+
+  // labels of the layer have to be placed again once it gets changed
+  Q_FOREACH ( const QString& layerId, layerIds )
+  {
+    QgsMapLayer* layer = QgsMapLayerRegistry::instance()->mapLayer( layerId );
+    if ( layer )
+    {
+      connect( layer, SIGNAL( repaintRequested() ), this, SLOT( layerRequestedLabelsRepaint() ), Qt::UniqueConnection );
+    }
+  }
+}
+
+QgsLabelingSolution QgsMapRendererCache::labelingSolution()
+{
+  QMutexLocker lock( &mMutex );
+  return mLabelingSolution;
+}
+
 void QgsMapRendererCache::layerRequestedRepaint()
 {
   QgsMapLayer* layer = qobject_cast<QgsMapLayer*>( sender() );
@@ -90,11 +149,22 @@ void QgsMapRendererCache::layerRequestedRepaint()
     clearCacheImage( layer->id() );
 }
 
+void QgsMapRendererCache::layerRequestedLabelsRepaint()
+{
+  QgsMapLayer* layer = qobject_cast<QgsMapLayer*>( sender() );
+  if ( layer )
+  {
+    QMutexLocker lock( &mMutex );
+    mLabelingSolution.removeProviders( layer->id() );
+  }
+}
+
 void QgsMapRendererCache::clearCacheImage( const QString& layerId )
 {
   QMutexLocker lock( &mMutex );
 
   mCachedImages.remove( layerId );
+  mPreviousImages.remove( layerId );
 
   QgsMapLayer* layer = QgsMapLayerRegistry::instance()->mapLayer( layerId );
   if ( layer )
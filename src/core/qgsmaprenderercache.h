@@ -19,8 +19,10 @@
 #include <QMap>
 #include <QImage>
 #include <QMutex>
+#include <QStringList>
 
 #include "qgsrectangle.h"
+#include "qgslabelingenginev2.h"
 
 
 /**
@@ -30,6 +32,10 @@
  * the cache listens to repaintRequested() signals from layer. If triggered, the cache
  * removes the rendered image (and disconnects from the layer).
  *
+ * When the extent changes while the scale stays the same (the map is panned), the images
+ * are kept as images of the previous extent, so renderer jobs can reuse the part still
+ * within the view and render just the newly exposed area.
+ *
  * The class is thread-safe (multiple classes can access the same instance safely).
  *
  * @note added in 2.4
@@ -44,7 +50,8 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     //! invalidate the cache contents
     void clear();
 
-    //! initialize cache: set new parameters and erase cache if parameters have changed
+    //! initialize cache: set new parameters and erase cache if parameters have changed.
+    //! If only the extent has been shifted, the images are kept as images of the previous extent.
     //! @return flag whether the parameters are the same as last time
     bool init( const QgsRectangle& extent, double scale );
 
@@ -54,12 +61,34 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     //! get cached image for the specified layer ID. Returns null image if it is not cached.
     QImage cacheImage( const QString& layerId );
 
+    //! get image of the layer rendered for the previous extent at the same scale.
+    //! Returns null image if the map has not been panned or the layer has not been cached.
+    //! @param layerId layer ID
+    //! @param extent will be set to the extent of the image
+    //! @note added in 2.14
+    QImage previousCacheImage( const QString& layerId, QgsRectangle& extent );
+
     //! remove layer from the cache
     void clearCacheImage( const QString& layerId );
 
+    //! set layout of labels computed by the labeling engine. Unlike layer images, it is kept when the extent changes.
+    //! Labels of a layer are removed once the layer requests repaint.
+    //! @param solution layout of labels
+    //! @param layerIds IDs of layers that have been labeled
+    //! @note added in 2.14
+    //! @note not available in Python bindings
+    void setLabelingSolution( const QgsLabelingSolution& solution, const QStringList& layerIds );
+
+    //! get layout of labels from the last labeling run
+    //! @note added in 2.14
+    //! @note not available in Python bindings
+    QgsLabelingSolution labelingSolution();
+
   protected slots:
     //! remove layer (that emitted the signal) from the cache
     void layerRequestedRepaint();
+    //! remove labels of the layer (that emitted the signal) from the labeling solution
+    void layerRequestedLabelsRepaint();
 
   protected:
     //! invalidate cache contents (without locking)
@@ -70,6 +99,11 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     QgsRectangle mExtent;
     double mScale;
     QMap<QString, QImage> mCachedImages;
+    //! extent of the images in mPreviousImages
+    QgsRectangle mPreviousExtent;
+    //! images of the extent before panning
+    QMap<QString, QImage> mPreviousImages;
+    QgsLabelingSolution mLabelingSolution;
 };
 
 
@@ -18,6 +18,7 @@
 #include "qgslabelingenginev2.h"
 #include "qgslogger.h"
 #include "qgsmaplayerregistry.h"
+#include "qgsmaprenderercache.h"
 #include "qgsmaplayerrenderer.h"
 #include "qgspallabeling.h"
 #include "qgsvectorlayer.h"
@@ -129,6 +130,7 @@ void QgsMapRendererCustomPainterJob::cancel()
   for ( LayerRenderJobs::iterator it = mLayerJobs.begin(); it != mLayerJobs.end(); ++it )
   {
     it->context.setRenderingStopped( true );
+    it->exposedContext.setRenderingStopped( true );
   }
 
   QTime t;
@@ -248,7 +250,7 @@ void QgsMapRendererCustomPainterJob::doRender()
     }
 
     if ( !job.cached )
-      job.renderer->render();
+      renderLayerJob( job );
 
     if ( job.img )
     {
@@ -261,7 +263,10 @@ void QgsMapRendererCustomPainterJob::doRender()
   QgsDebugMsg( "Done rendering map layers" );
 
   if ( mSettings.testFlag( QgsMapSettings::DrawLabeling ) && !mLabelingRenderContext.renderingStopped() )
+  {
     drawLabeling( mSettings, mLabelingRenderContext, mLabelingEngine, mLabelingEngineV2, mPainter );
+    updateLabelingSolution( mLabelingEngineV2, mLabelingRenderContext );
+  }
 
   QgsDebugMsg( "Rendering completed in (seconds): " + QString( "%1" ).arg( renderTime.elapsed() / 1000.0 ) );
 }
@@ -366,6 +371,14 @@ void QgsMapRendererJob::updateLayerGeometryCaches()
   mGeometryCaches.clear();
 }
 
+void QgsMapRendererJob::updateLabelingSolution( QgsLabelingEngineV2* labelingEngine2, const QgsRenderContext& renderContext )
+{
+  if ( !mCache || !labelingEngine2 || renderContext.renderingStopped() )
+    return;
+
+  mCache->setLabelingSolution( labelingEngine2->solution(), mSettings.layers() );
+}
+
 
 bool QgsMapRendererJob::needTemporaryImage( QgsMapLayer* ml )
 {
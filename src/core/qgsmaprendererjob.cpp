@@ -30,9 +30,23 @@
 #include "qgsmaplayerstylemanager.h"
 #include "qgsmaprenderercache.h"
 #include "qgspallabeling.h"
+#include "qgscategorizedsymbolrendererv2.h"
+#include "qgsgraduatedsymbolrendererv2.h"
+#include "qgssinglesymbolrendererv2.h"
+#include "qgssymbollayerv2.h"
+#include "qgssymbollayerv2utils.h"
 #include "qgsvectorlayerrenderer.h"
 #include "qgsvectorlayer.h"
 
+#include <cmath>
+
+//! map extent covered by the pixels of rect
+static QgsRectangle pixelRectExtent( const QgsMapToPixel& mtp, const QRect& rect )
+{
+  return QgsRectangle( mtp.toMapCoordinates( rect.topLeft() ),
+                       mtp.toMapCoordinates( rect.bottomRight() + QPoint( 1, 1 ) ) );
+}
+
 QgsMapRendererJob::QgsMapRendererJob( const QgsMapSettings& settings )
     : mSettings( settings )
     , mCache( 0 )
@@ -181,6 +195,10 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter* painter, QgsPalLabelin
     bool cacheValid = mCache->init( mSettings.visibleExtent(), mSettings.scale() );
     QgsDebugMsg( QString( "CACHE VALID: %1" ).arg( cacheValid ) );
     Q_UNUSED( cacheValid );
+
+    // labels still within the view may stay where they were placed by the last job
+    if ( labelingEngine2 )
+      labelingEngine2->setPreviousSolution( mCache->labelingSolution() );
   }
 
   mGeometryCaches.clear();
@@ -213,37 +231,71 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter* painter, QgsPalLabelin
       continue;
     }
 
+    // Force render of layers that are being edited
+    // or if there's a labeling engine that needs the layer to register features
+    if ( mCache && ml->type() == QgsMapLayer::VectorLayer )
+    {
+      QgsVectorLayer* vl = qobject_cast<QgsVectorLayer *>( ml );
+      if ( vl->isEditable() || (( labelingEngine || labelingEngine2 ) && QgsPalLabeling::staticWillUseLayer( vl ) ) )
+        mCache->clearCacheImage( ml->id() );
+    }
+
     QgsRectangle r1 = mSettings.visibleExtent(), r2;
     const QgsCoordinateTransform* ct = 0;
 
+    // if the map has been panned, reuse the previous image and render just the exposed area
+    QVector<QRect> exposedRects;
+    QgsRectangle exposedExtent, exposedR2;
+    QImage* pannedImage = 0;
+    if ( mCache && mCache->cacheImage( ml->id() ).isNull() )
+    {
+      // symbols of features just outside the exposed area may reach into it: the features
+      // are queried in the area grown by the symbol size, the painter is clipped to the area
+      QgsRenderContext context = QgsRenderContext::fromMapSettings( mSettings );
+      double margin = symbolMargin( ml, context );
+      pannedImage = margin >= 0 ? pannedCacheImage( ml->id(), exposedRects ) : 0;
+      if ( pannedImage )
+      {
+        int m = static_cast<int>( ceil( margin ) ) + 1;
+        r1 = pixelRectExtent( mSettings.mapToPixel(), exposedRects[0].adjusted( -m, -m, m, m ) );
+        if ( exposedRects.size() > 1 )
+          exposedExtent = pixelRectExtent( mSettings.mapToPixel(), exposedRects[1].adjusted( -m, -m, m, m ) );
+      }
+    }
+
     if ( mSettings.hasCrsTransformEnabled() )
     {
       ct = mSettings.layerTransform( ml );
       if ( ct )
       {
         reprojectToLayerExtent( ml, ct, r1, r2 );
+        if ( !exposedExtent.isEmpty() )
+          reprojectToLayerExtent( ml, ct, exposedExtent, exposedR2 );
       }
       QgsDebugMsg( "extent: " + r1.toString() );
       if ( !r1.isFinite() || !r2.isFinite() )
       {
         mErrors.append( Error( layerId, tr( "There was a problem transforming the layer's extent. Layer skipped." ) ) );
+        delete pannedImage;
         continue;
       }
-    }
-
-    // Force render of layers that are being edited
-    // or if there's a labeling engine that needs the layer to register features
-    if ( mCache && ml->type() == QgsMapLayer::VectorLayer )
-    {
-      QgsVectorLayer* vl = qobject_cast<QgsVectorLayer *>( ml );
-      if ( vl->isEditable() || (( labelingEngine || labelingEngine2 ) && QgsPalLabeling::staticWillUseLayer( vl ) ) )
-        mCache->clearCacheImage( ml->id() );
+      if ( !exposedExtent.isEmpty() && ( !exposedExtent.isFinite() || !exposedR2.isFinite() ) )
+      {
+        // render the layer in full
+        delete pannedImage;
+        pannedImage = 0;
+        exposedRects.clear();
+        r1 = mSettings.visibleExtent();
+        if ( ct )
+          reprojectToLayerExtent( ml, ct, r1, r2 );
+      }
     }
 
     layerJobs.append( LayerRenderJob() );
     LayerRenderJob& job = layerJobs.last();
     job.cached = false;
     job.img = 0;
+    job.exposedRenderer = 0;
     job.blendMode = ml->blendMode();
     job.layerId = ml->id();
 
@@ -267,7 +319,22 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter* painter, QgsPalLabelin
     // If we are drawing with an alternative blending mode then we need to render to a separate image
     // before compositing this on the map. This effectively flattens the layer and prevents
     // blending occuring between objects on the layer
-    if ( mCache || !painter || needTemporaryImage( ml ) )
+    if ( pannedImage )
+    {
+      job.img = pannedImage;
+      QPainter* mypPainter = new QPainter( job.img );
+      mypPainter->setRenderHint( QPainter::Antialiasing, mSettings.testFlag( QgsMapSettings::Antialiasing ) );
+      mypPainter->setClipRect( exposedRects[0] );
+      job.context.setPainter( mypPainter );
+      if ( exposedRects.size() > 1 )
+      {
+        // the second strip of a diagonal pan is rendered after the first one with the same painter
+        job.exposedContext = job.context;
+        job.exposedContext.setExtent( exposedExtent );
+        job.exposedRect = exposedRects[1];
+      }
+    }
+    else if ( mCache || !painter || needTemporaryImage( ml ) )
     {
       // Flattened image for drawing when a blending mode is set
       QImage * mypFlattenedImage = 0;
@@ -294,6 +361,8 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter* painter, QgsPalLabelin
       ml->styleManager()->setOverrideStyle( mSettings.layerStyleOverrides().value( ml->id() ) );
 
     job.renderer = ml->createMapRenderer( job.context );
+    if ( !job.exposedRect.isNull() )
+      job.exposedRenderer = ml->createMapRenderer( job.exposedContext );
 
     if ( hasStyleOverride )
       ml->styleManager()->restoreOverrideStyle();
@@ -312,6 +381,116 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter* painter, QgsPalLabelin
 }
 
 
+QImage* QgsMapRendererJob::pannedCacheImage( const QString& layerId, QVector<QRect>& exposedRects )
+{
+  if ( mSettings.rotation() != 0 )
+    return 0;
+
+  QgsRectangle previousExtent;
+  QImage previousImage = mCache->previousCacheImage( layerId, previousExtent );
+  if ( previousImage.isNull() || previousImage.size() != mSettings.outputSize() || previousImage.format() != mSettings.outputImageFormat() )
+    return 0;
+
+  // offset of the previous image - only shifts by whole pixels can be reused
+  QgsRectangle extent = mSettings.visibleExtent();
+  double mupp = mSettings.mapUnitsPerPixel();
+  double dx = ( previousExtent.xMinimum() - extent.xMinimum() ) / mupp;
+  double dy = ( extent.yMaximum() - previousExtent.yMaximum() ) / mupp;
+  int ix = qRound( dx );
+  int iy = qRound( dy );
+  if ( qAbs( dx - ix ) > 0.01 || qAbs( dy - iy ) > 0.01 )
+    return 0;
+
+  QRect viewRect( QPoint( 0, 0 ), mSettings.outputSize() );
+  QRect keptRect = viewRect.intersected( viewRect.translated( ix, iy ) );
+
+  // a strip along one of the edges is rendered, or two strips (a full width one and
+  // one beside the kept area) when panned in both directions
+  if ( keptRect.isEmpty() || keptRect == viewRect )
+    return 0;
+  exposedRects = ( QRegion( viewRect ) - QRegion( keptRect ) ).rects();
+  if ( exposedRects.isEmpty() || exposedRects.size() > 2 )
+    return 0;
+
+  QImage* image = new QImage( mSettings.outputSize(), mSettings.outputImageFormat() );
+  if ( image->isNull() )
+  {
+    delete image;
+    return 0;
+  }
+  image->fill( 0 );
+
+  QPainter painter( image );
+  painter.drawImage( ix, iy, previousImage );
+  painter.end();
+
+  QgsDebugMsg( QString( "reusing image of %1 panned by %2,%3 px" ).arg( layerId ).arg( ix ).arg( iy ) );
+  return image;
+}
+
+
+void QgsMapRendererJob::renderLayerJob( LayerRenderJob& job )
+{
+  job.renderer->render();
+
+  if ( job.exposedRenderer && !job.context.renderingStopped() )
+  {
+    job.context.painter()->setClipRect( job.exposedRect );
+    job.exposedRenderer->render();
+  }
+}
+
+
+double QgsMapRendererJob::symbolMargin( QgsMapLayer* ml, QgsRenderContext& context )
+{
+  QgsVectorLayer* vl = qobject_cast<QgsVectorLayer*>( ml );
+  if ( !vl )
+    return 0;
+
+  // other renderers (heatmap, point displacement...) do not just draw the symbols of the features
+  QgsFeatureRendererV2* renderer = vl->rendererV2();
+  static QStringList symbolRenderers = QStringList() << "singleSymbol" << "categorizedSymbol" << "graduatedSymbol" << "RuleRenderer";
+  if ( !renderer || !symbolRenderers.contains( renderer->type() ) )
+    return -1;
+
+  QgsSingleSymbolRendererV2* single = dynamic_cast<QgsSingleSymbolRendererV2*>( renderer );
+  QgsCategorizedSymbolRendererV2* categorized = dynamic_cast<QgsCategorizedSymbolRendererV2*>( renderer );
+  QgsGraduatedSymbolRendererV2* graduated = dynamic_cast<QgsGraduatedSymbolRendererV2*>( renderer );
+  if (( single && !single->sizeScaleField().isEmpty() ) ||
+      ( categorized && !categorized->sizeScaleField().isEmpty() ) ||
+      ( graduated && !graduated->sizeScaleField().isEmpty() ) )
+    return -1;
+
+  double margin = 0;
+  Q_FOREACH ( QgsSymbolV2* symbol, renderer->symbols( context ) )
+  {
+    for ( int i = 0; i < symbol->symbolLayerCount(); ++i )
+    {
+      QgsSymbolLayerV2* layer = symbol->symbolLayer( i );
+      if ( layer->hasDataDefinedProperties() )
+        return -1;
+
+      double bleed;
+      if ( QgsMarkerSymbolLayerV2* marker = dynamic_cast<QgsMarkerSymbolLayerV2*>( layer ) )
+      {
+        // the whole size - markers may be rotated, anchored at a corner or outlined
+        bleed = marker->size() * QgsSymbolLayerV2Utils::lineWidthScaleFactor( context, marker->sizeUnit(), marker->sizeMapUnitScale() )
+                + qMax( qAbs( marker->offset().x() ), qAbs( marker->offset().y() ) )
+                * QgsSymbolLayerV2Utils::lineWidthScaleFactor( context, marker->offsetUnit(), marker->offsetMapUnitScale() );
+      }
+      else
+      {
+        if ( layer->outputUnit() == QgsSymbolV2::Mixed )
+          return -1;
+        bleed = layer->estimateMaxBleed() * QgsSymbolLayerV2Utils::lineWidthScaleFactor( context, layer->outputUnit(), layer->mapUnitScale() );
+      }
+      margin = qMax( margin, bleed * context.rasterScaleFactor() );
+    }
+  }
+  return margin;
+}
+
+
 void QgsMapRendererJob::cleanupJobs( LayerRenderJobs& jobs )
 {
   for ( LayerRenderJobs::iterator it = jobs.begin(); it != jobs.end(); ++it )
@@ -340,6 +519,15 @@ void QgsMapRendererJob::cleanupJobs( LayerRenderJobs& jobs )
       delete job.renderer;
       job.renderer = 0;
     }
+
+    if ( job.exposedRenderer )
+    {
+      Q_FOREACH ( const QString& message, job.exposedRenderer->errors() )
+        mErrors.append( Error( job.exposedRenderer->layerID(), message ) );
+
+      delete job.exposedRenderer;
+      job.exposedRenderer = 0;
+    }
   }
 
   jobs.clear();
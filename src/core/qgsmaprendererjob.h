@@ -47,6 +47,10 @@ struct LayerRenderJob
   QPainter::CompositionMode blendMode;
   bool cached; // if true, img already contains cached image from previous rendering
   QString layerId;
+  // renders the second strip exposed by a diagonal pan after renderer, with the painter clipped to exposedRect (may be null, must be deleted)
+  QgsMapLayerRenderer* exposedRenderer;
+  QgsRenderContext exposedContext;
+  QRect exposedRect;
 };
 
 typedef QList<LayerRenderJob> LayerRenderJobs;
@@ -157,6 +161,26 @@ class CORE_EXPORT QgsMapRendererJob : public QObject
 
     static QImage composeImage( const QgsMapSettings& settings, const LayerRenderJobs& jobs );
 
+    //! Returns new image of the layer with its image cached for the previous extent shifted
+    //! to the current one, or null if the map has not been just panned.
+    //! @param layerId layer ID
+    //! @param exposedRects will be set to the areas of the image that still need to be rendered:
+    //! one strip along an edge, or two strips when panned diagonally
+    //! @note not available in python bindings
+    //! @note added in 2.14
+    QImage* pannedCacheImage( const QString& layerId, QVector<QRect>& exposedRects );
+
+    //! Renders the layer of a job, including the second strip exposed by a diagonal pan
+    //! @note not available in python bindings
+    //! @note added in 2.14
+    static void renderLayerJob( LayerRenderJob& job );
+
+    //! Returns how far (in pixels) the symbols of a layer may reach beyond the geometries
+    //! of the features, or -1 if that cannot be estimated (e.g. data defined sizes)
+    //! @note not available in python bindings
+    //! @note added in 2.14
+    static double symbolMargin( QgsMapLayer* ml, QgsRenderContext& context );
+
     bool needTemporaryImage( QgsMapLayer* ml );
 
     static void drawLabeling( const QgsMapSettings& settings, QgsRenderContext& renderContext, QgsPalLabeling* labelingEngine, QgsLabelingEngineV2* labelingEngine2, QPainter* painter );
@@ -166,6 +190,11 @@ class CORE_EXPORT QgsMapRendererJob : public QObject
     //! called when rendering has finished to update all layers' geometry caches
     void updateLayerGeometryCaches();
 
+    //! called when labeling has finished to keep the layout of labels for following jobs
+    //! @note not available in python bindings
+    //! @note added in 2.14
+    void updateLabelingSolution( QgsLabelingEngineV2* labelingEngine2, const QgsRenderContext& renderContext );
+
     QgsMapSettings mSettings;
     Errors mErrors;
 
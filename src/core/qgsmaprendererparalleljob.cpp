@@ -97,6 +97,7 @@ void QgsMapRendererParallelJob::cancel()
   for ( LayerRenderJobs::iterator it = mLayerJobs.begin(); it != mLayerJobs.end(); ++it )
   {
     it->context.setRenderingStopped( true );
+    it->exposedContext.setRenderingStopped( true );
   }
 
   if ( mStatus == RenderingLayers )
@@ -231,7 +232,7 @@ void QgsMapRendererParallelJob::renderLayerStatic( LayerRenderJob& job )
 
   try
   {
-    job.renderer->render();
+    renderLayerJob( job );
   }
   catch ( QgsException & e )
   {
@@ -259,6 +260,7 @@ void QgsMapRendererParallelJob::renderLabelsStatic( QgsMapRendererParallelJob* s
   try
   {
     drawLabeling( self->mSettings, self->mLabelingRenderContext, self->mLabelingEngine, self->mLabelingEngineV2, &painter );
+    self->updateLabelingSolution( self->mLabelingEngineV2, self->mLabelingRenderContext );
   }
   catch ( QgsException & e )
   {
@@ -333,6 +333,22 @@ void QgsMapToPixel::transformInPlace( float& x, float& y ) const
   x = mx; y = my;
 }
 
+void QgsMapToPixel::transformInPlace( QPointF* points, int count ) const
+{
+  // the matrix is affine (scale, rotation and translation), a plain loop over
+  // the coordinates is much cheaper than QTransform::map() for every point
+  const qreal m11 = mMatrix.m11(), m12 = mMatrix.m12();
+  const qreal m21 = mMatrix.m21(), m22 = mMatrix.m22();
+  const qreal dx = mMatrix.dx(), dy = mMatrix.dy();
+  for ( int i = 0; i < count; ++i )
+  {
+    const qreal x = points[i].x();
+    const qreal y = points[i].y();
+    points[i].rx() = m11 * x + m21 * y + dx;
+    points[i].ry() = m12 * x + m22 * y + dy;
+  }
+}
+
 QTransform QgsMapToPixel::transform() const
 {
   // NOTE: operations are done in the reverse order in which
@@ -120,6 +120,15 @@ class CORE_EXPORT QgsMapToPixel
         transformInPlace( x[i], y[i] );
     }
 
+    /**
+     * Transform an array of points from map coordinates to device coordinates
+     * in place. The matrix is read only once, so this is faster than transforming
+     * the points one by one.
+     * @note added in QGIS 2.14
+     * @note not available in python bindings
+     */
+    void transformInPlace( QPointF* points, int count ) const;
+
     QgsPoint toMapCoordinates( int x, int y ) const;
 
     //! Transform device coordinates to map (world) coordinates
@@ -17,11 +17,13 @@
 
 #include "qgsgeometry.h"
 #include "qgsvectorlayer.h"
+#include "qgsvectorlayerfeatureiterator.h"
 #include "qgswkbptr.h"
 
 #include <spatialindex/SpatialIndex.h>
 
 #include <QLinkedListIterator>
+#include <QtConcurrentRun>
 
 using namespace SpatialIndex;
 
@@ -571,6 +573,40 @@ class QgsPointLocator_DumpTree : public SpatialIndex::IQueryStrategy
 ////////////////////////////////////////////////////////////////////////////
 
 
+struct QgsPointLocator::IndexData
+{
+  IndexData()
+      : source( 0 )
+      , transform( 0 )
+      , maxFeaturesToIndex( -1 )
+      , storage( 0 )
+      , rtree( 0 )
+      , ok( true )
+  {}
+
+  ~IndexData()
+  {
+    delete source;
+    delete transform;
+    delete rtree;
+    delete storage;
+    qDeleteAll( geoms );
+  }
+
+  // input
+  QgsAbstractFeatureSource* source;
+  QgsFeatureRequest request;
+  QgsCoordinateTransform* transform;
+  int maxFeaturesToIndex;
+
+  // result
+  IStorageManager* storage;
+  ISpatialIndex* rtree;
+  QHash<QgsFeatureId, QgsGeometry*> geoms;
+  bool ok;
+};
+
+
 QgsPointLocator::QgsPointLocator( QgsVectorLayer* layer, const QgsCoordinateReferenceSystem* destCRS, const QgsRectangle* extent )
     : mStorage( 0 )
     , mRTree( 0 )
@@ -578,6 +614,7 @@ QgsPointLocator::QgsPointLocator( QgsVectorLayer* layer, const QgsCoordinateRefe
     , mTransform( 0 )
     , mLayer( layer )
     , mExtent( 0 )
+    , mAsyncIndex( 0 )
 {
   if ( destCRS )
   {
@@ -594,11 +631,13 @@ QgsPointLocator::QgsPointLocator( QgsVectorLayer* layer, const QgsCoordinateRefe
   connect( mLayer, SIGNAL( featureAdded( QgsFeatureId ) ), this, SLOT( onFeatureAdded( QgsFeatureId ) ) );
   connect( mLayer, SIGNAL( featureDeleted( QgsFeatureId ) ), this, SLOT( onFeatureDeleted( QgsFeatureId ) ) );
   connect( mLayer, SIGNAL( geometryChanged( QgsFeatureId, QgsGeometry& ) ), this, SLOT( onGeometryChanged( QgsFeatureId, QgsGeometry& ) ) );
+  connect( &mAsyncIndexWatcher, SIGNAL( finished() ), this, SLOT( onAsyncIndexFinished() ) );
 }
 
 
 QgsPointLocator::~QgsPointLocator()
 {
+  cancelIndexing();
   destroyIndex();
   delete mStorage;
   delete mTransform;
@@ -608,6 +647,12 @@ QgsPointLocator::~QgsPointLocator()
 
 bool QgsPointLocator::init( int maxFeaturesToIndex )
 {
+  // a build in background is waited for
+  if ( mAsyncIndex )
+  {
+    mAsyncIndexWatcher.waitForFinished();
+    return finishAsyncIndex();
+  }
   return hasIndex() ? true : rebuildIndex( maxFeaturesToIndex );
 }
 
@@ -616,20 +661,74 @@ bool QgsPointLocator::hasIndex() const
   return mRTree != 0 || mIsEmptyLayer;
 }
 
+void QgsPointLocator::initAsync( int maxFeaturesToIndex )
+{
+  if ( hasIndex() || mAsyncIndex || mLayer->geometryType() == QGis::NoGeometry )
+    return;
 
+  mAsyncIndex = createIndexData( maxFeaturesToIndex );
+  mCancelAsyncIndex = 0;
+  mAsyncIndexWatcher.setFuture( QtConcurrent::run( &QgsPointLocator::buildIndex, mAsyncIndex, &mCancelAsyncIndex ) );
+}
 
-bool QgsPointLocator::rebuildIndex( int maxFeaturesToIndex )
+bool QgsPointLocator::isIndexing() const
 {
-  destroyIndex();
+  return mAsyncIndex != 0;
+}
 
-  QLinkedList<RTree::Data*> dataList;
-  QgsFeature f;
-  QGis::GeometryType geomType = mLayer->geometryType();
-  if ( geomType == QGis::NoGeometry )
-    return true; // nothing to index
+void QgsPointLocator::cancelIndexing()
+{
+  if ( !mAsyncIndex )
+    return;
+
+  mCancelAsyncIndex = 1;
+  mAsyncIndexWatcher.waitForFinished();
+  delete mAsyncIndex;
+  mAsyncIndex = 0;
+  mChangedDuringIndexing.clear();
+}
 
-  QgsFeatureRequest request;
-  request.setSubsetOfAttributes( QgsAttributeList() );
+void QgsPointLocator::onAsyncIndexFinished()
+{
+  // already installed by init() or cancelled
+  if ( !mAsyncIndex )
+    return;
+
+  emit initFinished( finishAsyncIndex() );
+}
+
+bool QgsPointLocator::finishAsyncIndex()
+{
+  IndexData* data = mAsyncIndex;
+  mAsyncIndex = 0;
+  bool ok = installIndex( data );
+  delete data;
+
+  // the index is built from the features at the start of indexing
+  QSet<QgsFeatureId> changed = mChangedDuringIndexing;
+  mChangedDuringIndexing.clear();
+  if ( hasIndex() )
+  {
+    Q_FOREACH ( QgsFeatureId fid, changed )
+    {
+      onFeatureDeleted( fid );
+      onFeatureAdded( fid );
+    }
+  }
+  return ok;
+}
+
+QgsPointLocator::IndexData* QgsPointLocator::createIndexData( int maxFeaturesToIndex ) const
+{
+  IndexData* data = new IndexData;
+  data->source = new QgsVectorLayerFeatureSource( mLayer );
+  data->maxFeaturesToIndex = maxFeaturesToIndex;
+  data->request.setSubsetOfAttributes( QgsAttributeList() );
+  if ( mTransform )
+  {
+    // each thread needs its own transform
+    data->transform = new QgsCoordinateTransform( mTransform->sourceCrs(), mTransform->destCRS() );
+  }
   if ( mExtent )
   {
     QgsRectangle rect = *mExtent;
@@ -645,20 +744,34 @@ bool QgsPointLocator::rebuildIndex( int maxFeaturesToIndex )
         QgsDebugMsg( QString( "could not transform bounding box to map, skipping the snap filter (%1)" ).arg( e.what() ) );
       }
     }
-    request.setFilterRect( rect );
+    data->request.setFilterRect( rect );
   }
-  QgsFeatureIterator fi = mLayer->getFeatures( request );
+  return data;
+}
+
+void QgsPointLocator::buildIndex( IndexData* data, QAtomicInt* cancel )
+{
+  QLinkedList<RTree::Data*> dataList;
+  QgsFeature f;
+
+  QgsFeatureIterator fi = data->source->getFeatures( data->request );
   int indexedCount = 0;
   while ( fi.nextFeature( f ) )
   {
+    if ( cancel && *cancel )
+    {
+      qDeleteAll( dataList );
+      return;
+    }
+
     if ( !f.constGeometry() )
       continue;
 
-    if ( mTransform )
+    if ( data->transform )
     {
       try
       {
-        f.geometry()->transform( *mTransform );
+        f.geometry()->transform( *data->transform );
       }
       catch ( const QgsException& e )
       {
@@ -671,19 +784,24 @@ bool QgsPointLocator::rebuildIndex( int maxFeaturesToIndex )
     SpatialIndex::Region r( rect2region( f.constGeometry()->boundingBox() ) );
     dataList << new RTree::Data( 0, 0, r, f.id() );
 
-    if ( mGeoms.contains( f.id() ) )
-      delete mGeoms.take( f.id() );
-    mGeoms[f.id()] = new QgsGeometry( *f.constGeometry() );
+    if ( data->geoms.contains( f.id() ) )
+      delete data->geoms.take( f.id() );
+    data->geoms[f.id()] = new QgsGeometry( *f.constGeometry() );
     ++indexedCount;
 
-    if ( maxFeaturesToIndex != -1 && indexedCount > maxFeaturesToIndex )
+    if ( data->maxFeaturesToIndex != -1 && indexedCount > data->maxFeaturesToIndex )
     {
       qDeleteAll( dataList );
-      destroyIndex();
-      return false;
+      qDeleteAll( data->geoms );
+      data->geoms.clear();
+      data->ok = false;
+      return;
     }
   }
 
+  if ( dataList.isEmpty() )
+    return; // no features
+
   // R-Tree parameters
   double fillFactor = 0.7;
   unsigned long indexCapacity = 10;
@@ -692,18 +810,50 @@ bool QgsPointLocator::rebuildIndex( int maxFeaturesToIndex )
   RTree::RTreeVariant variant = RTree::RV_RSTAR;
   SpatialIndex::id_type indexId;
 
-  if ( dataList.isEmpty() )
+  data->storage = StorageManager::createNewMemoryStorageManager();
+  QgsPointLocator_Stream stream( dataList );
+  data->rtree = RTree::createAndBulkLoadNewRTree( RTree::BLM_STR, stream, *data->storage, fillFactor, indexCapacity,
+                leafCapacity, dimension, variant, indexId );
+}
+
+bool QgsPointLocator::installIndex( IndexData* data )
+{
+  destroyIndex();
+
+  if ( !data->ok )
+    return false;
+
+  if ( !data->rtree )
   {
     mIsEmptyLayer = true;
-    return true; // no features
+    return true;
   }
 
-  QgsPointLocator_Stream stream( dataList );
-  mRTree = RTree::createAndBulkLoadNewRTree( RTree::BLM_STR, stream, *mStorage, fillFactor, indexCapacity,
-           leafCapacity, dimension, variant, indexId );
+  delete mStorage;
+  mStorage = data->storage;
+  mRTree = data->rtree;
+  mGeoms = data->geoms;
+  data->storage = 0;
+  data->rtree = 0;
+  data->geoms.clear();
   return true;
 }
 
+bool QgsPointLocator::rebuildIndex( int maxFeaturesToIndex )
+{
+  destroyIndex();
+
+  QGis::GeometryType geomType = mLayer->geometryType();
+  if ( geomType == QGis::NoGeometry )
+    return true; // nothing to index
+
+  IndexData* data = createIndexData( maxFeaturesToIndex );
+  buildIndex( data, 0 );
+  bool ok = installIndex( data );
+  delete data;
+  return ok;
+}
+
 
 void QgsPointLocator::destroyIndex()
 {
@@ -719,6 +869,12 @@ void QgsPointLocator::destroyIndex()
 
 void QgsPointLocator::onFeatureAdded( QgsFeatureId fid )
 {
+  if ( mAsyncIndex )
+  {
+    mChangedDuringIndexing.insert( fid );
+    return;
+  }
+
   if ( !mRTree )
   {
     if ( mIsEmptyLayer )
@@ -761,6 +917,12 @@ void QgsPointLocator::onFeatureAdded( QgsFeatureId fid )
 
 void QgsPointLocator::onFeatureDeleted( QgsFeatureId fid )
 {
+  if ( mAsyncIndex )
+  {
+    mChangedDuringIndexing.insert( fid );
+    return;
+  }
+
   if ( !mRTree )
     return; // nothing to do if we are not initialized yet
 
@@ -783,6 +945,8 @@ QgsPointLocator::Match QgsPointLocator::nearestVertex( const QgsPoint& point, do
 {
   if ( !mRTree )
   {
+    if ( mAsyncIndex )
+      return Match(); // not ready yet
     init();
     if ( !mRTree ) // still invalid?
       return Match();
@@ -801,6 +965,8 @@ QgsPointLocator::Match QgsPointLocator::nearestEdge( const QgsPoint& point, doub
 {
   if ( !mRTree )
   {
+    if ( mAsyncIndex )
+      return Match(); // not ready yet
     init();
     if ( !mRTree ) // still invalid?
       return Match();
@@ -819,6 +985,8 @@ QgsPointLocator::MatchList QgsPointLocator::edgesInRect( const QgsRectangle& rec
 {
   if ( !mRTree )
   {
+    if ( mAsyncIndex )
+      return MatchList(); // not ready yet
     init();
     if ( !mRTree ) // still invalid?
       return MatchList();
@@ -842,6 +1010,8 @@ QgsPointLocator::MatchList QgsPointLocator::pointInPolygon( const QgsPoint& poin
 {
   if ( !mRTree )
   {
+    if ( mAsyncIndex )
+      return MatchList(); // not ready yet
     init();
     if ( !mRTree ) // still invalid?
       return MatchList();
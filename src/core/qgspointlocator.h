@@ -23,6 +23,9 @@ class QgsVectorLayer;
 #include "qgspoint.h"
 #include "qgsrectangle.h"
 
+#include <QAtomicInt>
+#include <QFutureWatcher>
+#include <QSet>
 
 #include <spatialindex/SpatialIndex.h>
 
@@ -77,6 +80,25 @@ class CORE_EXPORT QgsPointLocator : public QObject
     /** Indicate whether the data have been already indexed */
     bool hasIndex() const;
 
+    /** Start building the index in a background thread. Does nothing if the index already exists
+     * or is being built. Until the index is ready, queries return no matches - use a locator limited
+     * to an extent meanwhile. Changes of the layer's features are applied once the index is ready.
+     * initFinished() is emitted when the build is over, unless it is cancelled.
+     * @param maxFeaturesToIndex limit of features as in init()
+     * @note added in QGIS 2.14
+     */
+    void initAsync( int maxFeaturesToIndex = -1 );
+
+    /** Whether the index is being built in a background thread
+     * @note added in QGIS 2.14
+     */
+    bool isIndexing() const;
+
+    /** Stop building the index in the background thread (if running). Blocks until the thread is done.
+     * @note added in QGIS 2.14
+     */
+    void cancelIndexing();
+
     struct Match
     {
       //! consruct invalid match
@@ -164,6 +186,13 @@ class CORE_EXPORT QgsPointLocator : public QObject
     MatchList pointInPolygon( const QgsPoint& point );
 
 
+  signals:
+    /** Emitted when the index started with initAsync() is ready
+     * @param ok false if the creation of index has been stopped due to the limit of features
+     * @note added in QGIS 2.14
+     */
+    void initFinished( bool ok );
+
   protected:
     bool rebuildIndex( int maxFeaturesToIndex = -1 );
     void destroyIndex();
@@ -172,8 +201,19 @@ class CORE_EXPORT QgsPointLocator : public QObject
     void onFeatureAdded( QgsFeatureId fid );
     void onFeatureDeleted( QgsFeatureId fid );
     void onGeometryChanged( QgsFeatureId fid, QgsGeometry& geom );
+    void onAsyncIndexFinished();
 
   private:
+    //! Input and result of building the index, possibly in a background thread
+    struct IndexData;
+
+    IndexData* createIndexData( int maxFeaturesToIndex ) const;
+    static void buildIndex( IndexData* data, QAtomicInt* cancel );
+    //! Takes the index from the data, returns false if it was stopped by the limit of features
+    bool installIndex( IndexData* data );
+    //! Installs the index built in background
+    bool finishAsyncIndex();
+
     /** Storage manager */
     SpatialIndex::IStorageManager* mStorage;
 
@@ -188,6 +228,13 @@ class CORE_EXPORT QgsPointLocator : public QObject
     QgsVectorLayer* mLayer;
     QgsRectangle* mExtent;
 
+    //! index being built in background, null if not indexing
+    IndexData* mAsyncIndex;
+    QFutureWatcher<void> mAsyncIndexWatcher;
+    QAtomicInt mCancelAsyncIndex;
+    //! features changed while indexing in background, updated once the index is ready
+    QSet<QgsFeatureId> mChangedDuringIndexing;
+
     friend class QgsPointLocator_VisitorNearestVertex;
     friend class QgsPointLocator_VisitorNearestEdge;
     friend class QgsPointLocator_VisitorArea;
@@ -20,8 +20,10 @@
 #include <deque>
 #include <memory>
 
+#include "qgscrscache.h"
 #include "qgsdatasourceuri.h"
 #include "qgsexception.h"
+#include "qgsexpression.h"
 #include "qgslayertree.h"
 #include "qgslayertreeutils.h"
 #include "qgslayertreeregistrybridge.h"
@@ -29,13 +31,18 @@
 #include "qgsmaplayerregistry.h"
 #include "qgsmessagelog.h"
 #include "qgspluginlayer.h"
+#include "qgspainteffectregistry.h"
 #include "qgspluginlayerregistry.h"
 #include "qgsprojectfiletransform.h"
 #include "qgsprojectproperty.h"
 #include "qgsprojectversion.h"
+#include "qgsrasterdataprovider.h"
 #include "qgsrasterlayer.h"
 #include "qgsrectangle.h"
 #include "qgsrelationmanager.h"
+#include "qgsrendererv2registry.h"
+#include "qgssymbollayerv2registry.h"
+#include "qgsvectordataprovider.h"
 #include "qgsvectorlayer.h"
 #include "qgsvisibilitypresetcollection.h"
 
@@ -43,9 +50,13 @@
 #include <QFileInfo>
 #include <QDomNode>
 #include <QObject>
+#include <QSettings>
 #include <QTextStream>
+#include <QThread>
+#include <QTime>
 #include <QDir>
 #include <QUrl>
+#include <QtConcurrentRun>
 
 // canonical project instance
 QgsProject *QgsProject::theProject_ = 0;
@@ -318,6 +329,7 @@ struct QgsProject::Imp
   QgsPropertyKey properties_; // property hierarchy
   QString title;              // project title
   bool dirty;                 // project has been modified since it has been read or saved
+  QMap<QString, int> layerLoadTimes; // milliseconds spent loading each layer, by layer id
 
   Imp()
       : title()
@@ -338,6 +350,7 @@ struct QgsProject::Imp
     properties_.clearKeys();
     title.clear();
     dirty = false;
+    layerLoadTimes.clear();
   }
 
 };  // struct QgsProject::Imp
@@ -672,15 +685,60 @@ QPair< bool, QList<QDomNode> > QgsProject::_getMapLayers( QDomDocument const &do
   // They need to refresh join caches and symbology infos after all layers are loaded
   QList< QPair< QgsVectorLayer*, QDomElement > > vLayerList;
 
+  imp_->layerLoadTimes.clear();
+
+  // layers which can be loaded in parallel are read in worker threads first,
+  // all layers are then registered in their original order
+  QVector<LayerLoadJob> jobs( nl.count() );
+  QSettings settings;
+  bool parallel = settings.value( "/qgis/parallel_layer_loading", false ).toBool();
+  CUSTOM_CRS_VALIDATION savedValidation = QgsCoordinateReferenceSystem::customSrsValidation();
+  if ( parallel )
+  {
+    // layers read in worker threads must not ask for a CRS
+    QgsCoordinateReferenceSystem::setCustomSrsValidation( NULL );
+    startParallelLayerLoading( nl, jobs );
+  }
+
+  int loaded = 0;
+  for ( int i = 0; i < jobs.size(); i++ )
+  {
+    if ( !jobs[i].parallel )
+      continue;
+
+    QString name = nl.item( i ).namedItem( "layername" ).toElement().text();
+    if ( !name.isNull() )
+      emit loadingLayer( tr( "Loading layer %1" ).arg( name ) );
+
+    jobs[i].future.waitForFinished();
+    emit layerLoaded( ++loaded, nl.count() );
+  }
+
+  // workers are done, the remaining layers are loaded here as before
+  if ( parallel )
+    QgsCoordinateReferenceSystem::setCustomSrsValidation( savedValidation );
+
   for ( int i = 0; i < nl.count(); i++ )
   {
     QDomNode node = nl.item( i );
     QDomElement element = node.toElement();
+    LayerLoadJob& job = jobs[i];
+
+    if ( job.parallel )
+    {
+      if ( !registerLayer( job.layer, element, brokenNodes, vLayerList ) )
+        returnStatus = false;
+      imp_->layerLoadTimes.insert( job.layerId, job.elapsed );
+      continue;
+    }
 
     QString name = node.namedItem( "layername" ).toElement().text();
     if ( !name.isNull() )
       emit loadingLayer( tr( "Loading layer %1" ).arg( name ) );
 
+    QTime time;
+    time.start();
+
     if ( element.attribute( "embedded" ) == "1" )
     {
       createEmbeddedLayer( element.attribute( "id" ), readPath( element.attribute( "project" ) ), brokenNodes, vLayerList );
@@ -693,7 +751,8 @@ QPair< bool, QList<QDomNode> > QgsProject::_getMapLayers( QDomDocument const &do
         returnStatus = false;
       }
     }
-    emit layerLoaded( i + 1, nl.count() );
+    imp_->layerLoadTimes.insert( node.namedItem( "id" ).toElement().text(), time.elapsed() );
+    emit layerLoaded( ++loaded, nl.count() );
   }
 
   // Update field map of layers with joins and create join caches if necessary
@@ -720,6 +779,125 @@ QPair< bool, QList<QDomNode> > QgsProject::_getMapLayers( QDomDocument const &do
   return qMakePair( returnStatus, brokenNodes );
 } // _getMapLayers
 
+bool QgsProject::canLoadInParallel( const QDomElement &layerElem )
+{
+  if ( layerElem.attribute( "embedded" ) == "1" )
+    return false;
+
+  // plugin layers may be implemented in python
+  QString type = layerElem.attribute( "type" );
+  if ( type != "vector" && type != "raster" )
+    return false;
+
+  // only providers which can be created in any thread, e.g. postgres and spatialite
+  // share their connections between layers without locking. Network providers
+  // (wms, wcs, wfs) are excluded too: their requests go through the network access
+  // manager of the main thread, which is blocked while it waits for the workers
+  static QStringList providers = QStringList() << "ogr" << "gdal" << "gpx" << "memory";
+  if ( !providers.contains( layerElem.namedItem( "provider" ).toElement().text() ) )
+    return false;
+
+  // the master password may have to be asked for
+  if ( layerElem.namedItem( "datasource" ).toElement().text().contains( "authcfg=" ) )
+    return false;
+
+  // the user may have to be asked for a CRS
+  QgsCoordinateReferenceSystem crs;
+  crs.readXML( layerElem.namedItem( "srs" ) );
+  return crs.isValid();
+}
+
+void QgsProject::loadLayerInThread( LayerLoadJob *job )
+{
+  QTime time;
+  time.start();
+
+  // each thread reads its own copy of the layer element
+  QDomDocument doc;
+  doc.setContent( job->xml );
+  QDomElement layerElem = doc.documentElement();
+
+  QgsMapLayer *mapLayer;
+  if ( layerElem.attribute( "type" ) == "vector" )
+    mapLayer = new QgsVectorLayer;
+  else
+    mapLayer = new QgsRasterLayer;
+
+  if ( !mapLayer->readLayerXML( layerElem ) || !mapLayer->isValid() )
+  {
+    delete mapLayer;
+    mapLayer = 0;
+  }
+  else
+  {
+    // the layer and its provider are used from the main thread from now on
+    QgsVectorLayer *vLayer = qobject_cast<QgsVectorLayer*>( mapLayer );
+    QgsRasterLayer *rLayer = qobject_cast<QgsRasterLayer*>( mapLayer );
+    if ( vLayer && vLayer->dataProvider() )
+      vLayer->dataProvider()->moveToThread( job->thread );
+    else if ( rLayer && rLayer->dataProvider() )
+      rLayer->dataProvider()->moveToThread( job->thread );
+    mapLayer->moveToThread( job->thread );
+  }
+
+  job->layer = mapLayer;
+  job->elapsed = time.elapsed();
+}
+
+void QgsProject::startParallelLayerLoading( const QDomNodeList &nl, QVector<LayerLoadJob> &jobs )
+{
+  // make sure the registries are created before any worker needs them
+  QgsExpression::Functions();
+  QgsRendererV2Registry::instance();
+  QgsSymbolLayerV2Registry::instance();
+  QgsPaintEffectRegistry::instance();
+  QgsCRSCache::instance();
+
+  for ( int i = 0; i < nl.count(); i++ )
+  {
+    QDomElement element = nl.item( i ).toElement();
+    if ( !canLoadInParallel( element ) )
+      continue;
+
+    LayerLoadJob &job = jobs[i];
+    QTextStream stream( &job.xml );
+    element.save( stream, 0 );
+    stream.flush();
+    job.parallel = true;
+    job.layerId = element.namedItem( "id" ).toElement().text();
+    job.thread = thread();
+    job.future = QtConcurrent::run( loadLayerInThread, &job );
+  }
+}
+
+bool QgsProject::registerLayer( QgsMapLayer *mapLayer, const QDomElement &layerElem, QList<QDomNode> &brokenNodes, QList< QPair< QgsVectorLayer*, QDomElement > > &vectorLayerList )
+{
+  if ( !mapLayer )
+  {
+    QgsDebugMsg( "Unable to load " + layerElem.attribute( "type" ) + " layer" );
+    brokenNodes.push_back( layerElem );
+    return false;
+  }
+
+  // postpone readMapLayer signal for vector layers with joins
+  QgsVectorLayer *vLayer = qobject_cast<QgsVectorLayer*>( mapLayer );
+  if ( !vLayer || vLayer->vectorJoins().isEmpty() )
+    emit readMapLayer( mapLayer, layerElem );
+  else
+    vectorLayerList.push_back( qMakePair( vLayer, layerElem ) );
+
+  QList<QgsMapLayer *> myLayers;
+  myLayers << mapLayer;
+  QgsMapLayerRegistry::instance()->addMapLayers( myLayers );
+
+  return true;
+}
+
+QMap<QString, int> QgsProject::layerLoadTimes() const
+{
+  return imp_->layerLoadTimes;
+}
+
 bool QgsProject::addLayer( const QDomElement &layerElem, QList<QDomNode> &brokenNodes, QList< QPair< QgsVectorLayer*, QDomElement > > &vectorLayerList )
 {
   QString type = layerElem.attribute( "type" );
@@ -750,29 +928,13 @@ bool QgsProject::addLayer( const QDomElement &layerElem, QList<QDomNode> &broken
   Q_CHECK_PTR( mapLayer );
 
   // have the layer restore state that is stored in Dom node
-  if ( mapLayer->readLayerXML( layerElem ) && mapLayer->isValid() )
-  {
-    // postpone readMapLayer signal for vector layers with joins
-    QgsVectorLayer *vLayer = qobject_cast<QgsVectorLayer*>( mapLayer );
-    if ( !vLayer || vLayer->vectorJoins().isEmpty() )
-      emit readMapLayer( mapLayer, layerElem );
-    else
-      vectorLayerList.push_back( qMakePair( vLayer, layerElem ) );
-
-    QList<QgsMapLayer *> myLayers;
-    myLayers << mapLayer;
-    QgsMapLayerRegistry::instance()->addMapLayers( myLayers );
-
-    return true;
-  }
-  else
+  if ( !mapLayer->readLayerXML( layerElem ) || !mapLayer->isValid() )
   {
     delete mapLayer;
-
-    QgsDebugMsg( "Unable to load " + type + " layer" );
-    brokenNodes.push_back( layerElem );
-    return false;
+    mapLayer = 0;
   }
+
+  return registerLayer( mapLayer, layerElem, brokenNodes, vectorLayerList );
 }
 
 
@@ -23,11 +23,14 @@
 
 #include <memory>
 #include "qgsprojectversion.h"
+#include <QFuture>
 #include <QHash>
 #include <QList>
+#include <QMap>
 #include <QObject>
 #include <QPair>
 #include <QFileInfo>
+#include <QVector>
 
 //for the snap settings
 #include "qgssnapper.h"
@@ -39,6 +42,8 @@ class QFileInfo;
 class QDomDocument;
 class QDomElement;
 class QDomNode;
+class QDomNodeList;
+class QThread;
 
 class QgsLayerTreeGroup;
 class QgsLayerTreeRegistryBridge;
@@ -311,6 +316,13 @@ class CORE_EXPORT QgsProject : public QObject
      */
     QgsVisibilityPresetCollection* visibilityPresetCollection();
 
+    /** Returns the time in milliseconds spent loading each map layer when the project
+     * was read, by layer id. Layers loaded in parallel (setting "/qgis/parallel_layer_loading")
+     * are timed in their worker thread.
+     * @note added in QGIS 2.14
+     */
+    QMap<QString, int> layerLoadTimes() const;
+
   protected:
 
     /** Set error message from read/write operation */
@@ -386,6 +398,28 @@ class CORE_EXPORT QgsProject : public QObject
 
     QPair< bool, QList<QDomNode> > _getMapLayers( QDomDocument const &doc );
 
+    //! Layer read in a worker thread while the project is loaded
+    struct LayerLoadJob
+    {
+      LayerLoadJob() : parallel( false ), layer( 0 ), thread( 0 ), elapsed( 0 ) {}
+
+      bool parallel;
+      QString xml;          // maplayer element, every worker parses its own copy
+      QString layerId;
+      QgsMapLayer* layer;   // null if the layer could not be loaded
+      QThread* thread;      // thread the layer is moved to once loaded
+      int elapsed;
+      QFuture<void> future;
+    };
+
+    //! Whether the layer can be read in a worker thread (local files and memory layers only)
+    static bool canLoadInParallel( const QDomElement& layerElem );
+    static void loadLayerInThread( LayerLoadJob* job );
+    //! Starts reading of the layers which can be loaded in parallel
+    void startParallelLayerLoading( const QDomNodeList& nl, QVector<LayerLoadJob>& jobs );
+    //! Adds a layer read from the project to the registry (or to broken nodes if it is null)
+    bool registerLayer( QgsMapLayer* mapLayer, const QDomElement& layerElem, QList<QDomNode>& brokenNodes, QList< QPair< QgsVectorLayer*, QDomElement > >& vectorLayerList );
+
     QString mErrorMessage;
 
     QgsProjectBadLayerHandler* mBadLayerHandler;
@@ -30,6 +30,7 @@ QgsSnappingUtils::QgsSnappingUtils( QObject* parent )
     , mDefaultTolerance( 10 )
     , mDefaultUnit( QgsTolerance::Pixels )
     , mSnapOnIntersection( false )
+    , mBackgroundIndexing( false )
     , mIsIndexing( false )
 {
   connect( QgsMapLayerRegistry::instance(), SIGNAL( layersWillBeRemoved( QStringList ) ), this, SLOT( onLayersWillBeRemoved( QStringList ) ) );
@@ -50,6 +51,7 @@ QgsPointLocator* QgsSnappingUtils::locatorForLayer( QgsVectorLayer* vl )
   {
     QgsPointLocator* vlpl = new QgsPointLocator( vl, destCRS() );
     mLocators.insert( vl, vlpl );
+    connect( vlpl, SIGNAL( initFinished( bool ) ), this, SLOT( onInitFinished( bool ) ) );
   }
   return mLocators.value( vl );
 }
@@ -68,7 +70,8 @@ void QgsSnappingUtils::clearAllLocators()
 
 QgsPointLocator* QgsSnappingUtils::locatorForLayerUsingStrategy( QgsVectorLayer* vl, const QgsPoint& pointMap, double tolerance )
 {
-  if ( willUseIndex( vl ) )
+  // the index is not ready yet, do not wait for it
+  if ( willUseIndex( vl ) && !locatorForLayer( vl )->isIndexing() )
     return locatorForLayer( vl );
   else
     return temporaryLocatorForLayer( vl, pointMap, tolerance );
@@ -320,7 +323,13 @@ void QgsSnappingUtils::prepareIndex( const QList<QgsVectorLayer*>& layers )
     if ( willUseIndex( vl ) && !locatorForLayer( vl )->hasIndex() )
       layersToIndex << vl;
   }
-  if ( !layersToIndex.isEmpty() )
+  if ( !layersToIndex.isEmpty() && mBackgroundIndexing )
+  {
+    // queries use temporary locators until the indexes are ready
+    Q_FOREACH ( QgsVectorLayer* vl, layersToIndex )
+      locatorForLayer( vl )->initAsync( mStrategy == IndexHybrid ? 1000000 : -1 );
+  }
+  else if ( !layersToIndex.isEmpty() )
   {
     // build indexes
     QTime t; t.start();
@@ -467,6 +476,14 @@ void QgsSnappingUtils::readConfigFromProject()
 
 }
 
+void QgsSnappingUtils::onInitFinished( bool ok )
+{
+  QgsPointLocator* loc = qobject_cast<QgsPointLocator*>( sender() );
+  QgsVectorLayer* vl = mLocators.key( loc );
+  if ( !ok && vl )
+    mHybridNonindexableLayers.insert( vl->id() );
+}
+
 void QgsSnappingUtils::onLayersWillBeRemoved( const QStringList& layerIds )
 {
   // remove locators for layers that are going to be deleted
@@ -127,6 +127,17 @@ class CORE_EXPORT QgsSnappingUtils : public QObject
     /** Query whether to consider intersections of nearby segments for snapping */
     bool snapOnIntersections() const { return mSnapOnIntersection; }
 
+    /** Set whether the indexes of layers are built in a background thread instead of blocking
+     * the snapping queries. Until the index of a layer is ready, the layer is snapped to with
+     * a temporary locator of a small area (as with IndexNeverFull strategy).
+     * @note added in QGIS 2.14
+     */
+    void setBackgroundIndexing( bool enabled ) { mBackgroundIndexing = enabled; }
+    /** Query whether the indexes of layers are built in a background thread
+     * @note added in QGIS 2.14
+     */
+    bool backgroundIndexing() const { return mBackgroundIndexing; }
+
   public slots:
     /** Read snapping configuration from the project */
     void readConfigFromProject();
@@ -139,6 +150,7 @@ class CORE_EXPORT QgsSnappingUtils : public QObject
 
   private slots:
     void onLayersWillBeRemoved( const QStringList& layerIds );
+    void onInitFinished( bool ok );
 
   private:
     //! get from map settings pointer to destination CRS - or 0 if projections are disabled
@@ -170,6 +182,7 @@ class CORE_EXPORT QgsSnappingUtils : public QObject
     QgsTolerance::UnitType mDefaultUnit;
     QList<LayerConfig> mLayers;
     bool mSnapOnIntersection;
+    bool mBackgroundIndexing;
 
     // internal data
     typedef QMap<QgsVectorLayer*, QgsPointLocator*> LocatorsMap;
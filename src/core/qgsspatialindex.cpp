@@ -254,6 +254,16 @@ bool QgsSpatialIndex::insertFeature( const QgsFeature& f )
   if ( !featureInfo( f, r, id ) )
     return false;
 
+  return insertFeature( id, r );
+}
+
+bool QgsSpatialIndex::insertFeature( QgsFeatureId id, const QgsRectangle& rect )
+{
+  return insertFeature( id, rectToRegion( rect ) );
+}
+
+bool QgsSpatialIndex::insertFeature( QgsFeatureId id, const SpatialIndex::Region& r )
+{
   // TODO: handle possible exceptions correctly
   try
   {
@@ -73,6 +73,12 @@ class CORE_EXPORT QgsSpatialIndex
     /** Add feature to index */
     bool insertFeature( const QgsFeature& f );
 
+    /** Add an item with given id and bounding box to the index. This avoids creation
+     * of a feature with geometry for items that are not features (e.g. line segments).
+     * @note added in QGIS 2.14
+     */
+    bool insertFeature( QgsFeatureId id, const QgsRectangle& rect );
+
     /** Remove feature from index */
     bool deleteFeature( const QgsFeature& f );
 
@@ -96,6 +102,9 @@ class CORE_EXPORT QgsSpatialIndex
     // @note not available in python bindings
     static bool featureInfo( const QgsFeature& f, SpatialIndex::Region& r, QgsFeatureId &id );
 
+    // @note not available in python bindings
+    bool insertFeature( QgsFeatureId id, const SpatialIndex::Region& r );
+
     friend class QgsFeatureIteratorDataStream; // for access to featureInfo()
 
   private:
@@ -47,6 +47,7 @@
 #include "qgsfeature.h"
 #include "qgsfeaturerequest.h"
 #include "qgsfield.h"
+#include "qgsgeneralizedgeometrycache.h"
 #include "qgsgeometrycache.h"
 #include "qgsgeometry.h"
 #include "qgslabel.h"
@@ -139,6 +140,7 @@ QgsVectorLayer::QgsVectorLayer( const QString& vectorLayerPath,
     , mLayerTransparency( 0 )
     , mVertexMarkerOnlyForSelection( false )
     , mCache( new QgsGeometryCache() )
+    , mGeneralizedCache( 0 )
     , mEditBuffer( 0 )
     , mJoinBuffer( 0 )
     , mExpressionFieldBuffer( 0 )
@@ -168,6 +170,7 @@ QgsVectorLayer::QgsVectorLayer( const QString& vectorLayerPath,
   mSimplifyMethod.setThreshold( settings.value( "/qgis/simplifyDrawingTol", mSimplifyMethod.threshold() ).toFloat() );
   mSimplifyMethod.setForceLocalOptimization( settings.value( "/qgis/simplifyLocal", mSimplifyMethod.forceLocalOptimization() ).toBool() );
   mSimplifyMethod.setMaximumScale( settings.value( "/qgis/simplifyMaxScale", mSimplifyMethod.maximumScale() ).toFloat() );
+  mSimplifyMethod.setCacheGeneralizedGeometries( settings.value( "/qgis/simplifyCache", mSimplifyMethod.cacheGeneralizedGeometries() ).toBool() );
 } // QgsVectorLayer ctor
 
 
@@ -180,6 +183,7 @@ QgsVectorLayer::~QgsVectorLayer()
 
   mValid = false;
 
+  delete mGeneralizedCache;
   delete mDataProvider;
   delete mEditBuffer;
   delete mJoinBuffer;
@@ -380,6 +384,7 @@ void QgsVectorLayer::reload()
   {
     mDataProvider->reloadData();
   }
+  invalidateGeneralizedGeometryCache();
 }
 
 QgsMapLayerRenderer* QgsVectorLayer::createMapRenderer( QgsRenderContext& rendererContext )
@@ -902,6 +907,7 @@ bool QgsVectorLayer::setSubsetString( const QString& subset )
   // get the updated data source string from the provider
   mDataSource = mDataProvider->dataSourceUri();
   updateExtents();
+  invalidateGeneralizedGeometryCache();
 
   if ( res )
     emit repaintRequested();
@@ -1576,6 +1582,7 @@ bool QgsVectorLayer::setDataProvider( QString const & provider )
 
   connect( mDataProvider, SIGNAL( dataChanged() ), this, SIGNAL( dataChanged() ) );
   connect( mDataProvider, SIGNAL( dataChanged() ), this, SLOT( removeSelection() ) );
+  connect( mDataProvider, SIGNAL( dataChanged() ), this, SLOT( invalidateGeneralizedGeometryCache() ) );
 
   return true;
 } // QgsVectorLayer:: setDataProvider
@@ -1710,6 +1717,7 @@ bool QgsVectorLayer::readSymbology( const QDomNode& node, QString& errorMessage
     mSimplifyMethod.setThreshold( e.attribute( "simplifyDrawingTol", "1" ).toFloat() );
     mSimplifyMethod.setForceLocalOptimization( e.attribute( "simplifyLocal", "1" ).toInt() );
     mSimplifyMethod.setMaximumScale( e.attribute( "simplifyMaxScale", "1" ).toFloat() );
+    mSimplifyMethod.setCacheGeneralizedGeometries( e.attribute( "simplifyCache", "0" ).toInt() );
 
     //also restore custom properties (for labeling-ng)
     readCustomProperties( node, "labeling" );
@@ -1864,6 +1872,7 @@ bool QgsVectorLayer::writeSymbology( QDomNode& node, QDomDocument& doc, QString&
     mapLayerNode.setAttribute( "simplifyDrawingTol", QString::number( mSimplifyMethod.threshold() ) );
     mapLayerNode.setAttribute( "simplifyLocal", mSimplifyMethod.forceLocalOptimization() ? 1 : 0 );
     mapLayerNode.setAttribute( "simplifyMaxScale", QString::number( mSimplifyMethod.maximumScale() ) );
+    mapLayerNode.setAttribute( "simplifyCache", mSimplifyMethod.cacheGeneralizedGeometries() ? 1 : 0 );
 
     //save customproperties (for labeling ng)
     writeCustomProperties( node, doc );
@@ -2246,6 +2255,7 @@ bool QgsVectorLayer::commitChanges()
   {
     mCache->deleteCachedGeometries();
   }
+  invalidateGeneralizedGeometryCache();
 
   updateFields();
   mDataProvider->updateExtents();
@@ -3683,6 +3693,23 @@ void QgsVectorLayer::onJoinedFieldsChanged()
   updateFields();
 }
 
+void QgsVectorLayer::invalidateGeneralizedGeometryCache()
+{
+  if ( mGeneralizedCache )
+    mGeneralizedCache->invalidate();
+}
+
+QgsGeneralizedGeometryCache* QgsVectorLayer::generalizedGeometryCache()
+{
+  if ( !mGeneralizedCache )
+    mGeneralizedCache = new QgsGeneralizedGeometryCache();
+
+  if ( mValid && mDataProvider && !mEditBuffer && mGeneralizedCache->needsBuild() )
+    mGeneralizedCache->build( new QgsVectorLayerFeatureSource( this ), extent() );
+
+  return mGeneralizedCache;
+}
+
 void QgsVectorLayer::onFeatureDeleted( const QgsFeatureId& fid )
 {
   if ( mEditCommandActive )
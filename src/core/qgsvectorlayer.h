@@ -51,6 +51,7 @@ class QgsFeatureRendererV2;
 class QgsFeatureRequest;
 class QgsGeometry;
 class QgsGeometryCache;
+class QgsGeneralizedGeometryCache;
 class QgsGeometryVertexIndex;
 class QgsLabel;
 class QgsMapToPixel;
@@ -1586,6 +1587,14 @@ class CORE_EXPORT QgsVectorLayer : public QgsMapLayer
     /** @note not available in python bindings */
     inline QgsGeometryCache* cache() { return mCache; }
 
+    /** Returns the cache of geometries simplified for a ladder of scales. The cache
+     * is created and its build in a background thread started on first call.
+     * Used by the renderer when enabled in the simplify method.
+     * @note added in QGIS 2.14
+     * @note not available in python bindings
+     */
+    QgsGeneralizedGeometryCache* generalizedGeometryCache();
+
     /** Set the simplification settings for fast rendering of features
      *  @note added in 2.2
      */
@@ -1836,6 +1845,7 @@ class CORE_EXPORT QgsVectorLayer : public QgsMapLayer
   private slots:
     void onJoinedFieldsChanged();
     void onFeatureDeleted( const QgsFeatureId& fid );
+    void invalidateGeneralizedGeometryCache();
 
   protected:
     /** Set the extent */
@@ -1961,6 +1971,9 @@ class CORE_EXPORT QgsVectorLayer : public QgsMapLayer
     //! cache for some vector layer data - currently only geometries for faster editing
     QgsGeometryCache* mCache;
 
+    //! geometries simplified in advance for rendering, created on demand
+    QgsGeneralizedGeometryCache* mGeneralizedCache;
+
     //! stores information about uncommitted changes to layer
     QgsVectorLayerEditBuffer* mEditBuffer;
     friend class QgsVectorLayerEditBuffer;
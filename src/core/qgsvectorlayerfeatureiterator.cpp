@@ -89,8 +89,31 @@ QgsFeatureIterator QgsVectorLayerFeatureSource::getFeatures( const QgsFeatureReq
 QgsVectorLayerFeatureIterator::QgsVectorLayerFeatureIterator( QgsVectorLayerFeatureSource* source, bool ownSource, const QgsFeatureRequest& request )
     : QgsAbstractFeatureIteratorFromSource<QgsVectorLayerFeatureSource>( source, ownSource, request )
     , mFetchedFid( false )
+    , mDelegatedOrderByToProvider( false )
     , mEditGeometrySimplifier( 0 )
 {
+  if ( !mRequest.orderBy().isEmpty() )
+  {
+    // the attributes and geometry to order by must be fetched
+    Q_FOREACH ( const QgsFeatureRequest::OrderByClause& orderBy, mRequest.orderBy() )
+    {
+      QgsExpression expression( orderBy.expression() );
+      if ( expression.needsGeometry() )
+        mRequest.setFlags( mRequest.flags() & ~QgsFeatureRequest::NoGeometry );
+    }
+    if ( mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes )
+    {
+      QgsAttributeList attrs = mRequest.subsetOfAttributes();
+      Q_FOREACH ( const QString& attr, mRequest.orderBy().usedAttributes() )
+      {
+        int idx = mSource->mFields.fieldNameIndex( attr );
+        if ( idx != -1 && !attrs.contains( idx ) )
+          attrs << idx;
+      }
+      mRequest.setSubsetOfAttributes( attrs );
+    }
+  }
+
   prepareExpressions();
 
   // prepare joins: may add more attributes to fetch (in order to allow join)
@@ -133,6 +156,25 @@ QgsVectorLayerFeatureIterator::QgsVectorLayerFeatureIterator( QgsVectorLayerFeat
     }
   }
 
+  if ( !mProviderRequest.orderBy().isEmpty() )
+  {
+    // features from the edit buffer and fields added by QGIS are not known to the provider
+    mDelegatedOrderByToProvider = !mSource->mHasEditBuffer;
+    Q_FOREACH ( const QString& attr, mProviderRequest.orderBy().usedAttributes() )
+    {
+      int idx = mSource->mFields.fieldNameIndex( attr );
+      if ( idx == -1 || mSource->mFields.fieldOrigin( idx ) != QgsFields::OriginProvider )
+        mDelegatedOrderByToProvider = false;
+    }
+
+    if ( !mDelegatedOrderByToProvider )
+    {
+      // ordered locally, the provider must return all features
+      mProviderRequest.setOrderBy( QgsFeatureRequest::OrderBy() );
+      mProviderRequest.setLimit( -1 );
+    }
+  }
+
   if ( mSource->mHasEditBuffer )
   {
     mChangedFeaturesRequest = mProviderRequest;
@@ -162,6 +204,10 @@ QgsVectorLayerFeatureIterator::QgsVectorLayerFeatureIterator( QgsVectorLayerFeat
     mRequest.expressionContext()->setFields( mSource->mFields );
     mRequest.filterExpression()->prepare( mRequest.expressionContext() );
   }
+  else if ( !mRequest.orderBy().isEmpty() )
+  {
+    mRequest.expressionContext()->setFields( mSource->mFields );
+  }
 }
 
 
@@ -613,6 +659,12 @@ bool QgsVectorLayerFeatureIterator::prepareSimplification( const QgsSimplifyMeth
   return false;
 }
 
+bool QgsVectorLayerFeatureIterator::prepareOrderBy( const QList<QgsFeatureRequest::OrderByClause>& orderBys )
+{
+  Q_UNUSED( orderBys );
+  return mDelegatedOrderByToProvider;
+}
+
 bool QgsVectorLayerFeatureIterator::providerCanSimplify( QgsSimplifyMethod::MethodType methodType ) const
 {
   Q_UNUSED( methodType );
@@ -91,6 +91,9 @@ class CORE_EXPORT QgsVectorLayerFeatureIterator : public QgsAbstractFeatureItera
     //! Setup the simplification of geometries to fetch using the specified simplify method
     virtual bool prepareSimplification( const QgsSimplifyMethod& simplifyMethod ) override;
 
+    //! The provider orders the features unless the order depends on edits or on fields added by QGIS
+    virtual bool prepareOrderBy( const QList<QgsFeatureRequest::OrderByClause>& orderBys ) override;
+
 
     QgsFeatureRequest mProviderRequest;
     QgsFeatureIterator mProviderIterator;
@@ -155,6 +158,9 @@ class CORE_EXPORT QgsVectorLayerFeatureIterator : public QgsAbstractFeatureItera
 
     bool mHasVirtualAttributes;
 
+    //! whether the features fetched from the provider are already ordered
+    bool mDelegatedOrderByToProvider;
+
   private:
     //! optional object to locally simplify edited (changed or added) geometries fetched by this feature iterator
     QgsAbstractGeometrySimplifier* mEditGeometrySimplifier;
@@ -19,6 +19,7 @@
 #include "diagram/qgsdiagram.h"
 #include "qgsdiagramrendererv2.h"
 #include "qgsgeometrycache.h"
+#include "qgsmaptopixelgeometrysimplifier.h"
 #include "qgsmessagelog.h"
 #include "qgspallabeling.h"
 #include "qgsrendererv2.h"
@@ -53,6 +54,7 @@ QgsVectorLayerRenderer::QgsVectorLayerRenderer( QgsVectorLayer* layer, QgsRender
     , mLabelProvider( 0 )
     , mDiagramProvider( 0 )
     , mLayerTransparency( 0 )
+    , mGeneralizedCache( 0 )
 {
   mSource = new QgsVectorLayerFeatureSource( layer );
 
@@ -68,6 +70,8 @@ QgsVectorLayerRenderer::QgsVectorLayerRenderer( QgsVectorLayer* layer, QgsRender
 
   mSimplifyMethod = layer->simplifyMethod();
   mSimplifyGeometry = layer->simplifyDrawingCanbeApplied( mContext, QgsVectorSimplifyMethod::GeometrySimplification );
+  if ( mSimplifyGeometry && mSimplifyMethod.cacheGeneralizedGeometries() && !layer->editBuffer() )
+    mGeneralizedCache = layer->generalizedGeometryCache();
 
   QSettings settings;
   mVertexMarkerOnlyForSelection = settings.value( "/qgis/digitizing/marker_only_for_selected", false ).toBool();
@@ -213,7 +217,21 @@ bool QgsVectorLayerRenderer::render()
       }
     }
 
-    if ( validTransform )
+    if ( validTransform && mGeneralizedCache )
+    {
+      // take the geometries simplified in advance unless the filter needs the real ones
+      if ( !featureRequest.filterExpression() || !featureRequest.filterExpression()->needsGeometry() )
+        mGeneralizedLevel = mGeneralizedCache->level( map2pixelTol );
+    }
+
+    if ( validTransform && mGeneralizedLevel )
+    {
+      featureRequest.setFlags( featureRequest.flags() | QgsFeatureRequest::NoGeometry );
+
+      QgsVectorSimplifyMethod vectorMethod = mSimplifyMethod;
+      mContext.setVectorSimplifyMethod( vectorMethod );
+    }
+    else if ( validTransform )
     {
       QgsSimplifyMethod simplifyMethod;
       simplifyMethod.setMethodType( QgsSimplifyMethod::OptimizeForRendering );
@@ -281,6 +299,31 @@ void QgsVectorLayerRenderer::setGeometryCachePointer( QgsGeometryCache* cache )
 
 
 
+bool QgsVectorLayerRenderer::setGeneralizedGeometry( QgsFeature& feature )
+{
+  // other render threads use the same level, each takes its own copy of the geometry
+  QHash<QgsFeatureId, const QgsAbstractGeometryV2*>::const_iterator it = mGeneralizedLevel->geometries.constFind( feature.id() );
+  if ( it != mGeneralizedLevel->geometries.constEnd() )
+  {
+    feature.setGeometry( new QgsGeometry( it.value()->clone() ) );
+    return true;
+  }
+
+  if ( mGeneralizedLevel->nullGeometries->contains( feature.id() ) )
+    return false;
+
+  // the cache is invalidated by the layer when its data change, until then
+  // features unknown to the level are simplified on the fly
+  QgsFeature f;
+  if ( !mSource->getFeatures( QgsFeatureRequest( feature.id() ).setSubsetOfAttributes( QgsAttributeList() ) ).nextFeature( f ) || !f.constGeometry() )
+    return false;
+
+  QgsGeometry geom( *f.constGeometry() );
+  QgsMapToPixelSimplifier::simplifyGeometry( &geom, QgsMapToPixelSimplifier::SimplifyGeometry | QgsMapToPixelSimplifier::SimplifyEnvelope, mGeneralizedLevel->tolerance );
+  feature.setGeometry( geom );
+  return true;
+}
+
 void QgsVectorLayerRenderer::drawRendererV2( QgsFeatureIterator& fit )
 {
   QgsFeature fet;
@@ -288,6 +331,9 @@ void QgsVectorLayerRenderer::drawRendererV2( QgsFeatureIterator& fit )
   {
     try
     {
+      if ( mGeneralizedLevel && !setGeneralizedGeometry( fet ) )
+        continue;
+
       if ( !fet.constGeometry() )
         continue; // skip features without geometry
 
@@ -372,6 +418,9 @@ void QgsVectorLayerRenderer::drawRendererV2Levels( QgsFeatureIterator& fit )
   QgsFeature fet;
   while ( fit.nextFeature( fet ) )
   {
+    if ( mGeneralizedLevel && !setGeneralizedGeometry( fet ) )
+      continue;
+
     if ( !fet.constGeometry() )
       continue; // skip features without geometry
 
@@ -37,6 +37,7 @@ typedef QList<int> QgsAttributeList;
 #include "qgsfield.h"  // QgsFields
 #include "qgsfeature.h"  // QgsFeatureIds
 #include "qgsfeatureiterator.h"
+#include "qgsgeneralizedgeometrycache.h"
 #include "qgsvectorsimplifymethod.h"
 
 #include "qgsmaplayerrenderer.h"
@@ -81,6 +82,13 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
     /** Stop version 2 renderer and selected renderer (if required) */
     void stopRendererV2( QgsSingleSymbolRendererV2* selRenderer );
 
+    /** Sets the geometry of a feature fetched without geometry from the generalized
+     * geometry cache level. Features missing in the level are fetched and simplified,
+     * the cache is not invalidated (the layer does that when its data change).
+     * @returns false if the feature has no geometry
+     */
+    bool setGeneralizedGeometry( QgsFeature& feature );
+
 
   protected:
 
@@ -124,6 +132,11 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
 
     QgsVectorSimplifyMethod mSimplifyMethod;
     bool mSimplifyGeometry;
+
+    //! layer's cache of simplified geometries, null if not used
+    QgsGeneralizedGeometryCache* mGeneralizedCache;
+    //! level of the cache used for the current scale, null if geometries are fetched
+    QSharedPointer<const QgsGeneralizedGeometryCache::Level> mGeneralizedLevel;
 };
 
 
@@ -22,6 +22,7 @@ QgsVectorSimplifyMethod::QgsVectorSimplifyMethod()
     , mThreshold( QGis::DEFAULT_MAPTOPIXEL_THRESHOLD )
     , mLocalOptimization( true )
     , mMaximumScale( 1 )
+    , mCacheGeneralizedGeometries( false )
 {
 }
 
@@ -36,5 +37,6 @@ QgsVectorSimplifyMethod& QgsVectorSimplifyMethod::operator=( const QgsVectorSimp
   mThreshold = rh.mThreshold;
   mLocalOptimization = rh.mLocalOptimization;
   mMaximumScale = rh.mMaximumScale;
+  mCacheGeneralizedGeometries = rh.mCacheGeneralizedGeometries;
   return *this;
 }
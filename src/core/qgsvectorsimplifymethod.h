@@ -61,6 +61,16 @@ class CORE_EXPORT QgsVectorSimplifyMethod
     /** Gets the maximum scale at which the layer should be simplified */
     inline float maximumScale() const { return mMaximumScale; }
 
+    /** Sets whether the geometries simplified for a ladder of scales are cached in memory,
+     * so they do not need to be simplified again on every redraw
+     * @note added in QGIS 2.14
+     */
+    void setCacheGeneralizedGeometries( bool cache ) { mCacheGeneralizedGeometries = cache; }
+    /** Gets whether the geometries simplified for a ladder of scales are cached in memory
+     * @note added in QGIS 2.14
+     */
+    inline bool cacheGeneralizedGeometries() const { return mCacheGeneralizedGeometries; }
+
   private:
     /** Simplification hints for fast rendering of features of the vector layer managed */
     SimplifyHints mSimplifyHints;
@@ -70,6 +80,8 @@ class CORE_EXPORT QgsVectorSimplifyMethod
     bool mLocalOptimization;
     /** Maximum scale at which the layer should be simplified (Maximum scale at which generalisation should be carried out) */
     float mMaximumScale;
+    /** Simplified geometries are cached */
+    bool mCacheGeneralizedGeometries;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS( QgsVectorSimplifyMethod::SimplifyHints )
@@ -30,9 +30,74 @@
 
 #include <QDomDocument>
 #include <QDomElement>
+#include <QThread>
+#include <QtConcurrentMap>
+
+// number of colors precomputed from the color ramp
+#define RAMP_LUT_SIZE 1024
+// below this number of points the accumulation is not split between threads
+#define MIN_POINTS_PER_THREAD 10000
+
+struct QgsHeatmapRenderer::AccumulationBand
+{
+  int yBegin;
+  int yEnd;
+  //! points within the radius of the band rows
+  QVector<const HeatmapPoint*> points;
+  double maxValue;
+};
+
+class QgsHeatmapRenderer::AccumulateOperation
+{
+  public:
+    explicit AccumulateOperation( QgsHeatmapRenderer* renderer )
+        : mValues( renderer->mValues.data() )
+        , mStamp( renderer->mKernelStamp.constData() )
+        , mRadius( renderer->mRadiusPixels )
+        , mWidth( renderer->mWidth )
+    {}
+
+    void operator()( AccumulationBand& band )
+    {
+      int stampSize = 2 * mRadius;
+      Q_FOREACH ( const HeatmapPoint* pt, band.points )
+      {
+        int xMin = qMax( pt->x - mRadius, 0 );
+        int xMax = qMin( pt->x + mRadius, mWidth );
+        int yMin = qMax( pt->y - mRadius, band.yBegin );
+        int yMax = qMin( pt->y + mRadius, band.yEnd );
+        for ( int y = yMin; y < yMax; ++y )
+        {
+          double* row = mValues + y * mWidth + xMin;
+          const double* stampRow = mStamp + ( y - pt->y + mRadius ) * stampSize + xMin - pt->x + mRadius;
+          for ( int i = 0; i < xMax - xMin; ++i )
+          {
+            row[i] += pt->weight * stampRow[i];
+          }
+        }
+      }
+
+      band.maxValue = 0;
+      const double* values = mValues + band.yBegin * mWidth;
+      for ( int i = 0, n = ( band.yEnd - band.yBegin ) * mWidth; i < n; ++i )
+      {
+        if ( values[i] > band.maxValue )
+          band.maxValue = values[i];
+      }
+    }
+
+  private:
+    //! shared by all bands, each writes its own rows only
+    double* mValues;
+    const double* mStamp;
+    int mRadius;
+    int mWidth;
+};
 
 QgsHeatmapRenderer::QgsHeatmapRenderer( )
     : QgsFeatureRendererV2( "heatmapRenderer" )
+    , mWidth( 0 )
+    , mHeight( 0 )
     , mCalculatedMaxValue( 0 )
     , mRadius( 10 )
     , mRadiusPixels( 0 )
@@ -56,12 +121,31 @@ QgsHeatmapRenderer::~QgsHeatmapRenderer()
 
 void QgsHeatmapRenderer::initializeValues( QgsRenderContext& context )
 {
-  mValues.resize( context.painter()->device()->width() * context.painter()->device()->height() / ( mRenderQuality * mRenderQuality ) );
-  mValues.fill( 0 );
+  mWidth = context.painter()->device()->width() / mRenderQuality;
+  mHeight = context.painter()->device()->height() / mRenderQuality;
+  mValues.clear();
+  mPoints.clear();
   mCalculatedMaxValue = 0;
   mFeaturesRendered = 0;
   mRadiusPixels = qRound( mRadius * QgsSymbolLayerV2Utils::pixelSizeScaleFactor( context, mRadiusUnit, mRadiusMapUnitScale ) / mRenderQuality );
   mRadiusSquared = mRadiusPixels * mRadiusPixels;
+
+  // kernel values for offsets -radius .. radius - 1 in both directions, so the kernel
+  // does not need to be evaluated for every pixel of every point
+  int stampSize = 2 * mRadiusPixels;
+  mKernelStamp.fill( 0, stampSize * stampSize );
+  for ( int dy = -mRadiusPixels; dy < mRadiusPixels; ++dy )
+  {
+    for ( int dx = -mRadiusPixels; dx < mRadiusPixels; ++dx )
+    {
+      double distanceSquared = dx * dx + dy * dy;
+      if ( distanceSquared > mRadiusSquared )
+      {
+        continue;
+      }
+      mKernelStamp[( dy + mRadiusPixels ) * stampSize + dx + mRadiusPixels] = quarticKernel( sqrt( distanceSquared ), mRadiusPixels );
+    }
+  }
 }
 
 void QgsHeatmapRenderer::startRender( QgsRenderContext& context, const QgsFields& fields )
@@ -127,8 +211,7 @@ bool QgsHeatmapRenderer::renderFeature( QgsFeature& feature, QgsRenderContext& c
     }
     else
     {
-      QgsAttributes attrs = feature.attributes();
-      value = attrs.value( mWeightAttrNum );
+      value = feature.attribute( mWeightAttrNum );
     }
     bool ok = false;
     double evalWeight = value.toDouble( &ok );
@@ -138,9 +221,6 @@ bool QgsHeatmapRenderer::renderFeature( QgsFeature& feature, QgsRenderContext& c
     }
   }
 
-  int width = context.painter()->device()->width() / mRenderQuality;
-  int height = context.painter()->device()->height() / mRenderQuality;
-
   //transform geometry if required
   QgsGeometry* transformedGeom = 0;
   const QgsCoordinateTransform* xform = context.coordinateTransform();
@@ -156,36 +236,22 @@ bool QgsHeatmapRenderer::renderFeature( QgsFeature& feature, QgsRenderContext& c
   delete transformedGeom;
   transformedGeom = 0;
 
-  //loop through all points in multipoint
+  //loop through all points in multipoint, values are accumulated in stopRender()
   for ( QgsMultiPoint::const_iterator pointIt = multiPoint.constBegin(); pointIt != multiPoint.constEnd(); ++pointIt )
   {
     QgsPoint pixel = context.mapToPixel().transform( *pointIt );
-    int pointX = pixel.x() / mRenderQuality;
-    int pointY = pixel.y() / mRenderQuality;
-    for ( int x = qMax( pointX - mRadiusPixels, 0 ); x < qMin( pointX + mRadiusPixels, width ); ++x )
+    HeatmapPoint pt;
+    pt.x = pixel.x() / mRenderQuality;
+    pt.y = pixel.y() / mRenderQuality;
+    pt.weight = weight;
+
+    // skip points which do not affect any pixel of the image
+    if ( pt.x + mRadiusPixels <= 0 || pt.x - mRadiusPixels >= mWidth ||
+         pt.y + mRadiusPixels <= 0 || pt.y - mRadiusPixels >= mHeight )
     {
-      for ( int y = qMax( pointY - mRadiusPixels, 0 ); y < qMin( pointY + mRadiusPixels, height ); ++y )
-      {
-        int index = y * width + x;
-        if ( index >= mValues.count( ) )
-        {
-          continue;
-        }
-        double distanceSquared = pow( pointX - x, 2.0 ) + pow( pointY - y, 2.0 );
-        if ( distanceSquared > mRadiusSquared )
-        {
-          continue;
-        }
-
-        double score = weight * quarticKernel( sqrt( distanceSquared ), mRadiusPixels );
-        double value = mValues[ index ] + score;
-        if ( value > mCalculatedMaxValue )
-        {
-          mCalculatedMaxValue = value;
-        }
-        mValues[ index ] = value;
-      }
+      continue;
     }
+    mPoints << pt;
   }
 
   mFeaturesRendered++;
@@ -229,10 +295,65 @@ double QgsHeatmapRenderer::triangularKernel( const double distance, const int ba
 
 void QgsHeatmapRenderer::stopRender( QgsRenderContext& context )
 {
+  accumulatePoints();
   renderImage( context );
   mWeightExpression.reset();
 }
 
+void QgsHeatmapRenderer::accumulatePoints()
+{
+  mValues.fill( 0, mWidth * mHeight );
+  mCalculatedMaxValue = 0;
+  if ( mHeight <= 0 )
+  {
+    mPoints.clear();
+    return;
+  }
+
+  // every thread accumulates a band of rows of the single values buffer, from the points
+  // within the radius of the band (the points close to the band borders go to both bands)
+  int bandCount = qBound( 1, mPoints.count() / MIN_POINTS_PER_THREAD, qMax( QThread::idealThreadCount(), 1 ) );
+  bandCount = qMin( bandCount, mHeight );
+  int bandHeight = ( mHeight + bandCount - 1 ) / bandCount;
+  bandCount = ( mHeight + bandHeight - 1 ) / bandHeight;
+
+  QList< AccumulationBand > bands;
+  for ( int band = 0; band < bandCount; ++band )
+  {
+    AccumulationBand newBand;
+    newBand.yBegin = band * bandHeight;
+    newBand.yEnd = qMin( newBand.yBegin + bandHeight, mHeight );
+    newBand.maxValue = 0;
+    bands << newBand;
+  }
+  for ( const HeatmapPoint* pt = mPoints.constData(), *end = pt + mPoints.count(); pt != end; ++pt )
+  {
+    int firstBand = qMax( pt->y - mRadiusPixels, 0 ) / bandHeight;
+    int lastBand = qMin( pt->y + mRadiusPixels, mHeight ) - 1;
+    if ( lastBand < 0 )
+      continue;
+    lastBand /= bandHeight;
+    for ( int band = firstBand; band <= lastBand; ++band )
+      bands[band].points << pt;
+  }
+
+  AccumulateOperation operation( this );
+  if ( bands.count() == 1 )
+  {
+    operation( bands[0] );
+  }
+  else
+  {
+    QtConcurrent::blockingMap( bands, operation );
+  }
+  mPoints.clear();
+
+  Q_FOREACH ( const AccumulationBand& band, bands )
+  {
+    mCalculatedMaxValue = qMax( mCalculatedMaxValue, band.maxValue );
+  }
+}
+
 void QgsHeatmapRenderer::renderImage( QgsRenderContext& context )
 {
   if ( !context.painter() || !mGradientRamp )
@@ -247,9 +368,16 @@ void QgsHeatmapRenderer::renderImage( QgsRenderContext& context )
 
   double scaleMax = mExplicitMax > 0 ? mExplicitMax : mCalculatedMaxValue;
 
+  //colors from the ramp are looked up in a table instead of asking the ramp for every pixel
+  QVector<QRgb> colorTable( RAMP_LUT_SIZE );
+  for ( int i = 0; i < RAMP_LUT_SIZE; ++i )
+  {
+    double rampVal = i / ( double )( RAMP_LUT_SIZE - 1 );
+    colorTable[i] = mGradientRamp->color( mInvertRamp ? 1 - rampVal : rampVal ).rgba();
+  }
+
   int idx = 0;
   double pixVal = 0;
-  QColor pixColor;
   for ( int heightIndex = 0; heightIndex < image.height(); ++heightIndex )
   {
     QRgb* scanLine = ( QRgb* )image.scanLine( heightIndex );
@@ -259,9 +387,7 @@ void QgsHeatmapRenderer::renderImage( QgsRenderContext& context )
       pixVal = mValues.at( idx ) > 0 ? qMin(( mValues.at( idx ) / scaleMax ), 1.0 ) : 0;
 
       //convert value to color from ramp
-      pixColor = mGradientRamp->color( mInvertRamp ? 1 - pixVal : pixVal );
-
-      scanLine[widthIndex] = pixColor.rgba();
+      scanLine[widthIndex] = colorTable[ qRound( pixVal * ( RAMP_LUT_SIZE - 1 ) )];
       idx++;
     }
   }
@@ -172,7 +172,24 @@ class CORE_EXPORT QgsHeatmapRenderer : public QgsFeatureRendererV2
     /** Private assignment operator. @see clone() */
     QgsHeatmapRenderer& operator=( const QgsHeatmapRenderer& );
 
+    //! point in heatmap pixel coordinates, waiting for accumulation in stopRender()
+    struct HeatmapPoint
+    {
+      int x;
+      int y;
+      double weight;
+    };
+
+    //! band of rows of the values accumulated by one thread, from the points reaching into it
+    struct AccumulationBand;
+    class AccumulateOperation;
+
     QVector<double> mValues;
+    QVector<HeatmapPoint> mPoints;
+    //! kernel values for pixel offsets within the radius, precomputed for each render
+    QVector<double> mKernelStamp;
+    int mWidth;
+    int mHeight;
 
     double mCalculatedMaxValue;
 
@@ -202,6 +219,7 @@ class CORE_EXPORT QgsHeatmapRenderer : public QgsFeatureRendererV2
 
     QgsMultiPoint convertToMultipoint( const QgsGeometry *geom );
     void initializeValues( QgsRenderContext& context );
+    void accumulatePoints();
     void renderImage( QgsRenderContext &context );
 };
 
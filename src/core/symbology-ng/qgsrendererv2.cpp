@@ -107,11 +107,7 @@ const unsigned char* QgsFeatureRendererV2::_getLineString( QPolygonF& pts, QgsRe
     ct->transformPolygon( pts );
   }
 
-  QPointF* ptr = pts.data();
-  for ( int i = 0; i < pts.size(); ++i, ++ptr )
-  {
-    mtp.transformInPlace( ptr->rx(), ptr->ry() );
-  }
+  mtp.transformInPlace( pts.data(), pts.size() );
 
   return wkbPtr;
 }
@@ -171,12 +167,7 @@ const unsigned char* QgsFeatureRendererV2::_getPolygon( QPolygonF& pts, QList<QP
       ct->transformPolygon( poly );
     }
 
-
-    ptr = poly.data();
-    for ( int i = 0; i < poly.size(); ++i, ++ptr )
-    {
-      mtp.transformInPlace( ptr->rx(), ptr->ry() );
-    }
+    mtp.transformInPlace( poly.data(), poly.size() );
 
     if ( idx == 0 )
       pts = poly;
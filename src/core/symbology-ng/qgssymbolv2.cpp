@@ -105,7 +105,59 @@ QgsSymbolV2::QgsSymbolV2( SymbolType type, const QgsSymbolLayerV2List& layers )
 }
 
 
+// transforms the polygons to screen coordinates, with all points reprojected at once
+static void _transformPolygonsToScreen( QList<QPolygonF>& polygons, QgsRenderContext& context, QPolygonF& buffer )
+{
+  const QgsCoordinateTransform* ct = context.coordinateTransform();
+  if ( ct && polygons.size() == 1 )
+  {
+    ct->transformPolygon( polygons[0] );
+  }
+  else if ( ct && polygons.size() > 1 )
+  {
+    int nPoints = 0;
+    Q_FOREACH ( const QPolygonF& poly, polygons )
+      nPoints += poly.size();
+
+    buffer.resize( nPoints );
+    QPointF* dst = buffer.data();
+    Q_FOREACH ( const QPolygonF& poly, polygons )
+      dst = qCopy( poly.constBegin(), poly.constEnd(), dst );
+
+    ct->transformPolygon( buffer );
+
+    const QPointF* src = buffer.constData();
+    for ( int i = 0; i < polygons.size(); ++i )
+    {
+      QPolygonF& poly = polygons[i];
+      qCopy( src, src + poly.size(), poly.begin() );
+      src += poly.size();
+    }
+  }
+
+  const QgsMapToPixel& mtp = context.mapToPixel();
+  for ( int i = 0; i < polygons.size(); ++i )
+  {
+    QPolygonF& poly = polygons[i];
+    mtp.transformInPlace( poly.data(), poly.size() );
+  }
+}
+
 const unsigned char* QgsSymbolV2::_getLineString( QPolygonF& pts, QgsRenderContext& context, const unsigned char* wkb, bool clipToExtent )
+{
+  const unsigned char* end = _readLineString( pts, context, wkb, clipToExtent );
+
+  //transform the QPolygonF to screen coordinates
+  if ( context.coordinateTransform() )
+  {
+    context.coordinateTransform()->transformPolygon( pts );
+  }
+  context.mapToPixel().transformInPlace( pts.data(), pts.size() );
+
+  return end;
+}
+
+const unsigned char* QgsSymbolV2::_readLineString( QPolygonF& pts, QgsRenderContext& context, const unsigned char* wkb, bool clipToExtent )
 {
   QgsConstWkbPtr wkbPtr( wkb + 1 );
   unsigned int wkbType, nPoints;
@@ -116,8 +168,6 @@ const unsigned char* QgsSymbolV2::_getLineString( QPolygonF& pts, QgsRenderConte
 
   double x = 0.0;
   double y = 0.0;
-  const QgsCoordinateTransform* ct = context.coordinateTransform();
-  const QgsMapToPixel& mtp = context.mapToPixel();
 
   //apply clipping for large lines to achieve a better rendering performance
   if ( clipToExtent && nPoints > 1 )
@@ -144,22 +194,27 @@ const unsigned char* QgsSymbolV2::_getLineString( QPolygonF& pts, QgsRenderConte
     }
   }
 
-  //transform the QPolygonF to screen coordinates
-  if ( ct )
-  {
-    ct->transformPolygon( pts );
-  }
-
-  QPointF* ptr = pts.data();
-  for ( int i = 0; i < pts.size(); ++i, ++ptr )
-  {
-    mtp.transformInPlace( ptr->rx(), ptr->ry() );
-  }
-
   return wkbPtr;
 }
 
 const unsigned char* QgsSymbolV2::_getPolygon( QPolygonF& pts, QList<QPolygonF>& holes, QgsRenderContext& context, const unsigned char* wkb, bool clipToExtent )
+{
+  holes.clear();
+
+  QList<QPolygonF> rings;
+  const unsigned char* end = _readPolygon( rings, context, wkb, clipToExtent );
+  if ( rings.isEmpty() )  // sanity check for zero rings in polygon
+    return end;
+
+  QPolygonF buffer;
+  _transformPolygonsToScreen( rings, context, buffer );
+
+  pts = rings.takeFirst();
+  holes = rings;
+  return end;
+}
+
+const unsigned char* QgsSymbolV2::_readPolygon( QList<QPolygonF>& rings, QgsRenderContext& context, const unsigned char* wkb, bool clipToExtent )
 {
   QgsConstWkbPtr wkbPtr( wkb + 1 );
 
@@ -173,10 +228,7 @@ const unsigned char* QgsSymbolV2::_getPolygon( QPolygonF& pts, QList<QPolygonF>&
   bool hasMValue = QgsWKBTypes::hasM(( QgsWKBTypes::Type )wkbType );
 
   double x, y;
-  holes.clear();
 
-  const QgsCoordinateTransform* ct = context.coordinateTransform();
-  const QgsMapToPixel& mtp = context.mapToPixel();
   const QgsRectangle& e = context.extent();
   double cw = e.width() / 10; double ch = e.height() / 10;
   QgsRectangle clipRect( e.xMinimum() - cw, e.yMinimum() - ch, e.xMaximum() + cw, e.yMaximum() + ch );
@@ -201,35 +253,29 @@ const unsigned char* QgsSymbolV2::_getPolygon( QPolygonF& pts, QList<QPolygonF>&
       *ptr = QPointF( x, y );
     }
 
+    // the exterior ring is always kept so that holes are not taken for it
     if ( nPoints < 1 )
+    {
+      if ( idx == 0 )
+        rings.append( poly );
       continue;
+    }
 
     //clip close to view extent, if needed
     QRectF ptsRect = poly.boundingRect();
     if ( clipToExtent && !context.extent().contains( ptsRect ) ) QgsClipper::trimPolygon( poly, clipRect );
 
-    //transform the QPolygonF to screen coordinates
-    if ( ct )
-    {
-      ct->transformPolygon( poly );
-    }
-
-
-    ptr = poly.data();
-    for ( int i = 0; i < poly.size(); ++i, ++ptr )
-    {
-      mtp.transformInPlace( ptr->rx(), ptr->ry() );
-    }
-
-    if ( idx == 0 )
-      pts = poly;
-    else
-      holes.append( poly );
+    rings.append( poly );
   }
 
   return wkbPtr;
 }
 
+void QgsSymbolV2::transformToScreen( QList<QPolygonF>& polygons, QgsRenderContext& context )
+{
+  _transformPolygonsToScreen( polygons, context, mTransformBuffer );
+}
+
 QgsSymbolV2::~QgsSymbolV2()
 {
   // delete all symbol layers (we own them, so it's okay)
@@ -726,7 +772,13 @@ void QgsSymbolV2::renderFeature( const QgsFeature& feature, QgsRenderContext& co
         QgsDebugMsg( "polygon can be drawn only with fill symbol!" );
         break;
       }
-      _getPolygon( pts, holes, context, segmentizedGeometry->asWkb(), clipFeaturesToExtent() );
+      _readPolygon( holes, context, segmentizedGeometry->asWkb(), clipFeaturesToExtent() );
+      if ( holes.isEmpty() )
+        break;
+
+      // all rings are reprojected together
+      transformToScreen( holes, context );
+      pts = holes.takeFirst();
       static_cast<QgsFillSymbolV2*>( this )->renderPolygon( pts, ( !holes.isEmpty() ? &holes : NULL ), &feature, context, layer, selected );
     }
     break;
@@ -754,8 +806,6 @@ void QgsSymbolV2::renderFeature( const QgsFeature& feature, QgsRenderContext& co
     case QgsWKBTypes::MultiCurve:
     case QgsWKBTypes::MultiLineString:
     {
-      QPolygonF pts;
-
       if ( mType != QgsSymbolV2::Line )
       {
         QgsDebugMsg( "multi-linestring can be drawn only with line symbol!" );
@@ -767,16 +817,24 @@ void QgsSymbolV2::renderFeature( const QgsFeature& feature, QgsRenderContext& co
       wkbPtr >> num;
       const unsigned char* ptr = wkbPtr;
 
+      // read all parts first so that they are reprojected together
+      QList<QPolygonF> parts;
+      for ( unsigned int i = 0; i < num; ++i )
+      {
+        parts.append( QPolygonF() );
+        ptr = QgsConstWkbPtr( _readLineString( parts.last(), context, ptr, clipFeaturesToExtent() ) );
+      }
+      transformToScreen( parts, context );
+
       const QgsGeometryCollectionV2* geomCollection = dynamic_cast<const QgsGeometryCollectionV2*>( geom->geometry() );
 
-      for ( unsigned int i = 0; i < num; ++i )
+      for ( int i = 0; i < parts.size(); ++i )
       {
         if ( geomCollection )
         {
           context.setGeometry( geomCollection->geometryN( i ) );
         }
-        ptr = QgsConstWkbPtr( _getLineString( pts, context, ptr, clipFeaturesToExtent() ) );
-        static_cast<QgsLineSymbolV2*>( this )->renderPolyline( pts, &feature, context, layer, selected );
+        static_cast<QgsLineSymbolV2*>( this )->renderPolyline( parts.at( i ), &feature, context, layer, selected );
       }
     }
     break;
@@ -795,19 +853,34 @@ void QgsSymbolV2::renderFeature( const QgsFeature& feature, QgsRenderContext& co
       wkbPtr >> num;
       const unsigned char* ptr = wkbPtr;
 
-      QPolygonF pts;
+      // read the rings of all parts first so that they are reprojected together
+      QList<QPolygonF> rings;
+      QVector<int> ringCounts( num );
+      for ( unsigned int i = 0; i < num; ++i )
+      {
+        int count = rings.size();
+        ptr = _readPolygon( rings, context, ptr, clipFeaturesToExtent() );
+        ringCounts[i] = rings.size() - count;
+      }
+      transformToScreen( rings, context );
+
       QList<QPolygonF> holes;
 
       const QgsGeometryCollectionV2* geomCollection = dynamic_cast<const QgsGeometryCollectionV2*>( geom->geometry() );
 
+      int ring = 0;
       for ( unsigned int i = 0; i < num; ++i )
       {
+        if ( ringCounts[i] == 0 )
+          continue;
+
         if ( geomCollection )
         {
           context.setGeometry( geomCollection->geometryN( i ) );
         }
-        ptr = _getPolygon( pts, holes, context, ptr, clipFeaturesToExtent() );
-        static_cast<QgsFillSymbolV2*>( this )->renderPolygon( pts, ( !holes.isEmpty() ? &holes : NULL ), &feature, context, layer, selected );
+        holes = rings.mid( ring + 1, ringCounts[i] - 1 );
+        static_cast<QgsFillSymbolV2*>( this )->renderPolygon( rings.at( ring ), ( !holes.isEmpty() ? &holes : NULL ), &feature, context, layer, selected );
+        ring += ringCounts[i];
       }
       break;
     }
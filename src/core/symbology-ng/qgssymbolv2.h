@@ -19,6 +19,7 @@
 #include "qgis.h"
 #include <QList>
 #include <QMap>
+#include <QPolygonF>
 #include "qgsmapunitscale.h"
 #include "qgsgeometry.h"
 
@@ -27,7 +28,6 @@ class QImage;
 class QPainter;
 class QSize;
 class QPointF;
-class QPolygonF;
 
 class QDomDocument;
 class QDomElement;
@@ -267,6 +267,29 @@ class CORE_EXPORT QgsSymbolV2
      */
     static const unsigned char* _getPolygon( QPolygonF& pts, QList<QPolygonF>& holes, QgsRenderContext& context, const unsigned char* wkb, bool clipToExtent = true );
 
+    /**
+     * Reads a line string from wkb, the points are left in map coordinates
+     * @note added in QGIS 2.14
+     * @note not available in python bindings
+     */
+    static const unsigned char* _readLineString( QPolygonF& pts, QgsRenderContext& context, const unsigned char* wkb, bool clipToExtent = true );
+
+    /**
+     * Reads the rings of a polygon from wkb and appends them to rings (exterior
+     * ring first), the points are left in map coordinates
+     * @note added in QGIS 2.14
+     * @note not available in python bindings
+     */
+    static const unsigned char* _readPolygon( QList<QPolygonF>& rings, QgsRenderContext& context, const unsigned char* wkb, bool clipToExtent = true );
+
+    /**
+     * Transforms polygons from map coordinates to screen coordinates. The points of
+     * all polygons are reprojected together with a single call to proj.
+     * @note added in QGIS 2.14
+     * @note not available in python bindings
+     */
+    void transformToScreen( QList<QPolygonF>& polygons, QgsRenderContext& context );
+
     /**
      * Retrieve a cloned list of all layers that make up this symbol.
      * Ownership is transferred to the caller.
@@ -300,6 +323,9 @@ class CORE_EXPORT QgsSymbolV2
 
     const QgsVectorLayer* mLayer; //current vectorlayer
 
+  private:
+    //! buffer reused for the reprojection of all parts of a feature
+    QPolygonF mTransformBuffer;
 };
 
 ///////////////////////
@@ -80,6 +80,103 @@ bool QgsAttributeTableModel::loadFeatureAtId( QgsFeatureId fid ) const
   return mLayerCache->featureAtId( fid, mFeat );
 }
 
+void QgsAttributeTableModel::loadFeaturePage( int row ) const
+{
+  int page = row / FEATURE_PAGE_SIZE;
+  int first = page * FEATURE_PAGE_SIZE;
+  int last = qMin( first + FEATURE_PAGE_SIZE, mRowIdMap.size() );
+
+  QgsFeatureIds fids;
+  for ( int i = first; i < last; ++i )
+  {
+    QgsFeatureId fid = mRowIdMap.value( i );
+    if ( !mLayerCache->isFidCached( fid ) )
+      fids << fid;
+  }
+
+  // a single feature is fetched by id
+  if ( fids.size() < 2 )
+    return;
+
+  // evict whole pages, the oldest first, so that the layer cache does not keep pages
+  // partially and their remaining features are not fetched one by one when shown again
+  int maxPages = qMax( 1, mLayerCache->cacheSize() / FEATURE_PAGE_SIZE );
+  mLoadedPages.removeAll( page );
+  while ( mLoadedPages.size() >= maxPages )
+  {
+    int evicted = mLoadedPages.takeFirst();
+    int evictedLast = qMin(( evicted + 1 ) * FEATURE_PAGE_SIZE, mRowIdMap.size() );
+    for ( int i = evicted * FEATURE_PAGE_SIZE; i < evictedLast; ++i )
+      mLayerCache->removeCachedFeature( mRowIdMap.value( i ) );
+  }
+  mLoadedPages << page;
+
+  QgsDebugMsgLevel( QString( "loading page of %1 features at row %2" ).arg( fids.size() ).arg( first ), 3 );
+
+  // the layer cache adds the geometry and attributes it caches to the request
+  QgsFeatureIterator it = mLayerCache->getFeatures( QgsFeatureRequest()
+                          .setFilterFids( fids )
+                          .setFlags( QgsFeatureRequest::NoGeometry )
+                          .setSubsetOfAttributes( mAttributes ) );
+  QgsFeature f;
+  while ( it.nextFeature( f ) )
+    ;
+}
+
+QgsFeatureRequest::OrderBy QgsAttributeTableModel::cachedFieldOrderBy() const
+{
+  QgsFeatureRequest::OrderBy orderBy;
+  if ( mCachedField != -1 )
+    orderBy << QgsFeatureRequest::OrderByClause( QgsExpression::quotedColumnRef( layer()->fields().at( mCachedField ).name() ) );
+  return orderBy;
+}
+
+void QgsAttributeTableModel::setRowOrder( const QList<QgsFeatureId>& fids )
+{
+  if ( mRowIdMap.isEmpty() )
+    return;
+
+  emit layoutAboutToBeChanged();
+
+  QHash<int, QgsFeatureId> oldRowIdMap = mRowIdMap;
+  QHash<QgsFeatureId, int> oldIdRowMap = mIdRowMap;
+  mRowIdMap.clear();
+  mIdRowMap.clear();
+
+  Q_FOREACH ( QgsFeatureId fid, fids )
+  {
+    if ( !oldIdRowMap.contains( fid ) || mIdRowMap.contains( fid ) )
+      continue;
+
+    int n = mRowIdMap.size();
+    mIdRowMap.insert( fid, n );
+    mRowIdMap.insert( n, fid );
+  }
+  for ( int row = 0; row < oldRowIdMap.size(); ++row )
+  {
+    QgsFeatureId fid = oldRowIdMap.value( row );
+    if ( mIdRowMap.contains( fid ) )
+      continue;
+
+    int n = mRowIdMap.size();
+    mIdRowMap.insert( fid, n );
+    mRowIdMap.insert( n, fid );
+  }
+
+  mRowStylesMap.clear();
+  mLoadedPages.clear();
+
+  QModelIndexList oldIndexes = persistentIndexList();
+  QModelIndexList newIndexes;
+  Q_FOREACH ( const QModelIndex& oldIndex, oldIndexes )
+  {
+    newIndexes << index( mIdRowMap.value( oldRowIdMap.value( oldIndex.row() ) ), oldIndex.column() );
+  }
+  changePersistentIndexList( oldIndexes, newIndexes );
+
+  emit layoutChanged();
+}
+
 void QgsAttributeTableModel::featuresDeleted( const QgsFeatureIds& fids )
 {
   QList<int> rows;
@@ -358,7 +455,25 @@ void QgsAttributeTableModel::loadLayer()
     removeRows( 0, rowCount() );
   }
 
-  QgsFeatureIterator features = mLayerCache->getFeatures( mFeatureRequest );
+  // only the feature ids are needed for the rows, the attributes are loaded page by page
+  // when shown (expressions may need attributes and geometry though)
+  QgsFeatureRequest request( mFeatureRequest );
+  if ( mFeatureRequest.filterType() != QgsFeatureRequest::FilterExpression )
+  {
+    QgsAttributeList attributes;
+    if ( mCachedField != -1 )
+      attributes << mCachedField;
+    request.setSubsetOfAttributes( attributes );
+    if ( !( mFeatureRequest.flags() & QgsFeatureRequest::ExactIntersect ) )
+      request.setFlags( request.flags() | QgsFeatureRequest::NoGeometry );
+  }
+  // rows next to each other in the sorted view are loaded together
+  request.setOrderBy( cachedFieldOrderBy() );
+
+  mFeat.setFeatureId( std::numeric_limits<int>::min() );
+  mLoadedPages.clear();
+
+  QgsFeatureIterator features = layer()->getFeatures( request );
 
   int i = 0;
 
@@ -381,8 +496,12 @@ void QgsAttributeTableModel::loadLayer()
 
       t.restart();
     }
-    mFeat = feat;
-    featureAdded( feat.id() );
+    if ( mCachedField != -1 )
+      mFieldCache.insert( feat.id(), feat.attribute( mCachedField ) );
+
+    int n = mRowIdMap.size();
+    mIdRowMap.insert( feat.id(), n );
+    mRowIdMap.insert( n, feat.id() );
   }
 
   emit finished();
@@ -585,6 +704,9 @@ QVariant QgsAttributeTableModel::data( const QModelIndex &index, int role ) cons
   {
     if ( mFeat.id() != rowId || !mFeat.isValid() )
     {
+      if ( !mLayerCache->isFidCached( rowId ) )
+        loadFeaturePage( index.row() );
+
       if ( !loadFeatureAtId( rowId ) )
         return QVariant( "ERROR" );
 
@@ -741,17 +863,25 @@ void QgsAttributeTableModel::prefetchColumnData( int column )
     const QgsFields& fields = layer()->fields();
     QStringList fldNames;
     fldNames << fields[fieldId].name();
+    if ( mFeatureRequest.filterType() == QgsFeatureRequest::FilterExpression )
+      fldNames << mFeatureRequest.filterExpression()->referencedColumns();
 
+    mCachedField = fieldId;
+
+    // ask the layer directly, the layer cache would fetch all cached attributes and the geometry
     QgsFeatureRequest r( mFeatureRequest );
-    QgsFeatureIterator it = mLayerCache->getFeatures( r.setFlags( QgsFeatureRequest::NoGeometry ).setSubsetOfAttributes( fldNames, fields ) );
+    r.setFlags( QgsFeatureRequest::NoGeometry ).setSubsetOfAttributes( fldNames, fields );
+    QgsFeatureIterator it = layer()->getFeatures( r.setOrderBy( cachedFieldOrderBy() ) );
 
+    QList<QgsFeatureId> fids;
     QgsFeature f;
     while ( it.nextFeature( f ) )
     {
       mFieldCache.insert( f.id(), f.attribute( fieldId ) );
+      fids << f.id();
     }
 
-    mCachedField = fieldId;
+    setRowOrder( fids );
   }
 }
 
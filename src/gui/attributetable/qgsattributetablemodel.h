@@ -319,6 +319,32 @@ class GUI_EXPORT QgsAttributeTableModel: public QAbstractTableModel
      */
     virtual bool loadFeatureAtId( QgsFeatureId fid ) const;
 
+    /**
+     * Load the features of the page containing the row into the layer cache
+     * with a single request, instead of fetching them one by one while scrolling.
+     *
+     * @param  row     row in the page
+     */
+    void loadFeaturePage( int row ) const;
+
+    /** Number of rows loaded together into the layer cache */
+    static const int FEATURE_PAGE_SIZE = 100;
+
+    /** Pages of rows loaded into the layer cache, the most recently loaded last */
+    mutable QList<int> mLoadedPages;
+
+    /** Returns the clause ordering the features by the cached column */
+    QgsFeatureRequest::OrderBy cachedFieldOrderBy() const;
+
+    /**
+     * Orders the rows as the features are listed, rows of features not in the list
+     * are kept at the end. Rows shown next to each other in the sorted view are then
+     * loaded into the layer cache in one page.
+     *
+     * @param  fids    feature ids in the new order
+     */
+    void setRowOrder( const QList<QgsFeatureId>& fids );
+
     QgsFeatureRequest mFeatureRequest;
 
     /** The currently cached column */
@@ -8,122 +8,310 @@
 #include "qgsgeometryengine.h"
 #include "qgsgeometrygapcheck.h"
 #include "qgsgeometrycollectionv2.h"
+#include "qgslinestringv2.h"
+#include "qgspolygonv2.h"
 #include "../utils/qgsfeaturepool.h"
+#include "../utils/qgsfeaturetiles.h"
 
+#include <QtConcurrentMap>
+#include <qmath.h>
+
+
+static QgsAbstractGeometryV2* rectangleGeometry( const QgsRectangle& rect )
+{
+  QgsLineStringV2* ring = new QgsLineStringV2();
+  ring->setPoints( QList<QgsPointV2>()
+                   << QgsPointV2( rect.xMinimum(), rect.yMinimum() )
+                   << QgsPointV2( rect.xMaximum(), rect.yMinimum() )
+                   << QgsPointV2( rect.xMaximum(), rect.yMaximum() )
+                   << QgsPointV2( rect.xMinimum(), rect.yMaximum() )
+                   << QgsPointV2( rect.xMinimum(), rect.yMinimum() ) );
+  QgsPolygonV2* polygon = new QgsPolygonV2();
+  polygon->setExteriorRing( ring );
+  return polygon;
+}
+
+static bool reachesBorder( const QgsRectangle& bbox, const QgsRectangle& region )
+{
+  double tol = QgsGeometryCheckPrecision::tolerance();
+  return bbox.xMinimum() <= region.xMinimum() + tol || bbox.xMaximum() >= region.xMaximum() - tol ||
+         bbox.yMinimum() <= region.yMinimum() + tol || bbox.yMaximum() >= region.yMaximum() - tol;
+}
+
+// Number of tiles a region may grow to while completing a gap from its pieces
+static const int MAX_STITCH_TILES = 16;
 
 void QgsGeometryGapCheck::collectErrors( QList<QgsGeometryCheckError*>& errors, QStringList &messages, QAtomicInt* progressCounter , const QgsFeatureIds &ids ) const
 {
   assert( mFeaturePool->getLayer()->geometryType() == QGis::Polygon );
   if ( progressCounter ) progressCounter->fetchAndAddRelaxed( 1 );
 
-  // Collect geometries, build spatial index
-  QList<const QgsAbstractGeometryV2*> geomList;
   const QgsFeatureIds& featureIds = ids.isEmpty() ? mFeaturePool->getFeatureIds() : ids;
-  Q_FOREACH ( const QgsFeatureId& id, featureIds )
+  QgsRectangle extent = mFeaturePool->getExtent( ids );
+  if ( featureIds.isEmpty() || extent.isNull() )
+  {
+    return;
+  }
+
+  // Instead of computing the union of all polygons, the gaps are searched tile by tile
+  // in the tile extent grown by a halo. A gap within the halo of the tile containing the
+  // center of its bounding box is reported with that tile, the pieces of gaps which
+  // reach the border of a halo are completed afterwards.
+  QgsFeatureTiles tiles( extent, featureIds.size() );
+  double halo = qMin( qSqrt( mThreshold ), 0.5 * qMax( tiles.tileWidth(), tiles.tileHeight() ) );
+  halo = qMax( halo, 10 * QgsGeometryCheckPrecision::tolerance() );
+
+  QList<GapTile> tileList;
+  for ( int i = 0, n = tiles.count(); i < n; ++i )
+  {
+    GapTile tile;
+    tile.index = i;
+    tileList.append( tile );
+  }
+  QtConcurrent::blockingMap( tileList, CollectTileWrapper( this, featureIds, tiles, halo ) );
+
+  QList<QgsAbstractGeometryV2*> borderGaps;
+  Q_FOREACH ( const GapTile& tile, tileList )
+  {
+    errors.append( tile.errors );
+    messages.append( tile.messages );
+    borderGaps.append( tile.borderGaps );
+  }
+
+  stitchBorderGaps( borderGaps, featureIds, tiles, halo, errors, messages );
+  qDeleteAll( borderGaps );
+}
+
+bool QgsGeometryGapCheck::computeGaps( const QgsRectangle& region, const QgsFeatureIds& featureIds, QList<QgsAbstractGeometryV2*>& gaps, QHash<QgsFeatureId, QgsFeature>& features, QString& errMsg ) const
+{
+  // Fetch the polygons of the region at once, they are only accessed through this cache afterwards
+  QgsFeatureIds regionIds = mFeaturePool->getIntersects( region );
+  regionIds.intersect( featureIds );
+  mFeaturePool->getFeatures( regionIds, features );
+
+  QList<const QgsAbstractGeometryV2*> geomList;
+  Q_FOREACH ( const QgsFeature& feature, features )
   {
-    QgsFeature feature;
-    if ( mFeaturePool->get( id, feature ) )
+    if ( feature.constGeometry() )
     {
-      geomList.append( feature.geometry()->geometry()->clone() );
+      geomList.append( feature.constGeometry()->geometry() );
     }
   }
 
+  // Compute difference between region and union to obtain gap polygons
+  QgsAbstractGeometryV2* regionGeom = rectangleGeometry( region );
+  QgsAbstractGeometryV2* diffGeom = 0;
   if ( geomList.isEmpty() )
   {
-    return;
+    diffGeom = regionGeom->clone();
   }
-
-  QgsGeometryEngine* geomEngine = QgsGeomUtils::createGeomEngine( 0, QgsGeometryCheckPrecision::tolerance() );
-
-  // Create union of geometry
-  QString errMsg;
-  QgsAbstractGeometryV2* unionGeom = geomEngine->combine( geomList, &errMsg );
-  qDeleteAll( geomList );
-  delete geomEngine;
-  if ( !unionGeom )
+  else
   {
-    messages.append( tr( "Gap check: %1" ).arg( errMsg ) );
-    return;
+    QgsGeometryEngine* geomEngine = QgsGeomUtils::createGeomEngine( 0, QgsGeometryCheckPrecision::tolerance() );
+    QgsAbstractGeometryV2* unionGeom = geomEngine->combine( geomList, &errMsg );
+    delete geomEngine;
+    if ( unionGeom )
+    {
+      geomEngine = QgsGeomUtils::createGeomEngine( regionGeom, QgsGeometryCheckPrecision::tolerance() );
+      diffGeom = geomEngine->difference( *unionGeom, &errMsg );
+      delete geomEngine;
+      delete unionGeom;
+    }
+  }
+  delete regionGeom;
+  if ( !diffGeom )
+  {
+    return false;
   }
 
-  // Get envelope of union
-  geomEngine = QgsGeomUtils::createGeomEngine( unionGeom, QgsGeometryCheckPrecision::tolerance() );
-  QgsAbstractGeometryV2* envelope = geomEngine->envelope( &errMsg );
-  delete geomEngine;
-  if ( !envelope )
+  for ( int iPart = 0, nParts = diffGeom->partCount(); iPart < nParts; ++iPart )
   {
-    messages.append( tr( "Gap check: %1" ).arg( errMsg ) );
-    delete unionGeom;
-    return;
+    gaps.append( QgsGeomUtils::getGeomPart( diffGeom, iPart )->clone() );
   }
+  delete diffGeom;
+  return true;
+}
 
-  // Buffer envelope
-  geomEngine = QgsGeomUtils::createGeomEngine( envelope, QgsGeometryCheckPrecision::tolerance() );
-  QgsAbstractGeometryV2* bufEnvelope = geomEngine->buffer( 2, 0, GEOSBUF_CAP_SQUARE, GEOSBUF_JOIN_MITRE, 4. );
-  delete geomEngine;
-  delete envelope;
-  envelope = bufEnvelope;
+QgsGeometryCheckError* QgsGeometryGapCheck::createGapError( QgsAbstractGeometryV2* gap, const QHash<QgsFeatureId, QgsFeature>& features ) const
+{
+  // Get neighboring polygons
+  QgsFeatureIds neighboringIds;
+  QgsRectangle gapAreaBBox = gap->boundingBox();
+  Q_FOREACH ( const QgsFeature& feature, features )
+  {
+    if ( !feature.constGeometry() || !feature.constGeometry()->boundingBox().intersects( gap->boundingBox() ) )
+    {
+      continue;
+    }
+    QgsAbstractGeometryV2* geom2 = feature.constGeometry()->geometry();
+    if ( QgsGeomUtils::sharedEdgeLength( gap, geom2, QgsGeometryCheckPrecision::reducedTolerance() ) > 0 )
+    {
+      neighboringIds.insert( feature.id() );
+      gapAreaBBox.unionRect( geom2->boundingBox() );
+    }
+  }
+  if ( neighboringIds.isEmpty() )
+  {
+    return 0;
+  }
+  return new QgsGeometryGapCheckError( this, gap->clone(), neighboringIds, gap->area(), gapAreaBBox );
+}
 
-  // Compute difference between envelope and union to obtain gap polygons
-  geomEngine = QgsGeomUtils::createGeomEngine( envelope, QgsGeometryCheckPrecision::tolerance() );
-  QgsAbstractGeometryV2* diffGeom = geomEngine->difference( *unionGeom, &errMsg );
-  delete geomEngine;
-  if ( !diffGeom )
+void QgsGeometryGapCheck::collectTileErrors( GapTile& tile, const QgsFeatureIds& featureIds, const QgsFeatureTiles& tiles, double halo ) const
+{
+  QgsRectangle region = tiles.tile( tile.index ).buffer( halo );
+  QList<QgsAbstractGeometryV2*> gaps;
+  QHash<QgsFeatureId, QgsFeature> features;
+  QString errMsg;
+  if ( !computeGaps( region, featureIds, gaps, features, errMsg ) )
   {
-    messages.append( tr( "Gap check: %1" ).arg( errMsg ) );
-    delete unionGeom;
-    delete diffGeom;
+    tile.messages.append( tr( "Gap check: %1" ).arg( errMsg ) );
     return;
   }
 
-  // For each gap polygon which does not lie on the boundary, get neighboring polygons and add error
-  for ( int iPart = 0, nParts = diffGeom->partCount(); iPart < nParts; ++iPart )
+  Q_FOREACH ( QgsAbstractGeometryV2* gap, gaps )
   {
-    QgsAbstractGeometryV2* geom = QgsGeomUtils::getGeomPart( diffGeom, iPart );
-    // Skip the gap between features and boundingbox
-    if ( geom->boundingBox() == envelope->boundingBox() )
+    // Skip gaps above threshold, a piece of a gap is never larger than the gap
+    if ( gap->area() > mThreshold )
     {
+      delete gap;
       continue;
     }
-
-    // Skip gaps above threshold
-    if ( geom->area() > mThreshold || geom->area() < QgsGeometryCheckPrecision::reducedTolerance() )
+    // Pieces reaching the extent of the features belong to the area around them, not to a gap
+    if ( reachesBorder( gap->boundingBox(), tiles.extent() ) )
     {
+      delete gap;
       continue;
     }
-
-    // Get neighboring polygons
-    QgsFeatureIds neighboringIds;
-    QgsRectangle gapAreaBBox = geom->boundingBox();
-    QgsFeatureIds intersectIds = mFeaturePool->getIntersects( geom->boundingBox() );
-
-    Q_FOREACH ( QgsFeatureId id, intersectIds )
+    if ( reachesBorder( gap->boundingBox(), region ) )
+    {
+      tile.borderGaps.append( gap );
+      continue;
+    }
+    // Gaps within the halo of several tiles are reported by a single one
+    if ( gap->area() >= QgsGeometryCheckPrecision::reducedTolerance() &&
+         tiles.tileAt( gap->boundingBox().center() ) == tile.index )
     {
-      QgsFeature feature;
-      if ( !mFeaturePool->get( id, feature ) )
+      QgsGeometryCheckError* error = createGapError( gap, features );
+      if ( error )
       {
-        continue;
+        tile.errors.append( error );
       }
-      QgsAbstractGeometryV2* geom2 = feature.geometry()->geometry();
-      if ( QgsGeomUtils::sharedEdgeLength( geom, geom2, QgsGeometryCheckPrecision::reducedTolerance() ) > 0 )
+    }
+    delete gap;
+  }
+}
+
+void QgsGeometryGapCheck::stitchBorderGaps( const QList<QgsAbstractGeometryV2*>& borderGaps, const QgsFeatureIds& featureIds, const QgsFeatureTiles& tiles, double halo, QList<QgsGeometryCheckError*>& errors, QStringList& messages ) const
+{
+  // Complete gaps, several pieces usually belong to the same gap. The region around a piece
+  // grows until the gap lies within it, reaches the extent of the features (the piece then
+  // belongs to the area around them) or exceeds the threshold, up to MAX_STITCH_TILES tiles.
+  double maxRegionArea = MAX_STITCH_TILES * tiles.tileWidth() * tiles.tileHeight();
+  QList<QgsAbstractGeometryV2*> completedGaps;
+  Q_FOREACH ( QgsAbstractGeometryV2* piece, borderGaps )
+  {
+    QgsGeometryEngine* geomEngine = QgsGeomUtils::createGeomEngine( piece, QgsGeometryCheckPrecision::tolerance() );
+    QgsPointV2 piecePoint;
+    bool havePoint = geomEngine->pointOnSurface( piecePoint );
+    delete geomEngine;
+    if ( !havePoint )
+    {
+      continue;
+    }
+    QgsPoint point( piecePoint.x(), piecePoint.y() );
+
+    bool completed = false;
+    Q_FOREACH ( QgsAbstractGeometryV2* gap, completedGaps )
+    {
+      if ( gap->boundingBox().contains( point ) )
       {
-        neighboringIds.insert( feature.id() );
-        gapAreaBBox.unionRect( geom2->boundingBox() );
+        geomEngine = QgsGeomUtils::createGeomEngine( gap, QgsGeometryCheckPrecision::tolerance() );
+        completed = geomEngine->intersects( piecePoint );
+        delete geomEngine;
+        if ( completed )
+        {
+          break;
+        }
       }
     }
-    if ( neighboringIds.isEmpty() )
+    if ( completed )
     {
-      delete geom;
       continue;
     }
 
-    // Add error
-    errors.append( new QgsGeometryGapCheckError( this, geom->clone(), neighboringIds, geom->area(), gapAreaBBox ) );
-  }
+    // Grow the region until the gap lies within it
+    QgsRectangle region = piece->boundingBox().buffer( halo );
+    forever
+    {
+      QList<QgsAbstractGeometryV2*> gaps;
+      QHash<QgsFeatureId, QgsFeature> features;
+      QString errMsg;
+      if ( !computeGaps( region, featureIds, gaps, features, errMsg ) )
+      {
+        messages.append( tr( "Gap check: %1" ).arg( errMsg ) );
+        break;
+      }
 
-  delete unionGeom;
-  delete envelope;
-  delete diffGeom;
+      QgsAbstractGeometryV2* gap = 0;
+      Q_FOREACH ( QgsAbstractGeometryV2* candidate, gaps )
+      {
+        if ( !gap && candidate->boundingBox().contains( point ) )
+        {
+          geomEngine = QgsGeomUtils::createGeomEngine( candidate, QgsGeometryCheckPrecision::tolerance() );
+          if ( geomEngine->intersects( piecePoint ) )
+          {
+            gap = candidate;
+          }
+          delete geomEngine;
+        }
+        if ( gap != candidate )
+        {
+          delete candidate;
+        }
+      }
+      if ( !gap )
+      {
+        break;
+      }
+
+      if ( reachesBorder( gap->boundingBox(), tiles.extent() ) )
+      {
+        completedGaps.append( gap );
+        break;
+      }
+
+      bool reachesRegionBorder = reachesBorder( gap->boundingBox(), region );
+      if ( reachesRegionBorder && gap->area() <= mThreshold )
+      {
+        QgsRectangle grownRegion = region;
+        grownRegion.unionRect( gap->boundingBox().buffer( halo ) );
+        if ( grownRegion.width() * grownRegion.height() <= maxRegionArea )
+        {
+          region = grownRegion;
+          delete gap;
+          continue;
+        }
+        messages.append( tr( "Gap check: the gap at %1 extends over too many features to be checked" ).arg( point.toString() ) );
+      }
+      completedGaps.append( gap );
+
+      // Skip gaps above threshold and the area around the features. A gap within the halo
+      // of the tile containing its center has already been reported with the tile.
+      QgsRectangle ownerRegion = tiles.tile( tiles.tileAt( gap->boundingBox().center() ) ).buffer( halo );
+      if ( !reachesRegionBorder && gap->area() <= mThreshold && gap->area() >= QgsGeometryCheckPrecision::reducedTolerance() &&
+           reachesBorder( gap->boundingBox(), ownerRegion ) )
+      {
+        QgsGeometryCheckError* error = createGapError( gap, features );
+        if ( error )
+        {
+          errors.append( error );
+        }
+      }
+      break;
+    }
+  }
+  qDeleteAll( completedGaps );
 }
 
 void QgsGeometryGapCheck::fixError( QgsGeometryCheckError* error, int method, int /*mergeAttributeIndex*/, Changes &changes ) const
@@ -10,6 +10,7 @@
 
 #include "qgsgeometrycheck.h"
 
+class QgsFeatureTiles;
 
 class QgsGeometryGapCheckError : public QgsGeometryCheckError
 {
@@ -88,9 +89,35 @@ class QgsGeometryGapCheck : public QgsGeometryCheck
   private:
     enum ResolutionMethod { MergeLongestEdge, NoChange };
 
+    struct GapTile
+    {
+      int index;
+      QList<QgsGeometryCheckError*> errors;
+      QStringList messages;
+      //! Gap pieces which reach the border of the tile halo, completed by stitchBorderGaps
+      QList<QgsAbstractGeometryV2*> borderGaps;
+    };
+
+    class CollectTileWrapper
+    {
+      public:
+        CollectTileWrapper( const QgsGeometryGapCheck* instance, const QgsFeatureIds& featureIds, const QgsFeatureTiles& tiles, double halo )
+            : mInstance( instance ), mFeatureIds( featureIds ), mTiles( tiles ), mHalo( halo ) {}
+        void operator()( GapTile& tile ) { mInstance->collectTileErrors( tile, mFeatureIds, mTiles, mHalo ); }
+      private:
+        const QgsGeometryGapCheck* mInstance;
+        const QgsFeatureIds& mFeatureIds;
+        const QgsFeatureTiles& mTiles;
+        double mHalo;
+    };
+
     double mThreshold;
 
     bool mergeWithNeighbor( QgsGeometryGapCheckError *err, Changes &changes , QString &errMsg ) const;
+    bool computeGaps( const QgsRectangle& region, const QgsFeatureIds& featureIds, QList<QgsAbstractGeometryV2*>& gaps, QHash<QgsFeatureId, QgsFeature>& features, QString& errMsg ) const;
+    QgsGeometryCheckError* createGapError( QgsAbstractGeometryV2* gap, const QHash<QgsFeatureId, QgsFeature>& features ) const;
+    void collectTileErrors( GapTile& tile, const QgsFeatureIds& featureIds, const QgsFeatureTiles& tiles, double halo ) const;
+    void stitchBorderGaps( const QList<QgsAbstractGeometryV2*>& borderGaps, const QgsFeatureIds& featureIds, const QgsFeatureTiles& tiles, double halo, QList<QgsGeometryCheckError*>& errors, QStringList& messages ) const;
 };
 
 #endif // QGS_GEOMETRY_GAP_CHECK_H
@@ -8,40 +8,86 @@
 #include "qgsgeometryengine.h"
 #include "qgsgeometryoverlapcheck.h"
 #include "../utils/qgsfeaturepool.h"
+#include "../utils/qgsfeaturetiles.h"
+
+#include <QtConcurrentMap>
 
 void QgsGeometryOverlapCheck::collectErrors( QList<QgsGeometryCheckError*>& errors, QStringList &messages, QAtomicInt* progressCounter , const QgsFeatureIds &ids ) const
 {
   const QgsFeatureIds& featureIds = ids.isEmpty() ? mFeaturePool->getFeatureIds() : ids;
-  Q_FOREACH ( const QgsFeatureId& featureid, featureIds )
+  QgsRectangle extent = mFeaturePool->getExtent( ids );
+  if ( featureIds.isEmpty() || extent.isNull() )
   {
-    if ( progressCounter ) progressCounter->fetchAndAddRelaxed( 1 );
-    QgsFeature feature;
-    if ( !mFeaturePool->get( featureid, feature ) )
+    return;
+  }
+
+  // Check the features tile by tile, each feature with the tile containing the center of its bounding box
+  QgsFeatureTiles tiles( extent, featureIds.size() );
+  QList<OverlapTile> tileList;
+  for ( int i = 0, n = tiles.count(); i < n; ++i )
+  {
+    OverlapTile tile;
+    tile.index = i;
+    tileList.append( tile );
+  }
+  QtConcurrent::blockingMap( tileList, CollectTileWrapper( this, featureIds, tiles, progressCounter ) );
+
+  Q_FOREACH ( const OverlapTile& tile, tileList )
+  {
+    errors.append( tile.errors );
+    messages.append( tile.messages );
+  }
+}
+
+void QgsGeometryOverlapCheck::collectTileErrors( OverlapTile& tile, const QgsFeatureIds& featureIds, const QgsFeatureTiles& tiles, QAtomicInt* progressCounter ) const
+{
+  // Fetch the features of the tile and the features they may overlap at once,
+  // they are only accessed through this cache afterwards
+  QgsFeatureIds tileIds = mFeaturePool->getIntersects( tiles.tile( tile.index ) );
+  tileIds.intersect( featureIds );
+  QHash<QgsFeatureId, QgsFeature> features;
+  mFeaturePool->getFeatures( tileIds, features );
+
+  QMap<QgsFeatureId, QgsFeatureIds> candidateIds;
+  QgsFeatureIds otherIds;
+  Q_FOREACH ( const QgsFeature& feature, features )
+  {
+    if ( !feature.constGeometry() )
     {
       continue;
     }
-    QgsAbstractGeometryV2* geom = feature.geometry()->geometry();
+    QgsRectangle bbox = feature.constGeometry()->boundingBox();
+    if ( tiles.tileAt( bbox.center() ) == tile.index )
+    {
+      QgsFeatureIds ids = mFeaturePool->getIntersects( bbox );
+      candidateIds.insert( feature.id(), ids );
+      otherIds.unite( ids );
+    }
+  }
+  otherIds.subtract( QgsFeatureIds::fromList( features.keys() ) );
+  mFeaturePool->getFeatures( otherIds, features );
+
+  for ( QMap<QgsFeatureId, QgsFeatureIds>::const_iterator it = candidateIds.constBegin(); it != candidateIds.constEnd(); ++it )
+  {
+    if ( progressCounter ) progressCounter->fetchAndAddRelaxed( 1 );
+    const QgsFeatureId& featureid = it.key();
+    const QgsFeature& feature = features[featureid];
+    QgsAbstractGeometryV2* geom = feature.constGeometry()->geometry();
     QgsGeometryEngine* geomEngine = QgsGeomUtils::createGeomEngine( geom, QgsGeometryCheckPrecision::tolerance() );
 
-    QgsFeatureIds ids = mFeaturePool->getIntersects( feature.geometry()->boundingBox() );
-    Q_FOREACH ( const QgsFeatureId& otherid, ids )
+    Q_FOREACH ( const QgsFeatureId& otherid, it.value() )
     {
       // >= : only report overlaps once
-      if ( otherid >= featureid )
-      {
-        continue;
-      }
-
-      QgsFeature otherFeature;
-      if ( !mFeaturePool->get( otherid, otherFeature ) )
+      if ( otherid >= featureid || !features.contains( otherid ) || !features[otherid].constGeometry() )
       {
         continue;
       }
 
+      const QgsFeature& otherFeature = features[otherid];
       QString errMsg;
-      if ( geomEngine->overlaps( *otherFeature.geometry()->geometry(), &errMsg ) )
+      if ( geomEngine->overlaps( *otherFeature.constGeometry()->geometry(), &errMsg ) )
       {
-        QgsAbstractGeometryV2* interGeom = geomEngine->intersection( *otherFeature.geometry()->geometry() );
+        QgsAbstractGeometryV2* interGeom = geomEngine->intersection( *otherFeature.constGeometry()->geometry() );
         if ( interGeom && !interGeom->isEmpty() )
         {
           QgsGeomUtils::filter1DTypes( interGeom );
@@ -50,13 +96,13 @@ void QgsGeometryOverlapCheck::collectErrors( QList<QgsGeometryCheckError*>& erro
             double area = QgsGeomUtils::getGeomPart( interGeom, iPart )->area();
             if ( area > QgsGeometryCheckPrecision::reducedTolerance() && area < mThreshold )
             {
-              errors.append( new QgsGeometryOverlapCheckError( this, featureid, QgsGeomUtils::getGeomPart( interGeom, iPart )->centroid(), area, otherid ) );
+              tile.errors.append( new QgsGeometryOverlapCheckError( this, featureid, QgsGeomUtils::getGeomPart( interGeom, iPart )->centroid(), area, otherid ) );
             }
           }
         }
         else if ( !errMsg.isEmpty() )
         {
-          messages.append( tr( "Overlap check between features %1 and %2: %3" ).arg( feature.id() ).arg( otherFeature.id() ).arg( errMsg ) );
+          tile.messages.append( tr( "Overlap check between features %1 and %2: %3" ).arg( feature.id() ).arg( otherFeature.id() ).arg( errMsg ) );
         }
         delete interGeom;
       }
@@ -10,6 +10,8 @@
 
 #include "qgsgeometrycheck.h"
 
+class QgsFeatureTiles;
+
 class QgsGeometryOverlapCheckError : public QgsGeometryCheckError
 {
   public:
@@ -57,7 +59,30 @@ class QgsGeometryOverlapCheck : public QgsGeometryCheck
     QString errorName() const override { return "QgsGeometryOverlapCheck"; }
   private:
     enum ResolutionMethod { Subtract, NoChange };
+
+    struct OverlapTile
+    {
+      int index;
+      QList<QgsGeometryCheckError*> errors;
+      QStringList messages;
+    };
+
+    class CollectTileWrapper
+    {
+      public:
+        CollectTileWrapper( const QgsGeometryOverlapCheck* instance, const QgsFeatureIds& featureIds, const QgsFeatureTiles& tiles, QAtomicInt* progressCounter )
+            : mInstance( instance ), mFeatureIds( featureIds ), mTiles( tiles ), mProgressCounter( progressCounter ) {}
+        void operator()( OverlapTile& tile ) { mInstance->collectTileErrors( tile, mFeatureIds, mTiles, mProgressCounter ); }
+      private:
+        const QgsGeometryOverlapCheck* mInstance;
+        const QgsFeatureIds& mFeatureIds;
+        const QgsFeatureTiles& mTiles;
+        QAtomicInt* mProgressCounter;
+    };
+
     double mThreshold;
+
+    void collectTileErrors( OverlapTile& tile, const QgsFeatureIds& featureIds, const QgsFeatureTiles& tiles, QAtomicInt* progressCounter ) const;
 };
 
 #endif // QGS_GEOMETRY_OVERLAP_CHECK_H
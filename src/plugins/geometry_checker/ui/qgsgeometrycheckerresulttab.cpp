@@ -498,6 +498,12 @@ void QgsGeometryCheckerResultTab::fixErrors( bool prompt )
     unsetCursor();
   }
 
+  /** Write the fixed features to the layer at once **/
+  if ( !mFeaturePool->commitChanges() )
+  {
+    QMessageBox::critical( this, tr( "Fix errors" ), tr( "Failed to write the fixed features to the layer." ) );
+  }
+
   mIface->mapCanvas()->refresh();
 
   if ( mStatistics.itemCount() > 0 )
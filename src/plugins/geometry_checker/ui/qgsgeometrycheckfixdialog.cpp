@@ -20,6 +20,7 @@
 #include "qgsmapcanvas.h"
 #include "../qgsgeometrychecker.h"
 #include "../checks/qgsgeometrycheck.h"
+#include "../utils/qgsfeaturepool.h"
 #include <QButtonGroup>
 #include <QDialogButtonBox>
 #include <QGroupBox>
@@ -122,11 +123,17 @@ void QgsGeometryCheckerFixDialog::fixError()
 
   QgsGeometryCheckError* error = mErrors.first();
   mChecker->fixError( error, mRadioGroup->checkedId() );
+  // Write the fix to the layer right away so that the canvas shows it
+  bool committed = error->check()->getFeaturePool()->commitChanges();
 
   unsetCursor();
 
   mStatusLabel->setText( error->resolutionMessage() );
-  if ( error->status() == QgsGeometryCheckError::StatusFixed )
+  if ( !committed )
+  {
+    mStatusLabel->setText( tr( "<span color=\"red\"><b>Failed to write the fixed features to the layer</b></span>" ) );
+  }
+  else if ( error->status() == QgsGeometryCheckError::StatusFixed )
   {
     mStatusLabel->setText( tr( "<b>Fixed:</b> %1" ).arg( error->resolutionMessage() ) );
   }
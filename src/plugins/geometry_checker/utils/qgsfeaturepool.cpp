@@ -22,11 +22,267 @@
 #include "qgsgeomutils.h"
 
 #include <QMutexLocker>
+#include <QReadLocker>
+#include <QWriteLocker>
 #include <qmath.h>
+#include <algorithm>
+#include <cmath>
 #include <limits>
 
+namespace
+{
+  template<class T> bool centerXLessThan( const T& a, const T& b )
+  {
+    return a.bbox.xMinimum() + a.bbox.xMaximum() < b.bbox.xMinimum() + b.bbox.xMaximum();
+  }
+
+  template<class T> bool centerYLessThan( const T& a, const T& b )
+  {
+    return a.bbox.yMinimum() + a.bbox.yMaximum() < b.bbox.yMinimum() + b.bbox.yMaximum();
+  }
+
+  // Sort-tile-recursive order: vertical slices of items sorted by x, each sorted by y,
+  // so that runs of capacity items cover compact areas also for clustered data
+  template<class T> void strSort( QVector<T>& items, int capacity )
+  {
+    int nodeCount = ( items.size() + capacity - 1 ) / capacity;
+    int sliceSize = qMax( 1, qCeil( qSqrt( nodeCount ) ) ) * capacity;
+    std::sort( items.begin(), items.end(), centerXLessThan<T> );
+    for ( int i = 0; i < items.size(); i += sliceSize )
+    {
+      std::sort( items.begin() + i, items.begin() + qMin( i + sliceSize, items.size() ), centerYLessThan<T> );
+    }
+  }
+
+  // Creates a node for each run of capacity items
+  template<class T, class N> void packNodes( const QVector<T>& items, int capacity, QVector<N>& nodes )
+  {
+    for ( int i = 0; i < items.size(); i += capacity )
+    {
+      N node;
+      node.first = i;
+      node.count = qMin( capacity, items.size() - i );
+      node.bbox = items[i].bbox;
+      for ( int j = i + 1; j < i + node.count; ++j )
+      {
+        node.bbox.unionRect( items[j].bbox );
+      }
+      nodes.append( node );
+    }
+  }
+}
+
+QgsFeaturePool::IndexSnapshot::IndexSnapshot( const QHash<QgsFeatureId, QgsRectangle>& bboxes )
+    : mBBoxes( bboxes )
+{
+  if ( mBBoxes.isEmpty() )
+  {
+    return;
+  }
+
+  mEntries.reserve( mBBoxes.size() );
+  for ( QHash<QgsFeatureId, QgsRectangle>::const_iterator it = mBBoxes.constBegin(); it != mBBoxes.constEnd(); ++it )
+  {
+    Entry entry;
+    entry.bbox = it.value();
+    entry.id = it.key();
+    mEntries.append( entry );
+  }
+
+  // Bulk load the tree bottom up, the nodes of a level are sorted before their parents are created
+  strSort( mEntries, sNodeCapacity );
+  QVector<Node> level;
+  packNodes( mEntries, sNodeCapacity, level );
+  while ( level.size() > sNodeCapacity )
+  {
+    strSort( level, sNodeCapacity );
+    mLevels.append( level );
+    QVector<Node> parents;
+    packNodes( level, sNodeCapacity, parents );
+    level = parents;
+  }
+  mLevels.append( level );
+}
+
+QgsFeatureIds QgsFeaturePool::IndexSnapshot::intersects( const QgsRectangle& rect ) const
+{
+  QgsFeatureIds ids;
+  if ( mLevels.isEmpty() )
+  {
+    return ids;
+  }
+
+  // Nodes to visit as (level, index) pairs, starting with the root level
+  QVector< QPair<int, int> > stack;
+  int topLevel = mLevels.size() - 1;
+  for ( int i = 0, n = mLevels[topLevel].size(); i < n; ++i )
+  {
+    stack.append( qMakePair( topLevel, i ) );
+  }
+  while ( !stack.isEmpty() )
+  {
+    QPair<int, int> item = stack.last();
+    stack.resize( stack.size() - 1 );
+
+    const Node& node = mLevels[item.first][item.second];
+    if ( !node.bbox.intersects( rect ) )
+    {
+      continue;
+    }
+    for ( int i = node.first, end = node.first + node.count; i < end; ++i )
+    {
+      if ( item.first > 0 )
+      {
+        stack.append( qMakePair( item.first - 1, i ) );
+      }
+      else if ( mEntries[i].bbox.intersects( rect ) )
+      {
+        ids.insert( mEntries[i].id );
+      }
+    }
+  }
+  return ids;
+}
+
+void QgsFeaturePool::PendingIndex::insert( const QgsFeatureId& id, const QgsRectangle& bbox )
+{
+  QHash<QgsFeatureId, QgsRectangle>::iterator it = mBBoxes.find( id );
+  if ( it != mBBoxes.end() )
+  {
+    remove( id, it.value() );
+  }
+  mBBoxes.insert( id, bbox );
+  if ( bbox.isNull() )
+  {
+    return;
+  }
+
+  int x0, y0, x1, y1;
+  if ( !cellRange( bbox, x0, y0, x1, y1 ) )
+  {
+    mLargeIds.insert( id );
+    return;
+  }
+  for ( int x = x0; x <= x1; ++x )
+  {
+    for ( int y = y0; y <= y1; ++y )
+    {
+      mCells[qMakePair( x, y )].insert( id );
+    }
+  }
+}
+
+void QgsFeaturePool::PendingIndex::remove( const QgsFeatureId& id, const QgsRectangle& bbox )
+{
+  if ( bbox.isNull() )
+  {
+    return;
+  }
+  int x0, y0, x1, y1;
+  if ( !cellRange( bbox, x0, y0, x1, y1 ) )
+  {
+    mLargeIds.remove( id );
+    return;
+  }
+  for ( int x = x0; x <= x1; ++x )
+  {
+    for ( int y = y0; y <= y1; ++y )
+    {
+      QHash<Cell, QgsFeatureIds>::iterator cellIt = mCells.find( qMakePair( x, y ) );
+      if ( cellIt != mCells.end() )
+      {
+        cellIt.value().remove( id );
+        if ( cellIt.value().isEmpty() )
+        {
+          mCells.erase( cellIt );
+        }
+      }
+    }
+  }
+}
+
+QgsFeatureIds QgsFeaturePool::PendingIndex::intersects( const QgsRectangle& rect ) const
+{
+  QgsFeatureIds ids;
+  if ( mBBoxes.isEmpty() )
+  {
+    return ids;
+  }
+
+  int x0, y0, x1, y1;
+  if ( cellRange( rect, x0, y0, x1, y1 ) )
+  {
+    for ( int x = x0; x <= x1; ++x )
+    {
+      for ( int y = y0; y <= y1; ++y )
+      {
+        QHash<Cell, QgsFeatureIds>::const_iterator cellIt = mCells.constFind( qMakePair( x, y ) );
+        if ( cellIt == mCells.constEnd() )
+        {
+          continue;
+        }
+        Q_FOREACH ( const QgsFeatureId& id, cellIt.value() )
+        {
+          if ( mBBoxes.value( id ).intersects( rect ) )
+          {
+            ids.insert( id );
+          }
+        }
+      }
+    }
+  }
+  else
+  {
+    // The query covers a large part of the grid
+    for ( QHash<Cell, QgsFeatureIds>::const_iterator cellIt = mCells.constBegin(); cellIt != mCells.constEnd(); ++cellIt )
+    {
+      Q_FOREACH ( const QgsFeatureId& id, cellIt.value() )
+      {
+        if ( mBBoxes.value( id ).intersects( rect ) )
+        {
+          ids.insert( id );
+        }
+      }
+    }
+  }
+  Q_FOREACH ( const QgsFeatureId& id, mLargeIds )
+  {
+    if ( mBBoxes.value( id ).intersects( rect ) )
+    {
+      ids.insert( id );
+    }
+  }
+  return ids;
+}
+
+void QgsFeaturePool::PendingIndex::clear()
+{
+  mBBoxes.clear();
+  mCells.clear();
+  mLargeIds.clear();
+}
+
+bool QgsFeaturePool::PendingIndex::cellRange( const QgsRectangle& rect, int& x0, int& y0, int& x1, int& y1 ) const
+{
+  double fx0 = std::floor( rect.xMinimum() / mCellSize );
+  double fy0 = std::floor( rect.yMinimum() / mCellSize );
+  double fx1 = std::floor( rect.xMaximum() / mCellSize );
+  double fy1 = std::floor( rect.yMaximum() / mCellSize );
+  // Also rejects cell numbers out of the int range
+  if ( !( ( fx1 - fx0 + 1 ) * ( fy1 - fy0 + 1 ) <= sMaxCellsPerBBox ) ||
+       qAbs( fx0 ) > std::numeric_limits<int>::max() / 2 || qAbs( fy0 ) > std::numeric_limits<int>::max() / 2 )
+  {
+    return false;
+  }
+  x0 = static_cast<int>( fx0 );
+  y0 = static_cast<int>( fy0 );
+  x1 = static_cast<int>( fx1 );
+  y1 = static_cast<int>( fy1 );
+  return true;
+}
+
 QgsFeaturePool::QgsFeaturePool( QgsVectorLayer *layer, bool selectedOnly )
-    : mFeatureCache( sCacheSize ), mLayer( layer ), mSelectedOnly( selectedOnly )
+    : mLayer( layer ), mSelectedOnly( selectedOnly )
 {
   if ( selectedOnly )
   {
@@ -38,36 +294,187 @@ QgsFeaturePool::QgsFeaturePool( QgsVectorLayer *layer, bool selectedOnly )
   }
 
   // Build spatial index
+  mExtent.setMinimal();
+  QgsRectangle layerExtent;
+  layerExtent.setMinimal();
+  QHash<QgsFeatureId, QgsRectangle> bboxes;
   QgsFeature feature;
   QgsFeatureRequest req;
   req.setSubsetOfAttributes( QgsAttributeList() );
   QgsFeatureIterator it = layer->getFeatures( req );
   while ( it.nextFeature( feature ) )
   {
-    mIndex.insertFeature( feature );
+    if ( !feature.constGeometry() )
+    {
+      continue;
+    }
+    QgsRectangle bbox = feature.constGeometry()->boundingBox();
+    bboxes.insert( feature.id(), bbox );
+    layerExtent.unionRect( bbox );
+    if ( mFeatureIds.contains( feature.id() ) )
+    {
+      mExtent.unionRect( bbox );
+    }
+  }
+  mIndex = QSharedPointer<const IndexSnapshot>( new IndexSnapshot( bboxes ) );
+
+  // Grid of 128 x 128 cells over the layer for the changed bounding boxes
+  double cellSize = qMax( layerExtent.width(), layerExtent.height() ) / 128.;
+  if ( !bboxes.isEmpty() && cellSize > 0 )
+  {
+    mPendingIndex.setCellSize( cellSize );
   }
 }
 
+QgsFeaturePool::~QgsFeaturePool()
+{
+  if ( mLayer )
+  {
+    commitChanges();
+  }
+}
+
+QSharedPointer<const QgsFeaturePool::IndexSnapshot> QgsFeaturePool::indexSnapshot()
+{
+  QReadLocker lock( &mIndexLock );
+  return mIndex;
+}
+
 bool QgsFeaturePool::get( const QgsFeatureId& id , QgsFeature& feature )
 {
-  QMutexLocker lock( &mLayerMutex );
-  QgsFeature* pfeature = mFeatureCache.object( id );
-  if ( pfeature == 0 )
+  // Pending changes
   {
-    // Get new feature
-    pfeature = new QgsFeature();
-    // TODO: avoid always querying all attributes (attribute values are needed when merging by attribute)
-    if ( !mLayer->getFeatures( QgsFeatureRequest( id ) ).nextFeature( *pfeature ) )
+    QReadLocker lock( &mChangesLock );
+    if ( mDeletedIds.contains( id ) )
     {
-      delete pfeature;
       return false;
     }
-    mFeatureCache.insert( id, pfeature );
+    QHash<QgsFeatureId, QgsFeature>::const_iterator it = mChangedFeatures.constFind( id );
+    if ( it != mChangedFeatures.constEnd() )
+    {
+      feature = it.value();
+      return true;
+    }
+  }
+
+  if ( getCached( id, feature ) )
+  {
+    return true;
+  }
+
+  // Fetch the feature together with the uncached features around it
+  QgsFeatureIds fetchIds;
+  fetchIds.insert( id );
+  QSharedPointer<const IndexSnapshot> index = indexSnapshot();
+  QHash<QgsFeatureId, QgsRectangle>::const_iterator bboxIt = index->bboxes().constFind( id );
+  if ( bboxIt != index->bboxes().constEnd() )
+  {
+    Q_FOREACH ( const QgsFeatureId& neighborId, index->intersects( bboxIt.value() ) )
+    {
+      if ( fetchIds.size() >= sPrefetchSize )
+      {
+        break;
+      }
+      CacheShard& shard = cacheShard( neighborId );
+      QReadLocker lock( &shard.lock );
+      if ( !shard.features.contains( neighborId ) )
+      {
+        fetchIds.insert( neighborId );
+      }
+    }
+  }
+  fetchIntoCache( fetchIds );
+  return getCached( id, feature );
+}
+
+bool QgsFeaturePool::getCached( const QgsFeatureId& id, QgsFeature& feature )
+{
+  CacheShard& shard = cacheShard( id );
+  QReadLocker lock( &shard.lock );
+  QHash<QgsFeatureId, QgsFeature>::const_iterator it = shard.features.constFind( id );
+  if ( it == shard.features.constEnd() )
+  {
+    return false;
   }
-  feature = *pfeature;
+  feature = it.value();
   return true;
 }
 
+void QgsFeaturePool::fetchIntoCache( const QgsFeatureIds& ids )
+{
+  // TODO: avoid always querying all attributes (attribute values are needed when merging by attribute)
+  QgsFeatureList features;
+  {
+    QMutexLocker lock( &mLayerMutex );
+    if ( !mLayer )
+    {
+      return;
+    }
+    QgsFeatureIterator it = mLayer->getFeatures( QgsFeatureRequest().setFilterFids( ids ) );
+    QgsFeature feature;
+    while ( it.nextFeature( feature ) )
+    {
+      features.append( feature );
+    }
+  }
+
+  Q_FOREACH ( const QgsFeature& feature, features )
+  {
+    CacheShard& shard = cacheShard( feature.id() );
+    QWriteLocker lock( &shard.lock );
+    if ( shard.features.contains( feature.id() ) )
+    {
+      continue;
+    }
+    shard.features.insert( feature.id(), feature );
+    shard.age.enqueue( feature.id() );
+    while ( shard.age.size() > sShardCacheSize )
+    {
+      shard.features.remove( shard.age.dequeue() );
+    }
+  }
+}
+
+void QgsFeaturePool::applyChanges( QHash<QgsFeatureId, QgsFeature>& features )
+{
+  QReadLocker lock( &mChangesLock );
+  Q_FOREACH ( const QgsFeatureId& id, mDeletedIds )
+  {
+    features.remove( id );
+  }
+  for ( QHash<QgsFeatureId, QgsFeature>::iterator it = features.begin(); it != features.end(); ++it )
+  {
+    QHash<QgsFeatureId, QgsFeature>::const_iterator changedIt = mChangedFeatures.constFind( it.key() );
+    if ( changedIt != mChangedFeatures.constEnd() )
+    {
+      it.value() = changedIt.value();
+    }
+  }
+}
+
+void QgsFeaturePool::getFeatures( const QgsFeatureIds& ids, QHash<QgsFeatureId, QgsFeature>& features )
+{
+  if ( ids.isEmpty() || !mLayer )
+  {
+    return;
+  }
+  QgsFeatureRequest req;
+  req.setFilterFids( ids );
+  req.setSubsetOfAttributes( QgsAttributeList() );
+  QHash<QgsFeatureId, QgsFeature> fetched;
+  {
+    QMutexLocker lock( &mLayerMutex );
+    QgsFeatureIterator it = mLayer->getFeatures( req );
+    QgsFeature feature;
+    while ( it.nextFeature( feature ) )
+    {
+      fetched.insert( feature.id(), feature );
+    }
+  }
+  applyChanges( fetched );
+  features.unite( fetched );
+}
+
 void QgsFeaturePool::addFeature( QgsFeature& feature )
 {
   QgsFeatureList features;
@@ -82,46 +489,161 @@ void QgsFeaturePool::addFeature( QgsFeature& feature )
     mLayer->setSelectedFeatures( selectedFeatureIds );
   }
   mLayerMutex.unlock();
-  mIndexMutex.lock();
-  mIndex.insertFeature( feature );
-  mIndexMutex.unlock();
+  if ( feature.constGeometry() )
+  {
+    QWriteLocker lock( &mChangesLock );
+    mPendingIndex.insert( feature.id(), feature.constGeometry()->boundingBox() );
+    mExtent.unionRect( feature.constGeometry()->boundingBox() );
+  }
 }
 
 void QgsFeaturePool::updateFeature( QgsFeature& feature )
 {
-  QgsGeometryMap geometryMap;
-  geometryMap.insert( feature.id(), QgsGeometry( feature.geometry()->geometry()->clone() ) );
-  QgsChangedAttributesMap changedAttributesMap;
-  QgsAttributeMap attribMap;
-  for ( int i = 0, n = feature.attributes().size(); i < n; ++i )
+  QWriteLocker lock( &mChangesLock );
+  mChangedFeatures.insert( feature.id(), feature );
+  if ( feature.constGeometry() )
   {
-    attribMap.insert( i, feature.attributes().at( i ) );
+    mPendingIndex.insert( feature.id(), feature.constGeometry()->boundingBox() );
+    mExtent.unionRect( feature.constGeometry()->boundingBox() );
+  }
+  else
+  {
+    mPendingIndex.insert( feature.id(), QgsRectangle() );
   }
-  changedAttributesMap.insert( feature.id(), attribMap );
-  mLayerMutex.lock();
-  mFeatureCache.remove( feature.id() ); // Remove to force reload on next get()
-  mLayer->dataProvider()->changeGeometryValues( geometryMap );
-  mLayer->dataProvider()->changeAttributeValues( changedAttributesMap );
-  mLayerMutex.unlock();
-  mIndexMutex.lock();
-  mIndex.deleteFeature( feature );
-  mIndex.insertFeature( feature );
-  mIndexMutex.unlock();
 }
 
 void QgsFeaturePool::deleteFeature( QgsFeature& feature )
 {
-  mIndexMutex.lock();
-  mIndex.deleteFeature( feature );
-  mIndexMutex.unlock();
-  mLayerMutex.lock();
-  mFeatureCache.remove( feature.id() );
-  mLayer->dataProvider()->deleteFeatures( QgsFeatureIds() << feature.id() );
-  mLayerMutex.unlock();
+  QWriteLocker lock( &mChangesLock );
+  mChangedFeatures.remove( feature.id() );
+  mPendingIndex.insert( feature.id(), QgsRectangle() );
+  mDeletedIds.insert( feature.id() );
+}
+
+bool QgsFeaturePool::commitChanges()
+{
+  QWriteLocker lock( &mChangesLock );
+  if ( mChangedFeatures.isEmpty() && mDeletedIds.isEmpty() )
+  {
+    return true;
+  }
+
+  bool success = true;
+  if ( mLayer )
+  {
+    QgsGeometryMap geometryMap;
+    QgsChangedAttributesMap changedAttributesMap;
+    Q_FOREACH ( const QgsFeature& feature, mChangedFeatures )
+    {
+      if ( feature.constGeometry() )
+      {
+        geometryMap.insert( feature.id(), QgsGeometry( feature.constGeometry()->geometry()->clone() ) );
+      }
+      QgsAttributeMap attribMap;
+      for ( int i = 0, n = feature.attributes().size(); i < n; ++i )
+      {
+        attribMap.insert( i, feature.attributes().at( i ) );
+      }
+      changedAttributesMap.insert( feature.id(), attribMap );
+    }
+
+    QMutexLocker layerLock( &mLayerMutex );
+    if ( !geometryMap.isEmpty() )
+    {
+      success &= mLayer->dataProvider()->changeGeometryValues( geometryMap );
+    }
+    if ( !changedAttributesMap.isEmpty() )
+    {
+      success &= mLayer->dataProvider()->changeAttributeValues( changedAttributesMap );
+    }
+    if ( !mDeletedIds.isEmpty() )
+    {
+      success &= mLayer->dataProvider()->deleteFeatures( mDeletedIds );
+    }
+  }
+
+  // Committed features are cached as they are now
+  for ( QHash<QgsFeatureId, QgsFeature>::const_iterator it = mChangedFeatures.constBegin(); it != mChangedFeatures.constEnd(); ++it )
+  {
+    CacheShard& shard = cacheShard( it.key() );
+    QWriteLocker shardLock( &shard.lock );
+    if ( shard.features.contains( it.key() ) )
+    {
+      shard.features.insert( it.key(), it.value() );
+    }
+  }
+  Q_FOREACH ( const QgsFeatureId& id, mDeletedIds )
+  {
+    CacheShard& shard = cacheShard( id );
+    QWriteLocker shardLock( &shard.lock );
+    shard.features.remove( id );
+    shard.age.removeAll( id );
+  }
+
+  mChangedFeatures.clear();
+  mDeletedIds.clear();
+
+  // Replace the index snapshot once the grid of pending bounding boxes has grown large
+  if ( mPendingIndex.bboxes().size() > sMaxPendingBBoxes )
+  {
+    QHash<QgsFeatureId, QgsRectangle> bboxes = indexSnapshot()->bboxes();
+    const QHash<QgsFeatureId, QgsRectangle>& pending = mPendingIndex.bboxes();
+    for ( QHash<QgsFeatureId, QgsRectangle>::const_iterator it = pending.constBegin(); it != pending.constEnd(); ++it )
+    {
+      if ( it.value().isNull() )
+      {
+        bboxes.remove( it.key() );
+      }
+      else
+      {
+        bboxes.insert( it.key(), it.value() );
+      }
+    }
+    QSharedPointer<const IndexSnapshot> index( new IndexSnapshot( bboxes ) );
+    {
+      QWriteLocker indexLock( &mIndexLock );
+      mIndex = index;
+    }
+    mPendingIndex.clear();
+  }
+  return success;
 }
 
 QgsFeatureIds QgsFeaturePool::getIntersects( const QgsRectangle &rect )
 {
-  QMutexLocker lock( &mIndexMutex );
-  return QgsFeatureIds::fromList( mIndex.intersects( rect ) );
+  // The snapshot is taken under the changes lock, since it is replaced together with clearing the pending boxes
+  QReadLocker lock( &mChangesLock );
+  QgsFeatureIds ids;
+  Q_FOREACH ( const QgsFeatureId& id, indexSnapshot()->intersects( rect ) )
+  {
+    // Pending boxes replace the ones in the snapshot
+    if ( !mPendingIndex.contains( id ) )
+    {
+      ids.insert( id );
+    }
+  }
+  ids.unite( mPendingIndex.intersects( rect ) );
+  return ids;
+}
+
+QgsRectangle QgsFeaturePool::getExtent( const QgsFeatureIds& ids )
+{
+  if ( ids.isEmpty() )
+  {
+    QReadLocker lock( &mChangesLock );
+    return mExtent;
+  }
+
+  QHash<QgsFeatureId, QgsFeature> features;
+  getFeatures( ids, features );
+  QgsRectangle extent;
+  extent.setMinimal();
+  Q_FOREACH ( const QgsFeature& feature, features )
+  {
+    if ( feature.constGeometry() )
+    {
+      extent.unionRect( feature.constGeometry()->boundingBox() );
+    }
+  }
+  return extent;
 }
@@ -17,50 +17,154 @@
 #ifndef QGS_FEATUREPOOL_H
 #define QGS_FEATUREPOOL_H
 
-#include <QCache>
-#include <QLinkedList>
-#include <QMap>
+#include <QHash>
 #include <QMutex>
+#include <QQueue>
+#include <QReadWriteLock>
+#include <QSharedPointer>
+#include <QVector>
 #include "qgsfeature.h"
-#include "qgsspatialindex.h"
+#include "qgsrectangle.h"
 #include "qgsgeomutils.h"
 
 class QgsVectorLayer;
 
+/**
+ * @brief Feature access for the geometry checks, which run concurrently.
+ *
+ * Features are cached in shards with their own read-write lock, so that
+ * threads reading different features do not wait for each other. Cache misses
+ * are fetched from the layer in batches together with the neighbors of the
+ * feature, since checks mostly look at neighboring features next. Intersection
+ * queries use an immutable R-tree snapshot of the bounding boxes, and a grid of
+ * the bounding boxes changed since the snapshot was built. The snapshot is only
+ * rebuilt once the grid has grown large.
+ *
+ * Changed and deleted features are collected in a change list which is seen by
+ * all readers of the pool and only written to the layer by commitChanges().
+ * Added features are written immediately, since the layer assigns their id.
+ */
 class QgsFeaturePool
 {
   public:
     QgsFeaturePool( QgsVectorLayer* layer, bool selectedOnly = false );
+    //! Commits pending changes
+    ~QgsFeaturePool();
     bool get( const QgsFeatureId& id, QgsFeature& feature );
+    /**
+     * @brief Fetches the geometries of several features with a single layer request, bypassing the cache
+     * @param ids The ids of the features to fetch
+     * @param features Receives the features, without attributes
+     */
+    void getFeatures( const QgsFeatureIds& ids, QHash<QgsFeatureId, QgsFeature>& features );
     void addFeature( QgsFeature &feature );
     void updateFeature( QgsFeature &feature );
     void deleteFeature( QgsFeature &feature );
+    /**
+     * @brief Writes the changed and deleted features to the layer
+     * @return Whether the provider accepted all changes
+     */
+    bool commitChanges();
     QgsFeatureIds getIntersects( const QgsRectangle& rect );
+    /**
+     * @brief Returns the extent of the specified features, or of all features of the pool if none are specified
+     */
+    QgsRectangle getExtent( const QgsFeatureIds& ids = QgsFeatureIds() );
     QgsVectorLayer* getLayer() const { return mLayer; }
     const QgsFeatureIds& getFeatureIds() const { return mFeatureIds; }
     bool getSelectedOnly() const { return mSelectedOnly; }
     void clearLayer() { mLayer = 0; }
 
   private:
-    struct MapEntry
+    //! R-tree of feature bounding boxes, packed with sort-tile-recursive, never modified once built
+    class IndexSnapshot
     {
-      MapEntry( QgsFeature* _feature, QLinkedList<QgsFeatureId>::iterator _ageIt )
-          : feature( _feature ), ageIt( _ageIt ) {}
-      QgsFeature* feature;
-      QLinkedList<QgsFeatureId>::iterator ageIt;
+      public:
+        explicit IndexSnapshot( const QHash<QgsFeatureId, QgsRectangle>& bboxes );
+        const QHash<QgsFeatureId, QgsRectangle>& bboxes() const { return mBBoxes; }
+        QgsFeatureIds intersects( const QgsRectangle& rect ) const;
+
+      private:
+        struct Entry
+        {
+          QgsRectangle bbox;
+          QgsFeatureId id;
+        };
+        //! Node covering the entries (leaves) or the nodes of the level below from first to first + count - 1
+        struct Node
+        {
+          QgsRectangle bbox;
+          int first;
+          int count;
+        };
+
+        QHash<QgsFeatureId, QgsRectangle> mBBoxes;
+        QVector<Entry> mEntries;
+        //! Levels of nodes from the leaves to the root level
+        QVector< QVector<Node> > mLevels;
+    };
+
+    //! Uniform grid of the bounding boxes changed since the index snapshot was built, updated in place
+    class PendingIndex
+    {
+      public:
+        PendingIndex() : mCellSize( 1. ) {}
+        void setCellSize( double cellSize ) { mCellSize = cellSize; }
+        //! Sets the bounding box of a feature, a null rectangle for deleted features and features without geometry
+        void insert( const QgsFeatureId& id, const QgsRectangle& bbox );
+        bool contains( const QgsFeatureId& id ) const { return mBBoxes.contains( id ); }
+        const QHash<QgsFeatureId, QgsRectangle>& bboxes() const { return mBBoxes; }
+        QgsFeatureIds intersects( const QgsRectangle& rect ) const;
+        void clear();
+
+      private:
+        typedef QPair<int, int> Cell;
+
+        double mCellSize;
+        QHash<QgsFeatureId, QgsRectangle> mBBoxes;
+        QHash<Cell, QgsFeatureIds> mCells;
+        //! Boxes covering too many cells, checked one by one
+        QgsFeatureIds mLargeIds;
+
+        //! Returns the range of cells covered by rect, or false if there are too many of them
+        bool cellRange( const QgsRectangle& rect, int& x0, int& y0, int& x1, int& y1 ) const;
+        void remove( const QgsFeatureId& id, const QgsRectangle& bbox );
+    };
+
+    struct CacheShard
+    {
+      QReadWriteLock lock;
+      QHash<QgsFeatureId, QgsFeature> features;
+      //! Cached ids in insertion order, the oldest are evicted first
+      QQueue<QgsFeatureId> age;
     };
 
-    static const int sCacheSize = 1000;
+    static const int sNodeCapacity = 16;
+    static const int sShardCount = 16;
+    static const int sShardCacheSize = 1000;
+    static const int sPrefetchSize = 64;
+    static const int sMaxPendingBBoxes = 4096;
+    static const int sMaxCellsPerBBox = 64;
 
-    QCache<QgsFeatureId, QgsFeature> mFeatureCache;
+    CacheShard mCacheShards[sShardCount];
     QgsVectorLayer* mLayer;
     QgsFeatureIds mFeatureIds;
     QMutex mLayerMutex;
-    QMutex mIndexMutex;
-    QgsSpatialIndex mIndex;
+    QReadWriteLock mIndexLock;
+    QSharedPointer<const IndexSnapshot> mIndex;
+    QReadWriteLock mChangesLock;
+    QHash<QgsFeatureId, QgsFeature> mChangedFeatures;
+    //! Bounding boxes of changed, added and deleted features, not yet in the index snapshot
+    PendingIndex mPendingIndex;
+    QgsFeatureIds mDeletedIds;
+    QgsRectangle mExtent;
     bool mSelectedOnly;
 
-    bool getTouchingWithSharedEdge( QgsFeature &feature, QgsFeatureId &touchingId, const double& ( *comparator )( const double&, const double& ), double init );
+    CacheShard& cacheShard( const QgsFeatureId& id ) { return mCacheShards[( quint64 ) id % sShardCount]; }
+    QSharedPointer<const IndexSnapshot> indexSnapshot();
+    bool getCached( const QgsFeatureId& id, QgsFeature& feature );
+    void fetchIntoCache( const QgsFeatureIds& ids );
+    void applyChanges( QHash<QgsFeatureId, QgsFeature>& features );
 };
 
 #endif // QGS_FEATUREPOOL_H
@@ -0,0 +1,56 @@
+/***************************************************************************
+ *  qgsfeaturetiles.cpp                                                    *
+ *  -------------------                                                    *
+ *  copyright            : (C) 2015 by QGIS Development Team               *
+ *  email                : qgis-developer at lists dot osgeo dot org       *
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsfeaturetiles.h"
+
+#include <qmath.h>
+
+QgsFeatureTiles::QgsFeatureTiles( const QgsRectangle& extent, int featureCount )
+    : mExtent( extent ), mCols( 1 ), mRows( 1 )
+{
+  int nTiles = qMax( 1, ( featureCount + sFeaturesPerTile - 1 ) / sFeaturesPerTile );
+  double width = extent.width();
+  double height = extent.height();
+  if ( nTiles > 1 && width > 0 && height > 0 )
+  {
+    // Choose the number of columns and rows such that the tiles are roughly square
+    mCols = qBound( 1, qRound( qSqrt( nTiles * width / height ) ), nTiles );
+    mRows = qMax( 1, ( nTiles + mCols - 1 ) / mCols );
+  }
+  mTileWidth = width / mCols;
+  mTileHeight = height / mRows;
+}
+
+QgsRectangle QgsFeatureTiles::tile( int idx ) const
+{
+  int col = idx % mCols;
+  int row = idx / mCols;
+  double xMin = mExtent.xMinimum() + col * mTileWidth;
+  double yMin = mExtent.yMinimum() + row * mTileHeight;
+  // Let the last column and row end exactly on the extent
+  double xMax = col == mCols - 1 ? mExtent.xMaximum() : xMin + mTileWidth;
+  double yMax = row == mRows - 1 ? mExtent.yMaximum() : yMin + mTileHeight;
+  return QgsRectangle( xMin, yMin, xMax, yMax );
+}
+
+int QgsFeatureTiles::tileAt( const QgsPoint& point ) const
+{
+  int col = mTileWidth > 0 ? qFloor(( point.x() - mExtent.xMinimum() ) / mTileWidth ) : 0;
+  int row = mTileHeight > 0 ? qFloor(( point.y() - mExtent.yMinimum() ) / mTileHeight ) : 0;
+  col = qBound( 0, col, mCols - 1 );
+  row = qBound( 0, row, mRows - 1 );
+  return row * mCols + col;
+}
@@ -0,0 +1,58 @@
+/***************************************************************************
+ *  qgsfeaturetiles.h                                                      *
+ *  -------------------                                                    *
+ *  copyright            : (C) 2015 by QGIS Development Team               *
+ *  email                : qgis-developer at lists dot osgeo dot org       *
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGS_FEATURETILES_H
+#define QGS_FEATURETILES_H
+
+#include "qgsrectangle.h"
+
+/**
+ * @brief Regular grid of tiles over the extent of the checked features, used to
+ * split layer wide checks into pieces which can be processed independently
+ */
+class QgsFeatureTiles
+{
+  public:
+    /**
+     * @brief Creates a grid of roughly square tiles
+     * @param extent The extent of the features
+     * @param featureCount The number of features, determines the number of tiles
+     */
+    QgsFeatureTiles( const QgsRectangle& extent, int featureCount );
+
+    const QgsRectangle& extent() const { return mExtent; }
+    int count() const { return mCols * mRows; }
+    double tileWidth() const { return mTileWidth; }
+    double tileHeight() const { return mTileHeight; }
+    QgsRectangle tile( int idx ) const;
+
+    /**
+     * @brief Returns the index of the tile containing the point. Points on the
+     * border of two tiles belong to a single one of them.
+     */
+    int tileAt( const QgsPoint& point ) const;
+
+  private:
+    static const int sFeaturesPerTile = 1000;
+
+    QgsRectangle mExtent;
+    int mCols;
+    int mRows;
+    double mTileWidth;
+    double mTileHeight;
+};
+
+#endif // QGS_FEATURETILES_H
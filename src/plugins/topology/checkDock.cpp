@@ -351,39 +351,44 @@ void checkDock::runTests( ValidateType type )
 
     connect( &progress, SIGNAL( canceled() ), mTest, SLOT( setTestCancelled() ) );
     connect( mTest, SIGNAL( progress( int ) ), &progress, SLOT( setValue( int ) ) );
-    // run the test
+    connect( mTest, SIGNAL( errorsFound( ErrorList ) ), this, SLOT( addErrors( ErrorList ) ) );
+    // run the test, the errors are added while it is running
+    mTest->runTest( testName, layer1, layer2, type, toleranceStr.toDouble() );
 
-    ErrorList errors = mTest->runTest( testName, layer1, layer2, type, toleranceStr.toDouble() );
+    disconnect( &progress, SIGNAL( canceled() ), mTest, SLOT( setTestCancelled() ) );
+    disconnect( mTest, SIGNAL( progress( int ) ), &progress, SLOT( setValue( int ) ) );
+    disconnect( mTest, SIGNAL( errorsFound( ErrorList ) ), this, SLOT( addErrors( ErrorList ) ) );
+  }
+  mToggleRubberband->setChecked( true );
+  mErrorListModel->resetModel();
+}
 
-    QList<TopolError*>::Iterator it;
+void checkDock::addErrors( const ErrorList& errors )
+{
+  QList<TopolError*>::ConstIterator it;
 
-    QgsRubberBand* rb = 0;
-    for ( it = errors.begin(); it != errors.end(); ++it )
+  QgsRubberBand* rb = 0;
+  for ( it = errors.constBegin(); it != errors.constEnd(); ++it )
+  {
+    TopolError* te = *it;
+    if ( te->conflict()->type() == QGis::Polygon )
     {
-      TopolError* te = *it;
-      te->conflict();
-
-      QSettings settings;
-      if ( te->conflict()->type() == QGis::Polygon )
-      {
-        rb = new QgsRubberBand( qgsInterface->mapCanvas(), QGis::Polygon );
-      }
-      else
-      {
-        rb = new QgsRubberBand( qgsInterface->mapCanvas(), te->conflict()->type() );
-      }
-      rb->setColor( "red" );
-      rb->setWidth( 4 );
-      rb->setToGeometry( te->conflict(), layer1 );
-      rb->show();
-      mRbErrorMarkers << rb;
+      rb = new QgsRubberBand( qgsInterface->mapCanvas(), QGis::Polygon );
     }
-    disconnect( &progress, SIGNAL( canceled() ), mTest, SLOT( setTestCancelled() ) );
-    disconnect( mTest, SIGNAL( progress( int ) ), &progress, SLOT( setValue( int ) ) );
-    mErrorList << errors;
+    else
+    {
+      rb = new QgsRubberBand( qgsInterface->mapCanvas(), te->conflict()->type() );
+    }
+    rb->setColor( "red" );
+    rb->setWidth( 4 );
+    rb->setToGeometry( te->conflict(), te->featurePairs().first().layer );
+    rb->show();
+    mRbErrorMarkers << rb;
   }
-  mToggleRubberband->setChecked( true );
+  mErrorList << errors;
+
   mErrorListModel->resetModel();
+  mComment->setText( tr( "%1 errors were found" ).arg( mErrorList.count() ) );
 }
 
 void checkDock::validate( ValidateType type )
@@ -96,6 +96,11 @@ class checkDock : public QDockWidget, public Ui::checkDock
      * @param visible true if the window is visible
      */
     void updateRubberBands( bool visible );
+    /**
+     * Shows errors found by a running test
+     * @param errors new errors
+     */
+    void addErrors( const ErrorList& errors );
 
 
   private:
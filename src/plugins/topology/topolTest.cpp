@@ -30,7 +30,76 @@
 #include <set>
 #include <map>
 
+#include <QEventLoop>
+#include <QFutureWatcher>
+#include <QMutexLocker>
+#include <QPair>
+#include <QTimer>
+#include <QtConcurrentMap>
+
+static QList<const FeatureLayer*> featurePointers( const QList<FeatureLayer>& features )
+{
+  QList<const FeatureLayer*> pointers;
+  pointers.reserve( features.size() );
+  QList<FeatureLayer>::ConstIterator it;
+  for ( it = features.constBegin(); it != features.constEnd(); ++it )
+    pointers << &( *it );
+  return pointers;
+}
+
+static QList<const FeatureLayer*> featurePointers( const QMap<QgsFeatureId, FeatureLayer>& features )
+{
+  QList<const FeatureLayer*> pointers;
+  pointers.reserve( features.size() );
+  QMap<QgsFeatureId, FeatureLayer>::ConstIterator it;
+  for ( it = features.constBegin(); it != features.constEnd(); ++it )
+    pointers << &it.value();
+  return pointers;
+}
+
+// splits the extent in a grid of cells holding about featuresPerCell features
+static void gridSize( const QgsRectangle& extent, int featureCount, int featuresPerCell, int& cols, int& rows )
+{
+  int cells = qMax( 1, featureCount / featuresPerCell );
+  if ( extent.width() <= 0 && extent.height() <= 0 )
+  {
+    cols = 1;
+    rows = 1;
+  }
+  else if ( extent.height() <= 0 )
+  {
+    cols = cells;
+    rows = 1;
+  }
+  else if ( extent.width() <= 0 )
+  {
+    cols = 1;
+    rows = cells;
+  }
+  else
+  {
+    cols = qMax( 1, qRound( sqrt( cells * extent.width() / extent.height() ) ) );
+    rows = qMax( 1, qRound( double( cells ) / cols ) );
+  }
+}
+
+static int cellIndex( double coordinate, double origin, double cellSize, int cellCount )
+{
+  if ( cellSize <= 0 )
+    return 0;
+  return qBound( 0, ( int ) floor(( coordinate - origin ) / cellSize ), cellCount - 1 );
+}
+
+// whether the box reaches the border of the rectangle
+static bool reachesBorder( const QgsRectangle& box, const QgsRectangle& rect )
+{
+  double tolerance = 1E-9 * qMax( rect.width(), rect.height() );
+  return box.xMinimum() <= rect.xMinimum() + tolerance || box.xMaximum() >= rect.xMaximum() - tolerance ||
+         box.yMinimum() <= rect.yMinimum() + tolerance || box.yMaximum() >= rect.yMaximum() - tolerance;
+}
+
 topolTest::topolTest( QgisInterface* qgsIface )
+    : mReportedErrors( 0 )
 {
   theQgsInterface = qgsIface;
   mTestCancelled = false;
@@ -298,6 +367,8 @@ ErrorList topolTest::checkDanglingLines( double tolerance, QgsVectorLayer* layer
 
   QgsGeometry* canvasExtentPoly = QgsGeometry::fromWkt( theQgsInterface->mapCanvas()->extent().asWktPolygon() );
 
+  QList< QPair<QgsGeometry*, QgsFeatureId> > dangles;
+  QgsFeatureIds dangleIds;
 
   for ( std::multimap<QgsPoint, QgsFeatureId, PointComparer>::iterator pointIt = endVerticesMap.begin(), end = endVerticesMap.end(); pointIt != end; pointIt = endVerticesMap.upper_bound( pointIt->first ) )
   {
@@ -306,7 +377,6 @@ ErrorList topolTest::checkDanglingLines( double tolerance, QgsVectorLayer* layer
 
     size_t repetitions = endVerticesMap.count( p );
 
-    //QgsGeometry* extentPoly =
     if ( repetitions == 1 )
     {
 
@@ -320,133 +390,115 @@ ErrorList topolTest::checkDanglingLines( double tolerance, QgsVectorLayer* layer
         }
       }
 
-      QgsRectangle bBox = conflictGeom->boundingBox();
-      QgsFeature feat;
+      dangles << qMakePair( conflictGeom, k );
+      dangleIds << k;
+    }
+  }
+  delete canvasExtentPoly;
 
-      FeatureLayer ftrLayer1;
-      //need to fetch attributes?? being safe side by fetching..
-      layer1->getFeatures( QgsFeatureRequest().setFilterFid( k ) ).nextFeature( feat );
-      ftrLayer1.feature = feat;
-      ftrLayer1.layer = layer1;
+  //need to fetch attributes?? being safe side by fetching..
+  QHash<QgsFeatureId, QgsFeature> features = fetchFeatures( layer1, dangleIds );
 
-      QList<FeatureLayer> errorFtrLayers;
-      errorFtrLayers << ftrLayer1 << ftrLayer1;
+  for ( int d = 0; d < dangles.size(); ++d )
+  {
+    QgsGeometry* conflictGeom = dangles[d].first;
+    QgsRectangle bBox = conflictGeom->boundingBox();
 
-      TopolErrorDangle* err = new TopolErrorDangle( bBox, conflictGeom, errorFtrLayers );
-      errorList << err;
+    FeatureLayer ftrLayer1;
+    ftrLayer1.feature = features.value( dangles[d].second );
+    ftrLayer1.layer = layer1;
 
-    }
+    QList<FeatureLayer> errorFtrLayers;
+    errorFtrLayers << ftrLayer1 << ftrLayer1;
+
+    TopolErrorDangle* err = new TopolErrorDangle( bBox, conflictGeom, errorFtrLayers );
+    errorList << err;
   }
-  delete canvasExtentPoly;
   return errorList;
 }
 
 ErrorList topolTest::checkDuplicates( double tolerance, QgsVectorLayer *layer1, QgsVectorLayer *layer2, bool isExtent )
 {
   Q_UNUSED( tolerance );
-  Q_UNUSED( layer2 );
-  //TODO: multilines - check all separate pieces
-  int i = 0;
-  ErrorList errorList;
-
-  QList<QgsFeatureId> duplicateIds;
 
   QgsSpatialIndex* index = mLayerIndexes[layer1->id()];
+  if ( !index )
+  {
+    qDebug() << "no index present";
+    return ErrorList();
+  }
 
   QgsGeometry* canvasExtentPoly = QgsGeometry::fromWkt( theQgsInterface->mapCanvas()->extent().asWktPolygon() );
 
-  QMap<QgsFeatureId, FeatureLayer>::Iterator it;
-  QMap<QgsFeatureId, FeatureLayer>::ConstIterator FeatureListEnd = mFeatureMap2.end();
-  for ( it = mFeatureMap2.begin(); it != FeatureListEnd; ++it )
-  {
-    if ( !( ++i % 100 ) )
-      emit progress( i );
-
-    QgsFeatureId currentId = it->feature.id();
+  ErrorList errorList = runPartitioned( featurePointers( mFeatureMap2 ), &topolTest::testDuplicates,
+                                        TestContext( layer1, layer2, index, isExtent, canvasExtentPoly ) );
 
-    if ( duplicateIds.contains( currentId ) )
-    {
-      //is already a duplicate geometry..skip..
-      continue;
-    }
+  delete canvasExtentPoly;
+  return errorList;
+}
 
-    if ( testCancelled() )
-      break;
+ErrorList topolTest::testDuplicates( const FeatureLayer& feature, const QList<const FeatureLayer*>& candidates, const TestContext& context )
+{
+  //TODO: multilines - check all separate pieces
+  ErrorList errorList;
 
-    QgsGeometry* g1 = it->feature.geometry();
-    QgsRectangle bb = g1->boundingBox();
+  const QgsGeometry* g1 = feature.feature.constGeometry();
+  QgsRectangle bb = g1->boundingBox();
 
-    QList<QgsFeatureId> crossingIds;
-    crossingIds = index->intersects( bb );
+  QList<const FeatureLayer*> duplicates;
 
-    QList<QgsFeatureId>::Iterator cit = crossingIds.begin();
-    QList<QgsFeatureId>::ConstIterator crossingIdsEnd = crossingIds.end();
+  Q_FOREACH ( const FeatureLayer* candidate, candidates )
+  {
+    // skip itself
+    if ( candidate->feature.id() == feature.feature.id() )
+      continue;
 
-    bool duplicate = false;
+    const QgsGeometry* g2 = candidate->feature.constGeometry();
+    if ( !g2 )
+    {
+      QgsMessageLog::logMessage( tr( "Invalid second geometry in duplicate geometry test." ), tr( "Topology plugin" ) );
+      continue;
+    }
 
-    for ( ; cit != crossingIdsEnd; ++cit )
+    if ( g1->equals( g2 ) )
     {
-      duplicate = false;
-      // skip itself
-      if ( mFeatureMap2[*cit].feature.id() == it->feature.id() )
-        continue;
+      // the duplicates are reported by the one with the lowest id
+      if ( candidate->feature.id() < feature.feature.id() )
+        return errorList;
 
-      const QgsGeometry* g2 = mFeatureMap2[*cit].feature.constGeometry();
-      if ( !g2 )
-      {
-        QgsMessageLog::logMessage( tr( "Invalid second geometry in duplicate geometry test." ), tr( "Topology plugin" ) );
-        continue;
-      }
+      duplicates << candidate;
+    }
+  }
 
-      if ( !g2->asGeos() )
-      {
-        QgsMessageLog::logMessage( tr( "Failed to import second geometry into GEOS in duplicate geometry test." ), tr( "Topology plugin" ) );
-        continue;
-      }
+  for ( int i = 0; i < duplicates.size(); ++i )
+  {
+    QList<FeatureLayer> fls;
+    fls << feature << feature;
+    QScopedPointer<QgsGeometry> conflict( new QgsGeometry( *g1 ) );
 
-      if ( g1->equals( g2 ) )
+    if ( context.isExtent )
+    {
+      if ( context.canvasExtentPoly->disjoint( conflict.data() ) )
       {
-        duplicate = true;
-        duplicateIds.append( mFeatureMap2[*cit].feature.id() );
+        continue;
       }
-
-      if ( duplicate )
+      if ( context.canvasExtentPoly->crosses( conflict.data() ) )
       {
-
-
-        QList<FeatureLayer> fls;
-        fls << *it << *it;
-        QScopedPointer<QgsGeometry> conflict( new QgsGeometry( *g1 ) );
-
-        if ( isExtent )
-        {
-          if ( canvasExtentPoly->disjoint( conflict.data() ) )
-          {
-            continue;
-          }
-          if ( canvasExtentPoly->crosses( conflict.data() ) )
-          {
-            conflict.reset( conflict->intersection( canvasExtentPoly ) );
-          }
-        }
-
-        TopolErrorDuplicates* err = new TopolErrorDuplicates( bb, conflict.take(), fls );
-
-        errorList << err;
+        conflict.reset( conflict->intersection( context.canvasExtentPoly ) );
       }
-
     }
 
+    TopolErrorDuplicates* err = new TopolErrorDuplicates( bb, conflict.take(), fls );
+
+    errorList << err;
   }
-  delete canvasExtentPoly;
+
   return errorList;
 }
 
 ErrorList topolTest::checkOverlaps( double tolerance, QgsVectorLayer *layer1, QgsVectorLayer *layer2, bool isExtent )
 {
   Q_UNUSED( tolerance );
-  Q_UNUSED( layer2 );
-  int i = 0;
   ErrorList errorList;
 
   // could be enabled for lines and points too
@@ -457,128 +509,87 @@ ErrorList topolTest::checkOverlaps( double tolerance, QgsVectorLayer *layer1, Qg
     return errorList;
   }
 
-  QList<QgsFeatureId> *duplicateIds = new QList<QgsFeatureId>();
-
   QgsSpatialIndex* index = mLayerIndexes[layer1->id()];
   if ( !index )
   {
     qDebug() << "no index present";
-    delete duplicateIds;
     return errorList;
   }
 
-  QMap<QgsFeatureId, FeatureLayer>::Iterator it;
-  QMap<QgsFeatureId, FeatureLayer>::ConstIterator FeatureListEnd = mFeatureMap2.end();
-  for ( it = mFeatureMap2.begin(); it != FeatureListEnd; ++it )
+  QgsGeometry* canvasExtentPoly = QgsGeometry::fromWkt( theQgsInterface->mapCanvas()->extent().asWktPolygon() );
+
+  errorList = runPartitioned( featurePointers( mFeatureMap2 ), &topolTest::testOverlaps,
+                              TestContext( layer1, layer2, index, isExtent, canvasExtentPoly ) );
+
+  delete canvasExtentPoly;
+  return errorList;
+}
+
+ErrorList topolTest::testOverlaps( const FeatureLayer& feature, const QList<const FeatureLayer*>& candidates, const TestContext& context )
+{
+  ErrorList errorList;
+
+  const QgsGeometry* g1 = feature.feature.constGeometry();
+
+  if ( !g1->isGeosValid() )
   {
-    if ( !( ++i % 100 ) )
-      emit progress( i );
+    qDebug() << "invalid geometry(g1) found..skipping.." << feature.feature.id();
+    return errorList;
+  }
 
-    QgsFeatureId currentId = it->feature.id();
+  QgsRectangle bb = g1->boundingBox();
+
+  Q_FOREACH ( const FeatureLayer* candidate, candidates )
+  {
+    // every overlapping pair is reported once, by the feature with the lower id
+    if ( candidate->feature.id() <= feature.feature.id() )
+      continue;
 
-    if ( duplicateIds->contains( currentId ) )
+    const QgsGeometry* g2 = candidate->feature.constGeometry();
+    if ( !g2 )
     {
-      //is already a duplicate geometry..skip..
+      QgsMessageLog::logMessage( tr( "Invalid second geometry in overlaps test." ), tr( "Topology plugin" ) );
       continue;
     }
 
-    if ( testCancelled() )
-      break;
-
-    QgsGeometry* g1 = it->feature.geometry();
-
-    if ( !g1->isGeosValid() )
+    if ( !g2->isGeosValid() )
     {
-      qDebug() << "invalid geometry(g1) found..skipping.." << it->feature.id();
+      QgsMessageLog::logMessage( tr( "Skipping invalid second geometry of feature %1 in overlaps test." ).arg( candidate->feature.id() ), tr( "Topology plugin" ) );
       continue;
     }
 
-    QgsRectangle bb = g1->boundingBox();
-
-    QList<QgsFeatureId> crossingIds;
-    crossingIds = index->intersects( bb );
-
-    QList<QgsFeatureId>::Iterator cit = crossingIds.begin();
-    QList<QgsFeatureId>::ConstIterator crossingIdsEnd = crossingIds.end();
-
-    bool duplicate = false;
-
-    QgsGeometry* canvasExtentPoly = QgsGeometry::fromWkt( theQgsInterface->mapCanvas()->extent().asWktPolygon() );
-
-    for ( ; cit != crossingIdsEnd; ++cit )
+    if ( g1->overlaps( g2 ) )
     {
-      duplicate = false;
-      // skip itself
-      if ( mFeatureMap2[*cit].feature.id() == it->feature.id() )
-        continue;
-
-      const QgsGeometry* g2 = mFeatureMap2[*cit].feature.constGeometry();
-      if ( !g2 )
-      {
-        QgsMessageLog::logMessage( tr( "Invalid second geometry in overlaps test." ), tr( "Topology plugin" ) );
-        continue;
-      }
-
-      if ( !g2->asGeos() )
-      {
-        QgsMessageLog::logMessage( tr( "Failed to import second geometry into GEOS in overlaps test." ), tr( "Topology plugin" ) );
-        continue;
-      }
-
-      if ( !g2->isGeosValid() )
-      {
-        QgsMessageLog::logMessage( tr( "Skipping invalid second geometry of feature %1 in overlaps test." ).arg( it->feature.id() ), tr( "Topology plugin" ) );
-        continue;
-      }
-
-
-      qDebug() << "checking overlap for" << it->feature.id();
-      if ( g1->overlaps( g2 ) )
-      {
-        duplicate = true;
-        duplicateIds->append( mFeatureMap2[*cit].feature.id() );
-      }
+      QList<FeatureLayer> fls;
+      fls << feature << feature;
+      QScopedPointer< QgsGeometry > conflictGeom( g1->intersection( g2 ) );
 
-      if ( duplicate )
+      if ( context.isExtent )
       {
-        QList<FeatureLayer> fls;
-        fls << *it << *it;
-        QScopedPointer< QgsGeometry > conflictGeom( g1->intersection( g2 ) );
-
-        if ( isExtent )
+        if ( context.canvasExtentPoly->disjoint( conflictGeom.data() ) )
         {
-          if ( canvasExtentPoly->disjoint( conflictGeom.data() ) )
-          {
-            continue;
-          }
-          if ( canvasExtentPoly->crosses( conflictGeom.data() ) )
-          {
-            conflictGeom.reset( conflictGeom->intersection( canvasExtentPoly ) );
-          }
+          continue;
+        }
+        if ( context.canvasExtentPoly->crosses( conflictGeom.data() ) )
+        {
+          conflictGeom.reset( conflictGeom->intersection( context.canvasExtentPoly ) );
         }
-
-        TopolErrorOverlaps* err = new TopolErrorOverlaps( bb, conflictGeom.take(), fls );
-
-        errorList << err;
       }
 
+      TopolErrorOverlaps* err = new TopolErrorOverlaps( bb, conflictGeom.take(), fls );
+
+      errorList << err;
     }
-    delete canvasExtentPoly;
   }
 
-  delete duplicateIds;
-
   return errorList;
 }
 
 ErrorList topolTest::checkGaps( double tolerance, QgsVectorLayer *layer1, QgsVectorLayer *layer2, bool isExtent )
 {
   Q_UNUSED( tolerance );
-  Q_UNUSED( layer2 );
 
-  int i = 0;
   ErrorList errorList;
-  GEOSContextHandle_t geosctxt = QgsGeometry::getGEOSHandler();
 
   // could be enabled for lines and points too
   // so duplicate rule may be removed?
@@ -588,156 +599,212 @@ ErrorList topolTest::checkGaps( double tolerance, QgsVectorLayer *layer1, QgsVec
     return errorList;
   }
 
-  QList<FeatureLayer>::Iterator it;
-  QgsGeometry* g1;
-
-  QList<GEOSGeometry*> geomList;
+  // instead of a union of the whole layer, the gaps are searched tile by tile
+  // and the gaps crossing tile borders are merged afterwards
+  QList<const QgsGeometry*> polygons;
+  QList<QgsRectangle> boxes;
+  QgsRectangle extent;
 
   qDebug() << mFeatureList1.count() << " features in list!";
-  QList<FeatureLayer>::ConstIterator FeatureListEnd = mFeatureList1.end();
-  for ( it = mFeatureList1.begin(); it != FeatureListEnd; ++it )
+  QList<FeatureLayer>::ConstIterator it;
+  for ( it = mFeatureList1.constBegin(); it != mFeatureList1.constEnd(); ++it )
   {
-    qDebug() << "reading features-" << i;
-
-    if ( !( ++i % 100 ) )
-    {
-      emit progress( i );
-    }
-
-    if ( testCancelled() )
-    {
-      break;
-    }
-
-    g1 = it->feature.geometry();
-
+    const QgsGeometry* g1 = it->feature.constGeometry();
     if ( !g1 )
     {
       continue;
     }
 
-    if ( !g1->asGeos() )
-    {
-      continue;
-    }
-
-    if ( !g1->isGeosValid() )
-    {
-      qDebug() << "invalid geometry found..skipping.." << it->feature.id();
-      continue;
-    }
-
-    if ( g1->isMultipart() )
-    {
-      QgsMultiPolygon polys = g1->asMultiPolygon();
-      for ( int m = 0; m < polys.count(); m++ )
-      {
-        QgsPolygon polygon = polys[m];
-
-        QgsGeometry* polyGeom = QgsGeometry::fromPolygon( polygon );
-
-        geomList.push_back( GEOSGeom_clone_r( geosctxt, polyGeom->asGeos() ) );
-        delete polyGeom;
-      }
-
-    }
+    QgsRectangle bb = g1->boundingBox();
+    if ( polygons.isEmpty() )
+      extent = bb;
     else
-    {
-      geomList.push_back( GEOSGeom_clone_r( geosctxt, g1->asGeos() ) );
-    }
-  }
+      extent.combineExtentWith( &bb );
 
-  GEOSGeometry** geomArray = new GEOSGeometry*[geomList.size()];
-  for ( int i = 0; i < geomList.size(); ++i )
-  {
-    //qDebug() << "filling geometry array-" << i;
-    geomArray[i] = geomList.at( i );
+    polygons << g1;
+    boxes << bb;
   }
 
-  qDebug() << "creating geometry collection-";
-
-  if ( geomList.isEmpty() )
+  if ( polygons.isEmpty() || extent.isEmpty() )
   {
-    //qDebug() << "geometry list is empty!";
-    delete [] geomArray;
     return errorList;
   }
 
-  GEOSGeometry* collection = 0;
-  collection = GEOSGeom_createCollection_r( geosctxt, GEOS_MULTIPOLYGON, geomArray, geomList.size() );
-
+  int cols, rows;
+  gridSize( extent, polygons.size(), GapTileSize, cols, rows );
+  double tileWidth = extent.width() / cols;
+  double tileHeight = extent.height() / rows;
 
-  qDebug() << "performing cascaded union..might take time..-";
-  GEOSGeometry* unionGeom = GEOSUnionCascaded_r( geosctxt, collection );
-  //delete[] geomArray;
-
-  QgsGeometry test;
-  test.fromGeos( unionGeom );
+  QList<GapTile> tiles;
+  for ( int row = 0; row < rows; ++row )
+  {
+    for ( int col = 0; col < cols; ++col )
+    {
+      GapTile tile;
+      tile.rect = QgsRectangle( extent.xMinimum() + col * tileWidth,
+                                extent.yMinimum() + row * tileHeight,
+                                col == cols - 1 ? extent.xMaximum() : extent.xMinimum() + ( col + 1 ) * tileWidth,
+                                row == rows - 1 ? extent.yMaximum() : extent.yMinimum() + ( row + 1 ) * tileHeight );
+      tile.featureCount = 0;
+      tiles << tile;
+    }
+  }
 
+  // a polygon goes to every tile its bounding box intersects, with a margin for rounding
+  double marginX = 1E-6 * tileWidth;
+  double marginY = 1E-6 * tileHeight;
+  for ( int p = 0; p < polygons.size(); ++p )
+  {
+    const QgsRectangle& bb = boxes[p];
+    int col0 = cellIndex( bb.xMinimum() - marginX, extent.xMinimum(), tileWidth, cols );
+    int col1 = cellIndex( bb.xMaximum() + marginX, extent.xMinimum(), tileWidth, cols );
+    int row0 = cellIndex( bb.yMinimum() - marginY, extent.yMinimum(), tileHeight, rows );
+    int row1 = cellIndex( bb.yMaximum() + marginY, extent.yMinimum(), tileHeight, rows );
+    for ( int row = row0; row <= row1; ++row )
+    {
+      for ( int col = col0; col <= col1; ++col )
+      {
+        tiles[row * cols + col].polygons << polygons[p];
+      }
+    }
 
-  //qDebug() << "wktmerged - " << test.exportToWkt();
+    QgsPoint center = bb.center();
+    int col = cellIndex( center.x(), extent.xMinimum(), tileWidth, cols );
+    int row = cellIndex( center.y(), extent.yMinimum(), tileHeight, rows );
+    ++tiles[row * cols + col].featureCount;
+  }
 
-  QString extentWkt =  test.boundingBox().asWktPolygon();
-  QgsGeometry* extentGeom = QgsGeometry::fromWkt( extentWkt );
-  QgsGeometry* bufferExtent = extentGeom->buffer( 2, 3 );
-  delete extentGeom;
+  QgsGeometry* canvasExtentPoly = QgsGeometry::fromWkt( theQgsInterface->mapCanvas()->extent().asWktPolygon() );
+  TestContext context( layer1, layer2, 0, isExtent, canvasExtentPoly );
 
-  //qDebug() << "extent wkt - " << bufferExtent->exportToWkt();
+  errorList = waitForWorkers( QtConcurrent::map( tiles, CollectGapsWrapper( this, context ) ) );
 
-  QgsGeometry* diffGeoms = bufferExtent->difference( &test );
-  delete bufferExtent;
-  if ( !diffGeoms )
+  // the pieces of gaps crossing tile borders are merged, what reaches the border
+  // of the layer extent is outside of the polygons
+  QList<QgsGeometry*> borderGaps;
+  for ( int t = 0; t < tiles.size(); ++t )
   {
-    qDebug() << "difference result 0-";
-    return errorList;
+    borderGaps << tiles[t].borderGaps;
   }
 
-  //qDebug() << "difference gometry - " << diffGeoms->exportToWkt();
-
-  QList<QgsGeometry*> geomColl = diffGeoms->asGeometryCollection();
-  delete diffGeoms;
-
-  QgsGeometry* canvasExtentPoly = QgsGeometry::fromWkt( theQgsInterface->mapCanvas()->extent().asWktPolygon() );
-
-  for ( int i = 1; i < geomColl.count() ; ++i )
+  if ( !borderGaps.isEmpty() && !mWorkersCancelled )
   {
-    QgsGeometry* conflictGeom = geomColl[i];
-    if ( isExtent )
+    QScopedPointer<QgsGeometry> mergedGaps( QgsGeometry::unaryUnion( borderGaps ) );
+    Q_FOREACH ( QgsGeometry* gap, mergedGaps->asGeometryCollection() )
     {
-      if ( canvasExtentPoly->disjoint( conflictGeom ) )
+      if ( reachesBorder( gap->boundingBox(), extent ) )
       {
+        delete gap;
         continue;
       }
-      if ( canvasExtentPoly->crosses( conflictGeom ) )
-      {
-        conflictGeom = conflictGeom->intersection( canvasExtentPoly );
-      }
+
+      TopolError* err = createGapError( gap, context );
+      if ( err )
+        errorList << err;
     }
-    QgsRectangle bBox = conflictGeom->boundingBox();
-    FeatureLayer ftrLayer1;
-    ftrLayer1.layer = layer1;
-    QList<FeatureLayer> errorFtrLayers;
-    errorFtrLayers << ftrLayer1 << ftrLayer1;
-    TopolErrorGaps* err = new TopolErrorGaps( bBox, conflictGeom, errorFtrLayers );
-    errorList << err;
   }
+  qDeleteAll( borderGaps );
 
   delete canvasExtentPoly;
   return errorList;
 }
 
-ErrorList topolTest::checkPseudos( double tolerance, QgsVectorLayer *layer1, QgsVectorLayer *layer2, bool isExtent )
+void topolTest::collectGaps( GapTile& tile, const TestContext& context )
 {
-  Q_UNUSED( tolerance );
-  Q_UNUSED( layer2 );
-
-  int i = 0;
-  ErrorList errorList;
-  QgsFeature f;
+  if ( mWorkersCancelled )
+    return;
 
-  if ( layer1->geometryType() != QGis::Line )
+  QList<QgsGeometry*> geomList;
+  Q_FOREACH ( const QgsGeometry* polygon, tile.polygons )
   {
-    return errorList;
+    if ( !polygon->isGeosValid() )
+    {
+      qDebug() << "invalid geometry found..skipping..";
+      continue;
+    }
+    geomList << new QgsGeometry( *polygon );
+  }
+
+  QScopedPointer<QgsGeometry> tileGeom( QgsGeometry::fromRect( tile.rect ) );
+  QScopedPointer<QgsGeometry> diffGeoms;
+  if ( geomList.isEmpty() )
+  {
+    diffGeoms.reset( new QgsGeometry( *tileGeom ) );
+  }
+  else
+  {
+    QScopedPointer<QgsGeometry> unionGeom( QgsGeometry::unaryUnion( geomList ) );
+    if ( unionGeom && unionGeom->geometry() )
+      diffGeoms.reset( tileGeom->difference( unionGeom.data() ) );
+  }
+  qDeleteAll( geomList );
+
+  ErrorList errors;
+  if ( diffGeoms )
+  {
+    Q_FOREACH ( QgsGeometry* gap, diffGeoms->asGeometryCollection() )
+    {
+      if ( reachesBorder( gap->boundingBox(), tile.rect ) )
+      {
+        tile.borderGaps << gap;
+        continue;
+      }
+
+      TopolError* err = createGapError( gap, context );
+      if ( err )
+        errors << err;
+    }
+  }
+  else
+  {
+    qDebug() << "difference result 0-";
+  }
+
+  mProgressCounter.fetchAndAddRelaxed( tile.featureCount );
+
+  QMutexLocker locker( &mErrorMutex );
+  mPendingErrors << errors;
+}
+
+TopolError* topolTest::createGapError( QgsGeometry* gap, const TestContext& context )
+{
+  QgsGeometry* conflictGeom = gap;
+  if ( context.isExtent )
+  {
+    if ( context.canvasExtentPoly->disjoint( gap ) )
+    {
+      delete gap;
+      return 0;
+    }
+    if ( context.canvasExtentPoly->crosses( gap ) )
+    {
+      conflictGeom = gap->intersection( context.canvasExtentPoly );
+      delete gap;
+      if ( !conflictGeom )
+        return 0;
+    }
+  }
+
+  QgsRectangle bBox = conflictGeom->boundingBox();
+  FeatureLayer ftrLayer1;
+  ftrLayer1.layer = context.layer1;
+  QList<FeatureLayer> errorFtrLayers;
+  errorFtrLayers << ftrLayer1 << ftrLayer1;
+  return new TopolErrorGaps( bBox, conflictGeom, errorFtrLayers );
+}
+
+ErrorList topolTest::checkPseudos( double tolerance, QgsVectorLayer *layer1, QgsVectorLayer *layer2, bool isExtent )
+{
+  Q_UNUSED( tolerance );
+  Q_UNUSED( layer2 );
+
+  int i = 0;
+  ErrorList errorList;
+  QgsFeature f;
+
+  if ( layer1->geometryType() != QGis::Line )
+  {
+    return errorList;
   }
 
   QList<FeatureLayer>::Iterator it;
@@ -799,6 +866,8 @@ ErrorList topolTest::checkPseudos( double tolerance, QgsVectorLayer *layer1, Qgs
 
   QgsGeometry* canvasExtentPoly = QgsGeometry::fromWkt( theQgsInterface->mapCanvas()->extent().asWktPolygon() );
 
+  QList< QPair<QgsGeometry*, QgsFeatureId> > pseudos;
+  QgsFeatureIds pseudoIds;
 
   for ( std::multimap<QgsPoint, QgsFeatureId, PointComparer>::iterator pointIt = endVerticesMap.begin(), end = endVerticesMap.end(); pointIt != end; pointIt = endVerticesMap.upper_bound( pointIt->first ) )
   {
@@ -820,67 +889,64 @@ ErrorList topolTest::checkPseudos( double tolerance, QgsVectorLayer *layer1, Qgs
         }
       }
 
-      QgsRectangle bBox = conflictGeom->boundingBox();
-      QgsFeature feat;
+      pseudos << qMakePair( conflictGeom, k );
+      pseudoIds << k;
+    }
+  }
+  delete canvasExtentPoly;
 
-      FeatureLayer ftrLayer1;
-      //need to fetch attributes?? being safe side by fetching..
-      layer1->getFeatures( QgsFeatureRequest().setFilterFid( k ) ).nextFeature( feat );
-      ftrLayer1.feature = feat;
-      ftrLayer1.layer = layer1;
+  //need to fetch attributes?? being safe side by fetching..
+  QHash<QgsFeatureId, QgsFeature> features = fetchFeatures( layer1, pseudoIds );
 
-      QList<FeatureLayer> errorFtrLayers;
-      errorFtrLayers << ftrLayer1 << ftrLayer1;
+  for ( int p = 0; p < pseudos.size(); ++p )
+  {
+    QgsGeometry* conflictGeom = pseudos[p].first;
+    QgsRectangle bBox = conflictGeom->boundingBox();
 
-      TopolErrorPseudos* err = new TopolErrorPseudos( bBox, conflictGeom, errorFtrLayers );
-      errorList << err;
+    FeatureLayer ftrLayer1;
+    ftrLayer1.feature = features.value( pseudos[p].second );
+    ftrLayer1.layer = layer1;
 
-    }
+    QList<FeatureLayer> errorFtrLayers;
+    errorFtrLayers << ftrLayer1 << ftrLayer1;
+
+    TopolErrorPseudos* err = new TopolErrorPseudos( bBox, conflictGeom, errorFtrLayers );
+    errorList << err;
   }
-  delete canvasExtentPoly;
   return errorList;
 }
 
 ErrorList topolTest::checkValid( double tolerance, QgsVectorLayer* layer1, QgsVectorLayer* layer2, bool isExtent )
 {
   Q_UNUSED( tolerance );
-  Q_UNUSED( layer1 );
-  Q_UNUSED( layer2 );
-  Q_UNUSED( isExtent );
 
-  int i = 0;
-  ErrorList errorList;
-  QgsFeature f;
-
-  QList<FeatureLayer>::Iterator it;
+  return runPartitioned( featurePointers( mFeatureList1 ), &topolTest::testValid,
+                         TestContext( layer1, layer2, 0, isExtent, 0 ) );
+}
 
-  for ( it = mFeatureList1.begin(); it != mFeatureList1.end(); ++it )
-  {
-    if ( !( ++i % 100 ) )
-      emit progress( ++i );
-    if ( testCancelled() )
-      break;
+ErrorList topolTest::testValid( const FeatureLayer& feature, const QList<const FeatureLayer*>& candidates, const TestContext& context )
+{
+  Q_UNUSED( candidates );
+  Q_UNUSED( context );
 
-    QgsGeometry* g = it->feature.geometry();
-    if ( !g )
-    {
-      QgsMessageLog::logMessage( tr( "Invalid geometry in validity test." ), tr( "Topology plugin" ) );
-      continue;
-    }
+  ErrorList errorList;
 
-    if ( !g->asGeos() )
-      continue;
+  const QgsGeometry* g = feature.feature.constGeometry();
+  if ( !g )
+  {
+    QgsMessageLog::logMessage( tr( "Invalid geometry in validity test." ), tr( "Topology plugin" ) );
+    return errorList;
+  }
 
-    if ( !GEOSisValid_r( QgsGeometry::getGEOSHandler(), g->asGeos() ) )
-    {
-      QgsRectangle r = g->boundingBox();
-      QList<FeatureLayer> fls;
-      fls << *it << *it;
+  if ( !g->isGeosValid() )
+  {
+    QgsRectangle r = g->boundingBox();
+    QList<FeatureLayer> fls;
+    fls << feature << feature;
 
-      QgsGeometry* conflict = new QgsGeometry( *g );
-      TopolErrorValid* err = new TopolErrorValid( r, conflict, fls );
-      errorList << err;
-    }
+    QgsGeometry* conflict = new QgsGeometry( *g );
+    TopolErrorValid* err = new TopolErrorValid( r, conflict, fls );
+    errorList << err;
   }
 
   return errorList;
@@ -891,8 +957,6 @@ ErrorList topolTest::checkPointCoveredBySegment( double tolerance, QgsVectorLaye
 {
   Q_UNUSED( tolerance );
 
-  int i = 0;
-
   ErrorList errorList;
 
   if ( layer1->geometryType() != QGis::Point )
@@ -907,69 +971,61 @@ ErrorList topolTest::checkPointCoveredBySegment( double tolerance, QgsVectorLaye
   QgsSpatialIndex* index = mLayerIndexes[layer2->id()];
   QgsGeometry* canvasExtentPoly = QgsGeometry::fromWkt( theQgsInterface->mapCanvas()->extent().asWktPolygon() );
 
+  errorList = runPartitioned( featurePointers( mFeatureList1 ), &topolTest::testPointCoveredBySegment,
+                              TestContext( layer1, layer2, index, isExtent, canvasExtentPoly ) );
 
-  QList<FeatureLayer>::Iterator it;
-  for ( it = mFeatureList1.begin(); it != mFeatureList1.end(); ++it )
-  {
-    if ( !( ++i % 100 ) )
-      emit progress( i );
-
-    if ( testCancelled() )
-      break;
+  delete canvasExtentPoly;
+  return errorList;
+}
 
-    QgsGeometry* g1 = it->feature.geometry();
-    QgsRectangle bb = g1->boundingBox();
+ErrorList topolTest::testPointCoveredBySegment( const FeatureLayer& feature, const QList<const FeatureLayer*>& candidates, const TestContext& context )
+{
+  ErrorList errorList;
 
-    QList<QgsFeatureId> crossingIds;
-    crossingIds = index->intersects( bb );
+  const QgsGeometry* g1 = feature.feature.constGeometry();
+  QgsRectangle bb = g1->boundingBox();
 
-    QList<QgsFeatureId>::Iterator cit = crossingIds.begin();
-    QList<QgsFeatureId>::ConstIterator crossingIdsEnd = crossingIds.end();
+  bool touched = false;
 
-    bool touched = false;
+  Q_FOREACH ( const FeatureLayer* candidate, candidates )
+  {
+    const QgsGeometry* g2 = candidate->feature.constGeometry();
 
-    for ( ; cit != crossingIdsEnd; ++cit )
+    if ( !g2 )
     {
-      QgsFeature& f = mFeatureMap2[*cit].feature;
-      const QgsGeometry* g2 = f.constGeometry();
-
-      if ( !g2 )
-      {
-        QgsMessageLog::logMessage( tr( "Invalid geometry in covering test." ), tr( "Topology plugin" ) );
-        continue;
-      }
-
-      // test if point touches other geometry
-      if ( g1->touches( g2 ) )
-      {
-        touched = true;
-        break;
-      }
+      QgsMessageLog::logMessage( tr( "Invalid geometry in covering test." ), tr( "Topology plugin" ) );
+      continue;
     }
 
-    if ( !touched )
+    // test if point touches other geometry
+    if ( g1->touches( g2 ) )
     {
-      QgsGeometry* conflictGeom = new QgsGeometry( *g1 );
+      touched = true;
+      break;
+    }
+  }
 
-      if ( isExtent )
+  if ( !touched )
+  {
+    QgsGeometry* conflictGeom = new QgsGeometry( *g1 );
+
+    if ( context.isExtent )
+    {
+      if ( context.canvasExtentPoly->disjoint( conflictGeom ) )
       {
-        if ( canvasExtentPoly->disjoint( conflictGeom ) )
-        {
-          delete conflictGeom;
-          continue;
-        }
+        delete conflictGeom;
+        return errorList;
       }
+    }
 
-      QList<FeatureLayer> fls;
-      fls << *it << *it;
-      //bb.scale(10);
+    QList<FeatureLayer> fls;
+    fls << feature << feature;
+    //bb.scale(10);
 
-      TopolErrorCovered* err = new TopolErrorCovered( bb, conflictGeom, fls );
+    TopolErrorCovered* err = new TopolErrorCovered( bb, conflictGeom, fls );
 
-      errorList << err;
-    }
+    errorList << err;
   }
-  delete canvasExtentPoly;
   return errorList;
 }
 
@@ -1132,87 +1188,76 @@ ErrorList topolTest::checkOverlapWithLayer( double tolerance, QgsVectorLayer* la
 {
   Q_UNUSED( tolerance );
 
-  int i = 0;
-  ErrorList errorList;
-
-  bool skipItself = layer1 == layer2;
   QgsSpatialIndex* index = mLayerIndexes[layer2->id()];
 
   QgsGeometry* canvasExtentPoly = QgsGeometry::fromWkt( theQgsInterface->mapCanvas()->extent().asWktPolygon() );
 
+  ErrorList errorList = runPartitioned( featurePointers( mFeatureList1 ), &topolTest::testOverlapWithLayer,
+                                        TestContext( layer1, layer2, index, isExtent, canvasExtentPoly ) );
 
-  QList<FeatureLayer>::Iterator it;
-  QList<FeatureLayer>::ConstIterator FeatureListEnd = mFeatureList1.end();
-  for ( it = mFeatureList1.begin(); it != FeatureListEnd; ++it )
-  {
-    if ( !( ++i % 100 ) )
-      emit progress( i );
+  delete canvasExtentPoly;
+  return errorList;
+}
 
-    if ( testCancelled() )
-      break;
+ErrorList topolTest::testOverlapWithLayer( const FeatureLayer& feature, const QList<const FeatureLayer*>& candidates, const TestContext& context )
+{
+  ErrorList errorList;
 
-    QgsGeometry* g1 = it->feature.geometry();
-    QgsRectangle bb = g1->boundingBox();
+  bool skipItself = context.layer1 == context.layer2;
 
-    QList<QgsFeatureId> crossingIds;
-    crossingIds = index->intersects( bb );
+  const QgsGeometry* g1 = feature.feature.constGeometry();
+  QgsRectangle bb = g1->boundingBox();
 
-    QList<QgsFeatureId>::Iterator cit = crossingIds.begin();
-    QList<QgsFeatureId>::ConstIterator crossingIdsEnd = crossingIds.end();
-    for ( ; cit != crossingIdsEnd; ++cit )
+  Q_FOREACH ( const FeatureLayer* candidate, candidates )
+  {
+    const QgsFeature& f = candidate->feature;
+    const QgsGeometry* g2 = f.constGeometry();
+
+    // skip itself, when invoked with the same layer
+    if ( skipItself && f.id() == feature.feature.id() )
+      continue;
+
+    if ( !g2 )
     {
-      QgsFeature& f = mFeatureMap2[*cit].feature;
-      const QgsGeometry* g2 = f.constGeometry();
+      QgsMessageLog::logMessage( tr( "Second geometry missing." ), tr( "Topology plugin" ) );
+      continue;
+    }
 
-      // skip itself, when invoked with the same layer
-      if ( skipItself && f.id() == it->feature.id() )
-        continue;
+    if ( g1->overlaps( g2 ) )
+    {
+      QgsRectangle r = bb;
+      QgsRectangle r2 = g2->boundingBox();
+      r.combineExtentWith( &r2 );
 
-      if ( !g2 )
+      QScopedPointer<QgsGeometry> conflictGeom( g1->intersection( g2 ) );
+      // could this for some reason return NULL?
+      if ( !conflictGeom )
       {
-        QgsMessageLog::logMessage( tr( "Second geometry missing." ), tr( "Topology plugin" ) );
         continue;
       }
 
-      if ( g1->overlaps( g2 ) )
+      if ( context.isExtent )
       {
-        QgsRectangle r = bb;
-        QgsRectangle r2 = g2->boundingBox();
-        r.combineExtentWith( &r2 );
-
-        QScopedPointer<QgsGeometry> conflictGeom( g1->intersection( g2 ) );
-        // could this for some reason return NULL?
-        if ( !conflictGeom )
+        if ( context.canvasExtentPoly->disjoint( conflictGeom.data() ) )
         {
           continue;
         }
-
-        if ( isExtent )
+        if ( context.canvasExtentPoly->crosses( conflictGeom.data() ) )
         {
-          if ( canvasExtentPoly->disjoint( conflictGeom.data() ) )
-          {
-            continue;
-          }
-          if ( canvasExtentPoly->crosses( conflictGeom.data() ) )
-          {
-            conflictGeom.reset( conflictGeom->intersection( canvasExtentPoly ) );
-          }
+          conflictGeom.reset( conflictGeom->intersection( context.canvasExtentPoly ) );
         }
+      }
 
-        //c = new QgsGeometry;
-
-        QList<FeatureLayer> fls;
-        FeatureLayer fl;
-        fl.feature = f;
-        fl.layer = layer2;
-        fls << *it << fl;
-        TopolErrorIntersection* err = new TopolErrorIntersection( r, conflictGeom.take(), fls );
+      QList<FeatureLayer> fls;
+      FeatureLayer fl;
+      fl.feature = f;
+      fl.layer = context.layer2;
+      fls << feature << fl;
+      TopolErrorIntersection* err = new TopolErrorIntersection( r, conflictGeom.take(), fls );
 
-        errorList << err;
-      }
+      errorList << err;
     }
   }
-  delete canvasExtentPoly;
   return errorList;
 }
 
@@ -1222,7 +1267,6 @@ ErrorList topolTest::checkPointCoveredByLineEnds( double tolerance, QgsVectorLay
 {
   Q_UNUSED( tolerance );
 
-  int i = 0;
   ErrorList errorList;
 
 
@@ -1239,62 +1283,58 @@ ErrorList topolTest::checkPointCoveredByLineEnds( double tolerance, QgsVectorLay
   QgsSpatialIndex* index = mLayerIndexes[layer2->id()];
   QgsGeometry* canvasExtentPoly = QgsGeometry::fromWkt( theQgsInterface->mapCanvas()->extent().asWktPolygon() );
 
+  errorList = runPartitioned( featurePointers( mFeatureList1 ), &topolTest::testPointCoveredByLineEnds,
+                              TestContext( layer1, layer2, index, isExtent, canvasExtentPoly ) );
 
-  QList<FeatureLayer>::Iterator it;
-  for ( it = mFeatureList1.begin(); it != mFeatureList1.end(); ++it )
+  delete canvasExtentPoly;
+  return errorList;
+}
+
+ErrorList topolTest::testPointCoveredByLineEnds( const FeatureLayer& feature, const QList<const FeatureLayer*>& candidates, const TestContext& context )
+{
+  ErrorList errorList;
+
+  const QgsGeometry* g1 = feature.feature.constGeometry();
+  QgsRectangle bb = g1->boundingBox();
+  bool touched = false;
+  Q_FOREACH ( const FeatureLayer* candidate, candidates )
   {
-    if ( !( ++i % 100 ) )
-      emit progress( i );
-    if ( testCancelled() )
-      break;
-    QgsGeometry* g1 = it->feature.geometry();
-    QgsRectangle bb = g1->boundingBox();
-    QList<QgsFeatureId> crossingIds;
-    crossingIds = index->intersects( bb );
-    QList<QgsFeatureId>::Iterator cit = crossingIds.begin();
-    QList<QgsFeatureId>::ConstIterator crossingIdsEnd = crossingIds.end();
-    bool touched = false;
-    for ( ; cit != crossingIdsEnd; ++cit )
+    const QgsGeometry* g2 = candidate->feature.constGeometry();
+    if ( !g2 )
     {
-      QgsFeature& f = mFeatureMap2[*cit].feature;
-      const QgsGeometry* g2 = f.constGeometry();
-      if ( !g2 || !g2->asGeos() )
-      {
-        QgsMessageLog::logMessage( tr( "Second geometry missing or GEOS import failed." ), tr( "Topology plugin" ) );
-        continue;
-      }
-      QgsGeometry* startPoint = QgsGeometry::fromPoint( g2->asPolyline().at( 0 ) );
-      QgsGeometry* endPoint = QgsGeometry::fromPoint( g2->asPolyline().last() );
-      touched = g1->intersects( startPoint ) || g1->intersects( endPoint );
-      delete startPoint;
-      delete endPoint;
+      QgsMessageLog::logMessage( tr( "Second geometry missing." ), tr( "Topology plugin" ) );
+      continue;
+    }
+    QgsGeometry* startPoint = QgsGeometry::fromPoint( g2->asPolyline().at( 0 ) );
+    QgsGeometry* endPoint = QgsGeometry::fromPoint( g2->asPolyline().last() );
+    touched = g1->intersects( startPoint ) || g1->intersects( endPoint );
+    delete startPoint;
+    delete endPoint;
 
-      if ( touched )
-      {
-        break;
-      }
+    if ( touched )
+    {
+      break;
     }
-    if ( !touched )
+  }
+  if ( !touched )
+  {
+    QgsGeometry* conflictGeom = new QgsGeometry( *g1 );
+    if ( context.isExtent )
     {
-      QgsGeometry* conflictGeom = new QgsGeometry( *g1 );
-      if ( isExtent )
+      if ( context.canvasExtentPoly->disjoint( conflictGeom ) )
       {
-        if ( canvasExtentPoly->disjoint( conflictGeom ) )
-        {
-          delete conflictGeom;
-          continue;
-        }
+        delete conflictGeom;
+        return errorList;
       }
+    }
 
-      QList<FeatureLayer> fls;
-      fls << *it << *it;
-      //bb.scale(10);
+    QList<FeatureLayer> fls;
+    fls << feature << feature;
+    //bb.scale(10);
 
-      TopolErrorPointNotCoveredByLineEnds* err = new TopolErrorPointNotCoveredByLineEnds( bb, conflictGeom, fls );
-      errorList << err;
-    }
+    TopolErrorPointNotCoveredByLineEnds* err = new TopolErrorPointNotCoveredByLineEnds( bb, conflictGeom, fls );
+    errorList << err;
   }
-  delete canvasExtentPoly;
   return errorList;
 }
 
@@ -1302,7 +1342,6 @@ ErrorList topolTest::checkyLineEndsCoveredByPoints( double tolerance, QgsVectorL
 {
   Q_UNUSED( tolerance );
 
-  int i = 0;
   ErrorList errorList;
 
 
@@ -1320,83 +1359,80 @@ ErrorList topolTest::checkyLineEndsCoveredByPoints( double tolerance, QgsVectorL
 
   QgsGeometry* canvasExtentPoly = QgsGeometry::fromWkt( theQgsInterface->mapCanvas()->extent().asWktPolygon() );
 
-  QList<FeatureLayer>::Iterator it;
-  for ( it = mFeatureList1.begin(); it != mFeatureList1.end(); ++it )
-  {
-    if ( !( ++i % 100 ) )
-      emit progress( i );
-    if ( testCancelled() )
-      break;
-    QgsGeometry* g1 = it->feature.geometry();
+  errorList = runPartitioned( featurePointers( mFeatureList1 ), &topolTest::testLineEndsCoveredByPoints,
+                              TestContext( layer1, layer2, index, isExtent, canvasExtentPoly ) );
 
-    QgsGeometry* startPoint = QgsGeometry::fromPoint( g1->asPolyline().at( 0 ) );
-    QgsGeometry* endPoint = QgsGeometry::fromPoint( g1->asPolyline().last() );
+  delete canvasExtentPoly;
+  return errorList;
+}
 
-    QgsRectangle bb = g1->boundingBox();
-    QList<QgsFeatureId> crossingIds;
-    crossingIds = index->intersects( bb );
-    QList<QgsFeatureId>::Iterator cit = crossingIds.begin();
-    QList<QgsFeatureId>::ConstIterator crossingIdsEnd = crossingIds.end();
-    bool touched = false;
+ErrorList topolTest::testLineEndsCoveredByPoints( const FeatureLayer& feature, const QList<const FeatureLayer*>& candidates, const TestContext& context )
+{
+  ErrorList errorList;
 
-    bool touchStartPoint = false;
-    bool touchEndPoint = false;
+  const QgsGeometry* g1 = feature.feature.constGeometry();
 
-    for ( ; cit != crossingIdsEnd; ++cit )
-    {
-      QgsFeature& f = mFeatureMap2[*cit].feature;
-      const QgsGeometry* g2 = f.constGeometry();
-      if ( !g2 || !g2->asGeos() )
-      {
-        QgsMessageLog::logMessage( tr( "Second geometry missing or GEOS import failed." ), tr( "Topology plugin" ) );
-        continue;
-      }
+  QgsGeometry* startPoint = QgsGeometry::fromPoint( g1->asPolyline().at( 0 ) );
+  QgsGeometry* endPoint = QgsGeometry::fromPoint( g1->asPolyline().last() );
 
+  QgsRectangle bb = g1->boundingBox();
+  bool touched = false;
 
-      if ( g2->intersects( startPoint ) )
-      {
-        touchStartPoint = true;
-      }
+  bool touchStartPoint = false;
+  bool touchEndPoint = false;
 
-      if ( g2->intersects( endPoint ) )
-      {
-        touchEndPoint = true;
-      }
+  Q_FOREACH ( const FeatureLayer* candidate, candidates )
+  {
+    const QgsGeometry* g2 = candidate->feature.constGeometry();
+    if ( !g2 )
+    {
+      QgsMessageLog::logMessage( tr( "Second geometry missing." ), tr( "Topology plugin" ) );
+      continue;
+    }
 
-      if ( touchStartPoint && touchEndPoint )
-      {
-        touched = true;
-        break;
-      }
 
+    if ( g2->intersects( startPoint ) )
+    {
+      touchStartPoint = true;
     }
-    delete startPoint;
-    delete endPoint;
 
-    if ( !touched )
+    if ( g2->intersects( endPoint ) )
     {
-      QScopedPointer<QgsGeometry> conflictGeom( new QgsGeometry( *g1 ) );
+      touchEndPoint = true;
+    }
 
-      if ( isExtent )
+    if ( touchStartPoint && touchEndPoint )
+    {
+      touched = true;
+      break;
+    }
+
+  }
+  delete startPoint;
+  delete endPoint;
+
+  if ( !touched )
+  {
+    QScopedPointer<QgsGeometry> conflictGeom( new QgsGeometry( *g1 ) );
+
+    if ( context.isExtent )
+    {
+      if ( context.canvasExtentPoly->disjoint( conflictGeom.data() ) )
       {
-        if ( canvasExtentPoly->disjoint( conflictGeom.data() ) )
-        {
-          continue;
-        }
-        if ( canvasExtentPoly->crosses( conflictGeom.data() ) )
-        {
-          conflictGeom.reset( conflictGeom->intersection( canvasExtentPoly ) );
-        }
+        return errorList;
+      }
+      if ( context.canvasExtentPoly->crosses( conflictGeom.data() ) )
+      {
+        conflictGeom.reset( conflictGeom->intersection( context.canvasExtentPoly ) );
       }
-      QList<FeatureLayer> fls;
-      fls << *it << *it;
-      //bb.scale(10);
-
-      TopolErrorLineEndsNotCoveredByPoints* err = new TopolErrorLineEndsNotCoveredByPoints( bb, conflictGeom.take(), fls );
-      errorList << err;
     }
+    QList<FeatureLayer> fls;
+    fls << feature << feature;
+    //bb.scale(10);
+
+    TopolErrorLineEndsNotCoveredByPoints* err = new TopolErrorLineEndsNotCoveredByPoints( bb, conflictGeom.take(), fls );
+    errorList << err;
   }
-  delete canvasExtentPoly;
   return errorList;
 }
 
@@ -1404,7 +1440,6 @@ ErrorList topolTest::checkPointInPolygon( double tolerance, QgsVectorLayer *laye
 {
   Q_UNUSED( tolerance );
 
-  int i = 0;
   ErrorList errorList;
 
   if ( layer1->geometryType() != QGis::Point )
@@ -1421,58 +1456,54 @@ ErrorList topolTest::checkPointInPolygon( double tolerance, QgsVectorLayer *laye
 
   QgsGeometry* canvasExtentPoly = QgsGeometry::fromWkt( theQgsInterface->mapCanvas()->extent().asWktPolygon() );
 
-  QList<FeatureLayer>::Iterator it;
-  for ( it = mFeatureList1.begin(); it != mFeatureList1.end(); ++it )
+  errorList = runPartitioned( featurePointers( mFeatureList1 ), &topolTest::testPointInPolygon,
+                              TestContext( layer1, layer2, index, isExtent, canvasExtentPoly ) );
+
+  delete canvasExtentPoly;
+  return errorList;
+}
+
+ErrorList topolTest::testPointInPolygon( const FeatureLayer& feature, const QList<const FeatureLayer*>& candidates, const TestContext& context )
+{
+  ErrorList errorList;
+
+  const QgsGeometry* g1 = feature.feature.constGeometry();
+  QgsRectangle bb = g1->boundingBox();
+  bool touched = false;
+  Q_FOREACH ( const FeatureLayer* candidate, candidates )
   {
-    if ( !( ++i % 100 ) )
-      emit progress( i );
-    if ( testCancelled() )
-      break;
-    QgsGeometry* g1 = it->feature.geometry();
-    QgsRectangle bb = g1->boundingBox();
-    QList<QgsFeatureId> crossingIds;
-    crossingIds = index->intersects( bb );
-    QList<QgsFeatureId>::Iterator cit = crossingIds.begin();
-    QList<QgsFeatureId>::ConstIterator crossingIdsEnd = crossingIds.end();
-    bool touched = false;
-    for ( ; cit != crossingIdsEnd; ++cit )
+    const QgsGeometry* g2 = candidate->feature.constGeometry();
+    if ( !g2 )
     {
-      QgsFeature& f = mFeatureMap2[*cit].feature;
-      const QgsGeometry* g2 = f.constGeometry();
-      if ( !g2 || !g2->asGeos() )
-      {
-        QgsMessageLog::logMessage( tr( "Second geometry missing or GEOS import failed." ), tr( "Topology plugin" ) );
-        continue;
-      }
-      if ( g2->contains( g1 ) )
-      {
-        touched = true;
-        break;
-      }
+      QgsMessageLog::logMessage( tr( "Second geometry missing." ), tr( "Topology plugin" ) );
+      continue;
     }
-    if ( !touched )
+    if ( g2->contains( g1 ) )
     {
-      QgsGeometry* conflictGeom = new QgsGeometry( *g1 );
+      touched = true;
+      break;
+    }
+  }
+  if ( !touched )
+  {
+    QgsGeometry* conflictGeom = new QgsGeometry( *g1 );
 
-      if ( isExtent )
+    if ( context.isExtent )
+    {
+      if ( context.canvasExtentPoly->disjoint( conflictGeom ) )
       {
-        if ( canvasExtentPoly->disjoint( conflictGeom ) )
-        {
-          delete conflictGeom;
-          continue;
-        }
+        delete conflictGeom;
+        return errorList;
       }
+    }
 
-      QList<FeatureLayer> fls;
-      fls << *it << *it;
-      //bb.scale(10);
+    QList<FeatureLayer> fls;
+    fls << feature << feature;
+    //bb.scale(10);
 
-      TopolErrorPointNotInPolygon* err = new TopolErrorPointNotInPolygon( bb, conflictGeom, fls );
-      errorList << err;
-    }
+    TopolErrorPointNotInPolygon* err = new TopolErrorPointNotInPolygon( bb, conflictGeom, fls );
+    errorList << err;
   }
-
-  delete canvasExtentPoly;
   return errorList;
 }
 
@@ -1480,9 +1511,7 @@ ErrorList topolTest::checkPointInPolygon( double tolerance, QgsVectorLayer *laye
 ErrorList topolTest::checkPolygonContainsPoint( double tolerance, QgsVectorLayer *layer1, QgsVectorLayer *layer2, bool isExtent )
 {
   Q_UNUSED( tolerance );
-  Q_UNUSED( isExtent );
 
-  int i = 0;
   ErrorList errorList;
 
   if ( layer1->geometryType() != QGis::Polygon )
@@ -1497,81 +1526,73 @@ ErrorList topolTest::checkPolygonContainsPoint( double tolerance, QgsVectorLayer
 
   QgsSpatialIndex* index = mLayerIndexes[layer2->id()];
 
-  QList<FeatureLayer>::Iterator it;
-  for ( it = mFeatureList1.begin(); it != mFeatureList1.end(); ++it )
+  return runPartitioned( featurePointers( mFeatureList1 ), &topolTest::testPolygonContainsPoint,
+                         TestContext( layer1, layer2, index, isExtent, 0 ) );
+}
+
+ErrorList topolTest::testPolygonContainsPoint( const FeatureLayer& feature, const QList<const FeatureLayer*>& candidates, const TestContext& context )
+{
+  Q_UNUSED( context );
+
+  ErrorList errorList;
+
+  const QgsGeometry* g1 = feature.feature.constGeometry();
+  QgsRectangle bb = g1->boundingBox();
+  bool touched = false;
+  Q_FOREACH ( const FeatureLayer* candidate, candidates )
   {
-    if ( !( ++i % 100 ) )
-      emit progress( i );
-    if ( testCancelled() )
-      break;
-    QgsGeometry* g1 = it->feature.geometry();
-    QgsRectangle bb = g1->boundingBox();
-    QList<QgsFeatureId> crossingIds;
-    crossingIds = index->intersects( bb );
-    QList<QgsFeatureId>::Iterator cit = crossingIds.begin();
-    QList<QgsFeatureId>::ConstIterator crossingIdsEnd = crossingIds.end();
-    bool touched = false;
-    for ( ; cit != crossingIdsEnd; ++cit )
+    const QgsGeometry* g2 = candidate->feature.constGeometry();
+    if ( !g2 )
     {
-      QgsFeature& f = mFeatureMap2[*cit].feature;
-      const QgsGeometry* g2 = f.constGeometry();
-      if ( !g2 || !g2->asGeos() )
-      {
-        QgsMessageLog::logMessage( tr( "Second geometry missing or GEOS import failed." ), tr( "Topology plugin" ) );
-        continue;
-      }
-      if ( g1->contains( g2 ) )
-      {
-        touched = true;
-        break;
-      }
+      QgsMessageLog::logMessage( tr( "Second geometry missing." ), tr( "Topology plugin" ) );
+      continue;
     }
-    if ( !touched )
+    if ( g1->contains( g2 ) )
     {
-      QList<FeatureLayer> fls;
-      fls << *it << *it;
-      //bb.scale(10);
-      QgsGeometry* conflict = new QgsGeometry( *g1 );
-      TopolErrorPolygonContainsPoint* err = new TopolErrorPolygonContainsPoint( bb, conflict, fls );
-      errorList << err;
+      touched = true;
+      break;
     }
   }
+  if ( !touched )
+  {
+    QList<FeatureLayer> fls;
+    fls << feature << feature;
+    //bb.scale(10);
+    QgsGeometry* conflict = new QgsGeometry( *g1 );
+    TopolErrorPolygonContainsPoint* err = new TopolErrorPolygonContainsPoint( bb, conflict, fls );
+    errorList << err;
+  }
   return errorList;
 }
 
 ErrorList topolTest::checkMultipart( double tolerance, QgsVectorLayer *layer1, QgsVectorLayer *layer2, bool isExtent )
 {
   Q_UNUSED( tolerance );
-  Q_UNUSED( layer2 );
-  Q_UNUSED( layer1 );
-  Q_UNUSED( isExtent );
 
-  int i = 0;
+  return runPartitioned( featurePointers( mFeatureList1 ), &topolTest::testMultipart,
+                         TestContext( layer1, layer2, 0, isExtent, 0 ) );
+}
+
+ErrorList topolTest::testMultipart( const FeatureLayer& feature, const QList<const FeatureLayer*>& candidates, const TestContext& context )
+{
+  Q_UNUSED( candidates );
+  Q_UNUSED( context );
+
   ErrorList errorList;
-  QList<FeatureLayer>::Iterator it;
-  for ( it = mFeatureList1.begin(); it != mFeatureList1.end(); ++it )
+  const QgsGeometry* g = feature.feature.constGeometry();
+  if ( !g )
   {
-    if ( !( ++i % 100 ) )
-      emit progress( ++i );
-    if ( testCancelled() )
-      break;
-    QgsGeometry* g = it->feature.geometry();
-    if ( !g )
-    {
-      QgsMessageLog::logMessage( tr( "Missing geometry in multipart check." ), tr( "Topology plugin" ) );
-      continue;
-    }
-    if ( !g->asGeos() )
-      continue;
-    if ( g->isMultipart() )
-    {
-      QgsRectangle r = g->boundingBox();
-      QList<FeatureLayer> fls;
-      fls << *it << *it;
-      QgsGeometry* conflict = new QgsGeometry( *g );
-      TopolErroMultiPart* err = new TopolErroMultiPart( r, conflict, fls );
-      errorList << err;
-    }
+    QgsMessageLog::logMessage( tr( "Missing geometry in multipart check." ), tr( "Topology plugin" ) );
+    return errorList;
+  }
+  if ( g->isMultipart() )
+  {
+    QgsRectangle r = g->boundingBox();
+    QList<FeatureLayer> fls;
+    fls << feature << feature;
+    QgsGeometry* conflict = new QgsGeometry( *g );
+    TopolErroMultiPart* err = new TopolErroMultiPart( r, conflict, fls );
+    errorList << err;
   }
   return errorList;
 }
@@ -1670,6 +1691,173 @@ QgsSpatialIndex* topolTest::createIndex( QgsVectorLayer* layer, const QgsRectang
   return index;
 }
 
+ErrorList topolTest::runPartitioned( const QList<const FeatureLayer*>& features, featureTestFunction f, const TestContext& context )
+{
+  if ( features.isEmpty() )
+  {
+    return ErrorList();
+  }
+
+  QList<QgsRectangle> boxes;
+  QgsRectangle extent;
+  QList<const FeatureLayer*>::ConstIterator it;
+  for ( it = features.constBegin(); it != features.constEnd(); ++it )
+  {
+    QgsRectangle bb = ( *it )->feature.constGeometry()->boundingBox();
+    if ( boxes.isEmpty() )
+      extent = bb;
+    else
+      extent.combineExtentWith( &bb );
+    boxes << bb;
+  }
+
+  // the features are partitioned by a grid, each feature goes to the cell of its center
+  int cols, rows;
+  gridSize( extent, features.size(), PartitionSize, cols, rows );
+  double cellWidth = extent.width() / cols;
+  double cellHeight = extent.height() / rows;
+
+  QVector<TestPartition> cells( cols * rows );
+  for ( int i = 0; i < features.size(); ++i )
+  {
+    const QgsRectangle& bb = boxes[i];
+    QgsPoint center = bb.center();
+    int col = cellIndex( center.x(), extent.xMinimum(), cellWidth, cols );
+    int row = cellIndex( center.y(), extent.yMinimum(), cellHeight, rows );
+
+    TestPartition& cell = cells[row * cols + col];
+    if ( cell.features.isEmpty() )
+      cell.extent = bb;
+    else
+      cell.extent.combineExtentWith( &bb );
+    cell.features << features[i];
+    cell.boxes << bb;
+  }
+
+  QList<TestPartition> partitions;
+  for ( int c = 0; c < cells.size(); ++c )
+  {
+    if ( !cells[c].features.isEmpty() )
+      partitions << cells[c];
+  }
+  cells.clear();
+
+  QgsDebugMsg( QString( "checking %1 features in %2 partitions" ).arg( features.size() ).arg( partitions.size() ) );
+
+  return waitForWorkers( QtConcurrent::map( partitions, RunPartitionWrapper( this, f, context ) ) );
+}
+
+void topolTest::runPartition( TestPartition& partition, featureTestFunction f, const TestContext& context )
+{
+  if ( mWorkersCancelled )
+    return;
+
+  // the index is queried once for the whole partition, the candidates
+  // of each feature are picked from the result by their bounding boxes
+  QList<const FeatureLayer*> candidates;
+  QList<QgsRectangle> candidateBoxes;
+  if ( context.index )
+  {
+    QList<QgsFeatureId> crossingIds;
+    {
+      // the index is not safe for concurrent queries
+      QMutexLocker locker( &mIndexMutex );
+      crossingIds = context.index->intersects( partition.extent );
+    }
+
+    Q_FOREACH ( QgsFeatureId id, crossingIds )
+    {
+      QMap<QgsFeatureId, FeatureLayer>::ConstIterator it = mFeatureMap2.constFind( id );
+      if ( it == mFeatureMap2.constEnd() )
+        continue;
+
+      candidates << &it.value();
+      candidateBoxes << it->feature.constGeometry()->boundingBox();
+    }
+  }
+
+  ErrorList errors;
+  for ( int i = 0; i < partition.features.size(); ++i )
+  {
+    if ( mWorkersCancelled )
+      break;
+
+    const QgsRectangle& bb = partition.boxes[i];
+    QList<const FeatureLayer*> featureCandidates;
+    for ( int c = 0; c < candidates.size(); ++c )
+    {
+      if ( candidateBoxes[c].intersects( bb ) )
+        featureCandidates << candidates[c];
+    }
+
+    errors << ( this->*f )( *partition.features[i], featureCandidates, context );
+    mProgressCounter.ref();
+  }
+
+  QMutexLocker locker( &mErrorMutex );
+  mPendingErrors << errors;
+}
+
+ErrorList topolTest::waitForWorkers( const QFuture<void>& future )
+{
+  // the event loop keeps the progress dialog responsive while the workers run
+  QEventLoop loop;
+  QFutureWatcher<void> watcher;
+  QTimer timer;
+  connect( &watcher, SIGNAL( finished() ), &loop, SLOT( quit() ) );
+  connect( &timer, SIGNAL( timeout() ), this, SLOT( reportWorkerProgress() ) );
+  watcher.setFuture( future );
+  timer.start( 100 );
+  loop.exec();
+  timer.stop();
+
+  // pick up the errors of the last workers
+  reportWorkerProgress();
+
+  ErrorList errors = mWorkerErrors;
+  mWorkerErrors.clear();
+  return errors;
+}
+
+void topolTest::reportWorkerProgress()
+{
+  if ( testCancelled() )
+    mWorkersCancelled = 1;
+
+  emit progress( mProgressCounter );
+
+  ErrorList errors;
+  {
+    QMutexLocker locker( &mErrorMutex );
+    errors = mPendingErrors;
+    mPendingErrors.clear();
+  }
+
+  if ( errors.isEmpty() )
+    return;
+
+  mWorkerErrors << errors;
+  mReportedErrors += errors.size();
+  emit errorsFound( errors );
+}
+
+QHash<QgsFeatureId, QgsFeature> topolTest::fetchFeatures( QgsVectorLayer* layer, const QgsFeatureIds& ids )
+{
+  QHash<QgsFeatureId, QgsFeature> features;
+  if ( ids.isEmpty() )
+  {
+    return features;
+  }
+
+  QgsFeatureIterator fit = layer->getFeatures( QgsFeatureRequest().setFilterFids( ids ) );
+  QgsFeature f;
+  while ( fit.nextFeature( f ) )
+  {
+    features.insert( f.id(), f );
+  }
+  return features;
+}
+
 ErrorList topolTest::runTest( const QString& testName, QgsVectorLayer* layer1, QgsVectorLayer* layer2, ValidateType type, double tolerance )
 {
   QgsDebugMsg( QString( "Running test %1" ).arg( testName ) );
@@ -1694,8 +1882,13 @@ ErrorList topolTest::runTest( const QString& testName, QgsVectorLayer* layer1, Q
   //checking if new features are not
   //being recognised due to indexing not being upto date
 
+  qDeleteAll( mLayerIndexes );
   mLayerIndexes.clear();
 
+  mWorkersCancelled = 0;
+  mProgressCounter = 0;
+  mReportedErrors = 0;
+
   if ( mTopologyRuleMap[testName].useSecondLayer )
   {
     // validate all features or current extent
@@ -1764,5 +1957,18 @@ ErrorList topolTest::runTest( const QString& testName, QgsVectorLayer* layer1, Q
     isValidatingExtent = false;
   }
 
-  return ( this->*( mTopologyRuleMap[testName].f ) )( tolerance, layer1, layer2, isValidatingExtent );
+  // index creation was cancelled
+  if ( mLayerIndexes.values().contains( 0 ) )
+  {
+    return errors;
+  }
+
+  errors = ( this->*( mTopologyRuleMap[testName].f ) )( tolerance, layer1, layer2, isValidatingExtent );
+
+  // report the errors the test found outside of the workers
+  if ( mReportedErrors < errors.size() )
+  {
+    emit errorsFound( errors.mid( mReportedErrors ) );
+  }
+  return errors;
 }
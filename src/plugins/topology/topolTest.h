@@ -18,6 +18,9 @@
 #ifndef TOPOLTEST_H
 #define TOPOLTEST_H
 
+#include <QAtomicInt>
+#include <QFuture>
+#include <QMutex>
 #include <QObject>
 
 #include <qgsvectorlayer.h>
@@ -34,6 +37,30 @@ enum ValidateType { ValidateAll, ValidateExtent, ValidateSelected };
 
 typedef ErrorList( topolTest::*testFunction )( double, QgsVectorLayer*, QgsVectorLayer*, bool );
 
+/**
+ * Parameters of a test shared by the workers checking the features
+ */
+class TestContext
+{
+  public:
+    TestContext( QgsVectorLayer* layer1_, QgsVectorLayer* layer2_, QgsSpatialIndex* index_, bool isExtent_, const QgsGeometry* canvasExtentPoly_ )
+        : layer1( layer1_ )
+        , layer2( layer2_ )
+        , index( index_ )
+        , isExtent( isExtent_ )
+        , canvasExtentPoly( canvasExtentPoly_ )
+    {}
+
+    QgsVectorLayer* layer1;
+    QgsVectorLayer* layer2;
+    //! index of the features in the feature map, 0 if the test does not compare features
+    QgsSpatialIndex* index;
+    bool isExtent;
+    const QgsGeometry* canvasExtentPoly;
+};
+
+typedef ErrorList( topolTest::*featureTestFunction )( const FeatureLayer&, const QList<const FeatureLayer*>&, const TestContext& );
+
 class TopologyRule
 {
   public:
@@ -111,7 +138,9 @@ class topolTest: public QObject
      */
     QMap<QString, TopologyRule> testMap() { return mTopologyRuleMap; }
     /**
-     * Runs the test and returns all found errors
+     * Runs the test and returns all found errors.
+     * The features are checked in worker threads, the errors are reported by errorsFound()
+     * while the test is running.
      * @param testName name of the test
      * @param layer1 pointer to the first layer
      * @param layer2 pointer to the second layer
@@ -256,7 +285,64 @@ class topolTest: public QObject
      */
     void setTestCancelled();
 
+  private slots:
+    /**
+     * Emits progress and the errors collected by the workers so far
+     */
+    void reportWorkerProgress();
+
   private:
+    /**
+     * Features checked by one worker, close to each other
+     */
+    struct TestPartition
+    {
+      QList<const FeatureLayer*> features;
+      QList<QgsRectangle> boxes;
+      QgsRectangle extent;
+    };
+
+    /**
+     * Polygons intersecting a tile of the gap test
+     */
+    struct GapTile
+    {
+      QgsRectangle rect;
+      QList<const QgsGeometry*> polygons;
+      //! number of polygons centered in the tile, for progress
+      int featureCount;
+      //! gaps reaching the tile border, they may continue in the neighbour tiles
+      QList<QgsGeometry*> borderGaps;
+    };
+
+    class RunPartitionWrapper
+    {
+      public:
+        RunPartitionWrapper( topolTest* instance, featureTestFunction f, const TestContext& context )
+            : mInstance( instance ), mF( f ), mContext( context ) {}
+        void operator()( TestPartition& partition ) { mInstance->runPartition( partition, mF, mContext ); }
+      private:
+        topolTest* mInstance;
+        featureTestFunction mF;
+        TestContext mContext;
+    };
+
+    class CollectGapsWrapper
+    {
+      public:
+        CollectGapsWrapper( topolTest* instance, const TestContext& context )
+            : mInstance( instance ), mContext( context ) {}
+        void operator()( GapTile& tile ) { mInstance->collectGaps( tile, mContext ); }
+      private:
+        topolTest* mInstance;
+        TestContext mContext;
+    };
+
+    //! Number of features checked by one worker
+    static const int PartitionSize = 256;
+    //! Number of polygons per tile of the gap test
+    static const int GapTileSize = 500;
+
     QMap<QString, QgsSpatialIndex*> mLayerIndexes;
     QMap<QString, TopologyRule> mTopologyRuleMap;
 
@@ -266,6 +352,64 @@ class topolTest: public QObject
     QgisInterface* theQgsInterface;
     bool mTestCancelled;
 
+    // state of the workers of a running test
+    QAtomicInt mWorkersCancelled;
+    QAtomicInt mProgressCounter;
+    QMutex mIndexMutex;
+    QMutex mErrorMutex;
+    ErrorList mPendingErrors;
+    ErrorList mWorkerErrors;
+    int mReportedErrors;
+
+    /**
+     * Checks the features in worker threads, each feature is compared with the
+     * features of the feature map whose bounding boxes intersect its one
+     * @param features features to check
+     * @param f test of a feature
+     * @param context parameters of the test
+     */
+    ErrorList runPartitioned( const QList<const FeatureLayer*>& features, featureTestFunction f, const TestContext& context );
+
+    // tests of a single feature, the candidates are the features of the feature map
+    // whose bounding boxes intersect the feature's one
+    ErrorList testOverlapWithLayer( const FeatureLayer& feature, const QList<const FeatureLayer*>& candidates, const TestContext& context );
+    ErrorList testPointCoveredBySegment( const FeatureLayer& feature, const QList<const FeatureLayer*>& candidates, const TestContext& context );
+    ErrorList testValid( const FeatureLayer& feature, const QList<const FeatureLayer*>& candidates, const TestContext& context );
+    ErrorList testDuplicates( const FeatureLayer& feature, const QList<const FeatureLayer*>& candidates, const TestContext& context );
+    ErrorList testOverlaps( const FeatureLayer& feature, const QList<const FeatureLayer*>& candidates, const TestContext& context );
+    ErrorList testPointCoveredByLineEnds( const FeatureLayer& feature, const QList<const FeatureLayer*>& candidates, const TestContext& context );
+    ErrorList testPointInPolygon( const FeatureLayer& feature, const QList<const FeatureLayer*>& candidates, const TestContext& context );
+    ErrorList testPolygonContainsPoint( const FeatureLayer& feature, const QList<const FeatureLayer*>& candidates, const TestContext& context );
+    ErrorList testMultipart( const FeatureLayer& feature, const QList<const FeatureLayer*>& candidates, const TestContext& context );
+    ErrorList testLineEndsCoveredByPoints( const FeatureLayer& feature, const QList<const FeatureLayer*>& candidates, const TestContext& context );
+
+    /**
+     * Checks the features of a partition, runs in a worker thread
+     */
+    void runPartition( TestPartition& partition, featureTestFunction f, const TestContext& context );
+
+    /**
+     * Finds the gaps inside a tile, runs in a worker thread
+     */
+    void collectGaps( GapTile& tile, const TestContext& context );
+
+    /**
+     * Creates a gap error, returns 0 if the gap is outside the validated extent
+     * @param gap gap geometry, taken over
+     */
+    TopolError* createGapError( QgsGeometry* gap, const TestContext& context );
+
+    /**
+     * Waits for the workers while processing events and reporting their errors
+     * @returns the errors found by the workers
+     */
+    ErrorList waitForWorkers( const QFuture<void>& future );
+
+    /**
+     * Fetches the features of the layer with the given ids in one request
+     */
+    QHash<QgsFeatureId, QgsFeature> fetchFeatures( QgsVectorLayer* layer, const QgsFeatureIds& ids );
+
     /**
      * Builds spatial index for the layer
      * @param layer pointer to the layer
@@ -297,6 +441,12 @@ class topolTest: public QObject
      * @param value process status
      */
     void progress( int value );
+
+    /**
+     * Reports errors found by a running test
+     * @param errors new errors, all of them are also returned by runTest()
+     */
+    void errorsFound( const ErrorList& errors );
 };
 
 #endif
@@ -95,6 +95,21 @@ QgsDelimitedTextFeatureIterator::QgsDelimitedTextFeatureIterator( QgsDelimitedTe
     mMode = FeatureIds;
     mTestSubset = false;
   }
+  else if ( request.filterType() == QgsFeatureRequest::FilterFids )
+  {
+    QgsDebugMsg( "Configuring for returning a list of ids" );
+    // Records are located with the line offset index, sort them for sequential retrieval
+    QList<QgsFeatureId> featureIds;
+    Q_FOREACH ( QgsFeatureId fid, request.filterFids() )
+    {
+      // ids selected by the filter rectangle were sorted above
+      if ( mMode == FileScan || qBinaryFind( mFeatureIds.constBegin(), mFeatureIds.constEnd(), fid ) != mFeatureIds.constEnd() )
+        featureIds << fid;
+    }
+    qSort( featureIds.begin(), featureIds.end() );
+    mFeatureIds = featureIds;
+    mMode = FeatureIds;
+  }
   // If have geometry and testing geometry then evaluate options...
   // If we don't have geometry then all records pass geometry filter.
   // CC: 2013-05-09
@@ -491,6 +506,9 @@ QgsDelimitedTextFeatureSource::QgsDelimitedTextFeatureSource( const QgsDelimited
 {
   mFile = new QgsDelimitedTextFile();
   mFile->setFromUrl( p->mFile->url() );
+  // The lines indexed when the provider scanned the file, so that records are
+  // located without reading the file from the start
+  mFile->setLineOffsets( p->mFile->lineOffsets() );
 
   mExpressionContext << QgsExpressionContextUtils::globalScope()
   << QgsExpressionContextUtils::projectScope();
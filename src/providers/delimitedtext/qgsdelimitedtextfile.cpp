@@ -29,6 +29,11 @@
 #include <QRegExp>
 #include <QUrl>
 
+// Number of lines between the entries of the line offset index.  Getting the
+// position of a text stream is expensive, so only some lines are indexed and
+// the lines in between are read when seeking.
+#define LINE_OFFSET_INTERVAL 1024
+
 
 QgsDelimitedTextFile::QgsDelimitedTextFile( const QString& url ) :
     mFileName( QString() ),
@@ -124,6 +129,7 @@ bool QgsDelimitedTextFile::open()
 void QgsDelimitedTextFile::updateFile()
 {
   close();
+  mLineOffsets.clear();
   emit fileUpdated();
 }
 
@@ -131,6 +137,7 @@ void QgsDelimitedTextFile::updateFile()
 void QgsDelimitedTextFile::resetDefinition()
 {
   close();
+  mLineOffsets.clear();
   mFieldNames.clear();
   mMaxFieldCount = 0;
 }
@@ -557,6 +564,7 @@ QgsDelimitedTextFile::Status  QgsDelimitedTextFile::reset()
   // Reset the file pointer
   mStream->seek( 0 );
   mLineNumber = 0;
+  if ( mLineOffsets.isEmpty() ) mLineOffsets.append( 0 );
   mRecordNumber = -1;
   mRecordLineNumber = -1;
 
@@ -565,6 +573,7 @@ QgsDelimitedTextFile::Status  QgsDelimitedTextFile::reset()
   {
     if ( mStream->readLine().isNull() ) return RecordEOF;
     mLineNumber++;
+    indexLineOffset();
   }
   // Read the column names
   Status result = RecordOk;
@@ -591,6 +600,7 @@ QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextLine( QString &buffer, bo
     buffer = mStream->readLine();
     if ( buffer.isNull() ) break;
     mLineNumber++;
+    indexLineOffset();
     if ( skipBlank && buffer.isEmpty() ) continue;
     return RecordOk;
   }
@@ -602,7 +612,19 @@ QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextLine( QString &buffer, bo
 bool QgsDelimitedTextFile::setNextLineNumber( long nextLineNumber )
 {
   if ( ! mStream ) return false;
-  if ( mLineNumber > nextLineNumber - 1 )
+
+  // Seek to the closest indexed line before the next line if that saves
+  // reading lines (or rereading from the start)
+  long lastLine = nextLineNumber - 1;
+  if ( lastLine < 0 ) lastLine = 0;
+  long block = qMin( lastLine / LINE_OFFSET_INTERVAL, ( long ) mLineOffsets.size() - 1 );
+  if ( block >= 0 && ( mLineNumber > lastLine || block * LINE_OFFSET_INTERVAL > mLineNumber ) )
+  {
+    mRecordNumber = -1;
+    if ( ! mStream->seek( mLineOffsets[block] ) ) return false;
+    mLineNumber = block * LINE_OFFSET_INTERVAL;
+  }
+  else if ( mLineNumber > lastLine )
   {
     mRecordNumber = -1;
     mStream->seek( 0 );
@@ -617,6 +639,14 @@ bool QgsDelimitedTextFile::setNextLineNumber( long nextLineNumber )
 
 }
 
+void QgsDelimitedTextFile::indexLineOffset()
+{
+  // Only extend the index, the lines before have been indexed already
+  if ( mLineNumber != ( long ) mLineOffsets.size() * LINE_OFFSET_INTERVAL ) return;
+  qint64 pos = mStream->pos();
+  if ( pos >= 0 ) mLineOffsets.append( pos );
+}
+
 void QgsDelimitedTextFile::appendField( QStringList &record, QString field, bool quoted )
 {
   if ( mMaxFields > 0 && record.size() >= mMaxFields ) return;
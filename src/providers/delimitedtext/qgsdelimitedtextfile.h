@@ -19,6 +19,7 @@
 #define QGSDELIMITEDTEXTFILE_H
 
 #include <QStringList>
+#include <QVector>
 #include <QRegExp>
 #include <QUrl>
 #include <QObject>
@@ -261,6 +262,17 @@ class QgsDelimitedTextFile : public QObject
      *  @return maxRecordNumber The maximum record number
      */
     long recordCount() { return mMaxRecordNumber; }
+
+    /** Return the line offset index, the stream positions of some lines which
+     *  have been read. The index stays valid until the file is changed or its
+     *  definition is reset.
+     */
+    const QVector<qint64>& lineOffsets() const { return mLineOffsets; }
+
+    /** Set the line offset index, e.g. built by another instance reading the same file
+     *  @param lineOffsets The stream positions returned by lineOffsets()
+     */
+    void setLineOffsets( const QVector<qint64>& lineOffsets ) { mLineOffsets = lineOffsets; }
     /** Reset the file to reread from the beginning
      */
     Status reset();
@@ -338,6 +350,11 @@ class QgsDelimitedTextFile : public QObject
      */
     bool setNextLineNumber( long nextLineNumber );
 
+    /** Record the stream position of the next line in the line offset index
+     * if it is the first line of a new block of lines
+     */
+    void indexLineOffset();
+
     /** Utility routine to add a field to a record, accounting for trimming
      *  and discarding, and maximum field count
      */
@@ -379,6 +396,9 @@ class QgsDelimitedTextFile : public QObject
     bool mHoldCurrentRecord;
     // Maximum number of record (ie maximum record number visited)
     long mMaxRecordNumber;
+    // Stream positions of every LINE_OFFSET_INTERVAL'th line, to seek to
+    // records without reading the file from the start
+    QVector<qint64> mLineOffsets;
     int mMaxFieldCount;
 
     QString mDefaultFieldName;
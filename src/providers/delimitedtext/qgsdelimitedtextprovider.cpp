@@ -26,6 +26,8 @@
 #include <QSettings>
 #include <QRegExp>
 #include <QUrl>
+#include <QThread>
+#include <QtConcurrentRun>
 
 #include "qgsapplication.h"
 #include "qgsdataprovider.h"
@@ -52,6 +54,10 @@ static const QString TEXT_PROVIDER_DESCRIPTION = "Delimited text data provider";
 
 static const int SUBSET_ID_THRESHOLD_FACTOR = 10;
 
+// Number of records parsed at a time by a thread when scanning the file
+
+static const int SCAN_BATCH_SIZE = 2000;
+
 QRegExp QgsDelimitedTextProvider::WktPrefixRegexp( "^\\s*(?:\\d+\\s+|SRID\\=\\d+\\;)", Qt::CaseInsensitive );
 QRegExp QgsDelimitedTextProvider::WktZMRegexp( "\\s*(?:z|m|zm)(?=\\s*\\()", Qt::CaseInsensitive );
 QRegExp QgsDelimitedTextProvider::WktCrdRegexp( "(\\-?\\d+(?:\\.\\d*)?\\s+\\-?\\d+(?:\\.\\d*)?)\\s[\\s\\d\\.\\-]+" );
@@ -313,6 +319,217 @@ bool QgsDelimitedTextProvider::createSpatialIndex()
   return true;
 }
 
+// Possible types of the values of each field, narrowed down by each value
+// read from the file.  Types are possible until the first value which cannot
+// be parsed.
+
+struct QgsDelimitedTextProvider::FieldTypes
+{
+  QList<bool> isEmpty;
+  QList<bool> couldBeInt;
+  QList<bool> couldBeLongLong;
+  QList<bool> couldBeDouble;
+
+  void expand( int size )
+  {
+    while ( couldBeInt.size() < size )
+    {
+      isEmpty.append( true );
+      couldBeInt.append( false );
+      couldBeLongLong.append( false );
+      couldBeDouble.append( false );
+    }
+  }
+
+  void update( QStringList& values, const QString& decimalPoint )
+  {
+    for ( int i = 0; i < values.size(); i++ )
+    {
+      QString &value = values[i];
+      // Ignore empty fields - spreadsheet generated CSV files often
+      // have random empty fields at the end of a row
+      if ( value.isEmpty() )
+        continue;
+
+      // Expand the columns to include this non empty field if necessary
+      expand( i + 1 );
+
+      // If this column has been empty so far then initiallize it
+      // for possible types
+      if ( isEmpty[i] )
+      {
+        isEmpty[i] = false;
+        couldBeInt[i] = true;
+        couldBeLongLong[i] = true;
+        couldBeDouble[i] = true;
+      }
+
+      if ( couldBeInt[i] )
+      {
+        value.toInt( &couldBeInt[i] );
+      }
+
+      if ( couldBeLongLong[i] && ! couldBeInt[i] )
+      {
+        value.toLongLong( &couldBeLongLong[i] );
+      }
+
+      if ( couldBeDouble[i] && ! couldBeLongLong[i] )
+      {
+        if ( ! decimalPoint.isEmpty() )
+        {
+          value.replace( decimalPoint, "." );
+        }
+        value.toDouble( &couldBeDouble[i] );
+      }
+    }
+  }
+
+  // Integers are also long longs and doubles, so the types from separately
+  // parsed records combine as if parsed together
+  void merge( const FieldTypes& other )
+  {
+    expand( other.couldBeInt.size() );
+    for ( int i = 0; i < other.couldBeInt.size(); i++ )
+    {
+      if ( other.isEmpty[i] )
+        continue;
+      if ( isEmpty[i] )
+      {
+        isEmpty[i] = false;
+        couldBeInt[i] = other.couldBeInt[i];
+        couldBeLongLong[i] = other.couldBeLongLong[i];
+        couldBeDouble[i] = other.couldBeDouble[i];
+      }
+      else
+      {
+        couldBeInt[i] = couldBeInt[i] && other.couldBeInt[i];
+        couldBeLongLong[i] = couldBeLongLong[i] && other.couldBeLongLong[i];
+        couldBeDouble[i] = couldBeDouble[i] && other.couldBeDouble[i];
+      }
+    }
+  }
+};
+
+struct QgsDelimitedTextProvider::ScanRecord
+{
+  enum Result
+  {
+    BadFormat,
+    NoGeometry,        // layer without geometry, or WKT of an empty geometry
+    EmptyGeometry,
+    InvalidGeometry,
+    Geometry
+  };
+
+  ScanRecord() : recordId( -1 ), result( NoGeometry ), geometry( 0 ), wkbType( QGis::WKBUnknown ), geometryType( QGis::UnknownGeometry ), isMultipart( false ), wktExtraOrdinates( false ) {}
+
+  // Sets the result for the geometry parsed from the WKT, taking ownership of it
+  void setWktGeometry( QgsGeometry* geom )
+  {
+    delete geometry;
+    geometry = 0;
+    if ( !geom )
+    {
+      result = InvalidGeometry;
+    }
+    else if ( geom->wkbType() == QGis::WKBNoGeometry )
+    {
+      result = NoGeometry;
+      delete geom;
+    }
+    else
+    {
+      result = Geometry;
+      geometry = geom;
+      wkbType = geom->wkbType();
+      geometryType = geom->type();
+      isMultipart = geom->isMultipart();
+      bbox = geom->boundingBox();
+    }
+  }
+
+  long recordId;
+  QStringList parts;
+  Result result;
+  QgsGeometry* geometry;
+  QGis::WkbType wkbType;
+  QGis::GeometryType geometryType;
+  bool isMultipart;
+  QgsRectangle bbox;
+  // The WKT has extra ordinates but no Z/M keyword and was parsed before any record
+  // of the batch had one. It is parsed again when merged if a previous batch had one,
+  // and its field types are only assessed then.
+  bool wktExtraOrdinates;
+};
+
+struct QgsDelimitedTextProvider::ScanBatch
+{
+  ScanBatch( GeomRepresentationType geomRep, int wktFieldIndex, int xFieldIndex, int yFieldIndex, const QString& decimalPoint, bool xyDms )
+      : geomRep( geomRep )
+      , wktFieldIndex( wktFieldIndex )
+      , xFieldIndex( xFieldIndex )
+      , yFieldIndex( yFieldIndex )
+      , decimalPoint( decimalPoint )
+      , xyDms( xyDms )
+      , wktHasPrefix( false )
+      , wktHasZM( false )
+      , prefixRegexp( WktPrefixRegexp )
+      , zmRegexp( WktZMRegexp )
+      , crdRegexp( WktCrdRegexp )
+  {}
+
+  ~ScanBatch()
+  {
+    Q_FOREACH ( const ScanRecord& record, records )
+      delete record.geometry;
+  }
+
+  GeomRepresentationType geomRep;
+  int wktFieldIndex;
+  int xFieldIndex;
+  int yFieldIndex;
+  QString decimalPoint;
+  bool xyDms;
+
+  QList<ScanRecord> records;
+  bool wktHasPrefix;
+  bool wktHasZM;
+  // Copies of the WKT regular expressions for the worker thread, as matching changes their state
+  QRegExp prefixRegexp;
+  QRegExp zmRegexp;
+  QRegExp crdRegexp;
+  // Field types of the records which are valid whatever the layer geometry type is
+  FieldTypes types;
+  // Field types of the records by geometry type, only those matching the layer
+  // geometry type are used
+  QMap<int, FieldTypes> geometryTypes;
+};
+
+struct QgsDelimitedTextProvider::ScanState
+{
+  ScanState()
+      : buildSpatialIndex( false )
+      , buildSubsetIndex( false )
+      , foundFirstGeometry( false )
+      , nEmptyRecords( 0 )
+      , nBadFormatRecords( 0 )
+      , nIncompatibleGeometry( 0 )
+      , nInvalidGeometry( 0 )
+      , nEmptyGeometry( 0 )
+  {}
+
+  bool buildSpatialIndex;
+  bool buildSubsetIndex;
+  bool foundFirstGeometry;
+  long nEmptyRecords;
+  long nBadFormatRecords;
+  long nIncompatibleGeometry;
+  long nInvalidGeometry;
+  long nEmptyGeometry;
+  FieldTypes fieldTypes;
+};
+
 // Really want to merge scanFile and rescan into single code.  Currently the reason
 // this is not done is that scanFile is done initially to create field names and, rescan
 // file includes building subset expression and assumes field names/types are already
@@ -396,225 +613,71 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
   //
   // Also build subset and spatial indexes.
 
-  QStringList parts;
-  long nEmptyRecords = 0;
-  long nBadFormatRecords = 0;
-  long nIncompatibleGeometry = 0;
-  long nInvalidGeometry = 0;
-  long nEmptyGeometry = 0;
+  // The records are read sequentially, as they may span several lines, and
+  // parsed (geometries, field types) in parallel batches. The results of the
+  // batches are merged in file order, so that the first geometry determines the
+  // geometry type of the layer as when parsing sequentially.
+
+  ScanState state;
+  state.buildSpatialIndex = buildSpatialIndex;
+  state.buildSubsetIndex = buildSubsetIndex;
   mNumberFeatures = 0;
   mExtent = QgsRectangle();
 
-  QList<bool> isEmpty;
-  QList<bool> couldBeInt;
-  QList<bool> couldBeLongLong;
-  QList<bool> couldBeDouble;
-  bool foundFirstGeometry = false;
+  int maxPendingBatches = qMax( 1, QThread::idealThreadCount() ) * 2;
+  QList<ScanBatch*> batches;
+  QList< QFuture<void> > futures;
+  bool atEnd = false;
 
-  while ( true )
+  while ( !atEnd || !batches.isEmpty() )
   {
-    QgsDelimitedTextFile::Status status = mFile->nextRecord( parts );
-    if ( status == QgsDelimitedTextFile::RecordEOF ) break;
-    if ( status != QgsDelimitedTextFile::RecordOk )
-    {
-      nBadFormatRecords++;
-      recordInvalidLine( tr( "Invalid record format at line %1" ) );
-      continue;
-    }
-    // Skip over empty records
-    if ( recordIsEmpty( parts ) )
+    if ( !atEnd && batches.size() < maxPendingBatches )
     {
-      nEmptyRecords++;
-      continue;
-    }
-
-    // Check geometries are valid
-    bool geomValid = true;
-
-    if ( mGeomRep == GeomAsWkt )
-    {
-      if ( mWktFieldIndex >= parts.size() || parts[mWktFieldIndex].isEmpty() )
+      ScanBatch* batch = new ScanBatch( mGeomRep, mWktFieldIndex, mXFieldIndex, mYFieldIndex, mDecimalPoint, mXyDms );
+      while ( batch->records.size() < SCAN_BATCH_SIZE )
       {
-        nEmptyGeometry++;
-        mNumberFeatures++;
-      }
-      else
-      {
-        // Get the wkt - confirm it is valid, get the type, and
-        // if compatible with the rest of file, add to the extents
-
-        QString sWkt = parts[mWktFieldIndex];
-        QgsGeometry *geom = 0;
-        if ( !mWktHasPrefix && sWkt.indexOf( WktPrefixRegexp ) >= 0 )
-          mWktHasPrefix = true;
-        if ( !mWktHasZM && sWkt.indexOf( WktZMRegexp ) >= 0 )
-          mWktHasZM = true;
-        geom = geomFromWkt( sWkt, mWktHasPrefix, mWktHasZM );
-
-        if ( geom )
+        ScanRecord record;
+        QgsDelimitedTextFile::Status status = mFile->nextRecord( record.parts );
+        if ( status == QgsDelimitedTextFile::RecordEOF )
         {
-          QGis::WkbType type = geom->wkbType();
-          if ( type != QGis::WKBNoGeometry )
-          {
-            if ( mGeometryType == QGis::UnknownGeometry || geom->type() == mGeometryType )
-            {
-              mGeometryType = geom->type();
-              if ( !foundFirstGeometry )
-              {
-                mNumberFeatures++;
-                mWkbType = type;
-                mExtent = geom->boundingBox();
-                foundFirstGeometry = true;
-              }
-              else
-              {
-                mNumberFeatures++;
-                if ( geom->isMultipart() ) mWkbType = type;
-                QgsRectangle bbox( geom->boundingBox() );
-                mExtent.combineExtentWith( &bbox );
-              }
-              if ( buildSpatialIndex )
-              {
-                QgsFeature f;
-                f.setFeatureId( mFile->recordId() );
-                f.setGeometry( geom );
-                mSpatialIndex->insertFeature( f );
-                // Feature now has ownership of geometry, so set to null
-                // here to avoid deleting twice.
-                geom = 0;
-              }
-            }
-            else
-            {
-              nIncompatibleGeometry++;
-              geomValid = false;
-            }
-          }
-          if ( geom ) delete geom;
+          atEnd = true;
+          break;
         }
-        else
-        {
-          geomValid = false;
-          nInvalidGeometry++;
-          recordInvalidLine( tr( "Invalid WKT at line %1" ) );
-        }
-      }
-    }
-    else if ( mGeomRep == GeomAsXy )
-    {
-      // Get the x and y values, first checking to make sure they
-      // aren't null.
-
-      QString sX = mXFieldIndex < parts.size() ? parts[mXFieldIndex] : QString();
-      QString sY = mYFieldIndex < parts.size() ? parts[mYFieldIndex] : QString();
-      if ( sX.isEmpty() && sY.isEmpty() )
-      {
-        nEmptyGeometry++;
-        mNumberFeatures++;
-      }
-      else
-      {
-        QgsPoint pt;
-        bool ok = pointFromXY( sX, sY, pt, mDecimalPoint, mXyDms );
-
-        if ( ok )
+        record.recordId = mFile->recordId();
+        if ( status != QgsDelimitedTextFile::RecordOk )
         {
-          if ( foundFirstGeometry )
-          {
-            mExtent.combineExtentWith( pt.x(), pt.y() );
-          }
-          else
-          {
-            // Extent for the first point is just the first point
-            mExtent.set( pt.x(), pt.y(), pt.x(), pt.y() );
-            mWkbType = QGis::WKBPoint;
-            mGeometryType = QGis::Point;
-            foundFirstGeometry = true;
-          }
-          mNumberFeatures++;
-          if ( buildSpatialIndex && qIsFinite( pt.x() ) && qIsFinite( pt.y() ) )
-          {
-            QgsFeature f;
-            f.setFeatureId( mFile->recordId() );
-            f.setGeometry( QgsGeometry::fromPoint( pt ) );
-            mSpatialIndex->insertFeature( f );
-          }
+          record.result = ScanRecord::BadFormat;
         }
-        else
+        // Skip over empty records
+        else if ( recordIsEmpty( record.parts ) )
         {
-          geomValid = false;
-          nInvalidGeometry++;
-          recordInvalidLine( tr( "Invalid X or Y fields at line %1" ) );
+          state.nEmptyRecords++;
+          continue;
         }
+        batch->records.append( record );
       }
+      batches.append( batch );
+      futures.append( QtConcurrent::run( &QgsDelimitedTextProvider::scanBatch, batch ) );
     }
     else
     {
-      mWkbType = QGis::WKBNoGeometry;
-      mNumberFeatures++;
-    }
-
-    if ( ! geomValid ) continue;
-
-    if ( buildSubsetIndex ) mSubsetIndex.append( mFile->recordId() );
-
-
-    // If we are going to use this record, then assess the potential types of each colum
-
-    for ( int i = 0; i < parts.size(); i++ )
-    {
-
-      QString &value = parts[i];
-      // Ignore empty fields - spreadsheet generated CSV files often
-      // have random empty fields at the end of a row
-      if ( value.isEmpty() )
-        continue;
-
-      // Expand the columns to include this non empty field if necessary
-
-      while ( couldBeInt.size() <= i )
-      {
-        isEmpty.append( true );
-        couldBeInt.append( false );
-        couldBeLongLong.append( false );
-        couldBeDouble.append( false );
-      }
-
-      // If this column has been empty so far then initiallize it
-      // for possible types
-
-      if ( isEmpty[i] )
-      {
-        isEmpty[i] = false;
-        couldBeInt[i] = true;
-        couldBeLongLong[i] = true;
-        couldBeDouble[i] = true;
-      }
-
-      // Now test for still valid possible types for the field
-      // Types are possible until first record which cannot be parsed
-
-      if ( couldBeInt[i] )
-      {
-        value.toInt( &couldBeInt[i] );
-      }
-
-      if ( couldBeLongLong[i] && ! couldBeInt[i] )
-      {
-        value.toLongLong( &couldBeLongLong[i] );
-      }
-
-      if ( couldBeDouble[i] && ! couldBeLongLong[i] )
-      {
-        if ( ! mDecimalPoint.isEmpty() )
-        {
-          value.replace( mDecimalPoint, "." );
-        }
-        value.toDouble( &couldBeDouble[i] );
-      }
+      futures.first().waitForFinished();
+      futures.removeFirst();
+      ScanBatch* batch = batches.takeFirst();
+      mergeScanBatch( batch, state );
+      delete batch;
     }
   }
 
+  const FieldTypes& fieldTypes = state.fieldTypes;
+  const QList<bool>& couldBeInt = fieldTypes.couldBeInt;
+  const QList<bool>& couldBeLongLong = fieldTypes.couldBeLongLong;
+  const QList<bool>& couldBeDouble = fieldTypes.couldBeDouble;
+  long nBadFormatRecords = state.nBadFormatRecords;
+  long nIncompatibleGeometry = state.nIncompatibleGeometry;
+  long nInvalidGeometry = state.nInvalidGeometry;
+  long nEmptyGeometry = state.nEmptyGeometry;
+
   // Now create the attribute fields.  Field types are integer by preference,
   // failing that double, failing that text.
 
@@ -715,6 +778,190 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
 
 }
 
+// Parses the geometries and assesses the field types of a batch of records.
+// Runs in a worker thread, so only uses the batch.
+
+void QgsDelimitedTextProvider::scanBatch( ScanBatch* batch )
+{
+  for ( int r = 0; r < batch->records.size(); r++ )
+  {
+    ScanRecord& record = batch->records[r];
+    if ( record.result == ScanRecord::BadFormat )
+      continue;
+
+    QStringList& parts = record.parts;
+    if ( batch->geomRep == GeomAsWkt )
+    {
+      if ( batch->wktFieldIndex >= parts.size() || parts[batch->wktFieldIndex].isEmpty() )
+      {
+        record.result = ScanRecord::EmptyGeometry;
+      }
+      else
+      {
+        // The prefix is anchored, so removing it from each record which has one gives
+        // the same geometries as removing it from all records after the first one.
+        // Z/M ordinates are removed from all records after the first one with a Z/M
+        // keyword, records before that are fixed up when merged.
+        QString sWkt = parts[batch->wktFieldIndex];
+        bool hasPrefix = batch->prefixRegexp.indexIn( sWkt ) >= 0;
+        batch->wktHasPrefix = batch->wktHasPrefix || hasPrefix;
+        if ( !batch->wktHasZM )
+        {
+          batch->wktHasZM = batch->zmRegexp.indexIn( sWkt ) >= 0;
+          record.wktExtraOrdinates = !batch->wktHasZM && batch->crdRegexp.indexIn( sWkt ) >= 0;
+        }
+
+        record.setWktGeometry( geomFromWkt( sWkt, hasPrefix, batch->wktHasZM, batch->prefixRegexp, batch->zmRegexp, batch->crdRegexp ) );
+      }
+    }
+    else if ( batch->geomRep == GeomAsXy )
+    {
+      // Get the x and y values, first checking to make sure they
+      // aren't null.
+
+      QString sX = batch->xFieldIndex < parts.size() ? parts[batch->xFieldIndex] : QString();
+      QString sY = batch->yFieldIndex < parts.size() ? parts[batch->yFieldIndex] : QString();
+      if ( sX.isEmpty() && sY.isEmpty() )
+      {
+        record.result = ScanRecord::EmptyGeometry;
+      }
+      else
+      {
+        QgsPoint pt;
+        if ( pointFromXY( sX, sY, pt, batch->decimalPoint, batch->xyDms ) )
+        {
+          record.result = ScanRecord::Geometry;
+          record.wkbType = QGis::WKBPoint;
+          record.geometryType = QGis::Point;
+          record.bbox.set( pt.x(), pt.y(), pt.x(), pt.y() );
+        }
+        else
+        {
+          record.result = ScanRecord::InvalidGeometry;
+        }
+      }
+    }
+
+    // If we are going to use this record, then assess the potential types of each colum
+
+    if ( record.wktExtraOrdinates )
+    {
+      continue;
+    }
+    else if ( record.result == ScanRecord::Geometry )
+    {
+      batch->geometryTypes[record.geometryType].update( parts, batch->decimalPoint );
+    }
+    else if ( record.result != ScanRecord::InvalidGeometry )
+    {
+      batch->types.update( parts, batch->decimalPoint );
+    }
+  }
+}
+
+// Adds the results of a parsed batch of records to the layer.  The batches
+// must be merged in file order.
+
+void QgsDelimitedTextProvider::mergeScanBatch( ScanBatch* batch, ScanState& state )
+{
+  mWktHasPrefix = mWktHasPrefix || batch->wktHasPrefix;
+
+  for ( int r = 0; r < batch->records.size(); r++ )
+  {
+    ScanRecord& record = batch->records[r];
+    if ( record.wktExtraOrdinates && mWktHasZM )
+    {
+      // A previous batch had a Z/M keyword, so the extra ordinates are removed
+      QString sWkt = record.parts[mWktFieldIndex];
+      record.setWktGeometry( geomFromWkt( sWkt, true, true, batch->prefixRegexp, batch->zmRegexp, batch->crdRegexp ) );
+    }
+
+    switch ( record.result )
+    {
+      case ScanRecord::BadFormat:
+        state.nBadFormatRecords++;
+        recordInvalidLine( tr( "Invalid record format at line %1" ), record.recordId );
+        continue;
+
+      case ScanRecord::InvalidGeometry:
+        state.nInvalidGeometry++;
+        if ( mGeomRep == GeomAsWkt )
+          recordInvalidLine( tr( "Invalid WKT at line %1" ), record.recordId );
+        else
+          recordInvalidLine( tr( "Invalid X or Y fields at line %1" ), record.recordId );
+        continue;
+
+      case ScanRecord::EmptyGeometry:
+        state.nEmptyGeometry++;
+        mNumberFeatures++;
+        break;
+
+      case ScanRecord::NoGeometry:
+        if ( mGeomRep == GeomNone )
+        {
+          mWkbType = QGis::WKBNoGeometry;
+          mNumberFeatures++;
+        }
+        break;
+
+      case ScanRecord::Geometry:
+        // Only geometries compatible with the first one are used
+        if ( mGeometryType != QGis::UnknownGeometry && record.geometryType != mGeometryType )
+        {
+          state.nIncompatibleGeometry++;
+          continue;
+        }
+        mGeometryType = record.geometryType;
+        mNumberFeatures++;
+        if ( !state.foundFirstGeometry )
+        {
+          mWkbType = record.wkbType;
+          mExtent = record.bbox;
+          state.foundFirstGeometry = true;
+        }
+        else
+        {
+          if ( record.isMultipart ) mWkbType = record.wkbType;
+          mExtent.combineExtentWith( &record.bbox );
+        }
+        if ( state.buildSpatialIndex )
+        {
+          QgsFeature f;
+          f.setFeatureId( record.recordId );
+          if ( mGeomRep == GeomAsWkt )
+          {
+            // Feature takes ownership of the geometry
+            f.setGeometry( record.geometry );
+            record.geometry = 0;
+            mSpatialIndex->insertFeature( f );
+          }
+          else if ( qIsFinite( record.bbox.xMinimum() ) && qIsFinite( record.bbox.yMinimum() ) )
+          {
+            f.setGeometry( QgsGeometry::fromPoint( QgsPoint( record.bbox.xMinimum(), record.bbox.yMinimum() ) ) );
+            mSpatialIndex->insertFeature( f );
+          }
+        }
+        break;
+    }
+
+    if ( state.buildSubsetIndex ) mSubsetIndex.append( record.recordId );
+
+    // Field types of records parsed again are assessed here, as the record is used
+    if ( record.wktExtraOrdinates )
+    {
+      QStringList parts = record.parts;
+      state.fieldTypes.update( parts, mDecimalPoint );
+    }
+  }
+
+  mWktHasZM = mWktHasZM || batch->wktHasZM;
+  state.fieldTypes.merge( batch->types );
+  if ( batch->geometryTypes.contains( mGeometryType ) )
+  {
+    state.fieldTypes.merge( batch->geometryTypes[mGeometryType] );
+  }
+}
+
 // rescanFile.  Called if something has changed file definition, such as
 // selecting a subset, the file has been changed by another program, etc
 
@@ -813,18 +1060,24 @@ void QgsDelimitedTextProvider::rescanFile()
 }
 
 QgsGeometry *QgsDelimitedTextProvider::geomFromWkt( QString &sWkt, bool wktHasPrefixRegexp, bool wktHasZM )
+{
+  return geomFromWkt( sWkt, wktHasPrefixRegexp, wktHasZM, QRegExp( WktPrefixRegexp ), QRegExp( WktZMRegexp ), QRegExp( WktCrdRegexp ) );
+}
+
+QgsGeometry *QgsDelimitedTextProvider::geomFromWkt( QString &sWkt, bool wktHasPrefixRegexp, bool wktHasZM,
+    const QRegExp& prefixRegexp, const QRegExp& zmRegexp, const QRegExp& crdRegexp )
 {
   QgsGeometry *geom = 0;
   try
   {
     if ( wktHasPrefixRegexp )
     {
-      sWkt.remove( WktPrefixRegexp );
+      sWkt.remove( prefixRegexp );
     }
 
     if ( wktHasZM )
     {
-      sWkt.remove( WktZMRegexp ).replace( WktCrdRegexp, "\\1" );
+      sWkt.remove( zmRegexp ).replace( crdRegexp, "\\1" );
     }
     geom = QgsGeometry::fromWkt( sWkt );
   }
@@ -931,11 +1184,11 @@ bool QgsDelimitedTextProvider::recordIsEmpty( QStringList &record )
   return true;
 }
 
-void QgsDelimitedTextProvider::recordInvalidLine( const QString& message )
+void QgsDelimitedTextProvider::recordInvalidLine( const QString& message, long recordId )
 {
   if ( mInvalidLines.size() < mMaxInvalidLines )
   {
-    mInvalidLines.append( message.arg( mFile->recordId() ) );
+    mInvalidLines.append( message.arg( recordId ) );
   }
   else
   {
@@ -220,18 +220,29 @@ class QgsDelimitedTextProvider : public QgsVectorDataProvider
     static QRegExp WktZMRegexp;
     static QRegExp WktCrdRegexp;
 
+    // Types used to parse batches of records in parallel when scanning the file
+    struct FieldTypes;
+    struct ScanRecord;
+    struct ScanBatch;
+    struct ScanState;
+
     void scanFile( bool buildIndexes );
+    static void scanBatch( ScanBatch* batch );
+    void mergeScanBatch( ScanBatch* batch, ScanState& state );
     void rescanFile();
     void resetCachedSubset();
     void resetIndexes();
     void clearInvalidLines();
-    void recordInvalidLine( const QString& message );
+    void recordInvalidLine( const QString& message, long recordId );
     void reportErrors( const QStringList& messages = QStringList(), bool showDialog = false );
     static bool recordIsEmpty( QStringList &record );
     void setUriParameter( const QString& parameter, const QString& value );
 
 
     static QgsGeometry *geomFromWkt( QString &sWkt, bool wktHasPrefixRegexp, bool wktHasZM );
+    // Variant using the given copies of the WKT regular expressions, as they cannot be shared between threads
+    static QgsGeometry *geomFromWkt( QString &sWkt, bool wktHasPrefixRegexp, bool wktHasZM,
+                                     const QRegExp& prefixRegexp, const QRegExp& zmRegexp, const QRegExp& crdRegexp );
     static bool pointFromXY( QString &sX, QString &sY, QgsPoint &point, const QString& decimalPoint, bool xyDms );
     static double dmsStringToDouble( const QString &sX, bool *xOk );
 
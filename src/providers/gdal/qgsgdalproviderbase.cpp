@@ -22,8 +22,12 @@
 #include "qgslogger.h"
 #include "qgsgdalproviderbase.h"
 
+#include <QMutex>
+#include <QMutexLocker>
 #include <QSettings>
 
+static QMutex sRegisterDriversMutex;
+
 QgsGdalProviderBase::QgsGdalProviderBase()
 {
   QgsDebugMsg( "Entered" );
@@ -195,6 +199,10 @@ int QgsGdalProviderBase::colorInterpretationFromGdal( const GDALColorInterp gdal
 
 void QgsGdalProviderBase::registerGdalDrivers()
 {
+  // providers may be created in several threads when a project loads its layers,
+  // the skip list of the application is not safe to be changed concurrently
+  QMutexLocker locker( &sRegisterDriversMutex );
+
   GDALAllRegister();
   QSettings mySettings;
   QString myJoinedList = mySettings.value( "gdal/skipList", "" ).toString();
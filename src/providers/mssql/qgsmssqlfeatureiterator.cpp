@@ -29,6 +29,7 @@
 QgsMssqlFeatureIterator::QgsMssqlFeatureIterator( QgsMssqlFeatureSource* source, bool ownSource, const QgsFeatureRequest& request )
     : QgsAbstractFeatureIteratorFromSource<QgsMssqlFeatureSource>( source, ownSource, request )
     , mExpressionCompiled( false )
+    , mOrderByCompiled( false )
 {
   mClosed = false;
   mQuery = NULL;
@@ -191,6 +192,44 @@ void QgsMssqlFeatureIterator::BuildStatement( const QgsFeatureRequest& request )
     }
   }
 
+  QStringList orderByParts;
+  mOrderByCompiled = true;
+  if ( QSettings().value( "/qgis/compileExpressions", true ).toBool() )
+  {
+    Q_FOREACH ( const QgsFeatureRequest::OrderByClause& clause, request.orderBy() )
+    {
+      QgsMssqlExpressionCompiler compiler = QgsMssqlExpressionCompiler( mSource );
+      QgsExpression expression( clause.expression() );
+      if ( compiler.compile( &expression ) != QgsSqlExpressionCompiler::Complete )
+      {
+        // the compiled clauses before still pre-sort the features, the rest is sorted locally
+        mOrderByCompiled = false;
+        break;
+      }
+
+      // SQL Server sorts NULLs first in ascending order and has no NULLS FIRST/LAST
+      QString part = compiler.result();
+      if ( clause.nullsFirst() != clause.ascending() )
+        orderByParts << QString( "CASE WHEN (%1) IS NULL THEN %2 ELSE %3 END" ).arg( part ).arg( clause.nullsFirst() ? 0 : 1 ).arg( clause.nullsFirst() ? 1 : 0 );
+      orderByParts << part + ( clause.ascending() ? " ASC" : " DESC" );
+    }
+  }
+  else
+  {
+    mOrderByCompiled = request.orderBy().isEmpty();
+  }
+
+  // the limit applies to the features ordered locally
+  if ( !mOrderByCompiled )
+    limitAtProvider = false;
+
+  if ( !orderByParts.isEmpty() )
+  {
+    mStatement += " ORDER BY " + orderByParts.join( "," );
+    if ( !mFallbackStatement.isEmpty() )
+      mFallbackStatement += " ORDER BY " + orderByParts.join( "," );
+  }
+
   if ( request.limit() >= 0 && limitAtProvider )
   {
     mStatement.prepend( QString( "SELECT TOP %1 " ).arg( mRequest.limit() ) );
@@ -259,6 +298,13 @@ bool QgsMssqlFeatureIterator::fetchFeature( QgsFeature& feature )
   return false;
 }
 
+bool QgsMssqlFeatureIterator::prepareOrderBy( const QList<QgsFeatureRequest::OrderByClause>& orderBys )
+{
+  Q_UNUSED( orderBys )
+  // the order by clauses were compiled in BuildStatement()
+  return mOrderByCompiled;
+}
+
 bool QgsMssqlFeatureIterator::nextFeatureFilterExpression( QgsFeature& f )
 {
   if ( !mExpressionCompiled )
@@ -91,6 +91,8 @@ class QgsMssqlFeatureIterator : public QgsAbstractFeatureIteratorFromSource<QgsM
     //! fetch next feature filter expression
     bool nextFeatureFilterExpression( QgsFeature& f ) override;
 
+    virtual bool prepareOrderBy( const QList<QgsFeatureRequest::OrderByClause>& orderBys ) override;
+
     // The current database
     QSqlDatabase mDatabase;
 
@@ -112,6 +114,7 @@ class QgsMssqlFeatureIterator : public QgsAbstractFeatureIteratorFromSource<QgsM
     QgsMssqlGeometryParser mParser;
 
     bool mExpressionCompiled;
+    bool mOrderByCompiled;
 };
 
 #endif // QGSMSSQLFEATUREITERATOR_H
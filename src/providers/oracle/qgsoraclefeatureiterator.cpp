@@ -29,6 +29,7 @@ QgsOracleFeatureIterator::QgsOracleFeatureIterator( QgsOracleFeatureSource* sour
     : QgsAbstractFeatureIteratorFromSource<QgsOracleFeatureSource>( source, ownSource, request )
     , mRewind( false )
     , mExpressionCompiled( false )
+    , mOrderByCompiled( false )
 {
   mConnection = QgsOracleConnPool::instance()->acquireConnection( mSource->mUri.connectionInfo() );
   if ( !mConnection )
@@ -117,7 +118,34 @@ QgsOracleFeatureIterator::QgsOracleFeatureIterator( QgsOracleFeatureSource* sour
     whereClause += QgsOracleConn::databaseTypeFilter( "featureRequest", mSource->mGeometryColumn, mSource->mRequestedGeomType );
   }
 
-  if ( request.limit() >= 0 )
+  QStringList orderByParts;
+  mOrderByCompiled = true;
+  if ( QSettings().value( "/qgis/compileExpressions", true ).toBool() )
+  {
+    Q_FOREACH ( const QgsFeatureRequest::OrderByClause& clause, request.orderBy() )
+    {
+      QgsOracleExpressionCompiler compiler( mSource );
+      QgsExpression expression( clause.expression() );
+      if ( compiler.compile( &expression ) != QgsSqlExpressionCompiler::Complete )
+      {
+        // the compiled clauses before still pre-sort the features, the rest is sorted locally
+        mOrderByCompiled = false;
+        break;
+      }
+
+      orderByParts << QString( "%1 %2 %3" )
+      .arg( compiler.result(),
+            clause.ascending() ? "ASC" : "DESC",
+            clause.nullsFirst() ? "NULLS FIRST" : "NULLS LAST" );
+    }
+  }
+  else
+  {
+    mOrderByCompiled = request.orderBy().isEmpty();
+  }
+
+  // rownum is assigned before ordering, ordered features are limited locally
+  if ( request.limit() >= 0 && request.orderBy().isEmpty() )
   {
     if ( !whereClause.isEmpty() )
       whereClause += " AND ";
@@ -132,7 +160,7 @@ QgsOracleFeatureIterator::QgsOracleFeatureIterator( QgsOracleFeatureSource* sour
     whereClause += "(" + mSource->mSqlWhereClause + ")";
   }
 
-  openQuery( whereClause );
+  openQuery( whereClause, orderByParts.join( "," ) );
 }
 
 QgsOracleFeatureIterator::~QgsOracleFeatureIterator()
@@ -148,6 +176,13 @@ bool QgsOracleFeatureIterator::nextFeatureFilterExpression( QgsFeature& f )
     return fetchFeature( f );
 }
 
+bool QgsOracleFeatureIterator::prepareOrderBy( const QList<QgsFeatureRequest::OrderByClause>& orderBys )
+{
+  Q_UNUSED( orderBys )
+  // the order by clauses were compiled in the constructor
+  return mOrderByCompiled;
+}
+
 bool QgsOracleFeatureIterator::fetchFeature( QgsFeature& feature )
 {
   feature.setValid( false );
@@ -308,7 +343,7 @@ bool QgsOracleFeatureIterator::close()
   return true;
 }
 
-bool QgsOracleFeatureIterator::openQuery( QString whereClause )
+bool QgsOracleFeatureIterator::openQuery( QString whereClause, QString orderBy )
 {
   try
   {
@@ -359,6 +394,9 @@ bool QgsOracleFeatureIterator::openQuery( QString whereClause )
     if ( !whereClause.isEmpty() )
       query += QString( " WHERE %1" ).arg( whereClause );
 
+    if ( !orderBy.isEmpty() )
+      query += QString( " ORDER BY %1" ).arg( orderBy );
+
     QgsDebugMsg( QString( "Fetch features: %1" ).arg( query ) );
     if ( !QgsOracleProvider::exec( mQry, query ) )
     {
@@ -76,12 +76,15 @@ class QgsOracleFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Qgs
     //! fetch next feature filter expression
     bool nextFeatureFilterExpression( QgsFeature& f ) override;
 
-    bool openQuery( QString whereClause );
+    virtual bool prepareOrderBy( const QList<QgsFeatureRequest::OrderByClause>& orderBys ) override;
+
+    bool openQuery( QString whereClause, QString orderBy = QString() );
 
     QgsOracleConn *mConnection;
     QSqlQuery mQry;
     bool mRewind;
     bool mExpressionCompiled;
+    bool mOrderByCompiled;
     QgsAttributeList mAttributeList;
 };
 
@@ -35,6 +35,7 @@ QgsPostgresFeatureIterator::QgsPostgresFeatureIterator( QgsPostgresFeatureSource
     , mFetched( 0 )
     , mFetchGeometry( false )
     , mExpressionCompiled( false )
+    , mOrderByCompiled( false )
     , mLastFetch( false )
 {
   if ( !source->mTransactionConnection )
@@ -111,12 +112,42 @@ QgsPostgresFeatureIterator::QgsPostgresFeatureIterator( QgsPostgresFeatureSource
     }
   }
 
-  bool success = declareCursor( whereClause, limitAtProvider ? mRequest.limit() : -1, false );
+  QStringList orderByParts;
+  mOrderByCompiled = true;
+  if ( QSettings().value( "/qgis/compileExpressions", true ).toBool() )
+  {
+    Q_FOREACH ( const QgsFeatureRequest::OrderByClause& clause, request.orderBy() )
+    {
+      QgsPostgresExpressionCompiler compiler = QgsPostgresExpressionCompiler( source );
+      QgsExpression expression( clause.expression() );
+      if ( compiler.compile( &expression ) != QgsSqlExpressionCompiler::Complete )
+      {
+        // the compiled clauses before still pre-sort the features, the rest is sorted locally
+        mOrderByCompiled = false;
+        break;
+      }
+
+      orderByParts << QString( "%1 %2 %3" )
+      .arg( compiler.result(),
+            clause.ascending() ? "ASC" : "DESC",
+            clause.nullsFirst() ? "NULLS FIRST" : "NULLS LAST" );
+    }
+  }
+  else
+  {
+    mOrderByCompiled = request.orderBy().isEmpty();
+  }
+
+  // the limit applies to the features ordered locally
+  if ( !mOrderByCompiled )
+    limitAtProvider = false;
+
+  bool success = declareCursor( whereClause, limitAtProvider ? mRequest.limit() : -1, false, orderByParts.join( "," ) );
   if ( !success && useFallbackWhereClause )
   {
     //try with the fallback where clause, eg for cases when using compiled expression failed to prepare
     mExpressionCompiled = false;
-    success = declareCursor( fallbackWhereClause, -1, false );
+    success = declareCursor( fallbackWhereClause, -1, false, orderByParts.join( "," ) );
   }
 
   if ( !success )
@@ -227,6 +258,13 @@ bool QgsPostgresFeatureIterator::prepareSimplification( const QgsSimplifyMethod&
   return QgsAbstractFeatureIterator::prepareSimplification( simplifyMethod );
 }
 
+bool QgsPostgresFeatureIterator::prepareOrderBy( const QList<QgsFeatureRequest::OrderByClause>& orderBys )
+{
+  Q_UNUSED( orderBys )
+  // the order by clauses were compiled in the constructor
+  return mOrderByCompiled;
+}
+
 bool QgsPostgresFeatureIterator::providerCanSimplify( QgsSimplifyMethod::MethodType methodType ) const
 {
   return methodType == QgsSimplifyMethod::OptimizeForRendering || methodType == QgsSimplifyMethod::PreserveTopology;
@@ -347,7 +385,7 @@ QString QgsPostgresFeatureIterator::whereClauseRect()
 
 
 
-bool QgsPostgresFeatureIterator::declareCursor( const QString& whereClause, long limit, bool closeOnFail )
+bool QgsPostgresFeatureIterator::declareCursor( const QString& whereClause, long limit, bool closeOnFail, const QString& orderBy )
 {
   mFetchGeometry = !( mRequest.flags() & QgsFeatureRequest::NoGeometry ) && !mSource->mGeometryColumn.isNull();
 #if 0
@@ -506,6 +544,9 @@ bool QgsPostgresFeatureIterator::declareCursor( const QString& whereClause, long
   if ( !whereClause.isEmpty() )
     query += QString( " WHERE %1" ).arg( whereClause );
 
+  if ( !orderBy.isEmpty() )
+    query += QString( " ORDER BY %1" ).arg( orderBy );
+
   if ( limit >= 0 )
     query += QString( " LIMIT %1" ).arg( limit );
 
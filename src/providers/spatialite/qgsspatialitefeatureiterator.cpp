@@ -28,6 +28,7 @@ QgsSpatiaLiteFeatureIterator::QgsSpatiaLiteFeatureIterator( QgsSpatiaLiteFeature
     : QgsAbstractFeatureIteratorFromSource<QgsSpatiaLiteFeatureSource>( source, ownSource, request )
     , sqliteStatement( NULL )
     , mExpressionCompiled( false )
+    , mOrderByCompiled( false )
 {
 
   mHandle = QgsSpatiaLiteConnPool::instance()->acquireConnection( mSource->mSqlitePath );
@@ -116,13 +117,44 @@ QgsSpatiaLiteFeatureIterator::QgsSpatiaLiteFeatureIterator( QgsSpatiaLiteFeature
 
   whereClause = whereClauses.join( " AND " );
 
+  QStringList orderByParts;
+  mOrderByCompiled = true;
+  if ( QSettings().value( "/qgis/compileExpressions", true ).toBool() )
+  {
+    Q_FOREACH ( const QgsFeatureRequest::OrderByClause& clause, request.orderBy() )
+    {
+      QgsSpatiaLiteExpressionCompiler compiler = QgsSpatiaLiteExpressionCompiler( source );
+      QgsExpression expression( clause.expression() );
+      if ( compiler.compile( &expression ) != QgsSqlExpressionCompiler::Complete )
+      {
+        // the compiled clauses before still pre-sort the features, the rest is sorted locally
+        mOrderByCompiled = false;
+        break;
+      }
+
+      // SQLite sorts NULLs first in ascending order and has no NULLS FIRST/LAST
+      QString part = compiler.result();
+      if ( clause.nullsFirst() != clause.ascending() )
+        orderByParts << QString( "(%1) IS %2 NULL" ).arg( part, clause.nullsFirst() ? "NOT" : "" );
+      orderByParts << part + ( clause.ascending() ? " ASC" : " DESC" );
+    }
+  }
+  else
+  {
+    mOrderByCompiled = request.orderBy().isEmpty();
+  }
+
+  // the limit applies to the features ordered locally
+  if ( !mOrderByCompiled )
+    limitAtProvider = false;
+
   // preparing the SQL statement
-  bool success = prepareStatement( whereClause, limitAtProvider ? mRequest.limit() : -1 );
+  bool success = prepareStatement( whereClause, limitAtProvider ? mRequest.limit() : -1, orderByParts.join( "," ) );
   if ( !success && useFallbackWhereClause )
   {
     //try with the fallback where clause, eg for cases when using compiled expression failed to prepare
     mExpressionCompiled = false;
-    success = prepareStatement( fallbackWhereClause, -1 );
+    success = prepareStatement( fallbackWhereClause, -1, orderByParts.join( "," ) );
   }
 
   if ( !success )
@@ -213,7 +245,7 @@ bool QgsSpatiaLiteFeatureIterator::close()
 ////
 
 
-bool QgsSpatiaLiteFeatureIterator::prepareStatement( const QString& whereClause, long limit )
+bool QgsSpatiaLiteFeatureIterator::prepareStatement( const QString& whereClause, long limit, const QString& orderBy )
 {
   if ( !mHandle )
     return false;
@@ -252,6 +284,9 @@ bool QgsSpatiaLiteFeatureIterator::prepareStatement( const QString& whereClause,
     if ( !whereClause.isEmpty() )
       sql += QString( " WHERE %1" ).arg( whereClause );
 
+    if ( !orderBy.isEmpty() )
+      sql += QString( " ORDER BY %1" ).arg( orderBy );
+
     if ( limit >= 0 )
       sql += QString( " LIMIT %1" ).arg( limit );
 
@@ -503,6 +538,13 @@ void QgsSpatiaLiteFeatureIterator::getFeatureGeometry( sqlite3_stmt* stmt, int i
   }
 }
 
+bool QgsSpatiaLiteFeatureIterator::prepareOrderBy( const QList<QgsFeatureRequest::OrderByClause>& orderBys )
+{
+  Q_UNUSED( orderBys )
+  // the order by clauses were compiled in the constructor
+  return mOrderByCompiled;
+}
+
 
 QgsSpatiaLiteFeatureSource::QgsSpatiaLiteFeatureSource( const QgsSpatiaLiteProvider* p )
     : mGeometryColumn( p->mGeometryColumn )
@@ -146,6 +146,11 @@ QString QgsWFSCapabilities::uriGetFeature( const QString& typeName, QString crsS
   {
     uri += "&authcfg=" + mUri.param( "authcfg" );
   }
+  //number of features requested at once by feature iterators (paging)
+  if ( mUri.hasParam( "pageSize" ) )
+  {
+    uri += "&pageSize=" + mUri.param( "pageSize" );
+  }
   QgsDebugMsg( uri );
   return uri;
 }
@@ -0,0 +1,467 @@
+/***************************************************************************
+    qgswfsfeaturecache.cpp
+    ---------------------
+    begin                : October 2015
+    copyright            : (C) 2015 by QGIS Development Team
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgswfsfeaturecache.h"
+#include "qgsapplication.h"
+#include "qgsgeometry.h"
+#include "qgslogger.h"
+#include "qgsmessagelog.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QSettings>
+#include <QStringList>
+#include <QUrl>
+
+#include <sqlite3.h>
+
+QgsWFSFeatureCache::QgsWFSFeatureCache( const QString& fileName, bool create )
+    : mFileName( fileName )
+    , mDb( 0 )
+    , mSelectStmt( 0 )
+    , mSelectGeometry( false )
+    , mInsertStmt( 0 )
+    , mDeleteStmt( 0 )
+    , mIndexInsertStmt( 0 )
+    , mIndexDeleteStmt( 0 )
+{
+  if ( create )
+  {
+    QDir().mkpath( QFileInfo( fileName ).absolutePath() );
+  }
+
+  int flags = SQLITE_OPEN_READWRITE | ( create ? SQLITE_OPEN_CREATE : 0 );
+  if ( sqlite3_open_v2( fileName.toUtf8().constData(), &mDb, flags, NULL ) != SQLITE_OK )
+  {
+    QgsDebugMsg( QString( "could not open WFS cache %1: %2" ).arg( fileName, QString::fromUtf8( sqlite3_errmsg( mDb ) ) ) );
+    sqlite3_close( mDb );
+    mDb = 0;
+    return;
+  }
+
+  // the provider writes while iterators of other threads are reading
+  sqlite3_busy_timeout( mDb, 10000 );
+
+  if ( create )
+  {
+    // write ahead log does not block readers during a download
+    exec( "PRAGMA journal_mode=WAL" );
+
+    if ( !exec( "CREATE TABLE IF NOT EXISTS metadata(key TEXT PRIMARY KEY, value BLOB)" ) ||
+         !exec( "CREATE TABLE IF NOT EXISTS features(id INTEGER PRIMARY KEY, wfsid TEXT, geometry BLOB, attributes BLOB)" ) ||
+         !exec( "CREATE VIRTUAL TABLE IF NOT EXISTS features_idx USING rtree(id, minx, maxx, miny, maxy)" ) )
+    {
+      QgsMessageLog::logMessage( QObject::tr( "Could not initialize WFS feature cache %1" ).arg( fileName ), QObject::tr( "WFS" ) );
+      sqlite3_close( mDb );
+      mDb = 0;
+    }
+  }
+}
+
+QgsWFSFeatureCache::~QgsWFSFeatureCache()
+{
+  finalizeSelect();
+  finalizeWriteStatements();
+  if ( mDb )
+    sqlite3_close( mDb );
+}
+
+bool QgsWFSFeatureCache::isEnabled()
+{
+  QSettings settings;
+  return settings.value( "/qgis/wfsDiskCache", false ).toBool();
+}
+
+int QgsWFSFeatureCache::timeToLive()
+{
+  QSettings settings;
+  return settings.value( "/qgis/wfsDiskCacheTimeToLive", 24 * 3600 ).toInt();
+}
+
+QString QgsWFSFeatureCache::fileNameForUri( const QString& uri )
+{
+  // the same request by the same user always maps to the same file
+  QUrl url( uri );
+  url.removeQueryItem( "password" );
+  url.removeQueryItem( "pageSize" );
+  QByteArray key = QCryptographicHash::hash( url.toEncoded(), QCryptographicHash::Md5 ).toHex();
+
+  QSettings settings;
+  QString cacheDirectory = settings.value( "cache/directory", QgsApplication::qgisSettingsDirPath() + "cache" ).toString();
+  return QDir( cacheDirectory ).filePath( QString( "wfs/%1.sqlite" ).arg( QString::fromAscii( key ) ) );
+}
+
+bool QgsWFSFeatureCache::exec( const char* sql )
+{
+  if ( !mDb )
+    return false;
+
+  char* errMsg = 0;
+  if ( sqlite3_exec( mDb, sql, NULL, NULL, &errMsg ) != SQLITE_OK )
+  {
+    QgsDebugMsg( QString( "%1 failed: %2" ).arg( sql, QString::fromUtf8( errMsg ) ) );
+    sqlite3_free( errMsg );
+    return false;
+  }
+  return true;
+}
+
+sqlite3_stmt* QgsWFSFeatureCache::writeStatement( sqlite3_stmt*& stmt, const char* sql )
+{
+  if ( !stmt && sqlite3_prepare_v2( mDb, sql, -1, &stmt, NULL ) != SQLITE_OK )
+  {
+    QgsDebugMsg( QString( "%1 failed: %2" ).arg( sql, QString::fromUtf8( sqlite3_errmsg( mDb ) ) ) );
+    stmt = 0;
+  }
+  return stmt;
+}
+
+bool QgsWFSFeatureCache::stepWriteStatement( sqlite3_stmt* stmt )
+{
+  bool ok = sqlite3_step( stmt ) == SQLITE_DONE;
+  // the bound blobs are not copied, they must not be used after this call
+  sqlite3_reset( stmt );
+  sqlite3_clear_bindings( stmt );
+  return ok;
+}
+
+void QgsWFSFeatureCache::finalizeWriteStatements()
+{
+  sqlite3_stmt** statements[] = { &mInsertStmt, &mDeleteStmt, &mIndexInsertStmt, &mIndexDeleteStmt };
+  for ( int i = 0; i < 4; ++i )
+  {
+    if ( *statements[i] )
+    {
+      sqlite3_finalize( *statements[i] );
+      *statements[i] = 0;
+    }
+  }
+}
+
+QByteArray QgsWFSFeatureCache::metadata( const char* key ) const
+{
+  QByteArray value;
+  if ( !mDb )
+    return value;
+
+  sqlite3_stmt* stmt;
+  if ( sqlite3_prepare_v2( mDb, "SELECT value FROM metadata WHERE key=?", -1, &stmt, NULL ) != SQLITE_OK )
+    return value;
+
+  sqlite3_bind_text( stmt, 1, key, -1, SQLITE_STATIC );
+  if ( sqlite3_step( stmt ) == SQLITE_ROW )
+  {
+    const char* data = static_cast<const char*>( sqlite3_column_blob( stmt, 0 ) );
+    value = QByteArray( data, sqlite3_column_bytes( stmt, 0 ) );
+  }
+  sqlite3_finalize( stmt );
+  return value;
+}
+
+bool QgsWFSFeatureCache::setMetadata( const char* key, const QByteArray& value )
+{
+  sqlite3_stmt* stmt;
+  if ( !mDb || sqlite3_prepare_v2( mDb, "INSERT OR REPLACE INTO metadata(key, value) VALUES (?,?)", -1, &stmt, NULL ) != SQLITE_OK )
+    return false;
+
+  sqlite3_bind_text( stmt, 1, key, -1, SQLITE_STATIC );
+  sqlite3_bind_blob( stmt, 2, value.constData(), value.size(), SQLITE_STATIC );
+  bool ok = sqlite3_step( stmt ) == SQLITE_DONE;
+  sqlite3_finalize( stmt );
+  return ok;
+}
+
+bool QgsWFSFeatureCache::isUpToDate( int ttl, const QByteArray& fingerprint ) const
+{
+  if ( metadata( "complete" ) != "1" || metadata( "fingerprint" ) != fingerprint )
+    return false;
+
+  QDateTime timestamp = QDateTime::fromTime_t( metadata( "timestamp" ).toUInt() );
+  return timestamp.secsTo( QDateTime::currentDateTime() ) <= ttl;
+}
+
+bool QgsWFSFeatureCache::beginPopulate()
+{
+  finalizeSelect();
+  if ( !exec( "BEGIN" ) )
+    return false;
+
+  if ( !exec( "DELETE FROM features" ) || !exec( "DELETE FROM features_idx" ) || !setMetadata( "complete", "0" ) )
+  {
+    exec( "ROLLBACK" );
+    return false;
+  }
+  return true;
+}
+
+bool QgsWFSFeatureCache::finishPopulate( const QgsFields& fields, const QString& geometryAttribute, QGis::WkbType wkbType, const QgsRectangle& extent, const QByteArray& fingerprint )
+{
+  QByteArray schema;
+  QDataStream ds( &schema, QIODevice::WriteOnly );
+  ds << fields << geometryAttribute << static_cast<qint32>( wkbType )
+  << extent.xMinimum() << extent.yMinimum() << extent.xMaximum() << extent.yMaximum();
+
+  if ( !setMetadata( "schema", schema ) ||
+       !setMetadata( "fingerprint", fingerprint ) ||
+       !setMetadata( "timestamp", QByteArray::number( QDateTime::currentDateTime().toTime_t() ) ) ||
+       !setMetadata( "complete", "1" ) ||
+       !exec( "COMMIT" ) )
+  {
+    abortPopulate();
+    return false;
+  }
+  finalizeWriteStatements();
+  return true;
+}
+
+void QgsWFSFeatureCache::abortPopulate()
+{
+  finalizeWriteStatements();
+  exec( "ROLLBACK" );
+}
+
+bool QgsWFSFeatureCache::readSchema( QgsFields& fields, QString& geometryAttribute, QGis::WkbType& wkbType, QgsRectangle& extent ) const
+{
+  QByteArray schema = metadata( "schema" );
+  if ( schema.isEmpty() )
+    return false;
+
+  QDataStream ds( schema );
+  qint32 type;
+  double xmin, ymin, xmax, ymax;
+  ds >> fields >> geometryAttribute >> type >> xmin >> ymin >> xmax >> ymax;
+  if ( ds.status() != QDataStream::Ok )
+    return false;
+
+  wkbType = static_cast<QGis::WkbType>( type );
+  extent = QgsRectangle( xmin, ymin, xmax, ymax );
+  return true;
+}
+
+bool QgsWFSFeatureCache::readIds( QMap<QgsFeatureId, QString>& idMap ) const
+{
+  idMap.clear();
+
+  sqlite3_stmt* stmt;
+  if ( !mDb || sqlite3_prepare_v2( mDb, "SELECT id, wfsid FROM features", -1, &stmt, NULL ) != SQLITE_OK )
+    return false;
+
+  while ( sqlite3_step( stmt ) == SQLITE_ROW )
+  {
+    idMap.insert( sqlite3_column_int64( stmt, 0 ), QString::fromUtf8(( const char* ) sqlite3_column_text( stmt, 1 ) ) );
+  }
+  sqlite3_finalize( stmt );
+  return true;
+}
+
+bool QgsWFSFeatureCache::addFeature( const QgsFeature& f, const QString& wfsId )
+{
+  if ( !mDb )
+    return false;
+
+  QByteArray attributes;
+  QDataStream ds( &attributes, QIODevice::WriteOnly );
+  ds << f.attributes();
+
+  sqlite3_stmt* stmt = writeStatement( mInsertStmt, "INSERT OR REPLACE INTO features(id, wfsid, geometry, attributes) VALUES (?,?,?,?)" );
+  if ( !stmt )
+    return false;
+
+  QByteArray wfsIdUtf8 = wfsId.toUtf8();
+  const QgsGeometry* geom = f.constGeometry();
+  sqlite3_bind_int64( stmt, 1, f.id() );
+  sqlite3_bind_text( stmt, 2, wfsIdUtf8.constData(), wfsIdUtf8.size(), SQLITE_STATIC );
+  if ( geom && geom->asWkb() )
+    sqlite3_bind_blob( stmt, 3, geom->asWkb(), geom->wkbSize(), SQLITE_STATIC );
+  else
+    sqlite3_bind_null( stmt, 3 );
+  sqlite3_bind_blob( stmt, 4, attributes.constData(), attributes.size(), SQLITE_STATIC );
+  if ( !stepWriteStatement( stmt ) )
+    return false;
+
+  // features without geometry are not in the index - same as with QgsSpatialIndex
+  if ( !geom || !geom->asWkb() )
+  {
+    stmt = writeStatement( mIndexDeleteStmt, "DELETE FROM features_idx WHERE id=?" );
+    if ( !stmt )
+      return false;
+    sqlite3_bind_int64( stmt, 1, f.id() );
+    return stepWriteStatement( stmt );
+  }
+
+  QgsRectangle bbox = geom->boundingBox();
+  stmt = writeStatement( mIndexInsertStmt, "INSERT OR REPLACE INTO features_idx(id, minx, maxx, miny, maxy) VALUES (?,?,?,?,?)" );
+  if ( !stmt )
+    return false;
+
+  sqlite3_bind_int64( stmt, 1, f.id() );
+  sqlite3_bind_double( stmt, 2, bbox.xMinimum() );
+  sqlite3_bind_double( stmt, 3, bbox.xMaximum() );
+  sqlite3_bind_double( stmt, 4, bbox.yMinimum() );
+  sqlite3_bind_double( stmt, 5, bbox.yMaximum() );
+  return stepWriteStatement( stmt );
+}
+
+bool QgsWFSFeatureCache::deleteFeature( QgsFeatureId id )
+{
+  if ( !mDb )
+    return false;
+
+  sqlite3_stmt* stmt = writeStatement( mDeleteStmt, "DELETE FROM features WHERE id=?" );
+  if ( !stmt )
+    return false;
+  sqlite3_bind_int64( stmt, 1, id );
+  if ( !stepWriteStatement( stmt ) )
+    return false;
+
+  stmt = writeStatement( mIndexDeleteStmt, "DELETE FROM features_idx WHERE id=?" );
+  if ( !stmt )
+    return false;
+  sqlite3_bind_int64( stmt, 1, id );
+  return stepWriteStatement( stmt );
+}
+
+bool QgsWFSFeatureCache::feature( QgsFeatureId id, QgsFeature& f, const QgsFields& fields )
+{
+  if ( !select( id, true ) )
+    return false;
+
+  bool found = nextFeature( f, fields );
+  finalizeSelect();
+  return found;
+}
+
+bool QgsWFSFeatureCache::select( const QgsRectangle& rect, bool fetchGeometry )
+{
+  finalizeSelect();
+  if ( !mDb )
+    return false;
+
+  mSelectGeometry = fetchGeometry;
+  QString columns = fetchGeometry ? "f.id, f.attributes, f.geometry" : "f.id, f.attributes";
+  QString sql = rect.isNull()
+                ? QString( "SELECT %1 FROM features f" ).arg( columns )
+                : QString( "SELECT %1 FROM features f, features_idx i WHERE f.id=i.id AND i.minx<=? AND i.maxx>=? AND i.miny<=? AND i.maxy>=?" ).arg( columns );
+
+  if ( sqlite3_prepare_v2( mDb, sql.toUtf8().constData(), -1, &mSelectStmt, NULL ) != SQLITE_OK )
+  {
+    QgsDebugMsg( QString( "%1 failed: %2" ).arg( sql, QString::fromUtf8( sqlite3_errmsg( mDb ) ) ) );
+    mSelectStmt = 0;
+    return false;
+  }
+
+  if ( !rect.isNull() )
+  {
+    sqlite3_bind_double( mSelectStmt, 1, rect.xMaximum() );
+    sqlite3_bind_double( mSelectStmt, 2, rect.xMinimum() );
+    sqlite3_bind_double( mSelectStmt, 3, rect.yMaximum() );
+    sqlite3_bind_double( mSelectStmt, 4, rect.yMinimum() );
+  }
+  return true;
+}
+
+bool QgsWFSFeatureCache::select( QgsFeatureId id, bool fetchGeometry )
+{
+  finalizeSelect();
+  if ( !mDb )
+    return false;
+
+  mSelectGeometry = fetchGeometry;
+  const char* sql = fetchGeometry
+                    ? "SELECT id, attributes, geometry FROM features WHERE id=?"
+                    : "SELECT id, attributes FROM features WHERE id=?";
+  if ( sqlite3_prepare_v2( mDb, sql, -1, &mSelectStmt, NULL ) != SQLITE_OK )
+  {
+    mSelectStmt = 0;
+    return false;
+  }
+
+  sqlite3_bind_int64( mSelectStmt, 1, id );
+  return true;
+}
+
+bool QgsWFSFeatureCache::select( const QgsFeatureIds& ids, bool fetchGeometry )
+{
+  finalizeSelect();
+  if ( !mDb )
+    return false;
+
+  // the ids are integers, they are written into the query rather than bound
+  // so that the number of ids is not limited by the number of host parameters
+  QStringList idList;
+  Q_FOREACH ( QgsFeatureId id, ids )
+    idList << QString::number( id );
+
+  mSelectGeometry = fetchGeometry;
+  QString sql = QString( "SELECT %1 FROM features WHERE id IN (%2)" )
+                .arg( fetchGeometry ? "id, attributes, geometry" : "id, attributes", idList.join( "," ) );
+  if ( sqlite3_prepare_v2( mDb, sql.toUtf8().constData(), -1, &mSelectStmt, NULL ) != SQLITE_OK )
+  {
+    QgsDebugMsg( QString( "%1 failed: %2" ).arg( sql.left( 100 ), QString::fromUtf8( sqlite3_errmsg( mDb ) ) ) );
+    mSelectStmt = 0;
+    return false;
+  }
+  return true;
+}
+
+bool QgsWFSFeatureCache::nextFeature( QgsFeature& f, const QgsFields& fields )
+{
+  if ( !mSelectStmt || sqlite3_step( mSelectStmt ) != SQLITE_ROW )
+    return false;
+
+  f.setFeatureId( sqlite3_column_int64( mSelectStmt, 0 ) );
+
+  const char* attributeData = static_cast<const char*>( sqlite3_column_blob( mSelectStmt, 1 ) );
+  QByteArray attributeBlob = QByteArray::fromRawData( attributeData, sqlite3_column_bytes( mSelectStmt, 1 ) );
+  QDataStream ds( attributeBlob );
+  QgsAttributes attributes;
+  ds >> attributes;
+  attributes.resize( fields.count() );
+  f.setAttributes( attributes );
+
+  f.setGeometry( 0 );
+  if ( mSelectGeometry && sqlite3_column_type( mSelectStmt, 2 ) == SQLITE_BLOB )
+  {
+    const unsigned char* wkb = static_cast<const unsigned char*>( sqlite3_column_blob( mSelectStmt, 2 ) );
+    int wkbSize = sqlite3_column_bytes( mSelectStmt, 2 );
+    unsigned char* copiedWkb = new unsigned char[wkbSize];
+    memcpy( copiedWkb, wkb, wkbSize );
+
+    QgsGeometry* g = new QgsGeometry();
+    g->fromWkb( copiedWkb, wkbSize );
+    f.setGeometry( g );
+  }
+
+  f.setValid( true );
+  f.setFields( fields ); // allow name-based attribute lookups
+  return true;
+}
+
+void QgsWFSFeatureCache::rewind()
+{
+  if ( mSelectStmt )
+    sqlite3_reset( mSelectStmt );
+}
+
+void QgsWFSFeatureCache::finalizeSelect()
+{
+  if ( mSelectStmt )
+  {
+    sqlite3_finalize( mSelectStmt );
+    mSelectStmt = 0;
+  }
+}
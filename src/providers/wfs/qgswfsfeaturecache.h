@@ -0,0 +1,128 @@
+/***************************************************************************
+    qgswfsfeaturecache.h
+    ---------------------
+    begin                : October 2015
+    copyright            : (C) 2015 by QGIS Development Team
+    email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSWFSFEATURECACHE_H
+#define QGSWFSFEATURECACHE_H
+
+#include "qgis.h"
+#include "qgsfeature.h"
+#include "qgsfield.h"
+#include "qgsrectangle.h"
+
+#include <QByteArray>
+#include <QMap>
+#include <QString>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+/** Local store of the features downloaded from a WFS server.
+ *
+ * The features of a layer are kept in a SQLite database in the QGIS cache directory
+ * together with an R*Tree index of their bounding boxes, so a layer can be opened
+ * without downloading it again. The database file is identified by the GetFeature
+ * request (endpoint, typename, filter...). Besides the features it holds the layer
+ * schema, the time of the download and a fingerprint of the layer capabilities,
+ * which allow to find out whether the data are still up to date.
+ *
+ * An instance must not be used from several threads at the same time - feature
+ * iterators open their own connection to the database.
+ */
+class QgsWFSFeatureCache
+{
+  public:
+    /** Opens the cache database
+     * @param fileName database file
+     * @param create create the file and its tables if they do not exist
+     */
+    QgsWFSFeatureCache( const QString& fileName, bool create );
+    ~QgsWFSFeatureCache();
+
+    /** Whether WFS layers with all features cached keep the features on disk (set in options) */
+    static bool isEnabled();
+
+    /** Maximum age (in seconds) of the cached data before they are downloaded again */
+    static int timeToLive();
+
+    /** Returns name of the database file for a GetFeature url */
+    static QString fileNameForUri( const QString& uri );
+
+    /** False if the database could not be opened */
+    bool isValid() const { return mDb; }
+
+    const QString& fileName() const { return mFileName; }
+
+    /** True if the cache holds a complete download not older than ttl seconds,
+     * made with capabilities of the same fingerprint */
+    bool isUpToDate( int ttl, const QByteArray& fingerprint ) const;
+
+    /** Starts a new download: removes all features. The changes are not visible to
+     * other connections until finishPopulate() is called. The statements writing
+     * the features are prepared once and reused until then. */
+    bool beginPopulate();
+    /** Stores the layer description and commits the downloaded features */
+    bool finishPopulate( const QgsFields& fields, const QString& geometryAttribute, QGis::WkbType wkbType, const QgsRectangle& extent, const QByteArray& fingerprint );
+    /** Discards features added since beginPopulate() */
+    void abortPopulate();
+
+    /** Reads layer description stored by finishPopulate() */
+    bool readSchema( QgsFields& fields, QString& geometryAttribute, QGis::WkbType& wkbType, QgsRectangle& extent ) const;
+    /** Reads the relation between feature ids and WFS server ids */
+    bool readIds( QMap<QgsFeatureId, QString>& idMap ) const;
+
+    /** Adds or replaces a feature */
+    bool addFeature( const QgsFeature& f, const QString& wfsId );
+    /** Removes a feature */
+    bool deleteFeature( QgsFeatureId id );
+    /** Reads a single feature (with geometry) */
+    bool feature( QgsFeatureId id, QgsFeature& f, const QgsFields& fields );
+
+    /** Selects features with bounding box intersecting the rectangle (all features for a null rectangle) */
+    bool select( const QgsRectangle& rect, bool fetchGeometry );
+    /** Selects feature with given id */
+    bool select( QgsFeatureId id, bool fetchGeometry );
+    /** Selects features with given ids */
+    bool select( const QgsFeatureIds& ids, bool fetchGeometry );
+    /** Returns next selected feature */
+    bool nextFeature( QgsFeature& f, const QgsFields& fields );
+    /** Restarts reading of the selected features */
+    void rewind();
+
+  private:
+    QgsWFSFeatureCache( const QgsWFSFeatureCache& rh );
+    QgsWFSFeatureCache& operator=( const QgsWFSFeatureCache& rh );
+
+    bool exec( const char* sql );
+    QByteArray metadata( const char* key ) const;
+    bool setMetadata( const char* key, const QByteArray& value );
+    void finalizeSelect();
+    //! prepares a write statement on first use, returns 0 on failure
+    sqlite3_stmt* writeStatement( sqlite3_stmt*& stmt, const char* sql );
+    //! executes a bound write statement and resets it for the next use
+    bool stepWriteStatement( sqlite3_stmt* stmt );
+    void finalizeWriteStatements();
+
+    QString mFileName;
+    sqlite3* mDb;
+    //! statement of the current selection
+    sqlite3_stmt* mSelectStmt;
+    bool mSelectGeometry;
+    //! statements used by addFeature() and deleteFeature(), kept prepared between calls
+    sqlite3_stmt* mInsertStmt;
+    sqlite3_stmt* mDeleteStmt;
+    sqlite3_stmt* mIndexInsertStmt;
+    sqlite3_stmt* mIndexDeleteStmt;
+};
+
+#endif // QGSWFSFEATURECACHE_H
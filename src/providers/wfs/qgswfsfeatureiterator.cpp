@@ -13,15 +13,59 @@
  *                                                                         *
  ***************************************************************************/
 #include "qgswfsfeatureiterator.h"
+#include "qgswfsfeaturecache.h"
 #include "qgsspatialindex.h"
 #include "qgswfsprovider.h"
 #include "qgsmessagelog.h"
+#include "qgslogger.h"
 #include "qgsgeometry.h"
+#include "qgsgml.h"
+#include "qgsnetworkaccessmanager.h"
+
+#include <QEventLoop>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QUrl>
+
+// size of a response chunk parsed at once - limits number of features waiting in the queue
+static const qint64 CHUNK_SIZE = 64 * 1024;
+// size of network buffer - download is paused when the data are not consumed
+static const qint64 READ_BUFFER_SIZE = 1024 * 1024;
 
 QgsWFSFeatureIterator::QgsWFSFeatureIterator( QgsWFSFeatureSource* source, bool ownSource, const QgsFeatureRequest& request )
     : QgsAbstractFeatureIteratorFromSource<QgsWFSFeatureSource>( source, ownSource, request )
+    , mStreaming( false )
+    , mNAM( 0 )
+    , mReply( 0 )
+    , mGml( 0 )
+    , mWKBType( source->mWKBType )
+    , mPageStart( 0 )
+    , mPageFeatureCount( 0 )
+    , mDownloadFinished( false )
+    , mDiskCache( 0 )
 {
-  if ( !request.filterRect().isNull() && mSource->mSpatialIndex )
+  if ( !mSource->mDiskCacheFileName.isEmpty() )
+  {
+    // every iterator reads with its own connection, they may run in different threads
+    bool fetchGeometry = !( request.flags() & QgsFeatureRequest::NoGeometry ) || ( request.flags() & QgsFeatureRequest::ExactIntersect );
+    mDiskCache = new QgsWFSFeatureCache( mSource->mDiskCacheFileName, false );
+    if ( request.filterType() == QgsFeatureRequest::FilterFid )
+      mDiskCache->select( request.filterFid(), fetchGeometry );
+    else if ( request.filterType() == QgsFeatureRequest::FilterFids )
+      mDiskCache->select( request.filterFids(), fetchGeometry );
+    else
+      mDiskCache->select( request.filterRect(), fetchGeometry );
+  }
+  else if ( mSource->mStreaming )
+  {
+    // features are downloaded when they are fetched, features requested by id only if the server knows them
+    mStreaming = true;
+    if ( request.filterType() == QgsFeatureRequest::FilterFid )
+      mServerFeatureIds = mSource->mStreamedIds->gmlIds( QgsFeatureIds() << request.filterFid() );
+    else if ( request.filterType() == QgsFeatureRequest::FilterFids )
+      mServerFeatureIds = mSource->mStreamedIds->gmlIds( request.filterFids() );
+  }
+  else if ( !request.filterRect().isNull() && mSource->mSpatialIndex )
   {
     mSelectedFeatures = mSource->mSpatialIndex->intersects( request.filterRect() );
   }
@@ -29,6 +73,10 @@ QgsWFSFeatureIterator::QgsWFSFeatureIterator( QgsWFSFeatureSource* source, bool
   {
     mSelectedFeatures.push_back( request.filterFid() );
   }
+  else if ( request.filterType() == QgsFeatureRequest::FilterFids )
+  {
+    mSelectedFeatures = request.filterFids().toList();
+  }
   else
   {
     mSelectedFeatures = mSource->mFeatures.keys();
@@ -47,6 +95,24 @@ bool QgsWFSFeatureIterator::fetchFeature( QgsFeature& f )
   if ( mClosed )
     return false;
 
+  if ( mStreaming )
+    return fetchStreamedFeature( f );
+
+  if ( mDiskCache )
+  {
+    while ( mDiskCache->nextFeature( f, mSource->mFields ) )
+    {
+      if (( mRequest.flags() & QgsFeatureRequest::ExactIntersect ) &&
+          ( !f.constGeometry() || !f.constGeometry()->intersects( mRequest.filterRect() ) ) )
+        continue;
+
+      if ( mRequest.flags() & QgsFeatureRequest::NoGeometry )
+        f.setGeometry( 0 );
+      return true;
+    }
+    return false;
+  }
+
   if ( mFeatureIterator == mSelectedFeatures.constEnd() )
   {
     return false;
@@ -79,11 +145,179 @@ bool QgsWFSFeatureIterator::fetchFeature( QgsFeature& f )
   return true;
 }
 
+bool QgsWFSFeatureIterator::fetchStreamedFeature( QgsFeature& f )
+{
+  for ( ;; )
+  {
+    while ( !mQueue.isEmpty() )
+    {
+      QgsFeature* fet = mQueue.takeFirst();
+      if (( mRequest.flags() & QgsFeatureRequest::ExactIntersect ) &&
+          ( !fet->constGeometry() || !fet->constGeometry()->intersects( mRequest.filterRect() ) ) )
+      {
+        delete fet;
+        continue;
+      }
+
+      copyFeature( fet, f, !( mRequest.flags() & QgsFeatureRequest::NoGeometry ) );
+      delete fet;
+      return true;
+    }
+
+    if ( !readNextChunk() )
+      return false;
+  }
+}
+
+bool QgsWFSFeatureIterator::sendRequest()
+{
+  bool fidFilter = mRequest.filterType() == QgsFeatureRequest::FilterFid || mRequest.filterType() == QgsFeatureRequest::FilterFids;
+  if ( fidFilter && mServerFeatureIds.isEmpty() )
+  {
+    // none of the features was streamed before, the server cannot know them
+    return false;
+  }
+
+  if ( !mNAM )
+  {
+    // iterators run in rendering threads, the global network access manager belongs to the main thread
+    mNAM = new QgsNetworkAccessManager();
+    mNAM->setupDefaultProxyAndCache();
+  }
+  if ( !mGml )
+  {
+    mGml = new QgsGml( mSource->mTypeName, mSource->mGeometryAttribute, mSource->mFields );
+  }
+
+  QUrl url( mSource->mUri );
+  url.removeQueryItem( "username" );
+  url.removeQueryItem( "password" );
+  url.removeQueryItem( "authcfg" );
+  url.removeQueryItem( "pageSize" );
+
+  QgsRectangle rect = mRequest.filterRect();
+  url.removeQueryItem( "BBOX" );
+  if ( fidFilter )
+  {
+    // FEATUREID (RESOURCEID in WFS 2.0) must not be combined with BBOX or FILTER
+    QString idParam = url.queryItemValue( "VERSION" ).startsWith( "2" ) ? "RESOURCEID" : "FEATUREID";
+    url.removeQueryItem( "FILTER" );
+    url.removeQueryItem( idParam );
+    url.addQueryItem( idParam, mServerFeatureIds.join( "," ) );
+  }
+  else if ( !rect.isNull() )
+  {
+    url.addQueryItem( "BBOX", QString( "%1,%2,%3,%4" )
+                      .arg( qgsDoubleToString( rect.xMinimum() ),
+                            qgsDoubleToString( rect.yMinimum() ),
+                            qgsDoubleToString( rect.xMaximum() ),
+                            qgsDoubleToString( rect.yMaximum() ) ) );
+  }
+
+  if ( mSource->mPageSize > 0 )
+  {
+    // WFS 2.0 uses COUNT, older versions MAXFEATURES (STARTINDEX is supported by most 1.x servers too)
+    QString countParam = url.queryItemValue( "VERSION" ).startsWith( "2" ) ? "COUNT" : "MAXFEATURES";
+    url.removeQueryItem( "STARTINDEX" );
+    url.removeQueryItem( countParam );
+    url.addQueryItem( "STARTINDEX", QString::number( mPageStart ) );
+    url.addQueryItem( countParam, QString::number( mSource->mPageSize ) );
+  }
+
+  QNetworkRequest request( url );
+  if ( !mSource->mAuth.setAuthorization( request ) )
+  {
+    QgsMessageLog::logMessage( QObject::tr( "WFS GetFeature network request update failed for authcfg %1" ).arg( mSource->mAuth.mAuthCfg ), QObject::tr( "WFS" ) );
+    return false;
+  }
+
+  QgsDebugMsg( "streaming features: " + url.toString() );
+  mReply = mNAM->get( request );
+  // do not download faster than the features are consumed
+  mReply->setReadBufferSize( READ_BUFFER_SIZE );
+  mPageFeatureCount = 0;
+  return true;
+}
+
+bool QgsWFSFeatureIterator::readNextChunk()
+{
+  if ( !mReply )
+  {
+    if ( mDownloadFinished || !sendRequest() )
+      return false;
+  }
+
+  if ( mReply->bytesAvailable() == 0 && !mReply->isFinished() )
+  {
+    QEventLoop loop;
+    QObject::connect( mReply, SIGNAL( readyRead() ), &loop, SLOT( quit() ) );
+    QObject::connect( mReply, SIGNAL( finished() ), &loop, SLOT( quit() ) );
+    loop.exec( QEventLoop::ExcludeUserInputEvents );
+  }
+
+  bool atEnd = mReply->isFinished() && mReply->bytesAvailable() <= CHUNK_SIZE;
+  QByteArray data = mReply->read( CHUNK_SIZE );
+  mGml->processData( data, atEnd, &mWKBType );
+  // the parser numbers the features of this response only, the layer wide ids come from the server ids
+  QMap<QgsFeatureId, QString> ids;
+  mQueue = mGml->takeFeatures( &ids );
+  Q_FOREACH ( QgsFeature* f, mQueue )
+  {
+    f->setFeatureId( mSource->mStreamedIds->featureId( ids.value( f->id() ) ) );
+  }
+  mPageFeatureCount += mQueue.size();
+
+  if ( atEnd )
+  {
+    if ( mReply->error() != QNetworkReply::NoError )
+    {
+      QgsMessageLog::logMessage( QObject::tr( "WFS GetFeature network request failed with error: %1" ).arg( mReply->errorString() ), QObject::tr( "WFS" ) );
+      mDownloadFinished = true;
+    }
+    else if ( mSource->mPageSize > 0 && mPageFeatureCount >= mSource->mPageSize )
+    {
+      // full page - there may be more features, the next page is requested when the queue is empty
+      mPageStart += mPageFeatureCount;
+    }
+    else
+    {
+      mDownloadFinished = true;
+    }
+
+    delete mReply;
+    mReply = 0;
+  }
+  return true;
+}
+
+void QgsWFSFeatureIterator::resetStreaming()
+{
+  if ( mReply )
+  {
+    mReply->abort();
+    delete mReply;
+    mReply = 0;
+  }
+  qDeleteAll( mQueue );
+  mQueue.clear();
+  delete mGml;
+  mGml = 0;
+  mPageStart = 0;
+  mPageFeatureCount = 0;
+  mDownloadFinished = false;
+}
+
 bool QgsWFSFeatureIterator::rewind()
 {
   if ( mClosed )
     return false;
 
+  if ( mStreaming )
+    resetStreaming();
+
+  if ( mDiskCache )
+    mDiskCache->rewind();
+
   mFeatureIterator = mSelectedFeatures.constBegin();
 
   return true;
@@ -94,6 +328,16 @@ bool QgsWFSFeatureIterator::close()
   if ( mClosed )
     return false;
 
+  if ( mStreaming )
+  {
+    resetStreaming();
+    delete mNAM;
+    mNAM = 0;
+  }
+
+  delete mDiskCache;
+  mDiskCache = 0;
+
   iteratorClosed();
 
   mClosed = true;
@@ -154,6 +398,15 @@ QgsWFSFeatureSource::QgsWFSFeatureSource( const QgsWFSProvider* p )
     , mFields( p->mFields )
     , mFeatures( p->mFeatures )
     , mSpatialIndex( p->mSpatialIndex ? new QgsSpatialIndex( *p->mSpatialIndex ) : 0 )  // just shallow copy
+    , mStreaming( p->isStreaming() )
+    , mStreamedIds( p->mStreamedIds )
+    , mUri( p->dataSourceUri() )
+    , mAuth( p->mAuth )
+    , mTypeName( p->parameterFromUrl( "typename" ) )
+    , mGeometryAttribute( p->mGeometryAttribute )
+    , mWKBType( p->mWKBType )
+    , mPageSize( p->parameterFromUrl( "pageSize" ).toInt() )
+    , mDiskCacheFileName( p->mDiskCache ? p->mDiskCache->fileName() : QString() )
 {
 }
 
@@ -16,9 +16,14 @@
 #define QGSWFSFEATUREITERATOR_H
 
 #include "qgsfeatureiterator.h"
+#include "qgswfsprovider.h"
 
+class QgsGml;
+class QgsNetworkAccessManager;
+class QgsWFSFeatureCache;
 class QgsWFSProvider;
 class QgsSpatialIndex;
+class QNetworkReply;
 typedef QMap<QgsFeatureId, QgsFeature*> QgsFeaturePtrMap;
 
 
@@ -41,6 +46,21 @@ class QgsWFSFeatureSource : public QObject, public QgsAbstractFeatureSource
     QgsFeaturePtrMap mFeatures;
     QgsSpatialIndex* mSpatialIndex;
 
+    //! Features are streamed from the server (layers without feature cache)
+    bool mStreaming;
+    //! Ids of the streamed features, shared by all iterators of the layer
+    QSharedPointer<QgsWFSFeatureIdMap> mStreamedIds;
+    //! GetFeature URI of the layer
+    QString mUri;
+    QgsWFSAuthorization mAuth;
+    QString mTypeName;
+    QString mGeometryAttribute;
+    QGis::WkbType mWKBType;
+    //! Number of features requested at once (0 = no paging)
+    int mPageSize;
+    //! Database with the features if they are cached on disk (empty otherwise)
+    QString mDiskCacheFileName;
+
     friend class QgsWFSFeatureIterator;
 };
 
@@ -60,8 +80,36 @@ class QgsWFSFeatureIterator : public QgsAbstractFeatureIteratorFromSource<QgsWFS
     void copyFeature( const QgsFeature* f, QgsFeature& feature, bool fetchGeometry );
 
   private:
+    //! Returns next feature downloaded from the server
+    bool fetchStreamedFeature( QgsFeature& f );
+    //! Parses next chunk of the server response, sends request for the next page if needed.
+    //! Returns false if there are no more data.
+    bool readNextChunk();
+    //! Sends GetFeature request for the current page
+    bool sendRequest();
+    //! Aborts download and frees parsed features
+    void resetStreaming();
+
     QList<QgsFeatureId> mSelectedFeatures;
     QList<QgsFeatureId>::const_iterator mFeatureIterator;
+
+    bool mStreaming;
+    QgsNetworkAccessManager* mNAM;
+    QNetworkReply* mReply;
+    QgsGml* mGml;
+    //! Server ids of the features requested by id
+    QStringList mServerFeatureIds;
+    //! Parsed features waiting to be returned, never more than one chunk of the response
+    QList<QgsFeature*> mQueue;
+    QGis::WkbType mWKBType;
+    //! Index of the first feature of the current page
+    int mPageStart;
+    //! Number of features parsed from the current page
+    int mPageFeatureCount;
+    bool mDownloadFinished;
+
+    //! Connection to the disk cache used by this iterator
+    QgsWFSFeatureCache* mDiskCache;
 };
 
 #endif // QGSWFSFEATUREITERATOR_H
@@ -25,6 +25,7 @@
 #include "qgsgeometry.h"
 #include "qgsgml.h"
 #include "qgscoordinatereferencesystem.h"
+#include "qgswfsfeaturecache.h"
 #include "qgswfsfeatureiterator.h"
 #include "qgswfsprovider.h"
 #include "qgsdatasourceuri.h"
@@ -34,7 +35,9 @@
 #include "qgsnetworkaccessmanager.h"
 #include "qgsogcutils.h"
 
+#include <QCryptographicHash>
 #include <QDomDocument>
+#include <QEventLoop>
 #include <QMessageBox>
 #include <QDomNodeList>
 #include <QNetworkRequest>
@@ -43,7 +46,9 @@
 #include <QUrl>
 #include <QWidget>
 #include <QPair>
+#include <QTextStream>
 #include <QTimer>
+#include <QXmlStreamReader>
 
 #include <cfloat>
 
@@ -63,11 +68,13 @@ QgsWFSProvider::QgsWFSProvider( const QString& uri )
     , mWKBType( QGis::WKBUnknown )
     , mSourceCRS( 0 )
     , mFeatureCount( 0 )
+    , mFeatureCountRequested( false )
     , mMaxFeatureCount( 0 )
     , mValid( true )
     , mCached( false )
     , mPendingRetrieval( false )
     , mCapabilities( 0 )
+    , mStreamedIds( new QgsWFSFeatureIdMap() )
 #if 0
     , mLayer( 0 )
     , mGetRenderedOnly( false )
@@ -75,6 +82,7 @@ QgsWFSProvider::QgsWFSProvider( const QString& uri )
 #endif
 {
   mSpatialIndex = 0;
+  mDiskCache = 0;
   if ( uri.isEmpty() )
   {
     mValid = false;
@@ -102,11 +110,29 @@ QgsWFSProvider::QgsWFSProvider( const QString& uri )
   mAuth.mPassword = parameterFromUrl( "password" );
   mAuth.mAuthCfg = parameterFromUrl( "authcfg" );
 
+  //"Cache Features" layers may keep the downloaded features on disk
+  if ( mRequestEncoding == QgsWFSProvider::GET && !uri.contains( "BBOX=" ) && QgsWFSFeatureCache::isEnabled() )
+  {
+    mDiskCache = new QgsWFSFeatureCache( QgsWFSFeatureCache::fileNameForUri( uri ), true );
+    if ( !mDiskCache->isValid() )
+    {
+      delete mDiskCache;
+      mDiskCache = 0;
+    }
+  }
+
   //fetch attributes of layer and type of its geometry attribute
   //WBC 111221: extracting geometry type here instead of getFeature allows successful
   //layer creation even when no features are retrieved (due to, e.g., BBOX or FILTER)
   if ( describeFeatureType( uri, mGeometryAttribute, mFields, mWKBType ) )
   {
+    //server not available - open the layer read-only with features of a previous session
+    if ( loadDiskCache( true ) )
+    {
+      QgsMessageLog::logMessage( tr( "DescribeFeatureType failed for url %1, using features cached on disk" ).arg( uri ), tr( "WFS" ) );
+      mCached = true;
+      return;
+    }
     mValid = false;
     QgsMessageLog::logMessage( tr( "DescribeFeatureType failed for url %1" ).arg( uri ), tr( "WFS" ) );
     return;
@@ -127,12 +153,32 @@ QgsWFSProvider::QgsWFSProvider( const QString& uri )
   mCached = !uri.contains( "BBOX=" );
   if ( mCached )
   { //"Cache Features" option; get all features in layer immediately
-    reloadData();
+    //capabilities are read first, features cached on disk are only used if they did not change
+    getLayerCapabilities();
+    if ( !loadDiskCache( false ) )
+    {
+      reloadData();
+      if ( !mValid && loadDiskCache( true ) )
+      {
+        QgsMessageLog::logMessage( tr( "GetFeature failed for url %1, using features cached on disk" ).arg( uri ), tr( "WFS" ) );
+      }
+    }
+    if ( !mValid )
+    {
+      mCapabilities = 0;
+    }
   } //otherwise, defer feature retrieval until layer is first rendered
-
-  if ( mValid )
+  else if ( mValid )
   {
     getLayerCapabilities();
+    if ( isStreaming() )
+    {
+      //the features of the type detection got ids the streaming iterators do not know
+      deleteData();
+      mIdMap.clear();
+      //the server is asked for the number of features when it is needed the first time
+      mFeatureCount = -1;
+    }
   }
 
   qRegisterMetaType<QgsRectangle>( "QgsRectangle" );
@@ -142,6 +188,7 @@ QgsWFSProvider::~QgsWFSProvider()
 {
   deleteData();
   delete mSpatialIndex;
+  delete mDiskCache;
 }
 
 QgsAbstractFeatureSource* QgsWFSProvider::featureSource() const
@@ -183,6 +230,14 @@ QGis::WkbType QgsWFSProvider::geometryType() const
 
 long QgsWFSProvider::featureCount() const
 {
+  if ( isStreaming() && !mFeatureCountRequested )
+  {
+    mFeatureCountRequested = true;
+    mFeatureCount = requestFeatureCount();
+  }
+  //the server did not tell the number of features, count those streamed so far
+  if ( isStreaming() && mFeatureCount < 0 )
+    return mStreamedIds->count();
   return mFeatureCount;
 }
 
@@ -284,8 +339,10 @@ QgsFeatureIterator QgsWFSProvider::getFeatures( const QgsFeatureRequest& request
   }
   return new QgsWFSFeatureIterator( new QgsWFSFeatureSource( this ), true, request );
 #else
+  // layers without feature cache stream features from the server, layers cached on disk
+  // are refreshed when they are opened or reloaded explicitly
   QgsRectangle rect = request.filterRect();
-  if ( !( request.flags() & QgsFeatureRequest::NoGeometry ) && !rect.isEmpty() )
+  if ( !isStreaming() && !mDiskCache && !( request.flags() & QgsFeatureRequest::NoGeometry ) && !rect.isEmpty() )
   {
     deleteData();
     reloadData();
@@ -368,7 +425,35 @@ bool QgsWFSProvider::addFeatures( QgsFeatureList &flist )
   if ( transactionSuccess( serverResponse ) )
   {
     //transaction successful. Add the features to mSpatialIndex
-    if ( mSpatialIndex )
+    if ( mDiskCache )
+    {
+      QStringList idList = insertedFeatureIds( serverResponse );
+      QStringList::const_iterator idIt = idList.constBegin();
+      featureIt = flist.begin();
+
+      for ( ; idIt != idList.constEnd() && featureIt != flist.end(); ++idIt, ++featureIt )
+      {
+        QgsFeatureId newId = findNewKey();
+        featureIt->setFeatureId( newId );
+        mIdMap.insert( newId, *idIt );
+        mDiskCache->addFeature( *featureIt, *idIt );
+      }
+      mFeatureCount = mIdMap.size();
+    }
+    else if ( isStreaming() )
+    {
+      QStringList idList = insertedFeatureIds( serverResponse );
+      QStringList::const_iterator idIt = idList.constBegin();
+      featureIt = flist.begin();
+
+      for ( ; idIt != idList.constEnd() && featureIt != flist.end(); ++idIt, ++featureIt )
+      {
+        featureIt->setFeatureId( mStreamedIds->featureId( *idIt ) );
+        if ( mFeatureCount >= 0 )
+          ++mFeatureCount;
+      }
+    }
+    else if ( mSpatialIndex )
     {
       QStringList idList = insertedFeatureIds( serverResponse );
       QStringList::const_iterator idIt = idList.constBegin();
@@ -421,13 +506,13 @@ bool QgsWFSProvider::deleteFeatures( const QgsFeatureIds &id )
   for ( ; idIt != id.constEnd(); ++idIt )
   {
     //find out feature id
-    QMap< QgsFeatureId, QString >::const_iterator fidIt = mIdMap.find( *idIt );
-    if ( fidIt == mIdMap.constEnd() )
+    QString fid = serverFeatureId( *idIt );
+    if ( fid.isEmpty() )
     {
       continue;
     }
     QDomElement featureIdElem = transactionDoc.createElementNS( OGC_NAMESPACE, "FeatureId" );
-    featureIdElem.setAttribute( "fid", fidIt.value() );
+    featureIdElem.setAttribute( "fid", fid );
     filterElem.appendChild( featureIdElem );
   }
 
@@ -446,6 +531,22 @@ bool QgsWFSProvider::deleteFeatures( const QgsFeatureIds &id )
     idIt = id.constBegin();
     for ( ; idIt != id.constEnd(); ++idIt )
     {
+      if ( mDiskCache )
+      {
+        mDiskCache->deleteFeature( *idIt );
+        mIdMap.remove( *idIt );
+        mFeatureCount = mIdMap.size();
+        continue;
+      }
+
+      if ( isStreaming() )
+      {
+        mStreamedIds->remove( *idIt );
+        if ( mFeatureCount > 0 )
+          --mFeatureCount;
+        continue;
+      }
+
       QMap<QgsFeatureId, QgsFeature* >::iterator fIt = mFeatures.find( *idIt );
       if ( fIt != mFeatures.end() )
       {
@@ -484,8 +585,8 @@ bool QgsWFSProvider::changeGeometryValues( QgsGeometryMap & geometry_map )
   for ( ; geomIt != geometry_map.end(); ++geomIt )
   {
     //find out feature id
-    QMap< QgsFeatureId, QString >::const_iterator fidIt = mIdMap.find( geomIt.key() );
-    if ( fidIt == mIdMap.constEnd() )
+    QString fid = serverFeatureId( geomIt.key() );
+    if ( fid.isEmpty() )
     {
       continue;
     }
@@ -508,7 +609,7 @@ bool QgsWFSProvider::changeGeometryValues( QgsGeometryMap & geometry_map )
     //filter
     QDomElement filterElem = transactionDoc.createElementNS( OGC_NAMESPACE, "Filter" );
     QDomElement featureIdElem = transactionDoc.createElementNS( OGC_NAMESPACE, "FeatureId" );
-    featureIdElem.setAttribute( "fid", fidIt.value() );
+    featureIdElem.setAttribute( "fid", fid );
     filterElem.appendChild( featureIdElem );
     updateElem.appendChild( filterElem );
 
@@ -527,6 +628,17 @@ bool QgsWFSProvider::changeGeometryValues( QgsGeometryMap & geometry_map )
     geomIt = geometry_map.begin();
     for ( ; geomIt != geometry_map.end(); ++geomIt )
     {
+      if ( mDiskCache )
+      {
+        QgsFeature f;
+        if ( mDiskCache->feature( geomIt.key(), f, mFields ) )
+        {
+          f.setGeometry( geomIt.value() );
+          mDiskCache->addFeature( f, mIdMap.value( geomIt.key() ) );
+        }
+        continue;
+      }
+
       QMap<QgsFeatureId, QgsFeature* >::iterator fIt = mFeatures.find( geomIt.key() );
       if ( fIt == mFeatures.end() )
       {
@@ -572,8 +684,8 @@ bool QgsWFSProvider::changeAttributeValues( const QgsChangedAttributesMap &attr_
   for ( ; attIt != attr_map.constEnd(); ++attIt )
   {
     //find out wfs server feature id
-    QMap< QgsFeatureId, QString >::const_iterator fidIt = mIdMap.find( attIt.key() );
-    if ( fidIt == mIdMap.constEnd() )
+    QString fid = serverFeatureId( attIt.key() );
+    if ( fid.isEmpty() )
     {
       continue;
     }
@@ -603,7 +715,7 @@ bool QgsWFSProvider::changeAttributeValues( const QgsChangedAttributesMap &attr_
     //Filter
     QDomElement filterElem = transactionDoc.createElementNS( OGC_NAMESPACE, "Filter" );
     QDomElement featureIdElem = transactionDoc.createElementNS( OGC_NAMESPACE, "FeatureId" );
-    featureIdElem.setAttribute( "fid", fidIt.value() );
+    featureIdElem.setAttribute( "fid", fid );
     filterElem.appendChild( featureIdElem );
     updateElem.appendChild( filterElem );
 
@@ -623,6 +735,21 @@ bool QgsWFSProvider::changeAttributeValues( const QgsChangedAttributesMap &attr_
     attIt = attr_map.constBegin();
     for ( ; attIt != attr_map.constEnd(); ++attIt )
     {
+      if ( mDiskCache )
+      {
+        QgsFeature f;
+        if ( mDiskCache->feature( attIt.key(), f, mFields ) )
+        {
+          QgsAttributeMap::const_iterator attMapIt = attIt.value().constBegin();
+          for ( ; attMapIt != attIt.value().constEnd(); ++attMapIt )
+          {
+            f.setAttribute( attMapIt.key(), attMapIt.value() );
+          }
+          mDiskCache->addFeature( f, mIdMap.value( attIt.key() ) );
+        }
+        continue;
+      }
+
       QMap<QgsFeatureId, QgsFeature*>::iterator fIt = mFeatures.find( attIt.key() );
       if ( fIt == mFeatures.end() )
       {
@@ -713,31 +840,42 @@ int QgsWFSProvider::getFeatureGET( const QString& uri, const QString& geometryAt
   getFeatureUrl.removeQueryItem( "username" );
   getFeatureUrl.removeQueryItem( "password" );
   getFeatureUrl.removeQueryItem( "authcfg" );
-  QgsRectangle extent;
-  if ( dataReader.getFeatures( getFeatureUrl.toString(),
-                               &mWKBType,
-                               mCached ? &mExtent : &extent,
-                               mAuth.mUserName,
-                               mAuth.mPassword,
-                               mAuth.mAuthCfg ) != 0 )
-  {
-    QgsDebugMsg( "getWFSData returned with error" );
-    return 1;
+  getFeatureUrl.removeQueryItem( "pageSize" );
+  if ( mCached && mDiskCache )
+  {
+    if ( getFeatureDiskCache( getFeatureUrl, typeName, geometryAttribute ) != 0 )
+    {
+      return 1;
+    }
   }
-  mFeatures = dataReader.featuresMap();
-  mIdMap = dataReader.idsMap();
+  else
+  {
+    QgsRectangle extent;
+    if ( dataReader.getFeatures( getFeatureUrl.toString(),
+                                 &mWKBType,
+                                 mCached ? &mExtent : &extent,
+                                 mAuth.mUserName,
+                                 mAuth.mPassword,
+                                 mAuth.mAuthCfg ) != 0 )
+    {
+      QgsDebugMsg( "getWFSData returned with error" );
+      return 1;
+    }
+    mFeatures = dataReader.featuresMap();
+    mIdMap = dataReader.idsMap();
 
-  QgsDebugMsg( QString( "feature count after request is: %1" ).arg( mFeatures.size() ) );
+    QgsDebugMsg( QString( "feature count after request is: %1" ).arg( mFeatures.size() ) );
 
-  if ( mWKBType != QGis::WKBNoGeometry )
-  {
-    for ( QMap<QgsFeatureId, QgsFeature*>::iterator it = mFeatures.begin(); it != mFeatures.end(); ++it )
+    if ( mWKBType != QGis::WKBNoGeometry )
     {
-      QgsDebugMsg( "feature " + FID_TO_STRING(( *it )->id() ) );
-      mSpatialIndex->insertFeature( *( it.value() ) );
+      for ( QMap<QgsFeatureId, QgsFeature*>::iterator it = mFeatures.begin(); it != mFeatures.end(); ++it )
+      {
+        QgsDebugMsg( "feature " + FID_TO_STRING(( *it )->id() ) );
+        mSpatialIndex->insertFeature( *( it.value() ) );
+      }
     }
+    mFeatureCount = mFeatures.size();
   }
-  mFeatureCount = mFeatures.size();
 
   if ( mFeatureCount && mFeatureCount >= mMaxFeatureCount && mFeatureCount % 500 == 0 )
     QgsMessageLog::logMessage(
@@ -751,6 +889,160 @@ int QgsWFSProvider::getFeatureGET( const QString& uri, const QString& geometryAt
   return 0;
 }
 
+int QgsWFSProvider::getFeatureDiskCache( const QUrl& getFeatureUrl, const QString& typeName, const QString& geometryAttribute )
+{
+  QNetworkRequest request( getFeatureUrl );
+  if ( !mAuth.setAuthorization( request ) )
+  {
+    QgsMessageLog::logMessage( tr( "Network request update failed for authentication config" ),
+                               tr( "WFS" ) );
+    return 1;
+  }
+
+  //features are written to disk as they arrive, previous data are replaced when the download succeeds
+  if ( !mDiskCache->beginPopulate() )
+  {
+    QgsMessageLog::logMessage( tr( "Could not write to WFS feature cache %1" ).arg( mDiskCache->fileName() ), tr( "WFS" ) );
+    return 1;
+  }
+
+  QgsGml dataReader( typeName, geometryAttribute, mFields );
+  QNetworkReply* reply = QgsNetworkAccessManager::instance()->get( request );
+
+  QMap<QgsFeatureId, QString> idMap;
+  QgsRectangle extent;
+  extent.setMinimal();
+  qint64 received = 0;
+  bool ok = true;
+  bool atEnd = false;
+  while ( ok && !atEnd )
+  {
+    if ( reply->bytesAvailable() == 0 && !reply->isFinished() )
+    {
+      QEventLoop loop;
+      connect( reply, SIGNAL( readyRead() ), &loop, SLOT( quit() ) );
+      connect( reply, SIGNAL( finished() ), &loop, SLOT( quit() ) );
+      loop.exec( QEventLoop::ExcludeUserInputEvents );
+    }
+
+    atEnd = reply->isFinished();
+    QByteArray data = reply->readAll();
+    received += data.size();
+    handleWFSProgressMessage( static_cast<int>( received ), reply->header( QNetworkRequest::ContentLengthHeader ).toInt() );
+
+    ok = dataReader.processData( data, atEnd, &mWKBType );
+
+    QMap<QgsFeatureId, QString> ids;
+    QList<QgsFeature*> features = dataReader.takeFeatures( &ids );
+    Q_FOREACH ( QgsFeature* f, features )
+    {
+      //values are stored with the types of the schema
+      for ( int i = 0; i < mFields.count() && i < f->attributes().size(); ++i )
+      {
+        const QVariant& v = f->attributes().at( i );
+        if ( v.type() != mFields.at( i ).type() )
+          f->setAttribute( i, convertValue( mFields.at( i ).type(), v.toString() ) );
+      }
+
+      ok = ok && mDiskCache->addFeature( *f, ids.value( f->id() ) );
+      if ( f->constGeometry() )
+      {
+        QgsRectangle bbox = f->constGeometry()->boundingBox();
+        extent.combineExtentWith( &bbox );
+      }
+      delete f;
+    }
+    idMap.unite( ids );
+  }
+
+  if ( ok && reply->error() != QNetworkReply::NoError )
+  {
+    QgsMessageLog::logMessage( tr( "GetFeature network request failed with error: %1" ).arg( reply->errorString() ), tr( "WFS" ) );
+    ok = false;
+  }
+  reply->abort();
+  reply->deleteLater();
+
+  if ( !ok )
+  {
+    mDiskCache->abortPopulate();
+    return 1;
+  }
+
+  if ( idMap.isEmpty() || mWKBType == QGis::WKBNoGeometry )
+  {
+    extent = QgsRectangle();
+  }
+  if ( !mDiskCache->finishPopulate( mFields, mGeometryAttribute, mWKBType, extent, diskCacheFingerprint() ) )
+  {
+    QgsMessageLog::logMessage( tr( "Could not write to WFS feature cache %1" ).arg( mDiskCache->fileName() ), tr( "WFS" ) );
+    return 1;
+  }
+
+  mExtent = extent;
+  mIdMap = idMap;
+  mFeatureCount = mIdMap.size();
+  QgsDebugMsg( QString( "feature count after request is: %1" ).arg( mFeatureCount ) );
+  return 0;
+}
+
+bool QgsWFSProvider::loadDiskCache( bool offline )
+{
+  if ( !mDiskCache )
+  {
+    return false;
+  }
+
+  if ( !offline && !mDiskCache->isUpToDate( QgsWFSFeatureCache::timeToLive(), diskCacheFingerprint() ) )
+  {
+    return false;
+  }
+
+  QgsFields fields;
+  QString geometryAttribute;
+  QGis::WkbType wkbType;
+  QgsRectangle extent;
+  QMap<QgsFeatureId, QString> idMap;
+  if ( !mDiskCache->readSchema( fields, geometryAttribute, wkbType, extent ) || !mDiskCache->readIds( idMap ) )
+  {
+    return false;
+  }
+
+  if ( offline )
+  {
+    mFields = fields;
+    mGeometryAttribute = geometryAttribute;
+    mWKBType = wkbType;
+    //the server is not available, transactions would fail
+    mCapabilities = 0;
+  }
+
+  deleteData();
+  delete mSpatialIndex;
+  mSpatialIndex = 0;
+
+  mExtent = extent;
+  mIdMap = idMap;
+  mFeatureCount = mIdMap.size();
+  mValid = true;
+  QgsDebugMsg( QString( "%1 features read from disk cache %2" ).arg( mFeatureCount ).arg( mDiskCache->fileName() ) );
+  return true;
+}
+
+QByteArray QgsWFSProvider::diskCacheFingerprint() const
+{
+  QCryptographicHash hash( QCryptographicHash::Md5 );
+  hash.addData( mFeatureTypeCapabilities );
+  hash.addData( mGeometryAttribute.toUtf8() );
+  hash.addData( QByteArray::number( mWKBType ) );
+  for ( int i = 0; i < mFields.count(); ++i )
+  {
+    hash.addData( mFields.at( i ).name().toUtf8() );
+    hash.addData( mFields.at( i ).typeName().toUtf8() );
+  }
+  return hash.result();
+}
+
 int QgsWFSProvider::getFeatureFILE( const QString& uri, const QString& geometryAttribute )
 {
   QFile gmlFile( uri );
@@ -1509,6 +1801,12 @@ QStringList QgsWFSProvider::insertedFeatureIds( const QDomDocument& serverRespon
 
 QgsFeatureId QgsWFSProvider::findNewKey() const
 {
+  if ( mDiskCache )
+  {
+    //features cached on disk are not in memory, but their ids are
+    return mIdMap.isEmpty() ? 0 : ( mIdMap.constEnd() - 1 ).key() + 1;
+  }
+
   if ( mFeatures.isEmpty() )
   {
     return 0;
@@ -1521,9 +1819,87 @@ QgsFeatureId QgsWFSProvider::findNewKey() const
   return ++id;
 }
 
+QString QgsWFSProvider::serverFeatureId( QgsFeatureId id ) const
+{
+  if ( isStreaming() )
+  {
+    return mStreamedIds->gmlId( id );
+  }
+  return mIdMap.value( id );
+}
+
+int QgsWFSProvider::requestFeatureCount() const
+{
+  //WFS 1.0 has no RESULTTYPE parameter, the request keeps the version of the layer
+  QUrl hitsUrl( dataSourceUri() );
+  if ( hitsUrl.queryItemValue( "VERSION" ).startsWith( "1.0" ) )
+  {
+    return -1;
+  }
+  hitsUrl.removeQueryItem( "username" );
+  hitsUrl.removeQueryItem( "password" );
+  hitsUrl.removeQueryItem( "authcfg" );
+  hitsUrl.removeQueryItem( "pageSize" );
+  hitsUrl.removeQueryItem( "BBOX" );
+  hitsUrl.removeQueryItem( "MAXFEATURES" );
+  hitsUrl.removeQueryItem( "RESULTTYPE" );
+  hitsUrl.addQueryItem( "RESULTTYPE", "hits" );
+
+  QNetworkRequest request( hitsUrl );
+  if ( !mAuth.setAuthorization( request ) )
+  {
+    return -1;
+  }
+  QNetworkReply* reply = QgsNetworkAccessManager::instance()->get( request );
+
+  //only the root element is read - servers ignoring RESULTTYPE would send all features
+  QXmlStreamReader reader;
+  int count = -1;
+  bool atEnd = false;
+  while ( !atEnd )
+  {
+    if ( reply->bytesAvailable() == 0 && !reply->isFinished() )
+    {
+      QEventLoop loop;
+      connect( reply, SIGNAL( readyRead() ), &loop, SLOT( quit() ) );
+      connect( reply, SIGNAL( finished() ), &loop, SLOT( quit() ) );
+      loop.exec( QEventLoop::ExcludeUserInputEvents );
+    }
+    atEnd = reply->isFinished();
+    reader.addData( reply->readAll() );
+
+    while ( !reader.atEnd() && reader.readNext() != QXmlStreamReader::StartElement )
+      ;
+    if ( reader.isStartElement() )
+    {
+      //numberOfFeatures in WFS 1.1, numberMatched in WFS 2.0 (may be "unknown")
+      QXmlStreamAttributes attributes = reader.attributes();
+      QString number = attributes.hasAttribute( "numberMatched" ) ? attributes.value( "numberMatched" ).toString()
+                       : attributes.value( "numberOfFeatures" ).toString();
+      bool ok;
+      int n = number.toInt( &ok );
+      if ( reader.name() == "FeatureCollection" && ok )
+      {
+        count = n;
+      }
+      break;
+    }
+    if ( reader.hasError() && reader.error() != QXmlStreamReader::PrematureEndOfDocumentError )
+    {
+      break;
+    }
+  }
+
+  reply->abort();
+  reply->deleteLater();
+  QgsDebugMsg( QString( "server reports %1 features" ).arg( count ) );
+  return count;
+}
+
 void QgsWFSProvider::getLayerCapabilities()
 {
   int capabilities = 0;
+  mFeatureTypeCapabilities.clear();
   if ( !mNetworkRequestFinished )
   {
     mCapabilities = 0;
@@ -1582,6 +1958,11 @@ void QgsWFSProvider::getLayerCapabilities()
     QString name = featureTypeList.at( i ).firstChildElement( "Name" ).text();
     if ( name == thisLayerName )
     {
+      QString featureTypeXml;
+      QTextStream featureTypeStream( &featureTypeXml );
+      featureTypeList.at( i ).save( featureTypeStream, 0 );
+      mFeatureTypeCapabilities = featureTypeXml.toUtf8();
+
       if ( !mCached && mExtent.isEmpty() )
       {
         QDomElement e = featureTypeList.at( i ).firstChildElement( "LatLongBoundingBox" );
@@ -1729,7 +2110,8 @@ void QgsWFSProvider::handleException( const QDomDocument& serverResponse )
 
 void QgsWFSProvider::extendExtent( const QgsRectangle &extent )
 {
-  if ( mCached )
+  //streaming iterators download the features of their rectangle themselves
+  if ( mCached || isStreaming() )
     return;
 
   QgsRectangle r( mExtent.intersect( &extent ) );
@@ -1772,6 +2154,65 @@ void QgsWFSProvider::extendExtent( const QgsRectangle &extent )
   }
 }
 
+QgsWFSFeatureIdMap::QgsWFSFeatureIdMap()
+    : mNextId( 0 )
+{
+}
+
+QgsFeatureId QgsWFSFeatureIdMap::featureId( const QString& gmlId )
+{
+  QMutexLocker locker( &mMutex );
+  if ( gmlId.isEmpty() )
+  {
+    return mNextId++;
+  }
+
+  QHash<QString, QgsFeatureId>::const_iterator it = mFeatureIds.constFind( gmlId );
+  if ( it != mFeatureIds.constEnd() )
+  {
+    return it.value();
+  }
+
+  QgsFeatureId id = mNextId++;
+  mFeatureIds.insert( gmlId, id );
+  mGmlIds.insert( id, gmlId );
+  return id;
+}
+
+QString QgsWFSFeatureIdMap::gmlId( QgsFeatureId id ) const
+{
+  QMutexLocker locker( &mMutex );
+  return mGmlIds.value( id );
+}
+
+QStringList QgsWFSFeatureIdMap::gmlIds( const QgsFeatureIds& ids ) const
+{
+  QMutexLocker locker( &mMutex );
+  QStringList gmlIds;
+  Q_FOREACH ( QgsFeatureId id, ids )
+  {
+    QMap<QgsFeatureId, QString>::const_iterator it = mGmlIds.constFind( id );
+    if ( it != mGmlIds.constEnd() )
+    {
+      gmlIds << it.value();
+    }
+  }
+  return gmlIds;
+}
+
+void QgsWFSFeatureIdMap::remove( QgsFeatureId id )
+{
+  QMutexLocker locker( &mMutex );
+  mFeatureIds.remove( mGmlIds.value( id ) );
+  mGmlIds.remove( id );
+}
+
+int QgsWFSFeatureIdMap::count() const
+{
+  QMutexLocker locker( &mMutex );
+  return mGmlIds.size();
+}
+
 QGISEXTERN QgsWFSProvider* classFactory( const QString *uri )
 {
   return new QgsWFSProvider( *uri );
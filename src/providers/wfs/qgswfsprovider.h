@@ -26,12 +26,14 @@
 #include "qgsvectordataprovider.h"
 #include "qgsmaplayer.h"
 #include "qgsvectorlayer.h"
-#include "qgswfsfeatureiterator.h"
 
+#include <QMutex>
 #include <QNetworkRequest>
+#include <QSharedPointer>
 
 class QgsRectangle;
 class QgsSpatialIndex;
+class QgsWFSFeatureCache;
 
 // TODO: merge with QgsWmsAuthorization?
 struct QgsWFSAuthorization
@@ -66,6 +68,33 @@ struct QgsWFSAuthorization
   QString mAuthCfg;
 };
 
+/** Ids of the features streamed from the server. A feature gets the same id in all iterators
+  of the layer (derived from its gml:id), the map is shared by the provider and its feature sources
+  and may be used from several threads*/
+class QgsWFSFeatureIdMap
+{
+  public:
+    QgsWFSFeatureIdMap();
+
+    /** Returns the id of the feature with the server id, unknown features get a new id.
+      Features without server id get a new id every time*/
+    QgsFeatureId featureId( const QString& gmlId );
+    /** Returns the server id of the feature or an empty string if the feature is not known*/
+    QString gmlId( QgsFeatureId id ) const;
+    /** Returns the ids of the features with the server ids, unknown features are skipped*/
+    QStringList gmlIds( const QgsFeatureIds& ids ) const;
+    /** Forgets a feature deleted by a transaction*/
+    void remove( QgsFeatureId id );
+    /** Number of features which got an id so far*/
+    int count() const;
+
+  private:
+    mutable QMutex mMutex;
+    QHash<QString, QgsFeatureId> mFeatureIds;
+    QMap<QgsFeatureId, QString> mGmlIds;
+    QgsFeatureId mNextId;
+};
+
 /** A provider reading features from a WFS server*/
 class QgsWFSProvider : public QgsVectorDataProvider
 {
@@ -196,13 +225,22 @@ class QgsWFSProvider : public QgsVectorDataProvider
     QList<QgsFeatureId>::iterator mFeatureIterator;
     /** Map <feature Id / feature> */
     QMap<QgsFeatureId, QgsFeature* > mFeatures;
+    /** Features stored on disk, used instead of mFeatures and mSpatialIndex (if enabled)*/
+    QgsWFSFeatureCache* mDiskCache;
+    /** Description of the layer from capabilities document, data cached on disk are dropped when it changes*/
+    QByteArray mFeatureTypeCapabilities;
     /** Stores the relation between provider ids and WFS server ids*/
     QMap<QgsFeatureId, QString > mIdMap;
+    /** Relation between provider ids and WFS server ids of layers streaming the features (used instead of mIdMap)*/
+    QSharedPointer<QgsWFSFeatureIdMap> mStreamedIds;
     /** Geometry type of the features in this layer*/
     mutable QGis::WkbType mWKBType;
     /** Source CRS*/
     QgsCoordinateReferenceSystem mSourceCRS;
-    int mFeatureCount;
+    /** Number of features, -1 if it is not known for a streaming layer*/
+    mutable int mFeatureCount;
+    /** Whether the server of a streaming layer has been asked for the number of features*/
+    mutable bool mFeatureCountRequested;
     int mMaxFeatureCount;
     /** Flag if provider is valid*/
     bool mValid;
@@ -228,6 +266,13 @@ class QgsWFSProvider : public QgsVectorDataProvider
     int getFeaturePOST( const QString& uri, const QString& geometryAttribute );
     int getFeatureSOAP( const QString& uri, const QString& geometryAttribute );
     int getFeatureFILE( const QString& uri, const QString& geometryAttribute );
+    /** Downloads the features in chunks directly to the disk cache. Returns 0 in case of success*/
+    int getFeatureDiskCache( const QUrl& getFeatureUrl, const QString& typeName, const QString& geometryAttribute );
+    /** Uses features from the disk cache if they are up to date. If offline is set the age and capabilities are not checked
+      and the layer description is read from the cache too, the layer is read-only then. Returns true in case of success*/
+    bool loadDiskCache( bool offline );
+    /** Identifies the layer description (capabilities and schema) the features were downloaded with*/
+    QByteArray diskCacheFingerprint() const;
     //encoding specific methods of describeFeatureType
     int describeFeatureTypeGET( const QString& uri, QString& geometryAttribute, QgsFields& fields, QGis::WkbType& geomType );
     int describeFeatureTypePOST( const QString& uri, QString& geometryAttribute, QgsFields& fields );
@@ -275,6 +320,13 @@ class QgsWFSProvider : public QgsVectorDataProvider
     QStringList insertedFeatureIds( const QDomDocument& serverResponse ) const;
     /** Returns a key suitable for new items*/
     QgsFeatureId findNewKey() const;
+    /** Features are not kept by the provider, but streamed from the server for every request*/
+    bool isStreaming() const { return !mCached && mRequestEncoding == QgsWFSProvider::GET; }
+    /** Returns the WFS server id of the feature or an empty string if it is not known*/
+    QString serverFeatureId( QgsFeatureId id ) const;
+    /** Asks the server for the number of features of the layer (RESULTTYPE=hits, WFS 1.1 and newer).
+      Returns -1 if the server does not tell or the layer uses WFS 1.0*/
+    int requestFeatureCount() const;
     /** Retrieve capabilities for this layer from GetCapabilities document (will be stored in mCapabilites)*/
     void getLayerCapabilities();
     /** Takes <Operations> element and updates the capabilities*/
@@ -0,0 +1,133 @@
+/***************************************************************************
+  benchqgsgraphanalyzer.cpp
+  --------------------------------------
+  Date                 : October 2015
+  Copyright            : (C) 2015 by QGIS Development Team
+  Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include "qgscompactgraph.h"
+#include "qgsgraph.h"
+#include "qgsgraphanalyzer.h"
+
+/**
+ * Create a synthetic road network: a grid of size x size vertices with unit spacing,
+ * neighbours are connected by arcs in both directions. Cost of the arc is its length
+ * multiplied by a pseudo-random factor between 1 and 2 (i.e. cost is never lower than length).
+ */
+static QgsGraph* _gridGraph( int size )
+{
+  QgsGraph* graph = new QgsGraph;
+  for ( int row = 0; row < size; ++row )
+    for ( int col = 0; col < size; ++col )
+      graph->addVertex( QgsPoint( col, row ) );
+
+  unsigned int seed = 1;
+  for ( int row = 0; row < size; ++row )
+  {
+    for ( int col = 0; col < size; ++col )
+    {
+      int v = row * size + col;
+      QList<int> neighbours;
+      if ( col + 1 < size )
+        neighbours << v + 1;
+      if ( row + 1 < size )
+        neighbours << v + size;
+
+      Q_FOREACH ( int n, neighbours )
+      {
+        // simple linear congruential generator - results have to be reproducible
+        seed = seed * 1103515245 + 12345;
+        double factor = 1.0 + ( seed >> 16 ) % 1000 / 1000.0;
+
+        QVector<QVariant> props;
+        props << factor;
+        graph->addArc( v, n, props );
+        graph->addArc( n, v, props );
+      }
+    }
+  }
+  return graph;
+}
+
+/**
+ * Benchmarks of shortest path searches on a large graph. Not run with the unit tests,
+ * the qgis_graphanalyzerbench executable has to be started manually.
+ */
+class BenchQgsGraphAnalyzer : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    // synthetic road network with ~1M arcs (500 x 500 vertices)
+
+    void benchmarkDijkstraGraph()
+    {
+      QgsGraph* graph = _gridGraph( 500 );
+      QVector<double> cost;
+      QBENCHMARK
+      {
+        QgsGraphAnalyzer::dijkstra( graph, 0, 0, NULL, &cost );
+      }
+      delete graph;
+    }
+
+    void benchmarkDijkstraCompactGraph()
+    {
+      QgsGraph* graph = _gridGraph( 500 );
+      QgsCompactGraph cg( graph );
+      delete graph;
+
+      QVector<double> cost;
+      QBENCHMARK
+      {
+        QgsGraphAnalyzer::dijkstra( &cg, 0, 0, NULL, &cost );
+      }
+    }
+
+    void benchmarkAStarCompactGraph()
+    {
+      QgsGraph* graph = _gridGraph( 500 );
+      QgsCompactGraph cg( graph );
+      delete graph;
+
+      QVector<int> path;
+      QBENCHMARK
+      {
+        QgsGraphAnalyzer::aStar( &cg, 0, 500 * 250 + 250, 0, &path );
+      }
+    }
+
+    void benchmarkCostMatrix()
+    {
+      QgsGraph* graph = _gridGraph( 500 );
+      QgsCompactGraph cg( graph );
+      delete graph;
+
+      // 100 x 100 matrix of randomly spread vertices
+      QVector<int> origins, destinations;
+      for ( int i = 0; i < 100; ++i )
+      {
+        origins << ( i * 2477 ) % cg.vertexCount();
+        destinations << ( i * 3539 + 1000 ) % cg.vertexCount();
+      }
+
+      QBENCHMARK
+      {
+        QgsGraphAnalyzer::costMatrix( &cg, origins, destinations, 0 );
+      }
+    }
+};
+
+QTEST_MAIN( BenchQgsGraphAnalyzer )
+
+#include "benchqgsgraphanalyzer.moc"
@@ -0,0 +1,270 @@
+/***************************************************************************
+  benchqgsosmimport.cpp
+  --------------------------------------
+  Date                 : October 2015
+  Copyright            : (C) 2015 by QGIS Development Team
+  Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QFile>
+#include <QTextStream>
+
+#include "openstreetmap/qgsosmimport.h"
+
+// synthetic street grid of GRID_SIZE x GRID_SIZE nodes, streets along all rows and columns
+static const int GRID_SIZE = 300;
+// number of entities in a PBF block, as written by osmosis
+static const int PBF_BLOCK_SIZE = 8000;
+
+static QgsOSMId _nodeId( int row, int col ) { return 1 + ( QgsOSMId ) row * GRID_SIZE + col; }
+static double _nodeLat( int row ) { return 50.0 + row * 1E-4; }
+static double _nodeLon( int col ) { return 14.4 + col * 1E-4; }
+
+
+// minimal protocol buffers encoding, see http://wiki.openstreetmap.org/wiki/PBF_Format
+
+static void _pbfVarint( QByteArray& out, quint64 value )
+{
+  while ( value >= 0x80 )
+  {
+    out.append(( char )(( value & 0x7f ) | 0x80 ) );
+    value >>= 7;
+  }
+  out.append(( char ) value );
+}
+
+static quint64 _pbfZigzag( qint64 value )
+{
+  return (( quint64 ) value << 1 ) ^ ( quint64 )( value >> 63 );
+}
+
+static void _pbfValue( QByteArray& out, int field, quint64 value )
+{
+  _pbfVarint( out, field << 3 );
+  _pbfVarint( out, value );
+}
+
+static void _pbfBytes( QByteArray& out, int field, const QByteArray& bytes )
+{
+  _pbfVarint( out, ( field << 3 ) | 2 );
+  _pbfVarint( out, bytes.size() );
+  out.append( bytes );
+}
+
+static void _pbfPacked( QByteArray& out, int field, const QVector<quint64>& values )
+{
+  QByteArray packed;
+  Q_FOREACH ( quint64 value, values )
+    _pbfVarint( packed, value );
+  _pbfBytes( out, field, packed );
+}
+
+//! writes a zlib compressed blob with its header
+static void _pbfWriteBlob( QFile& file, const QByteArray& type, const QByteArray& data )
+{
+  QByteArray blob;
+  _pbfValue( blob, 2, data.size() );
+  // qCompress() puts the uncompressed size in front of the zlib stream
+  _pbfBytes( blob, 3, qCompress( data ).mid( 4 ) );
+
+  QByteArray header;
+  _pbfBytes( header, 1, type );
+  _pbfValue( header, 3, blob.size() );
+
+  QByteArray headerSize( 4, 0 );
+  for ( int i = 0; i < 4; ++i )
+    headerSize[i] = ( char )(( header.size() >> ( 24 - 8 * i ) ) & 0xff );
+
+  file.write( headerSize );
+  file.write( header );
+  file.write( blob );
+}
+
+static QByteArray _pbfStringTable( const QList<QByteArray>& strings )
+{
+  QByteArray table;
+  Q_FOREACH ( const QByteArray& s, strings )
+    _pbfBytes( table, 1, s );
+  return table;
+}
+
+static bool _writePbf( const QString& fileName )
+{
+  QFile file( fileName );
+  if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    return false;
+
+  QByteArray header;
+  _pbfBytes( header, 4, "OsmSchema-V0.6" );
+  _pbfBytes( header, 4, "DenseNodes" );
+  _pbfWriteBlob( file, "OSMHeader", header );
+
+  // string 0 is never used, it terminates the tags of dense nodes
+  QList<QByteArray> strings;
+  strings << "" << "highway" << "residential" << "traffic_signals" << "name";
+  for ( int i = 0; i < 2 * GRID_SIZE; ++i )
+    strings << QString( "Street %1" ).arg( i ).toUtf8();
+  QByteArray stringTable = _pbfStringTable( strings );
+
+  // dense nodes, delta coded, every tenth node has traffic signals
+  int nodeCount = GRID_SIZE * GRID_SIZE;
+  for ( int first = 0; first < nodeCount; first += PBF_BLOCK_SIZE )
+  {
+    QVector<quint64> ids, lats, lons, keysVals;
+    qint64 lastId = 0, lastLat = 0, lastLon = 0;
+    for ( int n = first; n < qMin( nodeCount, first + PBF_BLOCK_SIZE ); ++n )
+    {
+      int row = n / GRID_SIZE, col = n % GRID_SIZE;
+      qint64 id = _nodeId( row, col );
+      qint64 lat = qRound64( _nodeLat( row ) * 1E7 );
+      qint64 lon = qRound64( _nodeLon( col ) * 1E7 );
+      ids << _pbfZigzag( id - lastId );
+      lats << _pbfZigzag( lat - lastLat );
+      lons << _pbfZigzag( lon - lastLon );
+      lastId = id;
+      lastLat = lat;
+      lastLon = lon;
+      if ( n % 10 == 0 )
+        keysVals << 1 << 3;
+      keysVals << 0;
+    }
+
+    QByteArray dense;
+    _pbfPacked( dense, 1, ids );
+    _pbfPacked( dense, 8, lats );
+    _pbfPacked( dense, 9, lons );
+    _pbfPacked( dense, 10, keysVals );
+    QByteArray group;
+    _pbfBytes( group, 2, dense );
+    QByteArray block;
+    _pbfBytes( block, 1, stringTable );
+    _pbfBytes( block, 2, group );
+    _pbfWriteBlob( file, "OSMData", block );
+  }
+
+  // streets along the rows and the columns
+  QByteArray group;
+  for ( int i = 0; i < 2 * GRID_SIZE; ++i )
+  {
+    QVector<quint64> refs;
+    qint64 lastRef = 0;
+    for ( int j = 0; j < GRID_SIZE; ++j )
+    {
+      qint64 ref = i < GRID_SIZE ? _nodeId( i, j ) : _nodeId( j, i - GRID_SIZE );
+      refs << _pbfZigzag( ref - lastRef );
+      lastRef = ref;
+    }
+
+    QByteArray way;
+    _pbfValue( way, 1, i + 1 );
+    _pbfPacked( way, 2, QVector<quint64>() << 1 << 4 );
+    _pbfPacked( way, 3, QVector<quint64>() << 2 << ( quint64 )( 5 + i ) );
+    _pbfPacked( way, 8, refs );
+    _pbfBytes( group, 3, way );
+  }
+  QByteArray block;
+  _pbfBytes( block, 1, stringTable );
+  _pbfBytes( block, 2, group );
+  _pbfWriteBlob( file, "OSMData", block );
+
+  return file.error() == QFile::NoError;
+}
+
+static bool _writeXml( const QString& fileName )
+{
+  QFile file( fileName );
+  if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    return false;
+
+  QTextStream out( &file );
+  out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+  out << "<osm version=\"0.6\" generator=\"benchqgsosmimport\">\n";
+  for ( int row = 0; row < GRID_SIZE; ++row )
+  {
+    for ( int col = 0; col < GRID_SIZE; ++col )
+    {
+      QgsOSMId id = _nodeId( row, col );
+      out << QString( " <node id=\"%1\" lat=\"%2\" lon=\"%3\"" ).arg( id ).arg( _nodeLat( row ), 0, 'f', 7 ).arg( _nodeLon( col ), 0, 'f', 7 );
+      if ( ( id - 1 ) % 10 == 0 )
+        out << ">\n  <tag k=\"highway\" v=\"traffic_signals\"/>\n </node>\n";
+      else
+        out << "/>\n";
+    }
+  }
+  for ( int i = 0; i < 2 * GRID_SIZE; ++i )
+  {
+    out << QString( " <way id=\"%1\">\n" ).arg( i + 1 );
+    for ( int j = 0; j < GRID_SIZE; ++j )
+      out << QString( "  <nd ref=\"%1\"/>\n" ).arg( i < GRID_SIZE ? _nodeId( i, j ) : _nodeId( j, i - GRID_SIZE ) );
+    out << "  <tag k=\"highway\" v=\"residential\"/>\n";
+    out << QString( "  <tag k=\"name\" v=\"Street %1\"/>\n" ).arg( i );
+    out << " </way>\n";
+  }
+  out << "</osm>\n";
+  out.flush();
+
+  return file.error() == QFile::NoError;
+}
+
+/**
+ * Benchmarks of the import of OpenStreetMap data. Not run with the unit tests, the
+ * qgis_osmimportbench executable has to be started manually. The same synthetic
+ * data (90000 nodes, 600 ways) are imported from XML and PBF files.
+ */
+class BenchQgsOSMImport : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase()
+    {
+      mXmlFileName = QDir::tempPath() + "/osmimportbench.osm";
+      mPbfFileName = QDir::tempPath() + "/osmimportbench.osm.pbf";
+      mDbFileName = QDir::tempPath() + "/osmimportbench.db";
+      QVERIFY( _writeXml( mXmlFileName ) );
+      QVERIFY( _writePbf( mPbfFileName ) );
+    }
+
+    void cleanupTestCase()
+    {
+      QFile::remove( mXmlFileName );
+      QFile::remove( mPbfFileName );
+      QFile::remove( mDbFileName );
+    }
+
+    void benchmarkImport_data()
+    {
+      QTest::addColumn<QString>( "fileName" );
+
+      QTest::newRow( "xml" ) << mXmlFileName;
+      QTest::newRow( "pbf" ) << mPbfFileName;
+    }
+
+    void benchmarkImport()
+    {
+      QFETCH( QString, fileName );
+
+      QBENCHMARK
+      {
+        QgsOSMXmlImport import( fileName, mDbFileName );
+        QVERIFY2( import.import(), import.errorString().toUtf8().constData() );
+      }
+    }
+
+  private:
+    QString mXmlFileName;
+    QString mPbfFileName;
+    QString mDbFileName;
+};
+
+QTEST_MAIN( BenchQgsOSMImport )
+
+#include "benchqgsosmimport.moc"
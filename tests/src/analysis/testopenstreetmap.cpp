@@ -23,6 +23,34 @@
 #include "openstreetmap/qgsosmdownload.h"
 #include "openstreetmap/qgsosmimport.h"
 
+#include <sqlite3.h>
+
+/** Geometry blobs of the features in an exported table by feature id */
+static QMap<qint64, QByteArray> exportedGeometries( const QString& dbFilename, const QString& tableName )
+{
+  QMap<qint64, QByteArray> geometries;
+  sqlite3* database;
+  if ( sqlite3_open_v2( dbFilename.toUtf8().constData(), &database, SQLITE_OPEN_READONLY, 0 ) != SQLITE_OK )
+  {
+    sqlite3_close( database );
+    return geometries;
+  }
+
+  sqlite3_stmt* stmt;
+  QString sql = QString( "SELECT id,geometry FROM \"%1\"" ).arg( tableName );
+  if ( sqlite3_prepare_v2( database, sql.toUtf8().constData(), -1, &stmt, 0 ) == SQLITE_OK )
+  {
+    while ( sqlite3_step( stmt ) == SQLITE_ROW )
+    {
+      geometries.insert( sqlite3_column_int64( stmt, 0 ),
+                         QByteArray(( const char* ) sqlite3_column_blob( stmt, 1 ), sqlite3_column_bytes( stmt, 1 ) ) );
+    }
+    sqlite3_finalize( stmt );
+  }
+  sqlite3_close( database );
+  return geometries;
+}
+
 class TestOpenStreetMap : public QObject
 {
     Q_OBJECT
@@ -34,6 +62,7 @@ class TestOpenStreetMap : public QObject
     /** Our tests proper begin here */
     void download();
     void importAndQueries();
+    void importPbf();
   private:
 
 };
@@ -183,10 +212,82 @@ void TestOpenStreetMap::importAndQueries()
     qDebug( "EXPORT-2 ERR: %s", db.errorString().toAscii().data() );
   QCOMPARE( exportRes2, true );
 
+  // ways built with queries for each way instead of node locations in memory
+  db.setNodeLocationsInMemory( false );
+  bool exportRes3 = db.exportSpatiaLite( QgsOSMDatabase::Polygon, "sl_polygons", QStringList( "building" ) );
+  if ( !db.errorString().isEmpty() )
+    qDebug( "EXPORT-3 ERR: %s", db.errorString().toAscii().data() );
+  QCOMPARE( exportRes3, true );
+
+  // node locations in memory must give the same geometries as the queries for each way
+  db.setNodeLocationsInMemory( true );
+  bool exportRes4 = db.exportSpatiaLite( QgsOSMDatabase::Polygon, "sl_polygons_memory", QStringList( "building" ) );
+  if ( !db.errorString().isEmpty() )
+    qDebug( "EXPORT-4 ERR: %s", db.errorString().toAscii().data() );
+  QCOMPARE( exportRes4, true );
+
+  QMap<qint64, QByteArray> perWayGeometries = exportedGeometries( dbFilename, "sl_polygons" );
+  QMap<qint64, QByteArray> inMemoryGeometries = exportedGeometries( dbFilename, "sl_polygons_memory" );
+  QVERIFY( !perWayGeometries.isEmpty() );
+  QCOMPARE( inMemoryGeometries, perWayGeometries );
+
 
   // TODO: test exported data
 }
 
+void TestOpenStreetMap::importPbf()
+{
+  QString dbFilename =  QDir::tempPath() + "/testdata-pbf.db";
+  QString pbfFilename = TEST_DATA_DIR "/openstreetmap/testdata.pbf";
+
+  QgsOSMXmlImport import( pbfFilename, dbFilename );
+  bool res = import.import();
+  if ( import.hasError() )
+    qDebug( "PBF ERR: %s", import.errorString().toAscii().data() );
+  QCOMPARE( res, true );
+  QCOMPARE( import.hasError(), false );
+
+  QgsOSMDatabase db( dbFilename );
+  QCOMPARE( db.open(), true );
+
+  // the same data as in testdata.xml
+
+  QgsOSMNode n = db.node( 11111 );
+  QCOMPARE( n.isValid(), true );
+  QCOMPARE( n.point().x(), 14.4277148 );
+  QCOMPARE( n.point().y(), 50.0651387 );
+
+  QgsOSMNode n2 = db.node( 360769666 );
+  QCOMPARE( n2.isValid(), true );
+  QCOMPARE( n2.point().x(), 14.4270765 );
+  QCOMPARE( n2.point().y(), 50.0665127 );
+
+  QgsOSMTags tags = db.tags( false, 11111 );
+  QCOMPARE( tags.count(), 7 );
+  QCOMPARE( tags.value( "addr:postcode" ), QString( "12800" ) );
+  QCOMPARE( tags.value( "addr:street" ), QString::fromUtf8( "Jaromírova" ) );
+
+  QCOMPARE( db.tags( false, 360769661 ).count(), 0 );
+
+  QgsOSMWay w = db.way( 32137532 );
+  QCOMPARE( w.isValid(), true );
+  QCOMPARE( w.nodes().count(), 5 );
+  QCOMPARE( w.nodes().at( 0 ), ( qint64 )360769661 );
+  QCOMPARE( w.nodes().at( 1 ), ( qint64 )360769664 );
+  QCOMPARE( w.nodes().at( 4 ), ( qint64 )360769661 );
+
+  QgsOSMTags tagsW = db.tags( true, 32137532 );
+  QCOMPARE( tagsW.count(), 3 );
+  QCOMPARE( tagsW.value( "source" ), QString( "cuzk:km" ) );
+
+  QgsOSMWayIterator ways = db.listWays();
+  QCOMPARE( ways.next().id(), ( qint64 )32137532 );
+  QCOMPARE( ways.next().isValid(), false );
+  ways.close();
+
+  db.close();
+}
+
 
 QTEST_MAIN( TestOpenStreetMap )
 
@@ -0,0 +1,298 @@
+/***************************************************************************
+  testqgsgraphanalyzer.cpp
+  --------------------------------------
+  Date                 : October 2015
+  Copyright            : (C) 2015 by QGIS Development Team
+  Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include "qgis.h"
+#include "qgscompactgraph.h"
+#include "qgsgraph.h"
+#include "qgsgraphanalyzer.h"
+
+#include <limits>
+
+/**
+ * Create a synthetic road network: a grid of size x size vertices with unit spacing,
+ * neighbours are connected by arcs in both directions. Cost of the arc is its length
+ * multiplied by a pseudo-random factor between 1 and 2 (i.e. cost is never lower than length).
+ */
+static QgsGraph* _gridGraph( int size )
+{
+  QgsGraph* graph = new QgsGraph;
+  for ( int row = 0; row < size; ++row )
+    for ( int col = 0; col < size; ++col )
+      graph->addVertex( QgsPoint( col, row ) );
+
+  unsigned int seed = 1;
+  for ( int row = 0; row < size; ++row )
+  {
+    for ( int col = 0; col < size; ++col )
+    {
+      int v = row * size + col;
+      QList<int> neighbours;
+      if ( col + 1 < size )
+        neighbours << v + 1;
+      if ( row + 1 < size )
+        neighbours << v + size;
+
+      Q_FOREACH ( int n, neighbours )
+      {
+        // simple linear congruential generator - results have to be reproducible
+        seed = seed * 1103515245 + 12345;
+        double factor = 1.0 + ( seed >> 16 ) % 1000 / 1000.0;
+
+        QVector<QVariant> props;
+        props << factor;
+        graph->addArc( v, n, props );
+        graph->addArc( n, v, props );
+      }
+    }
+  }
+  return graph;
+}
+
+class TestQgsGraphAnalyzer : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+
+    void testCompactGraph()
+    {
+      QgsGraph* graph = _gridGraph( 3 );
+      QgsCompactGraph cg( graph );
+
+      QCOMPARE( cg.vertexCount(), 9 );
+      QCOMPARE( cg.arcCount(), graph->arcCount() );
+      QCOMPARE( cg.criterionCount(), 1 );
+      QCOMPARE( cg.vertexPoint( 5 ), QgsPoint( 2, 1 ) );
+      QCOMPARE( cg.findVertex( QgsPoint( 1, 2 ) ), 7 );
+      QCOMPARE( cg.findVertex( QgsPoint( 10, 10 ) ), -1 );
+
+      // outgoing arcs of every vertex match the source graph
+      for ( int v = 0; v < graph->vertexCount(); ++v )
+      {
+        QgsGraphArcIdList outArcs = graph->vertex( v ).outArc();
+        QCOMPARE( cg.outArcEnd( v ) - cg.outArcBegin( v ), outArcs.count() );
+        for ( int pos = cg.outArcBegin( v ); pos < cg.outArcEnd( v ); ++pos )
+        {
+          const QgsGraphArc& arc = graph->arc( cg.arcId( pos ) );
+          QCOMPARE( cg.arcOutVertex( pos ), v );
+          QCOMPARE( cg.arcInVertex( pos ), arc.inVertex() );
+          QCOMPARE( cg.arcCost( pos, 0 ), arc.property( 0 ).toDouble() );
+        }
+      }
+
+      delete graph;
+    }
+
+    void testGraphWithoutProperties()
+    {
+      QgsGraph graph;
+      graph.addVertex( QgsPoint( 0, 0 ) );
+      graph.addVertex( QgsPoint( 1, 0 ) );
+      graph.addVertex( QgsPoint( 2, 0 ) );
+      graph.addArc( 0, 1, QVector<QVariant>() );
+      graph.addArc( 1, 2, QVector<QVariant>() );
+      QgsCompactGraph cg( &graph );
+
+      QCOMPARE( cg.criterionCount(), 0 );
+      QVERIFY( !cg.hasCriterion( 0 ) );
+      QVERIFY( !cg.costs( 0 ) );
+      QVERIFY( !cg.costs( -1 ) );
+      QCOMPARE( cg.arcCost( 0, 0 ), 0.0 );
+
+      // missing properties cost nothing
+      QVector<int> tree;
+      QVector<double> cost;
+      QgsGraphAnalyzer::dijkstra( &cg, 0, 0, &tree, &cost );
+      QCOMPARE( cost.size(), 3 );
+      QCOMPARE( cost[2], 0.0 );
+      QCOMPARE( tree[2], 1 );
+
+      QVector<int> path;
+      QCOMPARE( QgsGraphAnalyzer::aStar( &cg, 0, 2, 1, &path ), 0.0 );
+      QCOMPARE( path.size(), 3 );
+
+      QVector<int> origins, destinations;
+      origins << 0;
+      destinations << 2;
+      QCOMPARE( QgsGraphAnalyzer::costMatrix( &cg, origins, destinations, 0 ).at( 0 ), 0.0 );
+    }
+
+    void testDijkstra()
+    {
+      QgsGraph* graph = _gridGraph( 20 );
+      QgsCompactGraph cg( graph );
+
+      QVector<int> tree, treeCompact;
+      QVector<double> cost, costCompact;
+      QgsGraphAnalyzer::dijkstra( graph, 0, 0, &tree, &cost );
+      QgsGraphAnalyzer::dijkstra( &cg, 0, 0, &treeCompact, &costCompact );
+
+      QCOMPARE( cost.size(), graph->vertexCount() );
+      QCOMPARE( cost[0], 0.0 );
+      QCOMPARE( tree[0], -1 );
+      for ( int v = 0; v < graph->vertexCount(); ++v )
+      {
+        QVERIFY( qgsDoubleNear( cost[v], costCompact[v], 1e-9 ) );
+        if ( v == 0 )
+          continue;
+
+        // the tree arcs lead to the vertex and are consistent with the costs
+        const QgsGraphArc& arc = graph->arc( treeCompact[v] );
+        QCOMPARE( arc.inVertex(), v );
+        QVERIFY( qgsDoubleNear( costCompact[ arc.outVertex()] + arc.property( 0 ).toDouble(), costCompact[v], 1e-9 ) );
+      }
+
+      delete graph;
+    }
+
+    void testAStar()
+    {
+      QgsGraph* graph = _gridGraph( 20 );
+      QgsCompactGraph cg( graph );
+
+      QVector<double> cost;
+      QgsGraphAnalyzer::dijkstra( &cg, 21, 0, NULL, &cost );
+
+      QVector<int> path;
+      double pathCost = QgsGraphAnalyzer::aStar( &cg, 21, 398, 0, &path );
+      QVERIFY( qgsDoubleNear( pathCost, cost[398], 1e-9 ) );
+      QCOMPARE( path.first(), 21 );
+      QCOMPARE( path.last(), 398 );
+
+      // sum of arc costs along the path
+      double sum = 0;
+      for ( int i = 1; i < path.count(); ++i )
+      {
+        double arcCost = std::numeric_limits<double>::infinity();
+        for ( int pos = cg.outArcBegin( path[i-1] ); pos < cg.outArcEnd( path[i-1] ); ++pos )
+        {
+          if ( cg.arcInVertex( pos ) == path[i] )
+            arcCost = cg.arcCost( pos, 0 );
+        }
+        sum += arcCost;
+      }
+      QVERIFY( qgsDoubleNear( sum, pathCost, 1e-9 ) );
+
+      // start == end
+      QCOMPARE( QgsGraphAnalyzer::aStar( &cg, 5, 5, 0, &path ), 0.0 );
+      QCOMPARE( path, QVector<int>() << 5 );
+
+      delete graph;
+    }
+
+    void testAStarUnreachable()
+    {
+      QgsGraph graph;
+      graph.addVertex( QgsPoint( 0, 0 ) );
+      graph.addVertex( QgsPoint( 1, 0 ) );
+      graph.addVertex( QgsPoint( 2, 0 ) );
+      graph.addArc( 0, 1, QVector<QVariant>() << 1.0 );
+      graph.addArc( 2, 1, QVector<QVariant>() << 1.0 );
+      QgsCompactGraph cg( &graph );
+
+      QVector<int> path;
+      QCOMPARE( QgsGraphAnalyzer::aStar( &cg, 0, 1, 0, &path ), 1.0 );
+      QCOMPARE( path.count(), 2 );
+      QCOMPARE( QgsGraphAnalyzer::aStar( &cg, 0, 2, 0, &path ), std::numeric_limits<double>::infinity() );
+      QVERIFY( path.isEmpty() );
+    }
+
+    void testCostMatrix()
+    {
+      QgsGraph* graph = _gridGraph( 20 );
+      QgsCompactGraph cg( graph );
+      delete graph;
+
+      QVector<int> origins, destinations;
+      for ( int i = 0; i < 50; ++i )
+      {
+        origins << ( i * 37 ) % 400;
+        destinations << ( i * 53 + 11 ) % 400;
+      }
+      destinations << destinations.first(); // duplicate destination
+
+      QVector<double> matrix = QgsGraphAnalyzer::costMatrix( &cg, origins, destinations, 0 );
+      QCOMPARE( matrix.size(), origins.size() * destinations.size() );
+
+      QVector<double> matrixLimited = QgsGraphAnalyzer::costMatrix( &cg, origins, destinations, 0, 10.0 );
+
+      for ( int i = 0; i < origins.size(); ++i )
+      {
+        QVector<double> cost;
+        QgsGraphAnalyzer::dijkstra( &cg, origins[i], 0, NULL, &cost );
+        for ( int j = 0; j < destinations.size(); ++j )
+        {
+          double expected = cost[ destinations[j] ];
+          QVERIFY( qgsDoubleNear( matrix[ i * destinations.size() + j ], expected, 1e-9 ) );
+          if ( expected <= 10.0 )
+            QVERIFY( qgsDoubleNear( matrixLimited[ i * destinations.size() + j ], expected, 1e-9 ) );
+          else
+            QCOMPARE( matrixLimited[ i * destinations.size() + j ], std::numeric_limits<double>::infinity() );
+        }
+      }
+
+      QVERIFY( QgsGraphAnalyzer::costMatrix( &cg, QVector<int>(), destinations, 0 ).isEmpty() );
+
+      // more entries than a QVector can hold, nothing is computed
+      QVector<int> manyOrigins( 20000, origins.first() );
+      QVector<int> manyDestinations( 20000, destinations.first() );
+      QVERIFY( QgsGraphAnalyzer::costMatrix( &cg, manyOrigins, manyDestinations, 0 ).isEmpty() );
+    }
+
+    void testServiceAreas()
+    {
+      QgsGraph* graph = _gridGraph( 20 );
+      QgsCompactGraph cg( graph );
+      delete graph;
+
+      QVector<int> origins;
+      origins << 0 << 210 << 399;
+
+      QVector< QVector<int> > vertices;
+      QVector< QVector<double> > costs;
+      QgsGraphAnalyzer::serviceAreas( &cg, origins, 0, 5.0, &vertices, &costs );
+      QCOMPARE( vertices.size(), 3 );
+      QCOMPARE( costs.size(), 3 );
+
+      for ( int i = 0; i < origins.size(); ++i )
+      {
+        QVector<double> cost;
+        QgsGraphAnalyzer::dijkstra( &cg, origins[i], 0, NULL, &cost );
+
+        int expectedCount = 0;
+        for ( int v = 0; v < cost.size(); ++v )
+        {
+          if ( cost[v] <= 5.0 )
+            ++expectedCount;
+        }
+
+        QCOMPARE( vertices[i].size(), expectedCount );
+        QCOMPARE( vertices[i].first(), origins[i] );
+        for ( int j = 0; j < vertices[i].size(); ++j )
+        {
+          QVERIFY( qgsDoubleNear( costs[i][j], cost[ vertices[i][j] ], 1e-9 ) );
+          // ordered by cost
+          if ( j > 0 )
+            QVERIFY( costs[i][j-1] <= costs[i][j] );
+        }
+      }
+    }
+};
+
+QTEST_MAIN( TestQgsGraphAnalyzer )
+
+#include "testqgsgraphanalyzer.moc"
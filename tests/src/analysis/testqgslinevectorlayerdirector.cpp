@@ -0,0 +1,104 @@
+/***************************************************************************
+     testqgslinevectorlayerdirector.cpp
+     --------------------------------------
+    Date                 : October 2015
+    Copyright            : (C) 2015 by QGIS Development Team
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include "qgsapplication.h"
+#include "qgsdistancearcproperter.h"
+#include "qgsgeometry.h"
+#include "qgsgraph.h"
+#include "qgsgraphbuilder.h"
+#include "qgslinevectorlayerdirector.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayer.h"
+
+/** \ingroup UnitTests
+ * This is a unit test for building of graphs from line layers
+ */
+class TestQgsLineVectorLayerDirector : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testMakeGraph();
+
+  private:
+    void addLine( QgsVectorLayer* layer, const QString& wkt );
+};
+
+void TestQgsLineVectorLayerDirector::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsLineVectorLayerDirector::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsLineVectorLayerDirector::addLine( QgsVectorLayer* layer, const QString& wkt )
+{
+  QgsFeature f;
+  f.setGeometry( QgsGeometry::fromWkt( wkt ) );
+  layer->dataProvider()->addFeatures( QgsFeatureList() << f );
+}
+
+void TestQgsLineVectorLayerDirector::testMakeGraph()
+{
+  QgsVectorLayer layer( "LineString", "lines", "memory" );
+  QVERIFY( layer.isValid() );
+  addLine( &layer, "LINESTRING(0 0, 10 0)" );
+  addLine( &layer, "LINESTRING(10 0, 10 10)" );
+  // starts within topology tolerance of (10 0)
+  addLine( &layer, "LINESTRING(9.9995 -0.0005, 20 -0.0005)" );
+
+  QgsLineVectorLayerDirector director( &layer, -1, "", "", "", 3 );
+  director.addProperter( new QgsDistanceArcProperter() );
+
+  QgsGraphBuilder builder( layer.crs(), false, 0.001 );
+
+  QVector<QgsPoint> additionalPoints;
+  additionalPoints << QgsPoint( 5, 1 ) << QgsPoint( 11, 5 ) << QgsPoint( 15, 1 );
+  QVector<QgsPoint> tiedPoints;
+  director.makeGraph( &builder, additionalPoints, tiedPoints );
+
+  QCOMPARE( tiedPoints.size(), 3 );
+  QCOMPARE( tiedPoints[0], QgsPoint( 5, 0 ) );
+  QCOMPARE( tiedPoints[1], QgsPoint( 10, 5 ) );
+  QCOMPARE( tiedPoints[2], QgsPoint( 15, -0.0005 ) );
+
+  QgsGraph* graph = builder.graph();
+
+  // 4 end points (two of them merged) + 3 tied points
+  QCOMPARE( graph->vertexCount(), 7 );
+  // every segment is split by a tied point, arcs in both directions
+  QCOMPARE( graph->arcCount(), 12 );
+
+  int crossing = graph->findVertex( QgsPoint( 10, 0 ) );
+  QVERIFY( crossing != -1 );
+  QCOMPARE( graph->vertex( crossing ).outArc().size(), 3 );
+
+  Q_FOREACH ( const QgsPoint& pt, tiedPoints )
+    QVERIFY( graph->findVertex( pt ) != -1 );
+
+  delete graph;
+}
+
+QTEST_MAIN( TestQgsLineVectorLayerDirector )
+#include "testqgslinevectorlayerdirector.moc"
@@ -21,6 +21,7 @@
 #include "qgscomposermap.h"
 #include "qgscomposermapoverview.h"
 #include "qgsatlascomposition.h"
+#include "qgsatlasparallelexport.h"
 #include "qgscomposerlabel.h"
 #include "qgsmaplayerregistry.h"
 #include "qgsmaprenderer.h"
@@ -82,6 +83,8 @@ class TestQgsAtlasComposition : public QObject
     void test_signals();
     // test removing coverage layer while atlas is enabled
     void test_remove_layer();
+    // test that the parallel export gives the same images as the sequential rendering
+    void parallel_export();
 
   private:
     QgsComposition* mComposition;
@@ -486,5 +489,53 @@ void TestQgsAtlasComposition::test_remove_layer()
   QVERIFY( spyToggled.count() == 1 );
 }
 
+void TestQgsAtlasComposition::parallel_export()
+{
+  mAtlasMap->setAtlasDriven( true );
+  mAtlasMap->setAtlasScalingMode( QgsComposerMap::Auto );
+  mAtlasMap->setAtlasMargin( 0.10 );
+  mAtlas->setFilenamePattern( "'parallel_' || @atlas_featurenumber" );
+
+  // maps are rendered to images, vector PDF output is not possible
+  mComposition->setPrintAsRaster( false );
+  QVERIFY( !QgsAtlasParallelExport::canExport( mComposition, QgsAtlasParallelExport::PdfFiles ) );
+  QVERIFY( QgsAtlasParallelExport::canExport( mComposition, QgsAtlasParallelExport::ImageFiles ) );
+
+  QString dir = QDir::tempPath() + "/qgis_atlas_parallel_export";
+  QDir().mkpath( dir );
+
+  // 127 dpi = 5 pixels per mm, the maps are placed at whole pixels
+  QgsAtlasParallelExport exporter( mComposition );
+  exporter.setThreadCount( 2 );
+  QSignalSpy spyProgress( &exporter, SIGNAL( progressChanged( int ) ) );
+  QVERIFY( exporter.exportImageFiles( dir, "png", 127 ) );
+
+  mAtlas->beginRender();
+  QCOMPARE( spyProgress.count(), mAtlas->numFeatures() );
+  for ( int fit = 0; fit < mAtlas->numFeatures(); ++fit )
+  {
+    mAtlas->prepareForFeature( fit );
+    QImage expected = mComposition->printPageAsRaster( 0, QSize(), 127 );
+    QImage exported( dir + QString( "/parallel_%1.png" ).arg( fit + 1 ) );
+    QCOMPARE( exported.size(), expected.size() );
+
+    // the maps are composed from separate images, allow for rounding of the antialiased pixels
+    int mismatches = 0;
+    for ( int y = 0; y < expected.height(); ++y )
+    {
+      for ( int x = 0; x < expected.width(); ++x )
+      {
+        QRgb e = expected.pixel( x, y );
+        QRgb p = exported.pixel( x, y );
+        if ( qAbs( qRed( e ) - qRed( p ) ) > 1 || qAbs( qGreen( e ) - qGreen( p ) ) > 1 ||
+             qAbs( qBlue( e ) - qBlue( p ) ) > 1 || qAbs( qAlpha( e ) - qAlpha( p ) ) > 1 )
+          ++mismatches;
+      }
+    }
+    QCOMPARE( mismatches, 0 );
+  }
+  mAtlas->endRender();
+}
+
 QTEST_MAIN( TestQgsAtlasComposition )
 #include "testqgsatlascomposition.moc"
@@ -20,9 +20,11 @@
 #include "qgscompositionchecker.h"
 #include "qgscomposermap.h"
 #include "qgscomposermapgrid.h"
+#include "qgscoordinatetransform.h"
 #include "qgsmaplayerregistry.h"
 #include "qgsmaprenderer.h"
 #include "qgsfontutils.h"
+#include "qgssymbolv2.h"
 #include <QObject>
 #include <QtTest/QtTest>
 
@@ -40,8 +42,11 @@ class TestQgsComposerMapGrid : public QObject
     void cleanup();// will be called after every testfunction.
     void grid(); //test if grid and grid annotation works
     void reprojected(); //test if reprojected grid works
+    void reprojectedMapCrsChanged(); //test if reprojected grid is updated when map crs changes
     void crossGrid(); //test if grid "cross" mode works
     void markerGrid(); //test if grid "marker" mode works
+    void reprojectedCrossGrid(); //test if reprojected grid "cross" mode works
+    void reprojectedMarkerGrid(); //test if reprojected grid "marker" mode works
     void frameOnly(); //test if grid "frame/annotation" mode works
     void zebraStyle(); //test zebra map border style
     void zebraStyleSides(); //test zebra border on certain sides
@@ -59,6 +64,12 @@ class TestQgsComposerMapGrid : public QObject
     void descendingAnnotations(); //test descending annotation direction
 
   private:
+    //! Sets up a reprojected grid with the given style and renders the page
+    QImage renderReprojectedGrid( QgsComposerMapGrid::GridStyle style );
+    //! Positions of the intersections of the 1 degree geographic grid on the page image, computed point by point,
+    //! within the map or less than margin mm beyond it
+    QList<QPointF> reprojectedIntersections( const QImage& page, double margin );
+
     QgsComposition* mComposition;
     QgsComposerMap* mComposerMap;
     QgsMapSettings *mMapSettings;
@@ -173,6 +184,37 @@ void TestQgsComposerMapGrid::reprojected()
   QVERIFY( testResult );
 }
 
+void TestQgsComposerMapGrid::reprojectedMapCrsChanged()
+{
+  // draw the grid in another map crs first, with the same extent and grid settings
+  mMapSettings->setDestinationCrs( QgsCoordinateReferenceSystem( 3857 ) );
+  mComposerMap->setNewExtent( QgsRectangle( -243577.565, 2939084.773, 1215622.435, 3668684.773 ) );
+  QgsCoordinateReferenceSystem geographic = QgsCoordinateReferenceSystem( 4326 );
+  mComposerMap->grid()->setCrs( geographic );
+  mComposerMap->grid()->setEnabled( true );
+  mComposerMap->grid()->setIntervalX( 1 );
+  mComposerMap->grid()->setIntervalY( 1 );
+  mComposerMap->grid()->setAnnotationEnabled( false );
+  mComposerMap->grid()->setBlendMode( QPainter::CompositionMode_SourceOver );
+  mComposerMap->grid()->setFrameStyle( QgsComposerMapGrid::ExteriorTicks );
+  mComposerMap->grid()->setFrameWidth( 10 );
+  mComposerMap->setFrameEnabled( false );
+  mComposerMap->updateBoundingRect();
+  mComposition->printPageAsRaster( 0 );
+
+  // grid lines reprojected for the previous map crs must not be reused
+  mMapSettings->setDestinationCrs( QgsCoordinateReferenceSystem( 32633 ) );
+  QgsCompositionChecker checker( "composermap_gridreprojected", mComposition );
+  checker.setControlPathPrefix( "composer_mapgrid" );
+
+  bool testResult = checker.testComposition( mReport, 0, 0 );
+  mComposerMap->grid()->setEnabled( false );
+  mComposerMap->grid()->setCrs( mMapSettings->destinationCrs() );
+  mComposerMap->grid()->setFrameStyle( QgsComposerMapGrid::NoFrame );
+  mComposerMap->setFrameEnabled( true );
+  QVERIFY( testResult );
+}
+
 void TestQgsComposerMapGrid::crossGrid()
 {
   mComposerMap->setNewExtent( QgsRectangle( 781662.375, 3339523.125, 793062.375, 3345223.125 ) );
@@ -211,6 +253,145 @@ void TestQgsComposerMapGrid::markerGrid()
   QVERIFY( testResult );
 }
 
+QImage TestQgsComposerMapGrid::renderReprojectedGrid( QgsComposerMapGrid::GridStyle style )
+{
+  mComposerMap->setNewExtent( QgsRectangle( -243577.565, 2939084.773, 1215622.435, 3668684.773 ) );
+  mComposerMap->grid()->setCrs( QgsCoordinateReferenceSystem( 4326 ) );
+  mComposerMap->grid()->setEnabled( true );
+  mComposerMap->grid()->setStyle( style );
+  mComposerMap->grid()->setIntervalX( 1 );
+  mComposerMap->grid()->setIntervalY( 1 );
+  mComposerMap->grid()->setAnnotationEnabled( false );
+  mComposerMap->grid()->setBlendMode( QPainter::CompositionMode_SourceOver );
+  mComposerMap->setFrameEnabled( false );
+  mComposerMap->updateBoundingRect();
+  QImage page = mComposition->printPageAsRaster( 0 );
+
+  mComposerMap->grid()->setStyle( QgsComposerMapGrid::Solid );
+  mComposerMap->grid()->setEnabled( false );
+  mComposerMap->grid()->setCrs( mMapSettings->destinationCrs() );
+  mComposerMap->setFrameEnabled( true );
+  return page;
+}
+
+QList<QPointF> TestQgsComposerMapGrid::reprojectedIntersections( const QImage& page, double margin )
+{
+  QgsCoordinateTransform transform( QgsCoordinateReferenceSystem( 4326 ), mMapSettings->destinationCrs() );
+  QgsRectangle extent = *mComposerMap->currentMapExtent();
+  QRectF mapRect( mComposerMap->pos(), mComposerMap->rect().size() );
+  double pixelsPerMM = page.width() / mComposition->paperWidth();
+  double mapMargin = margin * extent.width() / mapRect.width();
+  QgsRectangle searchExtent = extent.buffer( mapMargin );
+
+  QList<QPointF> intersections;
+  for ( int lon = 0; lon <= 40; ++lon )
+  {
+    for ( int lat = 10; lat <= 50; ++lat )
+    {
+      QgsPoint point = transform.transform( QgsPoint( lon, lat ) );
+      if ( !searchExtent.contains( point ) )
+        continue;
+      double x = mapRect.left() + ( point.x() - extent.xMinimum() ) / extent.width() * mapRect.width();
+      double y = mapRect.top() + ( extent.yMaximum() - point.y() ) / extent.height() * mapRect.height();
+      intersections << QPointF( x, y ) * pixelsPerMM;
+    }
+  }
+  return intersections;
+}
+
+void TestQgsComposerMapGrid::reprojectedCrossGrid()
+{
+  mComposerMap->grid()->setCrossLength( 2.0 );
+  QImage page = renderReprojectedGrid( QgsComposerMapGrid::Cross );
+  QList<QPointF> intersections = reprojectedIntersections( page, 0 );
+  QVERIFY( intersections.size() > 50 );
+  double pixelsPerMM = page.width() / mComposition->paperWidth();
+
+  // a cross is drawn at each intersection
+  Q_FOREACH ( const QPointF& intersection, intersections )
+  {
+    bool crossFound = false;
+    for ( int dx = -2; dx <= 2 && !crossFound; ++dx )
+    {
+      for ( int dy = -2; dy <= 2 && !crossFound; ++dy )
+      {
+        QPoint pixel = intersection.toPoint() + QPoint( dx, dy );
+        crossFound = page.rect().contains( pixel ) && qRed( page.pixel( pixel ) ) < 60;
+      }
+    }
+    QVERIFY2( crossFound, QString( "no cross at %1,%2" ).arg( intersection.x() ).arg( intersection.y() ).toLocal8Bit().constData() );
+  }
+
+  // and nowhere else
+  intersections = reprojectedIntersections( page, 3 );
+  double reach = ( 2.0 + 0.5 ) * pixelsPerMM + 2;
+  for ( int y = 0; y < page.height(); ++y )
+  {
+    for ( int x = 0; x < page.width(); ++x )
+    {
+      if ( qRed( page.pixel( x, y ) ) >= 60 )
+        continue;
+      bool nearIntersection = false;
+      Q_FOREACH ( const QPointF& intersection, intersections )
+      {
+        if ( qAbs( intersection.x() - x ) <= reach && qAbs( intersection.y() - y ) <= reach )
+        {
+          nearIntersection = true;
+          break;
+        }
+      }
+      QVERIFY2( nearIntersection, QString( "cross pixel at %1,%2" ).arg( x ).arg( y ).toLocal8Bit().constData() );
+    }
+  }
+}
+
+void TestQgsComposerMapGrid::reprojectedMarkerGrid()
+{
+  // half transparent markers, an intersection found twice would be drawn darker
+  QgsStringMap props;
+  props.insert( "name", "square" );
+  props.insert( "color", "0,0,255,128" );
+  props.insert( "outline_style", "no" );
+  props.insert( "size", "3" );
+  mComposerMap->grid()->setMarkerSymbol( QgsMarkerSymbolV2::createSimple( props ) );
+  QImage page = renderReprojectedGrid( QgsComposerMapGrid::Markers );
+  QList<QPointF> intersections = reprojectedIntersections( page, 0 );
+  QVERIFY( intersections.size() > 50 );
+  double pixelsPerMM = page.width() / mComposition->paperWidth();
+
+  // a single marker over the map background of 150,100,100
+  Q_FOREACH ( const QPointF& intersection, intersections )
+  {
+    QRgb color = page.pixel( intersection.toPoint() );
+    QVERIFY2( qAbs( qRed( color ) - 75 ) <= 6 && qAbs( qGreen( color ) - 50 ) <= 6 && qAbs( qBlue( color ) - 178 ) <= 6,
+              QString( "marker at %1,%2 has color %3,%4,%5" ).arg( intersection.x() ).arg( intersection.y() )
+              .arg( qRed( color ) ).arg( qGreen( color ) ).arg( qBlue( color ) ).toLocal8Bit().constData() );
+  }
+
+  // and no markers elsewhere
+  intersections = reprojectedIntersections( page, 3 );
+  double reach = 1.5 * pixelsPerMM + 2;
+  for ( int y = 0; y < page.height(); ++y )
+  {
+    for ( int x = 0; x < page.width(); ++x )
+    {
+      QRgb color = page.pixel( x, y );
+      if ( qBlue( color ) - qRed( color ) <= 20 )
+        continue;
+      bool nearIntersection = false;
+      Q_FOREACH ( const QPointF& intersection, intersections )
+      {
+        if ( qAbs( intersection.x() - x ) <= reach && qAbs( intersection.y() - y ) <= reach )
+        {
+          nearIntersection = true;
+          break;
+        }
+      }
+      QVERIFY2( nearIntersection, QString( "marker pixel at %1,%2" ).arg( x ).arg( y ).toLocal8Bit().constData() );
+    }
+  }
+}
+
 void TestQgsComposerMapGrid::frameOnly()
 {
   mComposerMap->setNewExtent( QgsRectangle( 781662.375, 3339523.125, 793062.375, 3345223.125 ) );
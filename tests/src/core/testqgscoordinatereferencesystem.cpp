@@ -20,6 +20,7 @@ Email                : sherman at mrcc dot com
 
 //header for class being tested
 #include <qgscoordinatereferencesystem.h>
+#include <qgscrscatalog.h>
 #include <qgis.h>
 #include <qgsvectorlayer.h>
 
@@ -44,6 +45,7 @@ class TestQgsCoordinateReferenceSystem: public QObject
     void createFromESRIWkt();
     void createFromSrsId();
     void createFromProj4();
+    void crsCatalog();
     void isValid();
     void validate();
     void equality();
@@ -284,6 +286,32 @@ void TestQgsCoordinateReferenceSystem::createFromProj4()
   QVERIFY( myCrs.createFromProj4( GEOPROJ4 ) );
   debugPrint( myCrs );
 }
+void TestQgsCoordinateReferenceSystem::crsCatalog()
+{
+  QgsCRSCatalog::Record record;
+  QVERIFY( QgsCRSCatalog::instance()->recordByAuthId( "epsg:4326", record ) );
+  QCOMPARE( record.srsId, GEOCRS_ID );
+  QCOMPARE( record.srid, GEOSRID );
+  QVERIFY( record.isGeo );
+
+  QVERIFY( QgsCRSCatalog::instance()->recordBySrid( GEOSRID, record ) );
+  QCOMPARE( record.srsId, GEOCRS_ID );
+  QVERIFY( QgsCRSCatalog::instance()->recordBySrsId( GEOCRS_ID, record ) );
+  QCOMPARE( record.authId, GEO_EPSG_CRS_AUTHID );
+  QVERIFY( !QgsCRSCatalog::instance()->recordBySrsId( -1, record ) );
+
+  //same parameters in a different order
+  bool found = false;
+  Q_FOREACH ( const QgsCRSCatalog::Record& r, QgsCRSCatalog::instance()->recordsByProj4Parameters( "+no_defs +datum=WGS84 +proj=longlat" ) )
+  {
+    found = found || r.srsId == GEOCRS_ID;
+  }
+  QVERIFY( found );
+
+  QgsCoordinateReferenceSystem myCrs;
+  QVERIFY( myCrs.createFromProj4( "+no_defs +datum=WGS84 +proj=longlat" ) );
+  QVERIFY( myCrs.geographicFlag() );
+}
 void TestQgsCoordinateReferenceSystem::isValid()
 {
   QgsCoordinateReferenceSystem myCrs;
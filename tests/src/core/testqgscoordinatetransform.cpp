@@ -17,6 +17,7 @@
 #include "qgscoordinatetransform.h"
 #include "qgsapplication.h"
 #include <QObject>
+#include <QPolygonF>
 #include <QtTest/QtTest>
 
 class TestQgsCoordinateTransform: public QObject
@@ -27,6 +28,7 @@ class TestQgsCoordinateTransform: public QObject
     void initTestCase();
     void cleanupTestCase();
     void transformBoundingBox();
+    void transformPolygon();
 
   private:
 
@@ -73,5 +75,41 @@ void TestQgsCoordinateTransform::transformBoundingBox()
   QVERIFY( qgsDoubleNear( resultRect.yMaximum(), expectedRect.yMaximum(), 0.001 ) );
 }
 
+void TestQgsCoordinateTransform::transformPolygon()
+{
+  //polygon points are transformed in place, the result must match point by point transformation
+  QgsCoordinateReferenceSystem sourceSrs;
+  sourceSrs.createFromSrid( 4326 );
+  QgsCoordinateReferenceSystem destSrs;
+  destSrs.createFromSrid( 3857 );
+  QgsCoordinateTransform tr( sourceSrs, destSrs );
+
+  QPolygonF poly;
+  poly << QPointF( 16.5, 48.1 ) << QPointF( -3.7, 40.4 ) << QPointF( 151.2, -33.9 ) << QPointF( 0, 0 );
+  QPolygonF transformed = poly;
+  tr.transformPolygon( transformed );
+
+  QCOMPARE( transformed.size(), poly.size() );
+  for ( int i = 0; i < poly.size(); ++i )
+  {
+    QgsPoint expected = tr.transform( poly.at( i ).x(), poly.at( i ).y() );
+    QVERIFY( qgsDoubleNear( transformed.at( i ).x(), expected.x(), 0.001 ) );
+    QVERIFY( qgsDoubleNear( transformed.at( i ).y(), expected.y(), 0.001 ) );
+  }
+
+  //and back
+  tr.transformPolygon( transformed, QgsCoordinateTransform::ReverseTransform );
+  for ( int i = 0; i < poly.size(); ++i )
+  {
+    QVERIFY( qgsDoubleNear( transformed.at( i ).x(), poly.at( i ).x(), 0.000001 ) );
+    QVERIFY( qgsDoubleNear( transformed.at( i ).y(), poly.at( i ).y(), 0.000001 ) );
+  }
+
+  //empty polygon
+  QPolygonF empty;
+  tr.transformPolygon( empty );
+  QVERIFY( empty.isEmpty() );
+}
+
 QTEST_MAIN( TestQgsCoordinateTransform )
 #include "testqgscoordinatetransform.moc"
@@ -0,0 +1,108 @@
+/***************************************************************************
+     testqgsgml.cpp
+     --------------------------------------
+    Date                 : October 2015
+    Copyright            : (C) 2015 by QGIS Development Team
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include "qgsgeometry.h"
+#include "qgsgml.h"
+
+static QByteArray _gmlDocument( int firstId, int count )
+{
+  QByteArray data = "<wfs:FeatureCollection xmlns:wfs=\"http://www.opengis.net/wfs\" "
+                    "xmlns:gml=\"http://www.opengis.net/gml\" xmlns:myns=\"http://myns\">";
+  for ( int i = firstId; i < firstId + count; ++i )
+  {
+    data += QString( "<gml:featureMember><myns:mytypename fid=\"mytypename.%1\">"
+                     "<myns:intfield>%1</myns:intfield>"
+                     "<myns:geometryProperty><gml:Point><gml:coordinates>%1,2</gml:coordinates></gml:Point></myns:geometryProperty>"
+                     "</myns:mytypename></gml:featureMember>" ).arg( i ).toUtf8();
+  }
+  data += "</wfs:FeatureCollection>";
+  return data;
+}
+
+/** \ingroup UnitTests
+ * This is a unit test for the GML parser
+ */
+class TestQgsGml : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void testProcessDataInChunks();
+    void testProcessDataMultipleDocuments();
+};
+
+void TestQgsGml::testProcessDataInChunks()
+{
+  QgsFields fields;
+  fields.append( QgsField( "intfield", QVariant::Int, "int" ) );
+  QgsGml gml( "mytypename", "geometryProperty", fields );
+
+  QByteArray data = _gmlDocument( 0, 10 );
+  QGis::WkbType wkbType = QGis::WKBUnknown;
+  QList<QgsFeature*> features;
+
+  // features are available as soon as they are complete
+  int chunkSize = 100;
+  for ( int pos = 0; pos < data.size(); pos += chunkSize )
+  {
+    bool atEnd = pos + chunkSize >= data.size();
+    QVERIFY( gml.processData( data.mid( pos, chunkSize ), atEnd, &wkbType ) );
+    QList<QgsFeature*> parsed = gml.takeFeatures();
+    if ( !atEnd )
+      QVERIFY( parsed.size() <= 1 );
+    features << parsed;
+  }
+
+  QCOMPARE( wkbType, QGis::WKBPoint );
+  QCOMPARE( features.size(), 10 );
+  for ( int i = 0; i < features.size(); ++i )
+  {
+    QCOMPARE( features[i]->id(), ( QgsFeatureId ) i );
+    QCOMPARE( features[i]->attribute( 0 ).toInt(), i );
+    QCOMPARE( features[i]->constGeometry()->asPoint(), QgsPoint( i, 2 ) );
+  }
+  qDeleteAll( features );
+
+  QVERIFY( gml.takeFeatures().isEmpty() );
+}
+
+void TestQgsGml::testProcessDataMultipleDocuments()
+{
+  QgsFields fields;
+  fields.append( QgsField( "intfield", QVariant::Int, "int" ) );
+  QgsGml gml( "mytypename", "geometryProperty", fields );
+  QGis::WkbType wkbType = QGis::WKBUnknown;
+
+  // pages of a WFS response
+  QVERIFY( gml.processData( _gmlDocument( 0, 3 ), true, &wkbType ) );
+  QMap<QgsFeatureId, QString> ids;
+  QList<QgsFeature*> features = gml.takeFeatures( &ids );
+  QCOMPARE( features.size(), 3 );
+  QCOMPARE( ids.value( 2 ), QString( "mytypename.2" ) );
+  qDeleteAll( features );
+
+  QVERIFY( gml.processData( _gmlDocument( 3, 2 ), true, &wkbType ) );
+  features = gml.takeFeatures( &ids );
+  QCOMPARE( features.size(), 2 );
+  // feature ids continue
+  QCOMPARE( features[0]->id(), ( QgsFeatureId ) 3 );
+  QCOMPARE( ids.value( 4 ), QString( "mytypename.4" ) );
+  qDeleteAll( features );
+}
+
+QTEST_MAIN( TestQgsGml )
+#include "testqgsgml.moc"
@@ -41,6 +41,7 @@ class TestQgsLabelingEngineV2 : public QObject
     void testBasic();
     void testDiagrams();
     void testRuleBased();
+    void testPreviousSolution();
 
   private:
     QgsVectorLayer* vl;
@@ -269,6 +270,85 @@ void TestQgsLabelingEngineV2::testRuleBased()
 
 }
 
+void TestQgsLabelingEngineV2::testPreviousSolution()
+{
+  QSize size( 640, 480 );
+  QgsMapSettings mapSettings;
+  mapSettings.setOutputSize( size );
+  mapSettings.setExtent( vl->extent() );
+  mapSettings.setLayers( QStringList() << vl->id() );
+  mapSettings.setOutputDpi( 96 );
+
+  vl->setCustomProperty( "labeling", "pal" );
+  vl->setCustomProperty( "labeling/enabled", true );
+  vl->setCustomProperty( "labeling/fieldName", "Class" );
+  setDefaultLabelParams( vl );
+
+  QImage img( size, QImage::Format_ARGB32_Premultiplied );
+  img.fill( Qt::white );
+  QPainter p( &img );
+  QgsRenderContext context = QgsRenderContext::fromMapSettings( mapSettings );
+  context.setPainter( &p );
+
+  QgsLabelingEngineV2 engine;
+  engine.setMapSettings( mapSettings );
+  engine.addProvider( new QgsVectorLayerLabelProvider( vl ) );
+  engine.run( context );
+
+  QgsLabelingSolution solution = engine.solution();
+  QVERIFY( !solution.isEmpty() );
+  QVERIFY( solution.isCompatible( mapSettings ) );
+
+  // pan the map by a few pixels - the solution can be reused
+  QgsMapSettings pannedSettings( mapSettings );
+  QgsRectangle pannedExtent = mapSettings.visibleExtent();
+  double dx = mapSettings.mapUnitsPerPixel() * 5;
+  pannedExtent.set( pannedExtent.xMinimum() + dx, pannedExtent.yMinimum(), pannedExtent.xMaximum() + dx, pannedExtent.yMaximum() );
+  pannedSettings.setExtent( pannedExtent );
+  QVERIFY( solution.isCompatible( pannedSettings ) );
+
+  QgsRenderContext pannedContext = QgsRenderContext::fromMapSettings( pannedSettings );
+  pannedContext.setPainter( &p );
+
+  QgsLabelingEngineV2 engine2;
+  engine2.setMapSettings( pannedSettings );
+  engine2.setPreviousSolution( solution );
+  engine2.addProvider( new QgsVectorLayerLabelProvider( vl ) );
+  engine2.run( pannedContext );
+
+  p.end();
+
+  // labels that are still fully visible keep their positions
+  QgsLabelingSolution solution2 = engine2.solution();
+  QVERIFY( !solution2.isEmpty() );
+  QgsLabelingSolution::ProviderKey key( vl->id(), 0 );
+  QgsRectangle retainExtent = solution.extent().intersect( &pannedExtent );
+  int retained = 0;
+  QgsFeature f;
+  QgsFeatureIterator fit = vl->getFeatures();
+  while ( fit.nextFeature( f ) )
+  {
+    QgsLabelingSolution::Label label1, label2;
+    if ( !solution.label( key, f.id(), label1 ) || !retainExtent.contains( label1.boundingBox ) )
+      continue;
+
+    QVERIFY( solution2.label( key, f.id(), label2 ) );
+    QCOMPARE( label2.position.x(), label1.position.x() );
+    QCOMPARE( label2.position.y(), label1.position.y() );
+    ++retained;
+  }
+  QVERIFY( retained > 0 );
+
+  // zooming makes the solution unusable
+  QgsMapSettings zoomedSettings( mapSettings );
+  QgsRectangle zoomedExtent = mapSettings.visibleExtent();
+  zoomedExtent.scale( 0.5 );
+  zoomedSettings.setExtent( zoomedExtent );
+  QVERIFY( !solution.isCompatible( zoomedSettings ) );
+
+  vl->setCustomProperty( "labeling/enabled", false );
+}
+
 bool TestQgsLabelingEngineV2::imageCheck( const QString& testName, QImage &image, int mismatchCount )
 {
   //draw background
@@ -37,6 +37,12 @@
 #include <qgsapplication.h>
 #include <qgsproviderregistry.h>
 #include <qgsmaplayerregistry.h>
+#include <qgsmaprenderercache.h>
+#include <qgsmaprendererparalleljob.h>
+#include <qgsmaprenderersequentialjob.h>
+#include <qgssinglesymbolrendererv2.h>
+#include <qgssymbolv2.h>
+#include <qgsvectordataprovider.h>
 
 //qgs unit test utility class
 #include "qgsrenderchecker.h"
@@ -72,7 +78,14 @@ class TestQgsMapRenderer : public QObject
     /** This method tests render perfomance */
     void performanceTest();
 
+    void testCachePanned();
+    void testCachePannedLargeSymbols();
+    void testCachePannedDiagonal();
+
   private:
+    QgsVectorLayer* markerLayer( double markerSize );
+    QImage renderPanned( const QgsMapSettings& settings, const QgsRectangle& pannedExtent, QgsMapRendererCache& cache, bool parallel );
+
     QString mEncoding;
     QgsVectorFileWriter::WriterError mError;
     QgsCoordinateReferenceSystem mCRS;
@@ -211,6 +224,151 @@ void TestQgsMapRenderer::performanceTest()
   QVERIFY( myResultFlag );
 }
 
+QgsVectorLayer* TestQgsMapRenderer::markerLayer( double markerSize )
+{
+  // a grid of points every 30 map units
+  QgsVectorLayer* layer = new QgsVectorLayer( "Point", "points", "memory" );
+  QgsFeatureList features;
+  for ( int i = 0; i < 20; ++i )
+  {
+    for ( int j = 0; j < 20; ++j )
+    {
+      QgsFeature f;
+      f.setGeometry( QgsGeometry::fromPoint( QgsPoint( -100 + i * 30 + 7, -100 + j * 30 + 11 ) ) );
+      features << f;
+    }
+  }
+  layer->dataProvider()->addFeatures( features );
+  QgsMarkerSymbolV2* marker = new QgsMarkerSymbolV2();
+  marker->setSize( markerSize );
+  layer->setRendererV2( new QgsSingleSymbolRendererV2( marker ) );
+  return layer;
+}
+
+QImage TestQgsMapRenderer::renderPanned( const QgsMapSettings& settings, const QgsRectangle& pannedExtent, QgsMapRendererCache& cache, bool parallel )
+{
+  QgsMapSettings pannedSettings( settings );
+  pannedSettings.setExtent( pannedExtent );
+
+  QgsMapRendererQImageJob* job;
+  if ( parallel )
+    job = new QgsMapRendererParallelJob( pannedSettings );
+  else
+    job = new QgsMapRendererSequentialJob( pannedSettings );
+  job->setCache( &cache );
+  job->start();
+  job->waitForFinished();
+  QImage image = job->renderedImage();
+  delete job;
+  return image;
+}
+
+void TestQgsMapRenderer::testCachePanned()
+{
+  QgsVectorLayer* layer = new QgsVectorLayer( QString( TEST_DATA_DIR ) + "/lines.shp", "lines", "ogr" );
+  QVERIFY( layer->isValid() );
+  QgsMapLayerRegistry::instance()->addMapLayers( QList<QgsMapLayer *>() << layer );
+
+  QgsMapSettings settings;
+  settings.setLayers( QStringList() << layer->id() );
+  settings.setOutputSize( QSize( 400, 300 ) );
+  settings.setExtent( layer->extent() );
+
+  QgsMapRendererCache cache;
+  QgsMapRendererSequentialJob job( settings );
+  job.setCache( &cache );
+  job.start();
+  job.waitForFinished();
+
+  // pan by 100 pixels to the right
+  QgsRectangle extent = settings.visibleExtent();
+  double shift = settings.mapUnitsPerPixel() * 100;
+  QgsRectangle pannedExtent( extent.xMinimum() + shift, extent.yMinimum(), extent.xMaximum() + shift, extent.yMaximum() );
+  QImage panned = renderPanned( settings, pannedExtent, cache, false );
+
+  // the image rendered for the new extent replaces the previous one
+  QgsRectangle previousExtent;
+  QVERIFY( cache.previousCacheImage( layer->id(), previousExtent ).isNull() );
+  QVERIFY( !cache.cacheImage( layer->id() ).isNull() );
+
+  settings.setExtent( pannedExtent );
+  QgsMapRendererSequentialJob uncachedJob( settings );
+  uncachedJob.start();
+  uncachedJob.waitForFinished();
+  QCOMPARE( panned, uncachedJob.renderedImage() );
+
+  QgsMapLayerRegistry::instance()->removeMapLayers( QStringList() << layer->id() );
+}
+
+void TestQgsMapRenderer::testCachePannedLargeSymbols()
+{
+  // points just outside of the strip exposed by the pan have markers reaching into it
+  QgsVectorLayer* layer = markerLayer( 20 );
+  QgsMapLayerRegistry::instance()->addMapLayers( QList<QgsMapLayer *>() << layer );
+
+  // one map unit per pixel
+  QgsMapSettings settings;
+  settings.setLayers( QStringList() << layer->id() );
+  settings.setExtent( QgsRectangle( 0, 0, 400, 400 ) );
+  settings.setOutputSize( QSize( 400, 400 ) );
+
+  QgsMapSettings pannedSettings( settings );
+  pannedSettings.setExtent( QgsRectangle( -95, 0, 305, 400 ) );
+  QgsMapRendererSequentialJob uncachedJob( pannedSettings );
+  uncachedJob.start();
+  uncachedJob.waitForFinished();
+
+  QgsMapRendererCache cache;
+  QgsMapRendererSequentialJob job( settings );
+  job.setCache( &cache );
+  job.start();
+  job.waitForFinished();
+
+  // pan to the left, the strip of the first 95 pixels is exposed
+  QCOMPARE( renderPanned( settings, pannedSettings.extent(), cache, false ), uncachedJob.renderedImage() );
+
+  QgsMapLayerRegistry::instance()->removeMapLayers( QStringList() << layer->id() );
+}
+
+void TestQgsMapRenderer::testCachePannedDiagonal()
+{
+  // panning in both directions exposes a strip along the top and one along the side
+  QgsVectorLayer* layer = markerLayer( 12 );
+  QgsMapLayerRegistry::instance()->addMapLayers( QList<QgsMapLayer *>() << layer );
+
+  QgsMapSettings settings;
+  settings.setLayers( QStringList() << layer->id() );
+  settings.setExtent( QgsRectangle( 0, 0, 400, 300 ) );
+  settings.setOutputSize( QSize( 400, 300 ) );
+
+  QList<QgsRectangle> pannedExtents;
+  pannedExtents << QgsRectangle( -70, 45, 330, 345 )   // up and to the left
+  << QgsRectangle( 85, -60, 485, 240 );                 // down and to the right
+
+  Q_FOREACH ( const QgsRectangle& pannedExtent, pannedExtents )
+  {
+    QgsMapSettings pannedSettings( settings );
+    pannedSettings.setExtent( pannedExtent );
+    QgsMapRendererSequentialJob uncachedJob( pannedSettings );
+    uncachedJob.start();
+    uncachedJob.waitForFinished();
+    QImage expected = uncachedJob.renderedImage();
+
+    for ( int parallel = 0; parallel < 2; ++parallel )
+    {
+      QgsMapRendererCache cache;
+      QgsMapRendererSequentialJob job( settings );
+      job.setCache( &cache );
+      job.start();
+      job.waitForFinished();
+
+      QCOMPARE( renderPanned( settings, pannedExtent, cache, parallel ), expected );
+    }
+  }
+
+  QgsMapLayerRegistry::instance()->removeMapLayers( QStringList() << layer->id() );
+}
+
 QTEST_MAIN( TestQgsMapRenderer )
 #include "testqgsmaprenderer.moc"
 
@@ -15,6 +15,7 @@
 #include <QtTest/QtTest>
 #include <QObject>
 #include <QString>
+#include <QPolygonF>
 //header for class being tested
 #include <qgsrectangle.h>
 #include <qgsmaptopixel.h>
@@ -27,6 +28,7 @@ class TestQgsMapToPixel: public QObject
   private slots:
     void legacy();
     void rotation();
+    void transformPoints();
 };
 
 void TestQgsMapToPixel::legacy()
@@ -108,6 +110,26 @@ void TestQgsMapToPixel::rotation()
 
 }
 
+void TestQgsMapToPixel::transformPoints()
+{
+  QgsMapToPixel m2p( 0.5, 5, 5, 10, 10, 30 );
+
+  QPolygonF points;
+  points << QPointF( 0, 0 ) << QPointF( 5, 5 ) << QPointF( -3.5, 12.25 ) << QPointF( 100, -40 );
+  QPolygonF transformed = points;
+  m2p.transformInPlace( transformed.data(), transformed.size() );
+
+  // same result as transforming the points one by one
+  for ( int i = 0; i < points.size(); ++i )
+  {
+    double x = points.at( i ).x();
+    double y = points.at( i ).y();
+    m2p.transformInPlace( x, y );
+    QVERIFY( qgsDoubleNear( transformed.at( i ).x(), x, 0.0000001 ) );
+    QVERIFY( qgsDoubleNear( transformed.at( i ).y(), y, 0.0000001 ) );
+  }
+}
+
 QTEST_MAIN( TestQgsMapToPixel )
 #include "testqgsmaptopixel.moc"
 
@@ -256,6 +256,39 @@ class TestQgsPointLocator : public QObject
       QVERIFY( m2.isValid() );
       QCOMPARE( m2.point(), QgsPoint( 1, 1 ) );
     }
+
+    void testAsyncIndex()
+    {
+      QgsPointLocator loc( mVL );
+      QSignalSpy spy( &loc, SIGNAL( initFinished( bool ) ) );
+      loc.initAsync();
+
+      QTime t; t.start();
+      while ( spy.isEmpty() && t.elapsed() < 10000 )
+        QCoreApplication::processEvents( QEventLoop::AllEvents, 100 );
+
+      QCOMPARE( spy.count(), 1 );
+      QCOMPARE( spy.at( 0 ).at( 0 ).toBool(), true );
+      QVERIFY( loc.hasIndex() );
+      QVERIFY( !loc.isIndexing() );
+
+      QgsPointLocator::Match m = loc.nearestVertex( QgsPoint( 2, 2 ), 999 );
+      QVERIFY( m.isValid() );
+      QCOMPARE( m.point(), QgsPoint( 1, 1 ) );
+
+      // init() waits for the index being built
+      QgsPointLocator loc2( mVL );
+      loc2.initAsync();
+      QVERIFY( loc2.init() );
+      QVERIFY( loc2.hasIndex() );
+      QVERIFY( loc2.nearestVertex( QgsPoint( 2, 2 ), 999 ).isValid() );
+
+      // cancelled build does not leave an index
+      QgsPointLocator loc3( mVL );
+      loc3.initAsync();
+      loc3.cancelIndexing();
+      QVERIFY( !loc3.isIndexing() );
+    }
 };
 
 QTEST_MAIN( TestQgsPointLocator )
@@ -14,9 +14,14 @@
  ***************************************************************************/
 #include <QtTest/QtTest>
 #include <QObject>
+#include <QDomDocument>
 
 #include <qgsapplication.h>
+#include <qgsmaplayerregistry.h>
 #include <qgsproject.h>
+#include <qgsrasterlayer.h>
+#include <qgsvectordataprovider.h>
+#include <qgsvectorlayer.h>
 
 
 class TestQgsProject : public QObject
@@ -29,6 +34,8 @@ class TestQgsProject : public QObject
     void cleanup();// will be called after every testfunction.
 
     void testReadPath();
+    void testParallelLayerLoading();
+    void testParallelLayerLoadingManyLayers();
 };
 
 void TestQgsProject::init()
@@ -43,12 +50,20 @@ void TestQgsProject::cleanup()
 void TestQgsProject::initTestCase()
 {
   // Runs once before any tests are run
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  // Set up the QSettings environment
+  QCoreApplication::setOrganizationName( "QGIS" );
+  QCoreApplication::setOrganizationDomain( "qgis.org" );
+  QCoreApplication::setApplicationName( "QGIS-TEST" );
 }
 
 
 void TestQgsProject::cleanupTestCase()
 {
   // Runs once after all tests are run
+  QgsApplication::exitQgis();
 }
 
 void TestQgsProject::testReadPath()
@@ -76,6 +91,130 @@ void TestQgsProject::testReadPath()
 
 }
 
+void TestQgsProject::testParallelLayerLoading()
+{
+  QString dataDir( TEST_DATA_DIR );
+  QgsVectorLayer* points = new QgsVectorLayer( dataDir + "/points.shp", "points", "ogr" );
+  QgsVectorLayer* lines = new QgsVectorLayer( dataDir + "/lines.shp", "lines", "ogr" );
+  QVERIFY( points->isValid() );
+  QVERIFY( lines->isValid() );
+  QString pointsId = points->id();
+  QString linesId = lines->id();
+  QgsMapLayerRegistry::instance()->addMapLayers( QList<QgsMapLayer*>() << points << lines );
+
+  QTemporaryFile projectFile( QDir::tempPath() + "/qgis_parallel_loading_XXXXXX.qgs" );
+  QVERIFY( projectFile.open() );
+  projectFile.close();
+
+  QgsProject* prj = QgsProject::instance();
+  prj->setFileName( projectFile.fileName() );
+  QVERIFY( prj->write() );
+  QgsMapLayerRegistry::instance()->removeAllMapLayers();
+
+  // a layer of a network provider is read in the main thread: loading it in a worker
+  // would dead lock waiting for the network access manager of the blocked main thread
+  QFile file( projectFile.fileName() );
+  QDomDocument doc;
+  QVERIFY( file.open( QIODevice::ReadOnly ) );
+  QVERIFY( doc.setContent( &file ) );
+  file.close();
+  QDomElement layerElem = doc.documentElement().firstChildElement( "projectlayers" ).firstChildElement( "maplayer" );
+  QVERIFY( !layerElem.isNull() );
+  QDomElement wmsElem = layerElem.cloneNode().toElement();
+  wmsElem.setAttribute( "type", "raster" );
+  wmsElem.firstChildElement( "id" ).firstChild().setNodeValue( "unreachable_wms" );
+  wmsElem.firstChildElement( "provider" ).firstChild().setNodeValue( "wms" );
+  // nothing listens on this port
+  wmsElem.firstChildElement( "datasource" ).firstChild().setNodeValue( "crs=EPSG:4326&format=image/png&layers=test&styles=&url=http://127.0.0.1:1/wms" );
+  layerElem.parentNode().appendChild( wmsElem );
+  QVERIFY( file.open( QIODevice::WriteOnly | QIODevice::Truncate ) );
+  QTextStream stream( &file );
+  doc.save( stream, 2 );
+  file.close();
+
+  QSettings settings;
+  settings.setValue( "/qgis/parallel_layer_loading", true );
+  QVERIFY( prj->read( QFileInfo( projectFile.fileName() ) ) );
+  settings.remove( "/qgis/parallel_layer_loading" );
+
+  QCOMPARE( QgsMapLayerRegistry::instance()->count(), 2 );
+  Q_FOREACH ( const QString& id, QStringList() << pointsId << linesId )
+  {
+    QgsVectorLayer* layer = qobject_cast<QgsVectorLayer*>( QgsMapLayerRegistry::instance()->mapLayer( id ) );
+    QVERIFY( layer );
+    QVERIFY( layer->isValid() );
+    // layers loaded in workers are handed over to the main thread
+    QCOMPARE( layer->thread(), QThread::currentThread() );
+    QCOMPARE( layer->dataProvider()->thread(), QThread::currentThread() );
+    QVERIFY( prj->layerLoadTimes().contains( id ) );
+  }
+  QCOMPARE( QgsMapLayerRegistry::instance()->mapLayer( pointsId )->name(), QString( "points" ) );
+  // the unreachable server makes the wms layer invalid, but it does not block loading
+  QVERIFY( !QgsMapLayerRegistry::instance()->mapLayer( "unreachable_wms" ) );
+
+  QgsMapLayerRegistry::instance()->removeAllMapLayers();
+}
+
+void TestQgsProject::testParallelLayerLoadingManyLayers()
+{
+  // vector and raster layers in different CRS, so that the workers look up the
+  // CRS while the main thread checks the CRS of the next layers
+  QString dataDir( TEST_DATA_DIR );
+  QList<long> epsgIds = QList<long>() << 4326 << 3857 << 32633 << 27700 << 2056 << 3035 << 31467 << 25832;
+  QMap<QString, QString> vectorCrs;
+  QStringList rasterIds;
+  QList<QgsMapLayer*> layers;
+  for ( int i = 0; i < 24; i++ )
+  {
+    QgsVectorLayer* layer = new QgsVectorLayer( dataDir + ( i % 2 ? "/lines.shp" : "/points.shp" ), QString( "vector %1" ).arg( i ), "ogr" );
+    QVERIFY( layer->isValid() );
+    layer->setCrs( QgsCoordinateReferenceSystem( QString( "EPSG:%1" ).arg( epsgIds.at( i % epsgIds.size() ) ) ) );
+    vectorCrs.insert( layer->id(), layer->crs().authid() );
+    layers << layer;
+  }
+  for ( int i = 0; i < 6; i++ )
+  {
+    QgsRasterLayer* layer = new QgsRasterLayer( dataDir + ( i % 2 ? "/landsat_4326.tif" : "/landsat.tif" ), QString( "raster %1" ).arg( i ), "gdal" );
+    QVERIFY( layer->isValid() );
+    rasterIds << layer->id();
+    layers << layer;
+  }
+  QgsMapLayerRegistry::instance()->addMapLayers( layers );
+
+  QTemporaryFile projectFile( QDir::tempPath() + "/qgis_parallel_loading_XXXXXX.qgs" );
+  QVERIFY( projectFile.open() );
+  projectFile.close();
+
+  QgsProject* prj = QgsProject::instance();
+  prj->setFileName( projectFile.fileName() );
+  QVERIFY( prj->write() );
+  QgsMapLayerRegistry::instance()->removeAllMapLayers();
+
+  QSettings settings;
+  settings.setValue( "/qgis/parallel_layer_loading", true );
+  QVERIFY( prj->read( QFileInfo( projectFile.fileName() ) ) );
+  settings.remove( "/qgis/parallel_layer_loading" );
+
+  QCOMPARE( QgsMapLayerRegistry::instance()->count(), 30 );
+  for ( QMap<QString, QString>::const_iterator it = vectorCrs.constBegin(); it != vectorCrs.constEnd(); ++it )
+  {
+    QgsVectorLayer* layer = qobject_cast<QgsVectorLayer*>( QgsMapLayerRegistry::instance()->mapLayer( it.key() ) );
+    QVERIFY( layer );
+    QVERIFY( layer->isValid() );
+    QCOMPARE( layer->crs().authid(), it.value() );
+    QCOMPARE( layer->thread(), QThread::currentThread() );
+  }
+  Q_FOREACH ( const QString& id, rasterIds )
+  {
+    QgsRasterLayer* layer = qobject_cast<QgsRasterLayer*>( QgsMapLayerRegistry::instance()->mapLayer( id ) );
+    QVERIFY( layer );
+    QVERIFY( layer->isValid() );
+    QCOMPARE( layer->dataProvider()->thread(), QThread::currentThread() );
+  }
+
+  QgsMapLayerRegistry::instance()->removeAllMapLayers();
+}
+
 
 QTEST_MAIN( TestQgsProject )
 #include "testqgsproject.moc"
@@ -31,6 +31,10 @@
 #include <qgsmaplayerregistry.h>
 #include <qgssymbolv2.h>
 #include <qgssinglesymbolrendererv2.h>
+#include <qgsgeneralizedgeometrycache.h>
+#include <qgsmaprendererparalleljob.h>
+#include <qgsmaprenderersequentialjob.h>
+#include <qgsmapsettings.h>
 //qgis test includes
 #include "qgsrenderchecker.h"
 
@@ -104,6 +108,9 @@ class TestQgsVectorLayer : public QObject
     void uniqueValues();
     void minimumValue();
     void maximumValue();
+    void generalizedGeometryCache();
+    void generalizedGeometryCacheNullGeometry();
+    void generalizedGeometryCacheRendering();
 };
 
 void TestQgsVectorLayer::initTestCase()
@@ -341,5 +348,146 @@ void TestQgsVectorLayer::maximumValue()
   QCOMPARE( vLayer->maximumValue( 1000 ), QVariant() );
 }
 
+void TestQgsVectorLayer::generalizedGeometryCache()
+{
+  QgsGeneralizedGeometryCache* cache = mpPolysLayer->generalizedGeometryCache();
+  QVERIFY( cache );
+
+  // wait for the build in background
+  QTime time;
+  time.start();
+  QSharedPointer<const QgsGeneralizedGeometryCache::Level> coarse;
+  while ( !coarse && time.elapsed() < 10000 )
+  {
+    QTest::qWait( 50 );
+    coarse = cache->level( 1e20 );
+  }
+  QVERIFY( coarse );
+  QCOMPARE( coarse->geometries.count(), ( int ) mpPolysLayer->featureCount() );
+
+  // finer levels for smaller tolerances, none below the finest level
+  QSharedPointer<const QgsGeneralizedGeometryCache::Level> fine = cache->level( coarse->tolerance / 2 );
+  QVERIFY( fine );
+  QCOMPARE( fine->tolerance, coarse->tolerance / 2 );
+  QVERIFY( !cache->level( coarse->tolerance / ( 1 << QgsGeneralizedGeometryCache::LevelCount ) ) );
+
+  cache->invalidate();
+  QVERIFY( cache->needsBuild() );
+  QVERIFY( !cache->level( 1e20 ) );
+}
+
+void TestQgsVectorLayer::generalizedGeometryCacheNullGeometry()
+{
+  QgsVectorLayer* layer = new QgsVectorLayer( "Polygon?crs=epsg:4326", "polys", "memory" );
+  QgsFeature withGeometry;
+  withGeometry.setGeometry( QgsGeometry::fromWkt( "POLYGON((0 0, 10 0, 10 10, 0 10, 0 0))" ) );
+  QgsFeature withoutGeometry;
+  QgsFeatureList features;
+  features << withGeometry << withoutGeometry;
+  QVERIFY( layer->dataProvider()->addFeatures( features ) );
+  layer->updateExtents();
+  QgsVectorSimplifyMethod simplifyMethod = layer->simplifyMethod();
+  simplifyMethod.setSimplifyHints( QgsVectorSimplifyMethod::GeometrySimplification );
+  simplifyMethod.setCacheGeneralizedGeometries( true );
+  layer->setSimplifyMethod( simplifyMethod );
+  QgsMapLayerRegistry::instance()->addMapLayers( QList<QgsMapLayer*>() << layer );
+
+  QgsGeneralizedGeometryCache* cache = layer->generalizedGeometryCache();
+  QTime time;
+  time.start();
+  QSharedPointer<const QgsGeneralizedGeometryCache::Level> coarse;
+  while ( !coarse && time.elapsed() < 10000 )
+  {
+    QTest::qWait( 50 );
+    coarse = cache->level( 1e20 );
+  }
+  QVERIFY( coarse );
+  QCOMPARE( coarse->geometries.count(), 1 );
+  QCOMPARE( coarse->nullGeometries->count(), 1 );
+
+  // the feature without geometry must not make the cache look outdated
+  QgsMapSettings ms;
+  ms.setLayers( QStringList() << layer->id() );
+  ms.setExtent( QgsRectangle( -5, -5, 15, 15 ) );
+  ms.setOutputSize( QSize( 100, 100 ) );
+  ms.setFlag( QgsMapSettings::UseRenderingOptimization );
+  for ( int i = 0; i < 2; ++i )
+  {
+    QgsMapRendererSequentialJob job( ms );
+    job.start();
+    job.waitForFinished();
+    QVERIFY( !cache->needsBuild() );
+    QVERIFY( cache->level( 1e20 ) );
+  }
+
+  QgsMapLayerRegistry::instance()->removeMapLayers( QStringList() << layer->id() );
+}
+
+void TestQgsVectorLayer::generalizedGeometryCacheRendering()
+{
+  QgsVectorLayer* layer = new QgsVectorLayer( mTestDataDir + "polys.shp", "polys", "ogr" );
+  QVERIFY( layer->isValid() );
+  QgsVectorSimplifyMethod simplifyMethod = layer->simplifyMethod();
+  simplifyMethod.setSimplifyHints( QgsVectorSimplifyMethod::GeometrySimplification );
+  simplifyMethod.setCacheGeneralizedGeometries( false );
+  layer->setSimplifyMethod( simplifyMethod );
+  QgsMapLayerRegistry::instance()->addMapLayers( QList<QgsMapLayer*>() << layer );
+
+  QgsMapSettings ms;
+  ms.setLayers( QStringList() << layer->id() );
+  ms.setExtent( layer->extent() );
+  ms.setOutputSize( QSize( 400, 400 ) );
+  ms.setFlag( QgsMapSettings::UseRenderingOptimization );
+  ms.setFlag( QgsMapSettings::Antialiasing );
+
+  QgsMapRendererSequentialJob uncachedJob( ms );
+  uncachedJob.start();
+  uncachedJob.waitForFinished();
+  QImage uncached = uncachedJob.renderedImage();
+
+  simplifyMethod.setCacheGeneralizedGeometries( true );
+  layer->setSimplifyMethod( simplifyMethod );
+  QgsGeneralizedGeometryCache* cache = layer->generalizedGeometryCache();
+  QTime time;
+  time.start();
+  while ( !cache->level( 1e20 ) && time.elapsed() < 10000 )
+    QTest::qWait( 50 );
+  QVERIFY( cache->level( 1e20 ) );
+
+  // several jobs render from the same level at the same time
+  QList<QgsMapRendererParallelJob*> jobs;
+  for ( int i = 0; i < 4; ++i )
+  {
+    jobs << new QgsMapRendererParallelJob( ms );
+    jobs.last()->start();
+  }
+  Q_FOREACH ( QgsMapRendererParallelJob* job, jobs )
+  {
+    job->waitForFinished();
+    QImage cached = job->renderedImage();
+    QCOMPARE( cached.size(), uncached.size() );
+
+    // the levels are simplified with tolerances not larger than the one of the map,
+    // the images may only differ by a few antialiased pixels
+    int differentPixels = 0;
+    for ( int y = 0; y < cached.height(); ++y )
+    {
+      for ( int x = 0; x < cached.width(); ++x )
+      {
+        QRgb a = cached.pixel( x, y );
+        QRgb b = uncached.pixel( x, y );
+        if ( qAbs( qRed( a ) - qRed( b ) ) > 16 || qAbs( qGreen( a ) - qGreen( b ) ) > 16 ||
+             qAbs( qBlue( a ) - qBlue( b ) ) > 16 || qAbs( qAlpha( a ) - qAlpha( b ) ) > 16 )
+          ++differentPixels;
+      }
+    }
+    QVERIFY2( differentPixels < cached.width() * cached.height() / 200, QString( "%1 pixels differ" ).arg( differentPixels ).toLocal8Bit().constData() );
+    delete job;
+  }
+  QVERIFY( !cache->needsBuild() );
+
+  QgsMapLayerRegistry::instance()->removeMapLayers( QStringList() << layer->id() );
+}
+
 QTEST_MAIN( TestQgsVectorLayer )
 #include "testqgsvectorlayer.moc"
@@ -0,0 +1,214 @@
+/***************************************************************************
+     testqgsfeaturepool.cpp
+     --------------------------------------
+    Date                 : October 2015
+    Copyright            : (C) 2015 by QGIS Development Team
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QObject>
+
+#include <qgsapplication.h>
+#include <qgsgeometry.h>
+#include <qgsvectordataprovider.h>
+#include <qgsvectorlayer.h>
+
+#include "qgsfeaturepool.h"
+
+/** \ingroup UnitTests
+ * Tests the feature pool of the geometry checker, whose pending changes are
+ * seen by the intersection queries before and after they are committed.
+ */
+class TestQgsFeaturePool : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void intersectsPendingChanges();
+    void intersectsAfterManyCommits();
+
+  private:
+    //! layer with a grid of size x size unit squares, two units apart
+    QgsVectorLayer* squaresLayer( int size );
+    //! ids of the features whose bounding box intersects rect, by checking them all
+    QgsFeatureIds bruteForceIntersects( const QHash<QgsFeatureId, QgsRectangle>& bboxes, const QgsRectangle& rect );
+    void checkIntersects( QgsFeaturePool& pool, const QHash<QgsFeatureId, QgsRectangle>& bboxes );
+};
+
+void TestQgsFeaturePool::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsFeaturePool::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+QgsVectorLayer* TestQgsFeaturePool::squaresLayer( int size )
+{
+  QgsVectorLayer* layer = new QgsVectorLayer( "Polygon", "squares", "memory" );
+  QgsFeatureList features;
+  for ( int i = 0; i < size; ++i )
+  {
+    for ( int j = 0; j < size; ++j )
+    {
+      QgsFeature f;
+      f.setGeometry( QgsGeometry::fromRect( QgsRectangle( i * 2, j * 2, i * 2 + 1, j * 2 + 1 ) ) );
+      features << f;
+    }
+  }
+  layer->dataProvider()->addFeatures( features );
+  return layer;
+}
+
+QgsFeatureIds TestQgsFeaturePool::bruteForceIntersects( const QHash<QgsFeatureId, QgsRectangle>& bboxes, const QgsRectangle& rect )
+{
+  QgsFeatureIds ids;
+  for ( QHash<QgsFeatureId, QgsRectangle>::const_iterator it = bboxes.constBegin(); it != bboxes.constEnd(); ++it )
+  {
+    if ( it.value().intersects( rect ) )
+      ids.insert( it.key() );
+  }
+  return ids;
+}
+
+void TestQgsFeaturePool::checkIntersects( QgsFeaturePool& pool, const QHash<QgsFeatureId, QgsRectangle>& bboxes )
+{
+  QList<QgsRectangle> rects;
+  rects << QgsRectangle( 0.5, 0.5, 0.6, 0.6 )
+  << QgsRectangle( 10.5, 10.5, 14.5, 12.5 )
+  << QgsRectangle( 40, 3, 60, 90 )
+  << QgsRectangle( -1000, -1000, 1000, 1000 );
+  Q_FOREACH ( const QgsRectangle& rect, rects )
+  {
+    QCOMPARE( pool.getIntersects( rect ), bruteForceIntersects( bboxes, rect ) );
+  }
+}
+
+void TestQgsFeaturePool::intersectsPendingChanges()
+{
+  QgsVectorLayer* layer = squaresLayer( 10 );
+  QgsFeaturePool pool( layer );
+
+  QHash<QgsFeatureId, QgsRectangle> bboxes;
+  QgsFeatureIterator it = layer->getFeatures();
+  QgsFeature feature;
+  while ( it.nextFeature( feature ) )
+    bboxes.insert( feature.id(), feature.constGeometry()->boundingBox() );
+  checkIntersects( pool, bboxes );
+
+  // move a square far away, to another one and delete one
+  QgsFeatureId movedId = bboxes.keys().at( 3 );
+  QVERIFY( pool.get( movedId, feature ) );
+  feature.setGeometry( QgsGeometry::fromRect( QgsRectangle( 500, 500, 501, 501 ) ) );
+  pool.updateFeature( feature );
+  bboxes[movedId] = QgsRectangle( 500, 500, 501, 501 );
+
+  QgsFeatureId overlappingId = bboxes.keys().at( 7 );
+  QVERIFY( pool.get( overlappingId, feature ) );
+  feature.setGeometry( QgsGeometry::fromRect( QgsRectangle( 10.5, 10.5, 11.5, 11.5 ) ) );
+  pool.updateFeature( feature );
+  bboxes[overlappingId] = QgsRectangle( 10.5, 10.5, 11.5, 11.5 );
+
+  QgsFeatureId deletedId = bboxes.keys().at( 11 );
+  QVERIFY( pool.get( deletedId, feature ) );
+  pool.deleteFeature( feature );
+  bboxes.remove( deletedId );
+
+  QgsFeature added;
+  added.setGeometry( QgsGeometry::fromRect( QgsRectangle( 12, 11, 13.5, 12 ) ) );
+  pool.addFeature( added );
+  bboxes.insert( added.id(), QgsRectangle( 12, 11, 13.5, 12 ) );
+
+  checkIntersects( pool, bboxes );
+  QCOMPARE( pool.getIntersects( QgsRectangle( 499, 499, 502, 502 ) ), QgsFeatureIds() << movedId );
+
+  // the changes are written to the layer, the queries are unchanged
+  QVERIFY( pool.commitChanges() );
+  checkIntersects( pool, bboxes );
+  QVERIFY( !layer->getFeatures( QgsFeatureRequest( deletedId ) ).nextFeature( feature ) );
+  QVERIFY( layer->getFeatures( QgsFeatureRequest( movedId ) ).nextFeature( feature ) );
+  QCOMPARE( feature.constGeometry()->boundingBox(), QgsRectangle( 500, 500, 501, 501 ) );
+
+  // moved once more after the commit
+  QVERIFY( pool.get( movedId, feature ) );
+  feature.setGeometry( QgsGeometry::fromRect( QgsRectangle( 0.2, 0.2, 0.8, 0.8 ) ) );
+  pool.updateFeature( feature );
+  bboxes[movedId] = QgsRectangle( 0.2, 0.2, 0.8, 0.8 );
+  checkIntersects( pool, bboxes );
+  QVERIFY( pool.getIntersects( QgsRectangle( 499, 499, 502, 502 ) ).isEmpty() );
+
+  pool.clearLayer();
+  delete layer;
+}
+
+void TestQgsFeaturePool::intersectsAfterManyCommits()
+{
+  // committed after each change like the fix dialog does, until the index snapshot is rebuilt
+  QgsVectorLayer* layer = squaresLayer( 60 );
+  QgsFeaturePool pool( layer );
+
+  QHash<QgsFeatureId, QgsRectangle> bboxes;
+  QgsFeatureIterator it = layer->getFeatures();
+  QgsFeature feature;
+  while ( it.nextFeature( feature ) )
+    bboxes.insert( feature.id(), feature.constGeometry()->boundingBox() );
+
+  QList<QgsFeatureId> ids = bboxes.keys();
+  qSort( ids );
+  for ( int i = 0; i < 5000; ++i )
+  {
+    QgsFeatureId id = ids.at(( i * 7919 ) % ids.size() );
+    if ( !bboxes.contains( id ) )
+      continue;
+    QVERIFY( pool.get( id, feature ) );
+    if ( i % 50 == 49 )
+    {
+      pool.deleteFeature( feature );
+      bboxes.remove( id );
+    }
+    else
+    {
+      QgsGeometry* geometry = new QgsGeometry( *feature.constGeometry() );
+      geometry->translate( 0.75, ( i % 3 ) - 1 );
+      feature.setGeometry( geometry );
+      pool.updateFeature( feature );
+      bboxes[id] = geometry->boundingBox();
+    }
+    QVERIFY( pool.commitChanges() );
+
+    if ( i % 500 == 0 )
+      checkIntersects( pool, bboxes );
+  }
+  checkIntersects( pool, bboxes );
+
+  // all changes have been written to the layer
+  QHash<QgsFeatureId, QgsRectangle> layerBBoxes;
+  it = layer->getFeatures();
+  while ( it.nextFeature( feature ) )
+    layerBBoxes.insert( feature.id(), feature.constGeometry()->boundingBox() );
+  QCOMPARE( layerBBoxes.size(), bboxes.size() );
+  for ( QHash<QgsFeatureId, QgsRectangle>::const_iterator bboxIt = bboxes.constBegin(); bboxIt != bboxes.constEnd(); ++bboxIt )
+  {
+    QVERIFY( layerBBoxes.value( bboxIt.key() ) == bboxIt.value() );
+  }
+
+  pool.clearLayer();
+  delete layer;
+}
+
+QTEST_MAIN( TestQgsFeaturePool )
+#include "testqgsfeaturepool.moc"
@@ -0,0 +1,212 @@
+/***************************************************************************
+     testqgsgeometrygapcheck.cpp
+     --------------------------------------
+    Date                 : October 2015
+    Copyright            : (C) 2015 by QGIS Development Team
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QObject>
+#include <QRect>
+
+#include <qgsapplication.h>
+#include <qgsgeometry.h>
+#include <qgsvectordataprovider.h>
+#include <qgsvectorlayer.h>
+
+#include "qgsfeaturepool.h"
+#include "qgsgeometrygapcheck.h"
+
+struct Gap
+{
+  QgsPointV2 center;
+  double area;
+  int neighbors;
+};
+
+static bool gapLessThan( const Gap& a, const Gap& b )
+{
+  if ( a.area != b.area )
+    return a.area < b.area;
+  return a.center.x() < b.center.x();
+}
+
+/** \ingroup UnitTests
+ * Tests the gap check of the geometry checker, which searches the gaps tile by tile
+ * and completes the gaps reaching the border of a tile afterwards.
+ */
+class TestQgsGeometryGapCheck : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void gapsOnTileBorders();
+    void gapsLargerThanHalo();
+    void gapsBeyondStitchLimit();
+
+  private:
+    //! layer with a grid of size x size touching unit squares, without the squares of the missing cells
+    QgsVectorLayer* gridLayer( int size, const QList<QRect>& missing );
+    //! runs the gap check on all features of the layer, the gaps are sorted by area and position
+    QList<Gap> collectGaps( QgsVectorLayer* layer, double threshold, QStringList& messages );
+    void compareGap( const Gap& gap, double x, double y, double area, int neighbors );
+};
+
+void TestQgsGeometryGapCheck::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsGeometryGapCheck::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+QgsVectorLayer* TestQgsGeometryGapCheck::gridLayer( int size, const QList<QRect>& missing )
+{
+  QgsVectorLayer* layer = new QgsVectorLayer( "Polygon", "grid", "memory" );
+  QgsFeatureList features;
+  for ( int i = 0; i < size; ++i )
+  {
+    for ( int j = 0; j < size; ++j )
+    {
+      bool isMissing = false;
+      Q_FOREACH ( const QRect& cells, missing )
+      {
+        isMissing = isMissing || cells.contains( i, j );
+      }
+      if ( isMissing )
+        continue;
+
+      QgsFeature f;
+      f.setGeometry( QgsGeometry::fromRect( QgsRectangle( i, j, i + 1, j + 1 ) ) );
+      features << f;
+    }
+  }
+  layer->dataProvider()->addFeatures( features );
+  return layer;
+}
+
+QList<Gap> TestQgsGeometryGapCheck::collectGaps( QgsVectorLayer* layer, double threshold, QStringList& messages )
+{
+  QgsFeaturePool pool( layer );
+  QgsGeometryGapCheck check( &pool, threshold );
+  QList<QgsGeometryCheckError*> errors;
+  messages.clear();
+  check.collectErrors( errors, messages );
+
+  QList<Gap> gaps;
+  Q_FOREACH ( QgsGeometryCheckError* error, errors )
+  {
+    Gap gap;
+    gap.center = error->location();
+    gap.area = error->value().toDouble();
+    gap.neighbors = static_cast<QgsGeometryGapCheckError*>( error )->neighbors().size();
+    gaps.append( gap );
+  }
+  qSort( gaps.begin(), gaps.end(), gapLessThan );
+
+  qDeleteAll( errors );
+  pool.clearLayer();
+  return gaps;
+}
+
+void TestQgsGeometryGapCheck::compareGap( const Gap& gap, double x, double y, double area, int neighbors )
+{
+  QVERIFY( qgsDoubleNear( gap.center.x(), x, 1E-6 ) );
+  QVERIFY( qgsDoubleNear( gap.center.y(), y, 1E-6 ) );
+  QVERIFY( qgsDoubleNear( gap.area, area, 1E-6 ) );
+  QCOMPARE( gap.neighbors, neighbors );
+}
+
+void TestQgsGeometryGapCheck::gapsOnTileBorders()
+{
+  // 2500 squares are checked in 2 x 2 tiles of 25 x 25 units
+  QList<QRect> missing;
+  missing << QRect( 10, 10, 1, 1 )  // within a tile
+  << QRect( 24, 10, 2, 1 )          // across the border of two tiles
+  << QRect( 24, 24, 2, 2 );         // on the corner of four tiles
+  QgsVectorLayer* layer = gridLayer( 50, missing );
+
+  // the halo of the tiles is sqrt(5), larger than the gaps
+  QStringList messages;
+  QList<Gap> gaps = collectGaps( layer, 5, messages );
+  QVERIFY( messages.isEmpty() );
+  QCOMPARE( gaps.size(), 3 );
+  compareGap( gaps.at( 0 ), 10.5, 10.5, 1, 4 );
+  compareGap( gaps.at( 1 ), 25, 10.5, 2, 6 );
+  compareGap( gaps.at( 2 ), 25, 25, 4, 8 );
+
+  // gaps above the threshold are not reported by any of the tiles
+  gaps = collectGaps( layer, 1.5, messages );
+  QCOMPARE( gaps.size(), 1 );
+  compareGap( gaps.at( 0 ), 10.5, 10.5, 1, 4 );
+
+  delete layer;
+}
+
+void TestQgsGeometryGapCheck::gapsLargerThanHalo()
+{
+  QList<QRect> missing;
+  missing << QRect( 10, 5, 1, 11 )   // within a tile, longer than the halo
+  << QRect( 20, 40, 11, 1 )          // across the tile border, beyond the halo of both tiles
+  << QRect( 5, 45, 13, 1 )           // above the threshold, within a tile
+  << QRect( 14, 30, 21, 1 );         // above the threshold, across the tile border
+  QgsVectorLayer* layer = gridLayer( 50, missing );
+
+  // the halo of the tiles is sqrt(12), the gaps across the tile border are completed from their pieces
+  QStringList messages;
+  QList<Gap> gaps = collectGaps( layer, 12, messages );
+  QVERIFY( messages.isEmpty() );
+  QCOMPARE( gaps.size(), 2 );
+  compareGap( gaps.at( 0 ), 10.5, 10.5, 11, 24 );
+  compareGap( gaps.at( 1 ), 25.5, 40.5, 11, 24 );
+
+  // all of them are gaps with a larger threshold, the halo stays limited by the tile size
+  gaps = collectGaps( layer, 1000, messages );
+  QVERIFY( messages.isEmpty() );
+  QCOMPARE( gaps.size(), 4 );
+  compareGap( gaps.at( 2 ), 11.5, 45.5, 13, 28 );
+  compareGap( gaps.at( 3 ), 24.5, 30.5, 21, 44 );
+
+  delete layer;
+}
+
+void TestQgsGeometryGapCheck::gapsBeyondStitchLimit()
+{
+  // 22500 squares are checked in 5 x 5 tiles of 30 x 30 units, a gap may be completed
+  // within a region of up to 16 tiles
+  QList<QRect> missing;
+  // frame with a bounding box of 130 x 130 units, larger than 16 tiles
+  missing << QRect( 10, 10, 130, 1 ) << QRect( 10, 139, 130, 1 )
+  << QRect( 10, 11, 1, 128 ) << QRect( 139, 11, 1, 128 );
+  // frame with a bounding box of 40 x 40 units inside of it
+  missing << QRect( 50, 50, 40, 1 ) << QRect( 50, 89, 40, 1 )
+  << QRect( 50, 51, 1, 38 ) << QRect( 89, 51, 1, 38 );
+  QgsVectorLayer* layer = gridLayer( 150, missing );
+
+  QStringList messages;
+  QList<Gap> gaps = collectGaps( layer, 600, messages );
+  // the small frame is completed and reported once, the large one is not reported
+  QCOMPARE( gaps.size(), 1 );
+  compareGap( gaps.at( 0 ), 70, 70, 4 * 40 - 4, 4 * 40 + 4 * 38 - 4 );
+  QVERIFY( !messages.isEmpty() );
+  QCOMPARE( messages.filter( "too many features" ).size(), messages.size() );
+
+  delete layer;
+}
+
+QTEST_MAIN( TestQgsGeometryGapCheck )
+#include "testqgsgeometrygapcheck.moc"
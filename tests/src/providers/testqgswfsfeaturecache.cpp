@@ -0,0 +1,294 @@
+/***************************************************************************
+     testqgswfsfeaturecache.cpp
+     --------------------------------------
+    Date                 : October 2015
+    Copyright            : (C) 2015 by QGIS Development Team
+    Email                : qgis-developer at lists dot osgeo dot org
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QtTest/QtTest>
+#include <QObject>
+#include <QString>
+#include <QDir>
+#include <QFile>
+#include <QSettings>
+
+//qgis includes...
+#include <qgis.h>
+#include <qgsapplication.h>
+#include <qgsfeature.h>
+#include <qgsfeatureiterator.h>
+#include <qgsgeometry.h>
+#include <qgsvectordataprovider.h>
+#include <qgsvectorlayer.h>
+#include <qgswfsfeaturecache.h>
+
+/** \ingroup UnitTests
+ * This is a unit test for the features of WFS layers cached on disk
+ */
+class TestQgsWFSFeatureCache : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+    void init();// will be called before each testfunction is executed.
+    void cleanup() {}// will be called after every testfunction.
+
+    void cacheHit(); //complete download is used and its features can be read
+    void cacheExpired(); //old, incomplete or differently described downloads are not up to date
+    void offlineProvider(); //provider uses the cache if the server is not available and is read-only
+    void manyFeatures(); //features written with the same statements in one download are all stored
+    void selectIds(); //features requested by ids are read from the cache
+
+  private:
+    /** Stores two points in a new cache file */
+    bool populate( const QString& fileName, const QByteArray& fingerprint );
+
+    QgsFields mFields;
+    QString mCacheDir;
+};
+
+void TestQgsWFSFeatureCache::initTestCase()
+{
+  QCoreApplication::setOrganizationName( "QGIS" );
+  QCoreApplication::setOrganizationDomain( "qgis.org" );
+  QCoreApplication::setApplicationName( "QGIS-TEST" );
+
+  // init QGIS's paths - true means that all path will be inited from prefix
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  mFields.append( QgsField( "name", QVariant::String, "string" ) );
+  mFields.append( QgsField( "value", QVariant::Int, "int" ) );
+
+  mCacheDir = QDir::tempPath() + "/qgis_wfsfeaturecache_test";
+  QSettings settings;
+  settings.setValue( "cache/directory", mCacheDir );
+  settings.setValue( "/qgis/wfsDiskCache", true );
+}
+
+void TestQgsWFSFeatureCache::cleanupTestCase()
+{
+  QSettings settings;
+  settings.remove( "cache/directory" );
+  settings.remove( "/qgis/wfsDiskCache" );
+  QgsApplication::exitQgis();
+}
+
+void TestQgsWFSFeatureCache::init()
+{
+  QDir dir( mCacheDir + "/wfs" );
+  Q_FOREACH ( const QString& file, dir.entryList( QDir::Files ) )
+  {
+    dir.remove( file );
+  }
+}
+
+bool TestQgsWFSFeatureCache::populate( const QString& fileName, const QByteArray& fingerprint )
+{
+  QgsWFSFeatureCache cache( fileName, true );
+  if ( !cache.isValid() || !cache.beginPopulate() )
+    return false;
+
+  QgsFeature f1( mFields, 1 );
+  f1.setAttribute( 0, "first" );
+  f1.setAttribute( 1, 10 );
+  f1.setGeometry( QgsGeometry::fromPoint( QgsPoint( 1, 1 ) ) );
+  QgsFeature f2( mFields, 2 );
+  f2.setAttribute( 0, "second" );
+  f2.setAttribute( 1, 20 );
+  f2.setGeometry( QgsGeometry::fromPoint( QgsPoint( 5, 5 ) ) );
+  if ( !cache.addFeature( f1, "points.1" ) || !cache.addFeature( f2, "points.2" ) )
+    return false;
+
+  return cache.finishPopulate( mFields, "geom", QGis::WKBPoint, QgsRectangle( 1, 1, 5, 5 ), fingerprint );
+}
+
+void TestQgsWFSFeatureCache::cacheHit()
+{
+  QString fileName = mCacheDir + "/wfs/hit.sqlite";
+  QVERIFY( populate( fileName, "fingerprint" ) );
+
+  QgsWFSFeatureCache cache( fileName, false );
+  QVERIFY( cache.isValid() );
+  QVERIFY( cache.isUpToDate( 3600, "fingerprint" ) );
+
+  QgsFields fields;
+  QString geometryAttribute;
+  QGis::WkbType wkbType;
+  QgsRectangle extent;
+  QVERIFY( cache.readSchema( fields, geometryAttribute, wkbType, extent ) );
+  QCOMPARE( fields.count(), 2 );
+  QCOMPARE( fields.at( 1 ).name(), QString( "value" ) );
+  QCOMPARE( geometryAttribute, QString( "geom" ) );
+  QCOMPARE( wkbType, QGis::WKBPoint );
+  QCOMPARE( extent, QgsRectangle( 1, 1, 5, 5 ) );
+
+  QMap<QgsFeatureId, QString> ids;
+  QVERIFY( cache.readIds( ids ) );
+  QCOMPARE( ids.size(), 2 );
+  QCOMPARE( ids.value( 2 ), QString( "points.2" ) );
+
+  //spatial selection uses the index
+  QgsFeature f;
+  QVERIFY( cache.select( QgsRectangle( 4, 4, 6, 6 ), true ) );
+  QVERIFY( cache.nextFeature( f, fields ) );
+  QCOMPARE( f.id(), QgsFeatureId( 2 ) );
+  QCOMPARE( f.attribute( "name" ).toString(), QString( "second" ) );
+  QCOMPARE( f.constGeometry()->asPoint(), QgsPoint( 5, 5 ) );
+  QVERIFY( !cache.nextFeature( f, fields ) );
+
+  QVERIFY( cache.feature( 1, f, fields ) );
+  QCOMPARE( f.attribute( "value" ).toInt(), 10 );
+}
+
+void TestQgsWFSFeatureCache::cacheExpired()
+{
+  QString fileName = mCacheDir + "/wfs/expired.sqlite";
+  QVERIFY( populate( fileName, "fingerprint" ) );
+
+  QgsWFSFeatureCache cache( fileName, true );
+  QVERIFY( cache.isUpToDate( 3600, "fingerprint" ) );
+  //older than the time to live
+  QVERIFY( !cache.isUpToDate( -1, "fingerprint" ) );
+  //layer capabilities or schema changed on the server
+  QVERIFY( !cache.isUpToDate( 3600, "changed" ) );
+
+  //an interrupted download is never up to date, the previous data stay unchanged
+  QVERIFY( cache.beginPopulate() );
+  cache.abortPopulate();
+  QVERIFY( cache.isUpToDate( 3600, "fingerprint" ) );
+
+  QString emptyFileName = mCacheDir + "/wfs/incomplete.sqlite";
+  QgsWFSFeatureCache incomplete( emptyFileName, true );
+  QVERIFY( incomplete.isValid() );
+  QVERIFY( !incomplete.isUpToDate( 3600, QByteArray() ) );
+}
+
+void TestQgsWFSFeatureCache::offlineProvider()
+{
+  //nothing listens on this port, all requests of the provider fail
+  QString uri = "http://127.0.0.1:1/wfs?SERVICE=WFS&VERSION=1.0.0&REQUEST=GetFeature&TYPENAME=test:points&SRSNAME=EPSG:4326";
+  QVERIFY( populate( QgsWFSFeatureCache::fileNameForUri( uri ), "outdated fingerprint" ) );
+
+  QgsVectorLayer layer( uri, "points", "WFS" );
+  QVERIFY( layer.isValid() );
+  QCOMPARE( layer.dataProvider()->featureCount(), 2L );
+  QCOMPARE( layer.dataProvider()->fields().count(), 2 );
+  QCOMPARE( layer.dataProvider()->capabilities() & QgsVectorDataProvider::EditingCapabilities, 0 );
+  QVERIFY( !layer.startEditing() );
+
+  QgsFeatureIterator it = layer.getFeatures( QgsFeatureRequest().setFilterRect( QgsRectangle( 0, 0, 2, 2 ) ) );
+  QgsFeature f;
+  QVERIFY( it.nextFeature( f ) );
+  QCOMPARE( f.attribute( "name" ).toString(), QString( "first" ) );
+  QVERIFY( !it.nextFeature( f ) );
+
+  it = layer.getFeatures( QgsFeatureRequest().setFilterFids( QgsFeatureIds() << 2 << 7 ) );
+  QVERIFY( it.nextFeature( f ) );
+  QCOMPARE( f.attribute( "name" ).toString(), QString( "second" ) );
+  QVERIFY( !it.nextFeature( f ) );
+}
+
+void TestQgsWFSFeatureCache::manyFeatures()
+{
+  QString fileName = mCacheDir + "/wfs/many.sqlite";
+  QgsWFSFeatureCache cache( fileName, true );
+  QVERIFY( cache.isValid() );
+
+  //an aborted download leaves nothing behind, the next one starts over
+  QVERIFY( cache.beginPopulate() );
+  QgsFeature aborted( mFields, 1 );
+  aborted.setAttribute( 0, "aborted" );
+  QVERIFY( cache.addFeature( aborted, "points.aborted" ) );
+  cache.abortPopulate();
+
+  QVERIFY( cache.beginPopulate() );
+  for ( int i = 1; i <= 10000; ++i )
+  {
+    QgsFeature f( mFields, i );
+    f.setAttribute( 0, QString( "feature %1" ).arg( i ) );
+    f.setAttribute( 1, i );
+    //every tenth feature has no geometry
+    if ( i % 10 != 0 )
+      f.setGeometry( QgsGeometry::fromPoint( QgsPoint( i % 100, i / 100 ) ) );
+    QVERIFY( cache.addFeature( f, QString( "points.%1" ).arg( i ) ) );
+  }
+  //replaced feature loses its geometry and leaves the index
+  QgsFeature replaced( mFields, 1 );
+  replaced.setAttribute( 0, "replaced" );
+  QVERIFY( cache.addFeature( replaced, "points.1" ) );
+  QVERIFY( cache.deleteFeature( 2 ) );
+  QVERIFY( cache.finishPopulate( mFields, "geom", QGis::WKBPoint, QgsRectangle( 0, 0, 99, 100 ), "fingerprint" ) );
+
+  QMap<QgsFeatureId, QString> ids;
+  QVERIFY( cache.readIds( ids ) );
+  QCOMPARE( ids.size(), 9999 );
+  QCOMPARE( ids.value( 5000 ), QString( "points.5000" ) );
+
+  int count = 0;
+  QgsFeature f;
+  QVERIFY( cache.select( QgsRectangle( 0, 0, 9.5, 0.5 ), true ) );
+  while ( cache.nextFeature( f, mFields ) )
+  {
+    QVERIFY( f.id() >= 3 && f.id() <= 9 );
+    QCOMPARE( f.attribute( "value" ).toInt(), int( f.id() ) );
+    ++count;
+  }
+  QCOMPARE( count, 7 );
+
+  QVERIFY( cache.feature( 1, f, mFields ) );
+  QCOMPARE( f.attribute( "name" ).toString(), QString( "replaced" ) );
+  QVERIFY( !f.constGeometry() );
+  QVERIFY( !cache.feature( 2, f, mFields ) );
+
+  //features are written again after the download
+  QgsFeature edited( mFields, 5000 );
+  edited.setAttribute( 0, "edited" );
+  edited.setGeometry( QgsGeometry::fromPoint( QgsPoint( 500, 500 ) ) );
+  QVERIFY( cache.addFeature( edited, "points.5000" ) );
+  QVERIFY( cache.select( QgsRectangle( 499, 499, 501, 501 ), false ) );
+  QVERIFY( cache.nextFeature( f, mFields ) );
+  QCOMPARE( f.attribute( "name" ).toString(), QString( "edited" ) );
+  QVERIFY( !cache.nextFeature( f, mFields ) );
+}
+
+void TestQgsWFSFeatureCache::selectIds()
+{
+  QString fileName = mCacheDir + "/wfs/ids.sqlite";
+  QVERIFY( populate( fileName, "fingerprint" ) );
+
+  QgsWFSFeatureCache cache( fileName, false );
+  QgsFeature f;
+  QVERIFY( cache.select( QgsFeatureIds() << 2 << 3, true ) );
+  QVERIFY( cache.nextFeature( f, mFields ) );
+  QCOMPARE( f.id(), QgsFeatureId( 2 ) );
+  QCOMPARE( f.constGeometry()->asPoint(), QgsPoint( 5, 5 ) );
+  QVERIFY( !cache.nextFeature( f, mFields ) );
+
+  QgsFeatureIds requested;
+  for ( int i = 0; i < 5000; ++i )
+    requested << i;
+  QVERIFY( cache.select( requested, false ) );
+  QgsFeatureIds found;
+  while ( cache.nextFeature( f, mFields ) )
+  {
+    QVERIFY( !f.constGeometry() );
+    found << f.id();
+  }
+  QCOMPARE( found, QgsFeatureIds() << 1 << 2 );
+
+  QVERIFY( cache.select( QgsFeatureIds(), true ) );
+  QVERIFY( !cache.nextFeature( f, mFields ) );
+}
+
+QTEST_MAIN( TestQgsWFSFeatureCache )
+#include "testqgswfsfeaturecache.moc"
@@ -194,6 +194,69 @@ class ProviderTestCase(object):
         features = [f['pk'] for f in it]
         assert 1 in features or 5 in features, 'Expected either 1 or 5 for expression and feature limit, Got {} instead'.format(features)
 
+    def runOrderByTests(self):
+        request = QgsFeatureRequest().addOrderBy('cnt')
+        values = [f['pk'] for f in self.provider.getFeatures(request)]
+        self.assertEquals(values, [5, 1, 2, 3, 4])
+
+        request = QgsFeatureRequest().addOrderBy('cnt', False)
+        values = [f['pk'] for f in self.provider.getFeatures(request)]
+        self.assertEquals(values, [4, 3, 2, 1, 5])
+
+        # nulls come last when ascending and first when descending by default
+        request = QgsFeatureRequest().addOrderBy('name')
+        values = [f['pk'] for f in self.provider.getFeatures(request)]
+        self.assertEquals(values, [2, 4, 1, 3, 5])
+
+        request = QgsFeatureRequest().addOrderBy('name', True, True)
+        values = [f['pk'] for f in self.provider.getFeatures(request)]
+        self.assertEquals(values, [5, 2, 4, 1, 3])
+
+        request = QgsFeatureRequest().addOrderBy('name', False)
+        values = [f['pk'] for f in self.provider.getFeatures(request)]
+        self.assertEquals(values, [5, 3, 1, 4, 2])
+
+        # expression which cannot be compiled
+        request = QgsFeatureRequest().addOrderBy('cnt * -1')
+        values = [f['pk'] for f in self.provider.getFeatures(request)]
+        self.assertEquals(values, [4, 3, 2, 1, 5])
+
+        # several clauses
+        request = QgsFeatureRequest().addOrderBy('cnt < 250').addOrderBy('cnt', False)
+        values = [f['pk'] for f in self.provider.getFeatures(request)]
+        self.assertEquals(values, [4, 3, 2, 1, 5])
+
+        # the limit applies to the ordered features
+        request = QgsFeatureRequest().addOrderBy('cnt', False).setLimit(2)
+        values = [f['pk'] for f in self.provider.getFeatures(request)]
+        self.assertEquals(values, [4, 3])
+
+        request = QgsFeatureRequest().addOrderBy('cnt').setFilterExpression('cnt > 100').setLimit(2)
+        values = [f['pk'] for f in self.provider.getFeatures(request)]
+        self.assertEquals(values, [2, 3])
+
+        # rewinding restarts from the first ordered feature
+        it = self.provider.getFeatures(QgsFeatureRequest().addOrderBy('cnt'))
+        feature = QgsFeature()
+        assert it.nextFeature(feature)
+        it.rewind()
+        values = [f['pk'] for f in it]
+        self.assertEquals(values, [5, 1, 2, 3, 4])
+
+    def testOrderByUncompiled(self):
+        try:
+            self.disableCompiler()
+        except AttributeError:
+            pass
+        self.runOrderByTests()
+
+    def testOrderByCompiled(self):
+        try:
+            self.enableCompiler()
+            self.runOrderByTests()
+        except AttributeError:
+            print 'Provider does not support compiling'
+
     def testMinValue(self):
         self.assertEqual(self.provider.minimumValue(1), -200)
         self.assertEqual(self.provider.minimumValue(2), 'Apple')
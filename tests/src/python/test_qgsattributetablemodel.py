@@ -13,7 +13,8 @@ __copyright__ = 'Copyright 2015, The QGIS Project'
 __revision__ = '$Format:%H$'
 
 from qgis.gui import QgsAttributeTableModel, QgsEditorWidgetRegistry
-from qgis.core import QgsFeature, QgsGeometry, QgsPoint, QgsVectorLayer, QgsVectorLayerCache, NULL
+from qgis.core import QgsFeature, QgsFeatureRequest, QgsGeometry, QgsPoint, QgsVectorLayer, QgsVectorLayerCache, NULL
+from PyQt4.QtCore import Qt
 
 from utilities import (unitTestDataPath,
                        getQgisTestApp,
@@ -59,6 +60,56 @@ class TestQgsAttributeTableModel(TestCase):
         assert self.am.rowCount() == 10, self.am.rowCount()
         assert self.am.columnCount() == 2, self.am.columnCount()
 
+    def testData(self):
+        # attributes are loaded into the cache page by page
+        for row in range(10):
+            fid = self.am.rowToId(row)
+            f = self.layer.getFeatures(QgsFeatureRequest(fid)).next()
+            assert self.am.data(self.am.index(row, 1), Qt.EditRole) == f['fldint']
+            assert self.cache.isFidCached(fid)
+
+    def testSortedRowOrder(self):
+        # rows follow the sorted column, so that neighbouring rows of the view are loaded together
+        layer = QgsVectorLayer("Point?field=fldint:integer", "sorted", "memory")
+        features = list()
+        for i in range(10):
+            f = QgsFeature()
+            f.setAttributes([(7 * i) % 10])
+            features.append(f)
+        assert layer.dataProvider().addFeatures(features)
+        cache = QgsVectorLayerCache(layer, 100)
+        am = QgsAttributeTableModel(cache)
+        am.loadLayer()
+
+        am.prefetchColumnData(0)
+        values = [am.data(am.index(row, 0), Qt.EditRole) for row in range(10)]
+        assert values == range(10), values
+
+        # the order is kept when the layer is loaded again
+        am.loadLayer()
+        values = [am.data(am.index(row, 0), Qt.EditRole) for row in range(10)]
+        assert values == range(10), values
+
+    def testPageEviction(self):
+        layer = QgsVectorLayer("Point?field=fldint:integer", "paged", "memory")
+        features = list()
+        for i in range(250):
+            f = QgsFeature()
+            f.setAttributes([i])
+            features.append(f)
+        assert layer.dataProvider().addFeatures(features)
+        cache = QgsVectorLayerCache(layer, 100)
+        am = QgsAttributeTableModel(cache)
+        am.loadLayer()
+
+        am.data(am.index(0, 0), Qt.EditRole)
+        assert cache.isFidCached(am.rowToId(99))
+        # the cache holds a single page, the first page is evicted as a whole
+        am.data(am.index(150, 0), Qt.EditRole)
+        assert cache.isFidCached(am.rowToId(199))
+        for row in range(100):
+            assert not cache.isFidCached(am.rowToId(row)), row
+
     def testRemove(self):
         self.layer.startEditing()
         self.layer.deleteFeature(5)
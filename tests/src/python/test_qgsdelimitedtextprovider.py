@@ -747,6 +747,177 @@ class TestQgsDelimitedTextProviderOther(TestCase):
         requests = None
         runTest(filename, requests, **params)
 
+    def test_040_filter_fid_line_offset_index(self):
+        # Seeking to records before and after the lines indexed every 1024 lines
+        (filehandle, filename) = tempfile.mkstemp(suffix='.csv')
+        if os.name == "nt":
+            filename = filename.replace("\\", "/")
+        names = {}
+        with os.fdopen(filehandle, "wb") as f:
+            f.write("id,name\n")
+            line = 2
+            for i in range(1, 3001):
+                # some records span two lines, around the indexed lines too
+                if i % 500 == 0 or i in (1021, 1022, 2044):
+                    name = "multi\nline {0}".format(i)
+                    f.write('{0},"{1}"\n'.format(i, name))
+                    names[line] = (i, name)
+                    line += 2
+                else:
+                    name = "name {0}".format(i)
+                    f.write("{0},{1}\n".format(i, name))
+                    names[line] = (i, name)
+                    line += 1
+
+        url = QUrl.fromLocalFile(filename)
+        url.addQueryItem("type", "csv")
+        url.addQueryItem("geomType", "none")
+        url.addQueryItem("watchFile", "no")
+        # the file is changed below, it must not be rescanned
+        url.addQueryItem("useWatcher", "no")
+        layer = QgsVectorLayer(url.toString(), u'test', u'delimitedtext')
+        assert layer.isValid(), "{} is invalid".format(filename)
+        assert layer.featureCount() == 3000, "Expected 3000 features, got {}".format(layer.featureCount())
+
+        def checkFeature(fid):
+            features = [f for f in layer.getFeatures(QgsFeatureRequest(fid))]
+            assert len(features) == 1, "Expected one feature with id {}, got {}".format(fid, len(features))
+            (i, name) = names[fid]
+            assert features[0]['id'] == i, "Feature {} has id {}, expected {}".format(fid, features[0]['id'], i)
+            assert features[0]['name'] == name, "Feature {} has name {}, expected {}".format(fid, features[0]['name'], name)
+
+        # forward and backward over the indexed lines 1024, 2048 and 3072
+        fids = sorted(names.keys())
+        for fid in [fids[-1], fids[0], 1023, 1024, 1025, 1026, fids[1030], fids[2046], 2048, 2049, fids[1021], fids[5], fids[-2]]:
+            if fid in names:
+                checkFeature(fid)
+
+        # ids beyond the end of the file
+        for fid in [fids[-1] + 1, fids[-1] + 2000]:
+            features = [f for f in layer.getFeatures(QgsFeatureRequest(fid))]
+            assert not features, "Unexpected feature with id {}".format(fid)
+        checkFeature(fids[1024])
+
+        # a list of ids across the indexed lines, in any order
+        wanted = [fids[3000 - 1], fids[1022], fids[1020], fids[0], fids[2047]]
+        request = QgsFeatureRequest().setFilterFids(wanted)
+        got = dict((f.id(), f['id']) for f in layer.getFeatures(request))
+        assert sorted(got.keys()) == sorted(wanted), "Expected features {}, got {}".format(sorted(wanted), sorted(got.keys()))
+        for fid in wanted:
+            assert got[fid] == names[fid][0], "Feature {} has id {}, expected {}".format(fid, got[fid], names[fid][0])
+
+        # join the first two records into one line without changing the size of the file:
+        # the lines after the first indexed line are only found at the same line numbers
+        # if the iterators seek to the offsets indexed when the layer was loaded, instead
+        # of counting the lines from the start of the file
+        with open(filename, "r+b") as f:
+            f.seek(len("id,name\n") + len("1,name 1"))
+            f.write(" ")
+        for fid in [fids[1030], 2048, fids[2046], fids[-1]]:
+            if fid in names:
+                checkFeature(fid)
+
+        del layer
+        os.remove(filename)
+
+    def writeRecords(self, records):
+        # Writes a csv file with an id, value, num and wkt field for each record
+        (filehandle, filename) = tempfile.mkstemp(suffix='.csv')
+        if os.name == "nt":
+            filename = filename.replace("\\", "/")
+        with os.fdopen(filehandle, "w") as f:
+            f.write("id,value,num,wkt\n")
+            for record in records:
+                f.write('{0},{1},{2},"{3}"\n'.format(*record))
+        return filename
+
+    def wktLayer(self, filename, subsetIndex='no'):
+        url = QUrl.fromLocalFile(filename)
+        url.addQueryItem("type", "csv")
+        url.addQueryItem("wktField", "wkt")
+        url.addQueryItem("spatialIndex", "no")
+        url.addQueryItem("subsetIndex", subsetIndex)
+        url.addQueryItem("watchFile", "no")
+        return QgsVectorLayer(url.toString(), u'test', u'delimitedtext')
+
+    def test_041_scan_batches(self):
+        # More records than scanned in one batch, with invalid and incompatible
+        # geometries on both sides of the batch boundaries
+        invalid = (1999, 2000, 2001, 4000, 4001)
+        records = []
+        valid = []
+        for i in range(1, 5001):
+            num = "0.5" if i == 4500 else str(i)
+            if i in invalid:
+                records.append((i, "xyz", num, "POINT(abc)"))
+            elif i % 7 == 0:
+                records.append((i, "abc", num, "LINESTRING(0 0,1 1)"))
+            elif i == 2003:
+                records.append((i, i, num, ""))
+                valid.append(i)
+            else:
+                records.append((i, i, num, "POINT({0} {1})".format(i, i % 100)))
+                valid.append(i)
+        filename = self.writeRecords(records)
+
+        with MessageLogger('DelimitedText') as logger:
+            layer = self.wktLayer(filename)
+            assert layer.isValid(), "{} is invalid".format(filename)
+        assert layer.featureCount() == len(valid), "Expected {} features, got {}".format(len(valid), layer.featureCount())
+        assert layer.wkbType() == QGis.WKBPoint, "Expected point layer, got {}".format(layer.wkbType())
+
+        # invalid lines are reported in file order, the header is the first line
+        lines = [int(m.group(1)) for m in (re.match(r'Invalid WKT at line (\d+)$', msg) for msg in logger.messages()) if m]
+        assert lines == [i + 1 for i in invalid], "Expected invalid lines {}, got {}".format([i + 1 for i in invalid], lines)
+        incompatible = len([i for i in range(1, 5001) if i % 7 == 0 and i not in invalid])
+        message = "{} records discarded due to incompatible geometry types".format(incompatible)
+        assert message in logger.messages(), "Expected message {}".format(message)
+
+        # the text values of invalid and incompatible records do not change the field types
+        fields = layer.dataProvider().fields()
+        assert fields[fields.indexFromName('value')].typeName() == 'integer', "value field is {}".format(fields[fields.indexFromName('value')].typeName())
+        assert fields[fields.indexFromName('num')].typeName() == 'double', "num field is {}".format(fields[fields.indexFromName('num')].typeName())
+
+        # more than 10% of the records are skipped, so the layer with a subset index
+        # uses it and must return the same features as the layer without
+        indexed = self.wktLayer(filename, 'yes')
+        for l in (layer, indexed):
+            ids = [f['id'] for f in l.getFeatures()]
+            assert ids == valid, "Features differ from the valid records: {}".format(sorted(set(ids) ^ set(valid))[:10])
+            fids = [f.id() for f in l.getFeatures()]
+            assert fids == [i + 1 for i in valid], "Feature ids are not the line numbers"
+
+        del layer
+        del indexed
+        os.remove(filename)
+
+    def test_042_scan_batches_zm(self):
+        # Once a record has a Z/M keyword, the extra ordinates of the following records
+        # are removed, also in later batches. The multipart record sets the layer type.
+        records = []
+        for i in range(1, 3001):
+            if i == 10:
+                records.append((i, i, i, "POINT Z(1 2 3)"))
+            elif i == 2500:
+                records.append((i, i, i, "MULTIPOINT({0} 6 7)".format(i)))
+            else:
+                records.append((i, i, i, "POINT({0} 1)".format(i)))
+        filename = self.writeRecords(records)
+
+        layer = self.wktLayer(filename)
+        assert layer.isValid(), "{} is invalid".format(filename)
+        assert layer.featureCount() == 3000, "Expected 3000 features, got {}".format(layer.featureCount())
+        assert layer.wkbType() == QGis.WKBMultiPoint, "Expected multipoint layer, got {}".format(layer.wkbType())
+        extent = layer.extent()
+        assert (extent.xMinimum(), extent.yMinimum(), extent.xMaximum(), extent.yMaximum()) == (1, 1, 3000, 6), \
+            "Unexpected extent {}".format(extent.toString())
+        features = [f for f in layer.getFeatures(QgsFeatureRequest(11))]
+        assert len(features) == 1, "Expected one feature with id 11"
+        assert compareWkt(features[0].geometry().exportToWkt(), "Point (1 2)"), "Unexpected geometry {}".format(features[0].geometry().exportToWkt())
+
+        del layer
+        os.remove(filename)
+
 
 if __name__ == '__main__':
     unittest.main()
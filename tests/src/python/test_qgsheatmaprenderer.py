@@ -0,0 +1,153 @@
+# -*- coding: utf-8 -*-
+
+"""
+***************************************************************************
+    test_qgsheatmaprenderer.py
+    ---------------------
+    Date                 : October 2015
+    Copyright            : (C) 2015 by QGIS Development Team
+    Email                : qgis-developer at lists dot osgeo dot org
+***************************************************************************
+*                                                                         *
+*   This program is free software; you can redistribute it and/or modify  *
+*   it under the terms of the GNU General Public License as published by  *
+*   the Free Software Foundation; either version 2 of the License, or     *
+*   (at your option) any later version.                                   *
+*                                                                         *
+***************************************************************************
+"""
+
+__author__ = 'QGIS Development Team'
+__date__ = 'October 2015'
+__copyright__ = '(C) 2015, QGIS Development Team'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+import qgis
+
+from PyQt4.QtCore import QSize
+from PyQt4.QtGui import QColor
+
+from qgis.core import (QgsVectorLayer,
+                       QgsFeature,
+                       QgsGeometry,
+                       QgsPoint,
+                       QgsRectangle,
+                       QgsMapSettings,
+                       QgsMapLayerRegistry,
+                       QgsHeatmapRenderer,
+                       QgsSymbolV2,
+                       QgsVectorGradientColorRampV2
+                       )
+from utilities import (getQgisTestApp,
+                       renderMapToImage,
+                       TestCase,
+                       unittest
+                       )
+QGISAPP, CANVAS, IFACE, PARENT = getQgisTestApp()
+
+
+def createLayer(points):
+    """ Memory layer with a point feature for every (x, y, weight) """
+    layer = QgsVectorLayer('Point?field=weight:double', 'points', 'memory')
+    features = []
+    for x, y, weight in points:
+        f = QgsFeature(layer.pendingFields())
+        f.setGeometry(QgsGeometry.fromPoint(QgsPoint(x, y)))
+        f['weight'] = weight
+        features.append(f)
+    layer.dataProvider().addFeatures(features)
+
+    renderer = QgsHeatmapRenderer()
+    renderer.setColorRamp(QgsVectorGradientColorRampV2(QColor(255, 255, 255), QColor(255, 0, 0)))
+    renderer.setRadius(10)
+    renderer.setRadiusUnit(QgsSymbolV2.Pixel)
+    renderer.setRenderQuality(1)
+    renderer.setWeightExpression('weight')
+    layer.setRendererV2(renderer)
+    return layer
+
+
+def render(layer):
+    """ Renders the layer, map units are equal to pixels """
+    settings = QgsMapSettings()
+    settings.setOutputSize(QSize(100, 100))
+    settings.setOutputDpi(96)
+    settings.setExtent(QgsRectangle(0, 0, 100, 100))
+    settings.setBackgroundColor(QColor(255, 255, 255))
+    settings.setLayers([layer.id()])
+    return renderMapToImage(settings)
+
+
+def pixelColor(image, x, y):
+    """ Color of the pixel at map coordinates """
+    return QColor(image.pixel(x, 100 - y))
+
+
+class TestQgsHeatmapRenderer(TestCase):
+
+    def setUp(self):
+        self.layers = []
+
+    def addLayer(self, points):
+        layer = createLayer(points)
+        QgsMapLayerRegistry.instance().addMapLayer(layer)
+        self.layers.append(layer.id())
+        return layer
+
+    def tearDown(self):
+        QgsMapLayerRegistry.instance().removeMapLayers(self.layers)
+
+    def assertColor(self, color, red, green, blue, tolerance=2):
+        for got, wanted in ((color.red(), red), (color.green(), green), (color.blue(), blue)):
+            assert abs(got - wanted) <= tolerance, 'Got color {} expected {}'.format(
+                (color.red(), color.green(), color.blue()), (red, green, blue))
+
+    def testSinglePoint(self):
+        image = render(self.addLayer([(50, 50, 1)]))
+        # maximum at the point, nothing outside of the radius
+        self.assertColor(pixelColor(image, 50, 50), 255, 0, 0)
+        self.assertColor(pixelColor(image, 50, 65), 255, 255, 255)
+        self.assertColor(pixelColor(image, 35, 50), 255, 255, 255)
+        # the kernel decreases with the distance
+        self.assertLess(pixelColor(image, 50, 52).green(), pixelColor(image, 50, 56).green())
+        self.assertLess(pixelColor(image, 50, 56).green(), 255)
+
+    def testWeights(self):
+        image = render(self.addLayer([(25, 50, 1), (75, 50, 4)]))
+        self.assertColor(pixelColor(image, 75, 50), 255, 0, 0)
+        # a quarter of the maximum
+        self.assertColor(pixelColor(image, 25, 50), 255, 191, 191, 3)
+
+    def testPointsOutsideImage(self):
+        # points beyond the edge still affect the pixels within their radius
+        image = render(self.addLayer([(50, 50, 1), (105, 50, 1)]))
+        self.assertColor(pixelColor(image, 50, 50), 255, 0, 0)
+        self.assertLess(pixelColor(image, 99, 50).green(), 255)
+
+    def testManyPoints(self):
+        # enough points to be accumulated in several threads - the result must be the same
+        # as for one point at each location with the total weight
+        count = 30000
+        many = render(self.addLayer([(30 + i % 3, 50, 1) for i in range(count)]))
+        single = render(self.addLayer([(30, 50, count / 3), (31, 50, count / 3), (32, 50, count / 3)]))
+        for x in range(15, 50):
+            for y in range(35, 65):
+                self.assertColor(pixelColor(many, x, y), pixelColor(single, x, y).red(),
+                                 pixelColor(single, x, y).green(), pixelColor(single, x, y).blue(), 1)
+
+    def testManyPointsAcrossBands(self):
+        # the rows are split in bands between the threads, points close to the band borders
+        # contribute to the rows of both bands
+        count = 11 * 2727
+        rows = [4 + 9 * i for i in range(11)]
+        many = render(self.addLayer([(20 + 6 * (i % 11), rows[i % 11], 1) for i in range(count)]))
+        single = render(self.addLayer([(20 + 6 * i, rows[i], count / 11.0) for i in range(11)]))
+        for x in range(100):
+            for y in range(1, 101):
+                self.assertColor(pixelColor(many, x, y), pixelColor(single, x, y).red(),
+                                 pixelColor(single, x, y).green(), pixelColor(single, x, y).blue(), 1)
+
+
+if __name__ == '__main__':
+    unittest.main()